@@ -80,3 +80,19 @@ int DummyAllocHooks::set_allocator_property(const char* name,
                                             size_t newlen) {
     return 1;
 }
+
+bool DummyAllocHooks::create_arena(unsigned* arena) {
+    return false;
+}
+
+void DummyAllocHooks::release_arena(unsigned arena) {
+    // empty
+}
+
+void DummyAllocHooks::switch_arena(unsigned arena) {
+    // empty
+}
+
+size_t DummyAllocHooks::get_arena_allocated(unsigned arena) {
+    return 0;
+}
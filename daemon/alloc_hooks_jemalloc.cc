@@ -38,6 +38,10 @@
 #include <jemalloc/jemalloc.h>
 #include <logger/logger.h>
 
+#include <mutex>
+#include <string>
+#include <vector>
+
 #if defined(HAVE_MEMALIGN)
 #include <malloc.h>
 #endif
@@ -57,6 +61,20 @@ static int jemalloc_get_stats_prop(const char* property, size_t* value) {
     return je_mallctl(property, value, &size, NULL, 0);
 }
 
+/* Force jemalloc to refresh its (cached) statistics. */
+static void jemalloc_refresh_stats() {
+    size_t epoch = 1;
+    size_t sz = sizeof(epoch);
+    je_mallctl("epoch", &epoch, &sz, &epoch, sz);
+}
+
+/* Arenas released by release_arena(), for reuse by create_arena() - jemalloc
+ * has no way to remove an arena which may still be referenced by a thread
+ * cache.
+ */
+static std::mutex released_arenas_mutex;
+static std::vector<unsigned> released_arenas;
+
 struct write_state {
     char* buffer;
     int remaining;
@@ -117,10 +135,8 @@ int JemallocHooks::get_extra_stats_size() {
 }
 
 void JemallocHooks::get_allocator_stats(allocator_stats* stats) {
-    size_t epoch = 1;
-    size_t sz = sizeof(epoch);
     /* jemalloc can cache its statistics - force a refresh */
-    je_mallctl("epoch", &epoch, &sz, &epoch, sz);
+    jemalloc_refresh_stats();
 
     jemalloc_get_stats_prop("stats.allocated", &(stats->allocated_size));
     jemalloc_get_stats_prop("stats.mapped", &(stats->heap_size));
@@ -210,7 +226,7 @@ bool JemallocHooks::enable_thread_cache(bool enable) {
 }
 
 bool JemallocHooks::get_allocator_property(const char* name, size_t* value) {
-    return jemalloc_get_stats_prop(name, value);
+    return jemalloc_get_stats_prop(name, value) == 0;
 }
 
 int JemallocHooks::set_allocator_property(const char* name,
@@ -218,3 +234,99 @@ int JemallocHooks::set_allocator_property(const char* name,
                                           size_t newlen) {
     return je_mallctl(name, nullptr, 0, newp, newlen);
 }
+
+bool JemallocHooks::create_arena(unsigned* arena) {
+    {
+        std::lock_guard<std::mutex> guard(released_arenas_mutex);
+        if (!released_arenas.empty()) {
+            *arena = released_arenas.back();
+            released_arenas.pop_back();
+            return true;
+        }
+    }
+
+    size_t len = sizeof(*arena);
+    int err = je_mallctl("arenas.create", arena, &len, NULL, 0);
+    if (err != 0) {
+        LOG_WARNING("jemalloc_create_arena() error {}", err);
+        return false;
+    }
+    return true;
+}
+
+void JemallocHooks::release_arena(unsigned arena) {
+    /* The arena can't be reset or destroyed: thread caches (which are not
+     * per-arena) may still hold regions from it. Instead purge its unused
+     * pages and keep it for the next create_arena(). */
+    const std::string purge = "arena." + std::to_string(arena) + ".purge";
+    int err = je_mallctl(purge.c_str(), NULL, 0, NULL, 0);
+    if (err != 0) {
+        LOG_WARNING("jemalloc_release_arena({}) error {}", arena, err);
+    }
+
+    std::lock_guard<std::mutex> guard(released_arenas_mutex);
+    released_arenas.push_back(arena);
+}
+
+namespace {
+/* MIB for a per-thread control, looked up once as switch_arena() is called
+ * on every switch between buckets. */
+struct ThreadMib {
+    explicit ThreadMib(const char* name) {
+        if (je_mallctlnametomib(name, mib, &miblen) != 0) {
+            miblen = 0;
+        }
+    }
+    size_t mib[3];
+    size_t miblen = 3;
+};
+} // namespace
+
+void JemallocHooks::switch_arena(unsigned arena) {
+    /* Threads start in the default arena (arena 0, as narenas is 1). */
+    static thread_local unsigned current_arena = 0;
+    static thread_local bool tcache_disabled = false;
+    if (arena == current_arena) {
+        return;
+    }
+
+    static const ThreadMib thread_arena("thread.arena");
+    if (thread_arena.miblen == 0) {
+        return;
+    }
+
+    /* The thread cache isn't per-arena, so once a thread allocates from a
+     * dedicated arena regions cached from one arena would be handed out for
+     * allocations in another. Flushing it on every switch would cost two
+     * flushes per engine call (onSwitchThread() switches to the bucket's
+     * arena and back), so instead the cache is disabled - and flushed, once -
+     * the first time a thread switches to a dedicated arena. Threads which
+     * only ever use arena 0 keep their cache. */
+    if (arena != 0 && !tcache_disabled) {
+        enable_thread_cache(false);
+        tcache_disabled = true;
+    }
+
+    int err = je_mallctlbymib(thread_arena.mib,
+                              thread_arena.miblen,
+                              NULL,
+                              NULL,
+                              &arena,
+                              sizeof(arena));
+    if (err != 0) {
+        LOG_WARNING("jemalloc_switch_arena({}) error {}", arena, err);
+        return;
+    }
+    current_arena = arena;
+}
+
+size_t JemallocHooks::get_arena_allocated(unsigned arena) {
+    jemalloc_refresh_stats();
+
+    const std::string prefix = "stats.arenas." + std::to_string(arena);
+    size_t small = 0;
+    size_t large = 0;
+    jemalloc_get_stats_prop((prefix + ".small.allocated").c_str(), &small);
+    jemalloc_get_stats_prop((prefix + ".large.allocated").c_str(), &large);
+    return small + large;
+}
@@ -21,7 +21,6 @@
 #include "memcached.h"
 #include "server_event.h"
 
-#include <mcbp/protocol/framebuilder.h>
 #include <memory>
 
 CccpNotificationTask::CccpNotificationTask(int bucket_, int revision_)
@@ -58,45 +57,28 @@ public:
 
     bool execute(Connection& connection) override {
         auto& bucket = connection.getBucket();
-        auto payload = bucket.clusterConfiguration.getConfiguration();
-        if (payload.first < connection.getClustermapRevno()) {
-            // Ignore.. we've already sent a newer cluster config
+        auto config = bucket.clusterConfiguration.getConfiguration();
+        if (!config || config->revision <= connection.getClustermapRevno()) {
+            // Ignore.. we've already sent this (or a newer) cluster config.
+            // Multiple pushes queued for the connection while the
+            // revision changed rapidly all send the latest one, once.
             return true;
         }
 
-        connection.setClustermapRevno(payload.first);
+        connection.setClustermapRevno(config->revision);
         LOG_INFO("{}: Sending Cluster map revision {}",
                  connection.getId(),
-                 payload.first);
-
-        std::string name = bucket.name;
-
-        using namespace cb::mcbp;
-        size_t needed = sizeof(Request) + // packet header
-                        4 + // rev number in extdata
-                        name.size() + // the name of the bucket
-                        payload.second->size(); // The actual payload
-
-        connection.write->ensureCapacity(needed);
-        FrameBuilder<Request> builder(connection.write->wdata());
-        builder.setMagic(Magic::ServerRequest);
-        builder.setDatatype(cb::mcbp::Datatype::JSON);
-        builder.setOpcode(ServerOpcode::ClustermapChangeNotification);
-
-        // The extras contains the cluster revision number as an uint32_t
-        const uint32_t rev = htonl(payload.first);
-        builder.setExtras(
-                {reinterpret_cast<const uint8_t*>(&rev), sizeof(rev)});
-        builder.setKey(
-                {reinterpret_cast<const uint8_t*>(name.data()), name.size()});
-        builder.setValue(
-                {reinterpret_cast<const uint8_t*>(payload.second->data()),
-                 payload.second->size()});
-
-        // Inject our packet into the stream!
+                 config->revision);
+
+        // Inject the (shared) pre-framed packet into the stream!
+        const auto& packet = connection.isSnappyEnabled() &&
+                                             !config->compressedNotification
+                                                      .empty()
+                                     ? config->compressedNotification
+                                     : config->notification;
         connection.addMsgHdr(true);
-        connection.addIov(connection.write->wdata().data(), needed);
-        connection.write->produced(needed);
+        connection.addIov(packet.data(), packet.size());
+        connection.pushSharedBuffer(std::move(config));
 
         connection.setState(StateMachine::State::send_data);
         connection.setWriteAndGo(StateMachine::State::new_cmd);
@@ -105,6 +87,19 @@ public:
 };
 
 Task::Status CccpNotificationTask::execute() {
+    const auto current = bucket.clusterConfiguration.getRevision();
+    if (revision < current) {
+        // The configuration changed again before we got to run; the
+        // task for the newer revision pushes that one to everyone.
+        LOG_INFO(
+                "Skipping push of cluster config for bucket:[{}] "
+                "revision:[{}] as it has been replaced by revision:[{}]",
+                bucket.name,
+                revision,
+                current);
+        return Status::Finished;
+    }
+
     LOG_INFO("Pushing new cluster config for bucket:[{}] revision:[{}]",
              bucket.name,
              revision);
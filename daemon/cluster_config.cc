@@ -16,12 +16,77 @@
  */
 #include "cluster_config.h"
 
+#include <mcbp/protocol/datatype.h>
+#include <mcbp/protocol/framebuilder.h>
+#include <platform/compress.h>
+#include <platform/socket.h>
 #include <subdoc/operations.h>
 
 #include <cstdlib>
 #include <stdexcept>
 
-void ClusterConfiguration::setConfiguration(cb::const_char_buffer buffer) {
+static std::string compress(cb::const_char_buffer config) {
+    cb::compression::Buffer deflated;
+    if (!cb::compression::deflate(
+                cb::compression::Algorithm::Snappy, config, deflated) ||
+        deflated.size() >= config.size()) {
+        return {};
+    }
+    return {deflated.data(), deflated.size()};
+}
+
+/**
+ * Build the ClustermapChangeNotification packet for the given revision
+ * (or an empty string if there isn't a value to send).
+ */
+static std::string frameNotification(int revision,
+                                      cb::const_char_buffer bucket,
+                                      cb::const_char_buffer value,
+                                      cb::mcbp::Datatype datatype) {
+    if (value.empty()) {
+        return {};
+    }
+
+    using namespace cb::mcbp;
+    std::string ret;
+    ret.resize(sizeof(Request) + // packet header
+               4 + // rev number in extdata
+               bucket.size() + // the name of the bucket
+               value.size()); // The actual payload
+    FrameBuilder<Request> builder(
+            {reinterpret_cast<uint8_t*>(&ret[0]), ret.size()});
+    builder.setMagic(Magic::ServerRequest);
+    builder.setDatatype(datatype);
+    builder.setOpcode(ServerOpcode::ClustermapChangeNotification);
+
+    // The extras contains the cluster revision number as an uint32_t
+    const uint32_t rev = htonl(revision);
+    builder.setExtras({reinterpret_cast<const uint8_t*>(&rev), sizeof(rev)});
+    builder.setKey(
+            {reinterpret_cast<const uint8_t*>(bucket.data()), bucket.size()});
+    builder.setValue(
+            {reinterpret_cast<const uint8_t*>(value.data()), value.size()});
+    return ret;
+}
+
+ClusterConfiguration::Config::Config(int revision,
+                                     cb::const_char_buffer bucket,
+                                     cb::const_char_buffer config)
+    : revision(revision),
+      config(config.begin(), config.end()),
+      compressedConfig(compress(config)),
+      notification(frameNotification(
+              revision, bucket, config, cb::mcbp::Datatype::JSON)),
+      compressedNotification(frameNotification(
+              revision,
+              bucket,
+              compressedConfig,
+              cb::mcbp::Datatype(uint8_t(cb::mcbp::Datatype::JSON) |
+                                 uint8_t(cb::mcbp::Datatype::Snappy)))) {
+}
+
+void ClusterConfiguration::setConfiguration(cb::const_char_buffer bucket,
+                                            cb::const_char_buffer buffer) {
     int rev = getRevisionNumber(buffer);
     if (rev == -1) {
         throw std::invalid_argument(
@@ -29,9 +94,11 @@ void ClusterConfiguration::setConfiguration(cb::const_char_buffer buffer) {
                 "revision");
     }
 
+    // Build (and compress) the new revision before taking the lock
+    auto next = std::make_shared<const Config>(rev, bucket, buffer);
+
     std::lock_guard<std::mutex> guard(mutex);
-    revision = rev;
-    config = std::make_shared<std::string>(buffer.begin(), buffer.end());
+    config = std::move(next);
 }
 
 int ClusterConfiguration::getRevisionNumber(cb::const_char_buffer buffer) {
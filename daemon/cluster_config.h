@@ -32,23 +32,63 @@
  */
 class ClusterConfiguration {
 public:
-    ClusterConfiguration()
-        : config(std::make_shared<std::string>()), revision(-1) {
-    }
+    /**
+     * A revision of the configuration. It is immutable once published,
+     * so a single copy is shared by all of the connections: they add it
+     * to their iovecs (holding a reference until it has been sent) rather
+     * than copying it into their own buffers.
+     */
+    class Config {
+    public:
+        Config(int revision,
+               cb::const_char_buffer bucket,
+               cb::const_char_buffer config);
+
+        /// The revision number of the configuration
+        const int revision;
+
+        /// The configuration itself (JSON)
+        const std::string config;
 
-    void setConfiguration(cb::const_char_buffer buffer);
+        /// config Snappy compressed, or empty if it didn't compress
+        const std::string compressedConfig;
+
+        /// A complete ClustermapChangeNotification carrying config
+        const std::string notification;
+
+        /// As notification, carrying compressedConfig (or empty)
+        const std::string compressedNotification;
+    };
+
+    ClusterConfiguration() = default;
+
+    /**
+     * Publish a new configuration.
+     *
+     * @param bucket the name of the bucket (included in the push
+     *               notification)
+     * @param buffer the configuration
+     * @throws std::invalid_argument if the revision can't be determined
+     */
+    void setConfiguration(cb::const_char_buffer bucket,
+                          cb::const_char_buffer buffer);
 
     /**
      * Get the current configuration.
      *
-     * @return a pair where the first element is the revision number, and
-     *         the second element is (a copy) of the configuration.
+     * @return the current configuration, or nullptr if none has been set
      */
-    std::pair<int, std::shared_ptr<std::string>> getConfiguration() const {
+    std::shared_ptr<const Config> getConfiguration() const {
         std::lock_guard<std::mutex> guard(mutex);
-        return std::make_pair(revision, config);
+        return config;
     };
 
+    /// @return the revision of the current configuration (-1 if none)
+    int getRevision() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        return config ? config->revision : -1;
+    }
+
     /**
      * Pick out the revision number from the provided cluster configuration.
      *
@@ -59,21 +99,16 @@ public:
 
 private:
     /**
-     * We use a mutex so that we can get a consistent copy of the revision
-     * number and the configuration. (we cache the revision number to avoid
-     * parsing the JSON every time we have to handle a not my vbucket reply
-     * because we want to be able to avoid sending duplicates of the cluster
-     * configuration map to the clients).
+     * We use a mutex to protect the (swap of the) current configuration.
+     * The revision number is cached in it to avoid parsing the JSON every
+     * time we have to handle a not my vbucket reply (because we want to be
+     * able to avoid sending duplicates of the cluster configuration map to
+     * the clients).
      */
     mutable std::mutex mutex;
 
     /**
      * The actual config
      */
-    std::shared_ptr<std::string> config;
-
-    /**
-     * Cached revision so we don't have to parse it every time
-     */
-    int revision;
+    std::shared_ptr<const Config> config;
 };
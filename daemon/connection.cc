@@ -1321,6 +1321,50 @@ size_t Connection::getNumberOfCookies() const {
     return ret;
 }
 
+void Connection::reorderCurrentCookie(bool hold) {
+    auto& cookie = getCookieObject();
+    if (!cookie.isReordered()) {
+        // Copy the packet so that we may consume it from the input
+        // buffer and carry on with the next one
+        cookie.preserveRequest();
+        read->consume([&cookie](cb::const_byte_buffer buffer) -> ssize_t {
+            size_t size = cookie.getPacket(Cookie::PacketContent::Full).size();
+            if (size > buffer.size()) {
+                throw std::logic_error(
+                        "Connection::reorderCurrentCookie: Not enough data "
+                        "in input buffer");
+            }
+            return gsl::narrow<ssize_t>(size);
+        });
+        cookie.setReordered();
+    }
+
+    if (hold) {
+        holdingCookie = true;
+    }
+    cookies.push_back(std::move(cookies.front()));
+    cookies.front().reset(new Cookie(*this));
+}
+
+bool Connection::resumeReorderedCookie() {
+    for (size_t ii = 1; ii < cookies.size(); ++ii) {
+        if (cookies[ii]->isEwouldblock()) {
+            continue;
+        }
+        if (holdingCookie && ii == cookies.size() - 1) {
+            if (ii != 1) {
+                // The held cookie must wait for the ones ahead of it
+                continue;
+            }
+            holdingCookie = false;
+        }
+        cookies.front() = std::move(cookies[ii]);
+        cookies.erase(cookies.begin() + ii);
+        return true;
+    }
+    return false;
+}
+
 bool Connection::isPacketAvailable() const {
     auto buffer = read->rdata();
 
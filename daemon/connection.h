@@ -643,12 +643,22 @@ public:
             cb_free(ptr);
         }
         temp_alloc.resize(0);
+        shared_buffers.clear();
     }
 
     void pushTempAlloc(char* ptr) {
         temp_alloc.push_back(ptr);
     }
 
+    /**
+     * Keep a reference to a shared (immutable) buffer which has been
+     * added to the iovecs until we're done sending all of the data. It
+     * is released together with the temporary allocations.
+     */
+    void pushSharedBuffer(std::shared_ptr<const void> buffer) {
+        shared_buffers.push_back(std::move(buffer));
+    }
+
     /**
      * Enable the datatype which corresponds to the feature
      *
@@ -778,6 +788,44 @@ public:
      */
     size_t getNumberOfCookies() const;
 
+    /**
+     * The maximum number of commands a connection in unordered execution
+     * mode may have blocked in the engine while it carries on executing
+     * the commands following them.
+     */
+    static const size_t MaxReorderedCookies = 16;
+
+    /**
+     * Take the current cookie out of the input stream (copying its packet)
+     * and install a fresh cookie to read the next command into. The cookie
+     * is kept with the connection until resumeReorderedCookie() makes it
+     * current again.
+     *
+     * @param hold true if the cookie hasn't been executed as it must wait
+     *             for the reordered cookies ahead of it to complete; no
+     *             further commands are read until it has been resumed.
+     */
+    void reorderCurrentCookie(bool hold);
+
+    /// @return the number of cookies set aside by reorderCurrentCookie()
+    size_t getNumberOfReorderedCookies() const {
+        return cookies.size() - 1;
+    }
+
+    /// @return true if a cookie is waiting for those reordered before it
+    bool isHoldingCookie() const {
+        return holdingCookie;
+    }
+
+    /**
+     * If one of the reordered cookies can make progress (the engine has
+     * notified it, or it is the held cookie and nothing is ahead of it)
+     * make it the current cookie, replacing the (idle) current cookie.
+     *
+     * @return true if the current cookie should now be executed
+     */
+    bool resumeReorderedCookie();
+
     /**
      * Check to see if the next packet to process is completely received
      * and available in the input pipe.
@@ -1225,6 +1273,9 @@ protected:
      */
     std::vector<char*> temp_alloc;
 
+    /// Shared buffers referenced from the iovecs (see pushSharedBuffer)
+    std::vector<std::shared_ptr<const void>> shared_buffers;
+
     /**
      * If the client enabled the mutation seqno feature each mutation
      * command will return the vbucket UUID and sequence number for the
@@ -1243,15 +1294,17 @@ protected:
     size_t totalSend = 0;
 
     /**
-     * The list of commands currently being processed. Currently we
-     * only use a single entry in this vector (and always reuse that
-     * object for all commands), but when the client tries to
-     * enable unordered execution we may operate with multiple
-     * commands at the same time and they're all stored in this
-     * vector)
+     * The list of commands currently being processed. The first entry
+     * is the current cookie (which all commands are read into), and is
+     * the only one unless the client enabled unordered execution. The
+     * following entries are the cookies set aside by
+     * reorderCurrentCookie(), in the order they were received.
      */
     std::vector<std::unique_ptr<Cookie>> cookies;
 
+    /// Is the last of the reordered cookies held (see reorderCurrentCookie)
+    bool holdingCookie = false;
+
     Datatype datatype;
 
     /**
@@ -52,10 +52,10 @@ enum class BufferLoan {
 /** Function prototypes ******************************************************/
 
 static BufferLoan loan_single_buffer(Connection& c,
-                                     std::unique_ptr<cb::Pipe>& thread_buf,
+                                     NetworkBufferPool& pool,
                                      std::unique_ptr<cb::Pipe>& conn_buf);
 static void maybe_return_single_buffer(Connection& c,
-                                       std::unique_ptr<cb::Pipe>& thread_buf,
+                                       NetworkBufferPool& pool,
                                        std::unique_ptr<cb::Pipe>& conn_buf);
 static void conn_destructor(Connection* c);
 static Connection* allocate_connection(SOCKET sfd,
@@ -332,6 +332,17 @@ static Connection* allocate_connection(SOCKET sfd,
  *  and freeing the Connection object.
  */
 static void release_connection(Connection* c) {
+    // Hand the buffers back (the pool only keeps them if they're empty)
+    auto* thread = c->getThread();
+    if (thread != nullptr) {
+        if (c->read) {
+            thread->read.put(std::move(c->read));
+        }
+        if (c->write) {
+            thread->write.put(std::move(c->write));
+        }
+    }
+
     {
         std::lock_guard<std::mutex> lock(connections.mutex);
         auto iter = std::find(connections.conns.begin(), connections.conns.end(), c);
@@ -350,7 +361,7 @@ static void release_connection(Connection* c) {
  * necessary.
  */
 static BufferLoan loan_single_buffer(Connection& c,
-                                     std::unique_ptr<cb::Pipe>& thread_buf,
+                                     NetworkBufferPool& pool,
                                      std::unique_ptr<cb::Pipe>& conn_buf) {
     /* Already have a (partial) buffer - nothing to do. */
     if (conn_buf) {
@@ -358,14 +369,15 @@ static BufferLoan loan_single_buffer(Connection& c,
     }
 
     // If the thread has a buffer, let's loan that to the connection
-    if (thread_buf) {
-        thread_buf.swap(conn_buf);
+    conn_buf = pool.take();
+    if (conn_buf) {
         return BufferLoan::Loaned;
     }
 
     // Need to allocate a new buffer
     try {
         conn_buf = std::make_unique<cb::Pipe>(DATA_BUFFER_SIZE);
+        pool.noteAllocated();
     } catch (const std::bad_alloc&) {
         // Unable to alloc a buffer for the thread. Not much we can do here
         // other than terminate the current connection.
@@ -382,15 +394,10 @@ static BufferLoan loan_single_buffer(Connection& c,
 }
 
 static void maybe_return_single_buffer(Connection& c,
-                                       std::unique_ptr<cb::Pipe>& thread_buf,
+                                       NetworkBufferPool& pool,
                                        std::unique_ptr<cb::Pipe>& conn_buf) {
     if (conn_buf && conn_buf->empty()) {
-        // Buffer clean, dispose of it
-        if (thread_buf) {
-            // Already got a thread buffer.. release this one
-            conn_buf.reset();
-        } else {
-            conn_buf.swap(thread_buf);
-        }
+        // Buffer clean, give it back to the pool
+        pool.put(std::move(conn_buf));
     }
 }
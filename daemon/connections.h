@@ -40,14 +40,16 @@ void run_event_loop(Connection* c, short which);
  * If the connection doesn't already have read/write buffers, ensure that it
  * does.
  *
- * In the common case, only one read/write buffer is created per worker thread,
+ * In the common case, only one read/write buffer is in use per worker thread,
  * and this buffer is loaned to the connection the worker is currently
  * handling. As long as the connection doesn't have a partial read/write (i.e.
  * the buffer is totally consumed) when it goes idle, the buffer is simply
  * returned back to the worker thread.
  *
  * If there is a partial read/write, then the buffer is left loaned to that
- * connection and the worker thread will allocate a new one.
+ * connection and the next connection borrows another buffer from the
+ * worker thread's pool (see NetworkBufferPool), or allocates a new one if
+ * the pool is empty.
  */
 void conn_loan_buffers(Connection* c);
 
@@ -24,7 +24,6 @@
 
 #include <logger/logger.h>
 #include <mcbp/mcbp.h>
-#include <mcbp/protocol/framebuilder.h>
 #include <nlohmann/json.hpp>
 #include <phosphor/phosphor.h>
 #include <platform/checked_snprintf.h>
@@ -174,6 +173,24 @@ cb::const_byte_buffer Cookie::getPacket(PacketContent content) const {
             "Cookie::getPacket(): Invalid content requested");
 }
 
+bool Cookie::mayReorder() const {
+    const auto& header = getHeader();
+    if (header.getMagic() != uint8_t(cb::mcbp::Magic::ClientRequest)) {
+        return false;
+    }
+
+    switch (header.getRequest().getClientOpcode()) {
+    case cb::mcbp::ClientOpcode::Get:
+    case cb::mcbp::ClientOpcode::Getq:
+    case cb::mcbp::ClientOpcode::Getk:
+    case cb::mcbp::ClientOpcode::Getkq:
+    case cb::mcbp::ClientOpcode::GetReplica:
+        return true;
+    default:
+        return false;
+    }
+}
+
 const cb::mcbp::Header& Cookie::getHeader() const {
     const auto packet = getPacket(PacketContent::Header);
     return *reinterpret_cast<const cb::mcbp::Header*>(packet.data());
@@ -226,9 +243,9 @@ void Cookie::sendDynamicBuffer() {
 }
 
 void Cookie::sendNotMyVBucket() {
-    auto pair = connection.getBucket().clusterConfiguration.getConfiguration();
-    if (pair.first == -1 || (pair.first == connection.getClustermapRevno() &&
-                             settings.isDedupeNmvbMaps())) {
+    auto config = connection.getBucket().clusterConfiguration.getConfiguration();
+    if (!config || (config->revision == connection.getClustermapRevno() &&
+                    settings.isDedupeNmvbMaps())) {
         // We don't have a vbucket map, or we've already sent it to the
         // client
         mcbp_add_header(*this,
@@ -242,25 +259,32 @@ void Cookie::sendNotMyVBucket() {
         return;
     }
 
-    const size_t needed = sizeof(cb::mcbp::Response) + pair.second->size();
-    if (!growDynamicBuffer(needed)) {
-        throw std::bad_alloc();
-    }
-    auto& buffer = getDynamicBuffer();
-    auto* buf = reinterpret_cast<uint8_t*>(buffer.getCurrent());
-    const auto& header = getHeader();
-    cb::mcbp::ResponseBuilder builder({buf, needed});
-    builder.setMagic(cb::mcbp::Magic::ClientResponse);
-    builder.setOpcode(header.getRequest().getClientOpcode());
-    builder.setStatus(cb::mcbp::Status::NotMyVbucket);
-    builder.setOpaque(header.getOpaque());
-    builder.setValue({reinterpret_cast<const uint8_t*>(pair.second->data()),
-                      pair.second->size()});
-    builder.validate();
-
-    buffer.moveOffset(needed);
-    sendDynamicBuffer();
-    connection.setClustermapRevno(pair.first);
+    sendClusterConfiguration(cb::mcbp::Status::NotMyVbucket,
+                             std::move(config));
+}
+
+void Cookie::sendClusterConfiguration(
+        cb::mcbp::Status status,
+        std::shared_ptr<const ClusterConfiguration::Config> config) {
+    const bool compressed =
+            connection.isSnappyEnabled() && !config->compressedConfig.empty();
+    const auto& value = compressed ? config->compressedConfig : config->config;
+    const auto datatype = compressed ? PROTOCOL_BINARY_DATATYPE_JSON |
+                                               PROTOCOL_BINARY_DATATYPE_SNAPPY
+                                     : PROTOCOL_BINARY_DATATYPE_JSON;
+
+    mcbp_add_header(*this,
+                    status,
+                    0,
+                    0,
+                    uint32_t(value.size()),
+                    connection.getEnabledDatatypes(datatype));
+    connection.addIov(value.data(), value.size());
+    connection.setClustermapRevno(config->revision);
+    connection.pushSharedBuffer(std::move(config));
+
+    connection.setState(StateMachine::State::send_data);
+    connection.setWriteAndGo(StateMachine::State::new_cmd);
 }
 
 void Cookie::sendResponse(cb::mcbp::Status status) {
@@ -509,4 +533,6 @@ void Cookie::reset() {
     dynamicBuffer.clear();
     tracer.clear();
     ewouldblock = false;
+    reordered = false;
+    received_packet.reset();
 }
@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include "cluster_config.h"
 #include "dynamic_buffer.h"
 #include "tracing/tracer.h"
 
@@ -327,6 +328,28 @@ public:
      */
     void setEwouldblock(bool ewouldblock);
 
+    /**
+     * May the command in this cookie be executed out of order with the
+     * commands around it, on a connection in unordered execution mode?
+     *
+     * Requests can't carry a per-command reorder flag yet, so this is
+     * limited to the plain key lookups (which is where a blocking command,
+     * waiting for a background fetch, hurts the ones behind it).
+     */
+    bool mayReorder() const;
+
+    /**
+     * Has this cookie been taken out of the connection's input stream (its
+     * packet copied) to be completed out of order?
+     */
+    bool isReordered() const {
+        return reordered;
+    }
+
+    void setReordered() {
+        reordered = true;
+    }
+
     /**
      *
      * @return
@@ -353,6 +376,18 @@ public:
      */
     void sendNotMyVBucket();
 
+    /**
+     * Send a response carrying the given cluster configuration. The value
+     * is sent from the shared copy (Snappy compressed if the client
+     * supports it) rather than copied into the connection.
+     *
+     * @param status The status code for the operation
+     * @param config The configuration to send
+     */
+    void sendClusterConfiguration(
+            cb::mcbp::Status status,
+            std::shared_ptr<const ClusterConfiguration::Config> config);
+
     /**
      * Send a response without a message payload back to the client.
      *
@@ -515,4 +550,6 @@ protected:
     ENGINE_ERROR_CODE aiostat = ENGINE_SUCCESS;
 
     bool ewouldblock = false;
+
+    bool reordered = false;
 };
@@ -22,9 +22,12 @@
 #include <memcached/engine_error.h>
 #include <platform/socket.h>
 #include <subdoc/operations.h>
+#include <atomic>
+#include <cstdint>
 #include <mutex>
 #include <queue>
 #include <unordered_map>
+#include <vector>
 
 // Forward decl
 namespace cb {
@@ -56,12 +59,75 @@ private:
     std::queue<std::unique_ptr<ConnectionQueueItem> > connections;
 };
 
+/**
+ * A pool of network buffers owned by a front-end thread. The connections
+ * served by the thread borrow a buffer from the pool while they have data
+ * in flight and give it back once it's drained, so that idle connections
+ * don't pin any buffer memory.
+ *
+ * Only the owning thread may take / put buffers, but the counters may be
+ * read by any thread (for stats).
+ */
+class NetworkBufferPool {
+public:
+    /// The maximum number of unused buffers kept in the pool
+    static const size_t MaxPooledBuffers = 16;
+
+    /// Buffers which have grown beyond this size are freed, not pooled
+    static const size_t MaxPooledBufferSize = 1024 * 1024;
+
+    ~NetworkBufferPool();
+
+    /**
+     * Take a buffer from the pool for a connection to use.
+     *
+     * @return a buffer, or nullptr if the pool is empty (the caller
+     *         should then allocate one and call noteAllocated())
+     */
+    std::unique_ptr<cb::Pipe> take();
+
+    /// Note that a connection allocated a buffer of its own
+    void noteAllocated() {
+        in_use++;
+    }
+
+    /**
+     * Give back a buffer a connection no longer needs. Full or oversized
+     * buffers are freed rather than pooled.
+     */
+    void put(std::unique_ptr<cb::Pipe> buffer);
+
+    /// Number of unused buffers in the pool
+    size_t getPooled() const {
+        return pooled;
+    }
+
+    /// Number of bytes allocated for the unused buffers in the pool
+    size_t getPooledBytes() const {
+        return pooled_bytes;
+    }
+
+    /// Number of buffers currently held by connections
+    size_t getInUse() const {
+        return in_use;
+    }
+
+private:
+    std::vector<std::unique_ptr<cb::Pipe>> buffers;
+    std::atomic<size_t> pooled{0};
+    std::atomic<size_t> pooled_bytes{0};
+    std::atomic<size_t> in_use{0};
+};
+
 struct FrontEndThread {
     /**
      * Pending IO requests for this thread. Maps each pending Connection to
-     * the IO status to be notified.
+     * the cookies (a connection in unordered execution mode may have
+     * several blocked) and the IO status to be notified.
      */
-    using PendingIoMap = std::unordered_map<Connection*, ENGINE_ERROR_CODE>;
+    using PendingIoMap = std::unordered_map<
+            Connection*,
+            std::vector<std::pair<Cookie*, ENGINE_ERROR_CODE>>>;
 
     /**
      * Destructor.
@@ -88,6 +154,27 @@ struct FrontEndThread {
      */
     SOCKET notify[2] = {INVALID_SOCKET, INVALID_SOCKET};
 
+    /**
+     * Set if notify[0] is an eventfd (used for the worker threads where
+     * available) rather than one end of a socket pair. notify[1] is then
+     * unused, and the thread is notified by writing to notify[0].
+     */
+    bool notify_eventfd = false;
+
+    /**
+     * Set when the thread has been notified, until it starts to process
+     * the notification. Other threads skip the write to the notification
+     * channel while it is set, as the thread will pick up whatever they
+     * queued for it anyway.
+     */
+    std::atomic<bool> notify_pending{false};
+
+    /// Number of times the thread has been woken via the notify channel
+    std::atomic<uint64_t> wakeups{0};
+
+    /// Number of notifications which didn't need a wakeup (see above)
+    std::atomic<uint64_t> notifications_coalesced{0};
+
     /// queue of new connections to handle
     ConnectionQueue new_conn_queue;
 
@@ -103,11 +190,11 @@ struct FrontEndThread {
     /// index of this thread in the threads array
     size_t index = 0;
 
-    /// Shared read buffer for all connections serviced by this thread.
-    std::unique_ptr<cb::Pipe> read;
+    /// Read buffers for the connections serviced by this thread.
+    NetworkBufferPool read;
 
-    /// Shared write buffer for all connections serviced by this thread.
-    std::unique_ptr<cb::Pipe> write;
+    /// Write buffers for the connections serviced by this thread.
+    NetworkBufferPool write;
 
     /**
      * Shared sub-document operation for all connections serviced by this
@@ -134,5 +221,49 @@ struct FrontEndThread {
 };
 
 void notify_thread(FrontEndThread& thread);
+
+/**
+ * Create the channel through which notify_thread() wakes the thread (see
+ * FrontEndThread::notify).
+ *
+ * @return true on success
+ */
+bool create_notification_channel(FrontEndThread& me);
+
+/**
+ * Called by a thread woken through its notification channel, before it
+ * looks for the work it was notified about: drains the channel and clears
+ * notify_pending, so that any later notify_thread() wakes it again.
+ */
+void acknowledge_notification(FrontEndThread& me);
+
+/// Get the front-end (worker) thread with the given index
+FrontEndThread& get_worker_thread(size_t index);
+
+/**
+ * The notification counters of a worker thread (see
+ * FrontEndThread::wakeups and FrontEndThread::notifications_coalesced)
+ */
+struct FrontEndThreadNotifyStats {
+    uint64_t wakeups;
+    uint64_t coalesced;
+};
+
+/// Get the notification counters of each of the worker threads
+std::vector<FrontEndThreadNotifyStats> get_worker_thread_notify_stats();
+
+/// The buffer pool counters of a worker thread (see NetworkBufferPool)
+struct FrontEndThreadBufferStats {
+    size_t rbufs_pooled;
+    size_t rbufs_pooled_bytes;
+    size_t rbufs_in_use;
+    size_t wbufs_pooled;
+    size_t wbufs_pooled_bytes;
+    size_t wbufs_in_use;
+};
+
+/// Get the buffer pool counters of each of the worker threads
+std::vector<FrontEndThreadBufferStats> get_worker_thread_buffer_stats();
+
 void notify_dispatcher();
 void notify_thread_bucket_deletion(FrontEndThread& me);
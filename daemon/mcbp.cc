@@ -19,6 +19,7 @@
 #include "buckets.h"
 #include "cookie.h"
 #include "debug_helpers.h"
+#include "front_end_thread.h"
 #include "memcached.h"
 #include "settings.h"
 #include "utilities/logtags.h"
@@ -258,7 +259,8 @@ void mcbp_collect_timings(Cookie& cookie) {
     cookie.getTracer().end(cb::tracing::TraceCode::REQUEST, endTime);
 
     // aggregated timing for all buckets
-    all_buckets[0].timings.collect(opcode, elapsed);
+    const auto thread = c->getThread()->index;
+    all_buckets[0].timings.collect(opcode, elapsed, thread);
 
     // timing for current bucket
     const auto bucketid = c->getBucketIndex();
@@ -267,7 +269,7 @@ void mcbp_collect_timings(Cookie& cookie) {
      * to delete the bucket you're associated with and your're idle.
      */
     if (bucketid != 0) {
-        all_buckets[bucketid].timings.collect(opcode, elapsed);
+        all_buckets[bucketid].timings.collect(opcode, elapsed, thread);
     }
 
     // Log operations taking longer than the "slow" threshold for the opcode.
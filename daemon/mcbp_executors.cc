@@ -21,6 +21,7 @@
 #include "config_parse.h"
 #include "debug_helpers.h"
 #include "external_auth_manager_thread.h"
+#include "front_end_thread.h"
 #include "ioctl.h"
 #include "mc_time.h"
 #include "mcaudit.h"
@@ -67,11 +68,15 @@ std::array<bool, 0x100>&  topkey_commands = get_mcbp_topkeys();
 void update_topkeys(const Cookie& cookie) {
     const auto opcode = cookie.getHeader().getOpcode();
     if (topkey_commands[opcode]) {
-        const auto index = cookie.getConnection().getBucketIndex();
+        auto& connection = cookie.getConnection();
+        const auto index = connection.getBucketIndex();
+        const auto* thread = connection.getThread();
         const auto key = cookie.getRequestKey();
-        if (all_buckets[index].topkeys != nullptr) {
-            all_buckets[index].topkeys->updateKey(
-                    key.data(), key.size(), mc_time_get_current_time());
+        if (all_buckets[index].topkeys != nullptr && thread != nullptr) {
+            all_buckets[index].topkeys->updateKey(key.data(),
+                                                  key.size(),
+                                                  mc_time_get_current_time(),
+                                                  thread->index);
         }
     }
 }
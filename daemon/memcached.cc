@@ -105,6 +105,12 @@
 #include <time.h>
 #include <vector>
 
+#if defined(__linux__) && defined(SO_REUSEPORT)
+// Linux balances incoming connections between the sockets bound to the
+// same address with SO_REUSEPORT (other platforms hand them all to one)
+#define USE_REUSEPORT_LISTENERS 1
+#endif
+
 /**
  * All of the buckets in couchbase is stored in this array.
  */
@@ -392,6 +398,7 @@ static void stats_init(void) {
     stats.total_conns.reset();
     stats.daemon_conns.reset();
     stats.rejected_conns.reset();
+    stats.offloaded_commands.reset();
     stats.curr_conns.store(0, std::memory_order_relaxed);
 }
 
@@ -408,6 +415,7 @@ void stats_reset(Cookie& cookie) {
     }
     stats.total_conns.reset();
     stats.rejected_conns.reset();
+    stats.offloaded_commands.reset();
     threadlocal_stats_reset(cookie.getConnection().getBucket().stats);
     bucket_reset_stats(cookie);
 }
@@ -658,7 +666,7 @@ uint64_t get_listen_disabled_num(void) {
     return listen_state.num_disable;
 }
 
-void disable_listen() {
+void disable_listen(FrontEndThread* thread) {
     {
         std::lock_guard<std::mutex> guard(listen_state.mutex);
         listen_state.disabled = true;
@@ -666,8 +674,13 @@ void disable_listen() {
         ++listen_state.num_disable;
     }
 
+    // Only touch our own sockets: removing another thread's event would
+    // wait for its callback (which may be in here too) to complete. The
+    // other threads disable theirs as they hit the limit themselves.
     for (auto& connection : listen_conn) {
-        connection->disable();
+        if (connection->getThread() == thread) {
+            connection->disable();
+        }
     }
 }
 
@@ -810,6 +823,12 @@ void listen_event_handler(evutil_socket_t, short which, void *arg) {
     auto& c = *reinterpret_cast<ServerSocket*>(arg);
 
     if (memcached_shutdown) {
+        if (c.getThread() != nullptr) {
+            // The front-end thread is stopped through its notification
+            // channel, just stop accepting new connections.
+            c.disable();
+            return;
+        }
         // Someone requested memcached to shut down. The listen thread should
         // be stopped immediately to avoid new connections
         LOG_INFO("Stopping listen thread");
@@ -930,6 +949,18 @@ static SOCKET new_server_socket(struct addrinfo *ai, bool tcp_nodelay) {
                     cb_strerror(cb::net::get_socket_error()));
     }
 
+#ifdef USE_REUSEPORT_LISTENERS
+    if (settings.isReuseportListenersEnabled() &&
+        cb::net::setsockopt(sfd,
+                            SOL_SOCKET,
+                            SO_REUSEPORT,
+                            reinterpret_cast<const void*>(&flags),
+                            sizeof(flags)) != 0) {
+        LOG_WARNING("setsockopt(SO_REUSEPORT): {}",
+                    cb_strerror(cb::net::get_socket_error()));
+    }
+#endif
+
     if (cb::net::setsockopt(sfd,
                             SOL_SOCKET,
                             SO_KEEPALIVE,
@@ -1185,6 +1216,79 @@ static bool server_sockets(bool management) {
     return success;
 }
 
+/**
+ * With reuseport_listeners each front-end thread accepts its own clients,
+ * so that the accept rate isn't limited by the dispatcher thread. Move the
+ * sockets created by create_listen_sockets() from the dispatcher over to
+ * the first front-end thread (they may already have clients queued), and
+ * give each of the other front-end threads a socket bound to the same
+ * address in the same SO_REUSEPORT group.
+ */
+static void create_worker_listen_sockets() {
+    if (!settings.isReuseportListenersEnabled()) {
+        return;
+    }
+#ifdef USE_REUSEPORT_LISTENERS
+    const auto nthreads = settings.getNumWorkerThreads();
+    std::vector<std::unique_ptr<ServerSocket>> sockets;
+    for (auto& dispatcher_socket : listen_conn) {
+        const auto sfd = dispatcher_socket->getSocket();
+        const auto port = dispatcher_socket->getPort();
+        const auto family = dispatcher_socket->getFamily();
+        const auto interf = dispatcher_socket->getInterface();
+
+        sockaddr_storage addr{};
+        socklen_t addrlen = sizeof(addr);
+        if (getsockname(sfd, reinterpret_cast<sockaddr*>(&addr), &addrlen) ==
+            SOCKET_ERROR) {
+            FATAL_ERROR(EX_OSERR,
+                        "Failed to get the address of {}: {}",
+                        dispatcher_socket->getSockname(),
+                        cb_strerror(cb::net::get_socket_error()));
+        }
+
+        dispatcher_socket.reset();
+        auto& first = get_worker_thread(0);
+        sockets.emplace_back(std::make_unique<ServerSocket>(
+                sfd, first.base, port, family, interf, &first));
+
+        addrinfo ai = {};
+        ai.ai_family = family;
+        ai.ai_socktype = SOCK_STREAM;
+        ai.ai_protocol = IPPROTO_TCP;
+        for (size_t ii = 1; ii < nthreads; ++ii) {
+            auto fd = new_server_socket(&ai, interf.tcp_nodelay);
+            if (fd == INVALID_SOCKET) {
+                FATAL_ERROR(EX_OSERR,
+                            "Failed to create listening socket for {}",
+                            cb::net::to_string(&addr, addrlen));
+            }
+            if (bind(fd, reinterpret_cast<sockaddr*>(&addr), addrlen) ==
+                SOCKET_ERROR) {
+                FATAL_ERROR(EX_OSERR,
+                            "Failed to bind to {} - {}",
+                            cb::net::to_string(&addr, addrlen),
+                            cb_strerror(cb::net::get_socket_error()));
+            }
+
+            auto& thread = get_worker_thread(ii);
+            sockets.emplace_back(std::make_unique<ServerSocket>(
+                    fd, thread.base, port, family, interf, &thread));
+            stats.daemon_conns++;
+            stats.curr_conns.fetch_add(1, std::memory_order_relaxed);
+            // The port was already added (and its listener counted in
+            // curr_conns) for the dispatcher's socket.
+        }
+    }
+    listen_conn = std::move(sockets);
+    LOG_INFO("Each front-end thread accepts its own clients");
+#else
+    LOG_WARNING(
+            "reuseport_listeners is not supported on this platform, all "
+            "clients are accepted by the dispatcher thread");
+#endif
+}
+
 static void create_listen_sockets(bool management) {
     if (!server_sockets(management)) {
         FATAL_ERROR(
@@ -1523,7 +1627,8 @@ struct ServerCookieApi : public ServerCookieIface {
             // worker threads), so put the connection in the pool of pending
             // IO and have the system retry the operation for the connection
             connection.decrementRefcount();
-            notify = add_conn_to_pending_io_list(&connection, ENGINE_SUCCESS);
+            notify = add_conn_to_pending_io_list(
+                    &connection, &cookie, ENGINE_SUCCESS);
         }
 
         // kick the thread in the butt
@@ -1649,6 +1754,10 @@ public:
         hooks_api.release_free_memory = AllocHooks::release_free_memory;
         hooks_api.enable_thread_cache = AllocHooks::enable_thread_cache;
         hooks_api.get_allocator_property = AllocHooks::get_allocator_property;
+        hooks_api.create_arena = AllocHooks::create_arena;
+        hooks_api.release_arena = AllocHooks::release_arena;
+        hooks_api.switch_arena = AllocHooks::switch_arena;
+        hooks_api.get_arena_allocated = AllocHooks::get_arena_allocated;
 
         core = &core_api;
         callback = &callback_api;
@@ -1736,7 +1845,9 @@ void CreateBucketThread::create() {
         all_buckets[ii].type = type;
         strcpy(all_buckets[ii].name, name.c_str());
         try {
-            all_buckets[ii].topkeys = new TopKeys(settings.getTopkeysSize());
+            all_buckets[ii].topkeys =
+                    new TopKeys(settings.getTopkeysSize(),
+                                settings.getNumWorkerThreads() + 1);
         } catch (const std::bad_alloc &) {
             result = ENGINE_ENOMEM;
             LOG_WARNING("{} Create bucket [{}] failed - out of memory",
@@ -2003,6 +2114,7 @@ static void initialize_buckets(void) {
     size_t numthread = settings.getNumWorkerThreads() + 1;
     for (auto &b : all_buckets) {
         b.stats.resize(numthread);
+        b.timings.set_num_threads(numthread);
     }
 
     // To make the life easier for us in the code, index 0
@@ -2357,6 +2469,7 @@ extern "C" int memcached_main(int argc, char **argv) {
 
     /* start up worker threads if MT mode */
     thread_init(settings.getNumWorkerThreads(), main_base, dispatch_event_handler);
+    create_worker_listen_sockets();
 
     executorPool =
             std::make_unique<ExecutorPool>(settings.getNumWorkerThreads());
@@ -59,6 +59,7 @@ class Pipe;
 }
 class Cookie;
 class Connection;
+struct FrontEndThread;
 struct thread_stats;
 
 void associate_initial_bucket(Connection& connection);
@@ -77,6 +78,14 @@ void threads_shutdown();
 void threads_cleanup();
 
 void dispatch_conn_new(SOCKET sfd, in_port_t parent_port);
+/**
+ * Create a connection for a client accepted by the given front-end thread
+ * (on its own listening socket) and serve it from that thread. Must be
+ * called by the thread.
+ */
+void accept_conn_new(FrontEndThread& thread,
+                     SOCKET sfd,
+                     in_port_t parent_port);
 
 /* Lock wrappers for cache functions that are called from main loop. */
 int is_listen_thread(void);
@@ -86,7 +95,9 @@ void threadlocal_stats_reset(std::vector<thread_stats>& thread_stats);
 void notify_io_complete(gsl::not_null<const void*> cookie,
                         ENGINE_ERROR_CODE status);
 void safe_close(SOCKET sfd);
-int add_conn_to_pending_io_list(Connection* c, ENGINE_ERROR_CODE status);
+int add_conn_to_pending_io_list(Connection* c,
+                                Cookie* cookie,
+                                ENGINE_ERROR_CODE status);
 void event_handler(evutil_socket_t fd, short which, void *arg);
 void listen_event_handler(evutil_socket_t, short, void *);
 
@@ -118,7 +129,12 @@ void shutdown_server();
 bool associate_bucket(Connection& connection, const char* name);
 void disassociate_bucket(Connection& connection);
 
-void disable_listen();
+/**
+ * Stop accepting clients on the listening sockets served by the given
+ * front-end thread (nullptr for the dispatcher's), until enough
+ * connections are closed. Must be called by that thread.
+ */
+void disable_listen(FrontEndThread* thread);
 bool is_listen_disabled();
 uint64_t get_listen_disabled_num();
 
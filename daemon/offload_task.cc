@@ -0,0 +1,51 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include "config.h"
+#include "offload_task.h"
+#include "connection.h"
+#include "cookie.h"
+#include "memcached.h"
+#include "settings.h"
+#include <logger/logger.h>
+
+OffloadTask::OffloadTask(Cookie& cookie_,
+                         std::function<ENGINE_ERROR_CODE()> function_)
+    : cookie(cookie_), function(std::move(function_)) {
+}
+
+Task::Status OffloadTask::execute() {
+    try {
+        status = function();
+    } catch (const std::bad_alloc&) {
+        status = ENGINE_ENOMEM;
+    } catch (const std::exception& exception) {
+        LOG_WARNING("{}: OffloadTask::execute(): An exception occurred: {}",
+                    cookie.getConnection().getId(),
+                    exception.what());
+        status = ENGINE_FAILED;
+    }
+    return Task::Status::Finished;
+}
+
+void OffloadTask::notifyExecutionComplete() {
+    notify_io_complete(static_cast<void*>(&cookie), ENGINE_SUCCESS);
+}
+
+bool shouldOffload(size_t nbytes) {
+    const auto threshold = settings.getOffloadThreshold();
+    return threshold != 0 && nbytes >= threshold;
+}
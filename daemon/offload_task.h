@@ -0,0 +1,65 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#pragma once
+
+#include "task.h"
+
+#include <memcached/engine_error.h>
+
+#include <functional>
+
+class Cookie;
+
+/**
+ * The OffloadTask runs a CPU intensive part of a command (for instance
+ * inflating a large document) on the executor pool rather than on the
+ * front-end thread, so that it doesn't stall all of the other connections
+ * served by that thread. The cookie is notified once the function has run,
+ * and the command picks up the result with getStatus().
+ *
+ * The function must only touch state owned by the command (the front-end
+ * thread won't touch the command while it is blocked).
+ */
+class OffloadTask : public Task {
+public:
+    OffloadTask() = delete;
+
+    OffloadTask(const OffloadTask&) = delete;
+
+    OffloadTask(Cookie& cookie_, std::function<ENGINE_ERROR_CODE()> function_);
+
+    Status execute() override;
+
+    void notifyExecutionComplete() override;
+
+    ENGINE_ERROR_CODE getStatus() const {
+        return status;
+    }
+
+protected:
+    Cookie& cookie;
+    std::function<ENGINE_ERROR_CODE()> function;
+    ENGINE_ERROR_CODE status = ENGINE_FAILED;
+};
+
+/**
+ * Should a command working on the given amount of data offload the
+ * work to the executor pool (see the offload_threshold setting)?
+ *
+ * @param nbytes the (estimated) number of bytes the work processes
+ */
+bool shouldOffload(size_t nbytes);
@@ -48,6 +48,9 @@ ENGINE_ERROR_CODE AppendPrependCommandContext::step() {
         case State::InflateInputData:
             ret = inflateInputData();
             break;
+        case State::EngineAppendPrepend:
+            ret = engineAppendPrepend();
+            break;
         case State::GetItem:
             ret = getItem();
             break;
@@ -87,25 +90,61 @@ ENGINE_ERROR_CODE AppendPrependCommandContext::validateInput() {
     if (mcbp::datatype::is_snappy(datatype)) {
         state = State::InflateInputData;
     } else {
-        state = State::GetItem;
+        state = State::EngineAppendPrepend;
     }
     return ENGINE_SUCCESS;
 }
 
 ENGINE_ERROR_CODE AppendPrependCommandContext::inflateInputData() {
-    try {
-        if (!cb::compression::inflate(cb::compression::Algorithm::Snappy,
-                                      value,
-                                      inputbuffer)) {
-            return ENGINE_EINVAL;
+    const auto size = cb::compression::get_uncompressed_length(
+            cb::compression::Algorithm::Snappy, value);
+    const auto ret = runOffloadable(size, [this]() {
+        try {
+            if (!cb::compression::inflate(cb::compression::Algorithm::Snappy,
+                                          value,
+                                          inputbuffer)) {
+                return ENGINE_EINVAL;
+            }
+        } catch (const std::bad_alloc&) {
+            return ENGINE_ENOMEM;
         }
+        return ENGINE_SUCCESS;
+    });
+
+    if (ret == ENGINE_SUCCESS) {
         value = inputbuffer;
-        state = State::GetItem;
-    } catch (const std::bad_alloc&) {
-        return ENGINE_ENOMEM;
+        state = State::EngineAppendPrepend;
     }
+    return ret;
+}
 
-    return ENGINE_SUCCESS;
+ENGINE_ERROR_CODE AppendPrependCommandContext::engineAppendPrepend() {
+    uint64_t ncas = cas;
+    mutation_descr_t info = {};
+    auto ret = bucket_append_prepend(cookie,
+                                     key,
+                                     value,
+                                     mode == Mode::Append
+                                             ? AppendPrependMode::Append
+                                             : AppendPrependMode::Prepend,
+                                     ncas,
+                                     vbucket,
+                                     info);
+    switch (ret) {
+    case ENGINE_ENOTSUP:
+        // The engine can't do it for us (at least not for this document);
+        // use the generic get / allocate / store implementation.
+        state = State::GetItem;
+        return ENGINE_SUCCESS;
+    case ENGINE_SUCCESS:
+        update_topkeys(cookie);
+        sendMutationResponse(ncas, info);
+        state = State::Done;
+        break;
+    default:
+        break;
+    }
+    return ret;
 }
 
 ENGINE_ERROR_CODE AppendPrependCommandContext::getItem() {
@@ -225,25 +264,16 @@ ENGINE_ERROR_CODE AppendPrependCommandContext::storeItem() {
 
     if (ret == ENGINE_SUCCESS) {
         update_topkeys(cookie);
-        cookie.setCas(ncas);
+        mutation_descr_t info = {};
         if (connection.isSupportsMutationExtras()) {
             item_info newItemInfo;
             if (!bucket_get_item_info(
                         connection, newitem.get(), &newItemInfo)) {
                 return ENGINE_FAILED;
             }
-            extras.vbucket_uuid = htonll(newItemInfo.vbucket_uuid);
-            extras.seqno = htonll(newItemInfo.seqno);
-            cookie.sendResponse(
-                    cb::mcbp::Status::Success,
-                    {reinterpret_cast<const char*>(&extras), sizeof(extras)},
-                    {},
-                    {},
-                    cb::mcbp::Datatype::Raw,
-                    ncas);
-        } else {
-            cookie.sendResponse(cb::mcbp::Status::Success);
+            info = {newItemInfo.vbucket_uuid, newItemInfo.seqno};
         }
+        sendMutationResponse(ncas, info);
         state = State::Done;
     } else if (ret == ENGINE_KEY_EEXISTS && cas == 0) {
         state = State::Reset;
@@ -252,6 +282,24 @@ ENGINE_ERROR_CODE AppendPrependCommandContext::storeItem() {
     return ret;
 }
 
+void AppendPrependCommandContext::sendMutationResponse(
+        uint64_t ncas, const mutation_descr_t& info) {
+    cookie.setCas(ncas);
+    if (connection.isSupportsMutationExtras()) {
+        extras.vbucket_uuid = htonll(info.vbucket_uuid);
+        extras.seqno = htonll(info.seqno);
+        cookie.sendResponse(
+                cb::mcbp::Status::Success,
+                {reinterpret_cast<const char*>(&extras), sizeof(extras)},
+                {},
+                {},
+                cb::mcbp::Datatype::Raw,
+                ncas);
+    } else {
+        cookie.sendResponse(cb::mcbp::Status::Success);
+    }
+}
+
 ENGINE_ERROR_CODE AppendPrependCommandContext::reset() {
     olditem.reset();
     newitem.reset();
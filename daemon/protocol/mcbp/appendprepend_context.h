@@ -24,11 +24,13 @@
 
 /**
  * The AppendPrependCommandContext is a state machine used by the memcached
- * core to implement append and prepend by fetching the document from the
- * underlying engine, performing the operation and try to use CAS to replace
- * the document in the underlying engine. Multiple clients operating on the
- * same document will be detected by the CAS store operation returning EEXISTS,
- * and we just retry the operation.
+ * core to implement append and prepend. The underlying engine is first asked
+ * to perform the operation itself (EngineIface::append_prepend); if it
+ * doesn't support that (for the given document) we fall back to fetching the
+ * document from the underlying engine, performing the operation and try to
+ * use CAS to replace the document in the underlying engine. Multiple clients
+ * operating on the same document will be detected by the CAS store operation
+ * returning EEXISTS, and we just retry the operation.
  */
 class AppendPrependCommandContext : public SteppableCommandContext {
 public:
@@ -43,6 +45,8 @@ public:
         // If the client sends compressed data we need to inflate the
         // input data before we can do anything
             InflateInputData,
+        // Try to let the engine perform the operation directly
+            EngineAppendPrepend,
         // Look up the item to operate on
             GetItem,
         // Allocate the destination object
@@ -69,6 +73,8 @@ protected:
 
     ENGINE_ERROR_CODE inflateInputData();
 
+    ENGINE_ERROR_CODE engineAppendPrepend();
+
     ENGINE_ERROR_CODE getItem();
 
     ENGINE_ERROR_CODE allocateNewItem();
@@ -78,6 +84,9 @@ protected:
     ENGINE_ERROR_CODE reset();
 
 private:
+    /// Send the success response for the mutation to the client
+    void sendMutationResponse(uint64_t ncas, const mutation_descr_t& info);
+
     const Mode mode;
     const DocKey key;
     cb::const_char_buffer value;
@@ -44,17 +44,12 @@ void get_cluster_config_executor(Cookie& cookie) {
         return;
     }
 
-    auto pair = bucket.clusterConfiguration.getConfiguration();
-    if (pair.first == -1) {
+    auto config = bucket.clusterConfiguration.getConfiguration();
+    if (!config) {
         cookie.sendResponse(cb::mcbp::Status::KeyEnoent);
     } else {
-        cookie.sendResponse(cb::mcbp::Status::Success,
-                            {},
-                            {},
-                            {pair.second->data(), pair.second->size()},
-                            cb::mcbp::Datatype::JSON,
-                            0);
-        connection.setClustermapRevno(pair.first);
+        cookie.sendClusterConfiguration(cb::mcbp::Status::Success,
+                                        std::move(config));
     }
 }
 
@@ -90,12 +85,11 @@ void set_cluster_config_executor(Cookie& cookie) {
         auto payload = req.getValue();
         cb::const_char_buffer conf{
                 reinterpret_cast<const char*>(payload.data()), payload.size()};
-        bucket.clusterConfiguration.setConfiguration(conf);
+        bucket.clusterConfiguration.setConfiguration(bucket.name, conf);
         cookie.setCas(cas);
         cookie.sendResponse(cb::mcbp::Status::Success);
 
-        const long revision =
-                bucket.clusterConfiguration.getConfiguration().first;
+        const long revision = bucket.clusterConfiguration.getRevision();
 
         LOG_INFO(
                 "{}: {} Updated cluster configuration for bucket [{}]. New "
@@ -129,6 +129,27 @@ cb::EngineErrorCasPair bucket_store_if(Cookie& cookie,
     return ret;
 }
 
+ENGINE_ERROR_CODE bucket_append_prepend(Cookie& cookie,
+                                        const DocKey& key,
+                                        cb::const_char_buffer value,
+                                        AppendPrependMode mode,
+                                        uint64_t& cas,
+                                        Vbid vbucket,
+                                        mutation_descr_t& mut_info) {
+    auto& c = cookie.getConnection();
+    auto ret = c.getBucketEngine()->append_prepend(
+            &cookie, key, value, mode, cas, vbucket, mut_info);
+    if (ret == ENGINE_SUCCESS) {
+        cb::audit::document::add(cookie,
+                                 cb::audit::document::Operation::Modify);
+    } else if (ret == ENGINE_DISCONNECT) {
+        LOG_WARNING("{}: {} bucket_append_prepend return ENGINE_DISCONNECT",
+                    c.getId(),
+                    c.getDescription());
+    }
+    return ret;
+}
+
 ENGINE_ERROR_CODE bucket_remove(Cookie& cookie,
                                 const DocKey& key,
                                 uint64_t& cas,
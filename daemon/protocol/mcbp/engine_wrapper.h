@@ -68,6 +68,14 @@ cb::EngineErrorCasPair bucket_store_if(
         cb::StoreIfPredicate predicate,
         DocumentState document_state = DocumentState::Alive);
 
+ENGINE_ERROR_CODE bucket_append_prepend(Cookie& cookie,
+                                        const DocKey& key,
+                                        cb::const_char_buffer value,
+                                        AppendPrependMode mode,
+                                        uint64_t& cas,
+                                        Vbid vbucket,
+                                        mutation_descr_t& mut_info);
+
 ENGINE_ERROR_CODE bucket_remove(Cookie& cookie,
                                 const DocKey& key,
                                 uint64_t& cas,
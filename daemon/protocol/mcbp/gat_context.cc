@@ -82,19 +82,26 @@ ENGINE_ERROR_CODE GatCommandContext::getAndTouchItem() {
 }
 
 ENGINE_ERROR_CODE GatCommandContext::inflateItem() {
-    try {
-        if (!cb::compression::inflate(cb::compression::Algorithm::Snappy,
-                                      payload, buffer)) {
-            LOG_WARNING("{}: Failed to inflate item", connection.getId());
-            return ENGINE_FAILED;
+    const auto size = cb::compression::get_uncompressed_length(
+            cb::compression::Algorithm::Snappy, payload);
+    const auto ret = runOffloadable(size, [this]() {
+        try {
+            if (!cb::compression::inflate(cb::compression::Algorithm::Snappy,
+                                          payload, buffer)) {
+                LOG_WARNING("{}: Failed to inflate item", connection.getId());
+                return ENGINE_FAILED;
+            }
+        } catch (const std::bad_alloc&) {
+            return ENGINE_ENOMEM;
         }
+        return ENGINE_SUCCESS;
+    });
+
+    if (ret == ENGINE_SUCCESS) {
         payload = buffer;
-    } catch (const std::bad_alloc&) {
-        return ENGINE_ENOMEM;
+        state = State::SendResponse;
     }
-
-    state = State::SendResponse;
-    return ENGINE_SUCCESS;
+    return ret;
 }
 
 ENGINE_ERROR_CODE GatCommandContext::sendResponse() {
@@ -20,6 +20,7 @@
 
 #include <daemon/buckets.h>
 #include <daemon/mcbp.h>
+#include <cJSON_utils.h>
 #include <logger/logger.h>
 #include <mcbp/protocol/request.h>
 
@@ -34,7 +35,7 @@
  *         and the second being the histogram (only valid if the first
  *         parameter is ENGINE_SUCCESS)
  */
-static std::pair<ENGINE_ERROR_CODE, TimingHistogram> get_timings(
+static std::pair<ENGINE_ERROR_CODE, CommandTimingHistogram> get_timings(
         Cookie& cookie, const Bucket& bucket, uint8_t opcode) {
     // Don't creata a new privilege context if the one we've got is for the
     // connected bucket:
@@ -43,7 +44,7 @@ static std::pair<ENGINE_ERROR_CODE, TimingHistogram> get_timings(
         auto ret = mcbp::checkPrivilege(cookie,
                                         cb::rbac::Privilege::SimpleStats);
         if (ret != ENGINE_SUCCESS) {
-            return std::make_pair(ENGINE_EACCESS, TimingHistogram{});
+            return std::make_pair(ENGINE_EACCESS, CommandTimingHistogram{});
         }
     } else {
         // Check to see if we've got access to the bucket
@@ -61,7 +62,7 @@ static std::pair<ENGINE_ERROR_CODE, TimingHistogram> get_timings(
         }
 
         if (!access) {
-            return std::make_pair(ENGINE_EACCESS, TimingHistogram{});
+            return std::make_pair(ENGINE_EACCESS, CommandTimingHistogram{});
         }
     }
 
@@ -80,10 +81,10 @@ static std::pair<ENGINE_ERROR_CODE, TimingHistogram> get_timings(
  * @param opcode The opcode we're interested in
  * @param bucketname The name of the bucket we want
  */
-static std::pair<ENGINE_ERROR_CODE, TimingHistogram> maybe_get_timings(
+static std::pair<ENGINE_ERROR_CODE, CommandTimingHistogram> maybe_get_timings(
     Cookie& cookie, const Bucket& bucket, uint8_t opcode, const std::string& bucketname) {
 
-    std::pair<ENGINE_ERROR_CODE, TimingHistogram> ret = std::make_pair(ENGINE_KEY_ENOENT, TimingHistogram{});
+    std::pair<ENGINE_ERROR_CODE, CommandTimingHistogram> ret = std::make_pair(ENGINE_KEY_ENOENT, CommandTimingHistogram{});
     std::lock_guard<std::mutex> guard(bucket.mutex);
     if (bucket.type != BucketType::NoBucket &&
         bucket.state == BucketState::Ready && bucketname == bucket.name) {
@@ -95,23 +96,37 @@ static std::pair<ENGINE_ERROR_CODE, TimingHistogram> maybe_get_timings(
 
 /**
  * Get the aggregated timings across "all" buckets that the connected
- * client has access to.
+ * client has access to. Each bucket's percentiles are included in the
+ * "buckets" object so a single slow bucket can be spotted.
  */
 static std::pair<ENGINE_ERROR_CODE, std::string> get_aggregated_timings(
         Cookie& cookie, uint8_t opcode) {
-    TimingHistogram timings;
+    CommandTimingHistogram timings;
     bool found = false;
+    unique_cJSON_ptr buckets(cJSON_CreateObject());
 
     for (auto& bucket : all_buckets) {
         auto bt = maybe_get_timings(cookie, bucket, opcode, bucket.name);
         if (bt.first == ENGINE_SUCCESS) {
             timings += bt.second;
             found = true;
+
+            const auto total = bt.second.get_total();
+            if (total != 0) {
+                cJSON* entry = cJSON_CreateObject();
+                cJSON_AddNumberToObject(entry, "total", double(total));
+                cJSON_AddItemToObject(entry,
+                                      "percentiles",
+                                      bt.second.percentiles_to_json().release());
+                cJSON_AddItemToObject(buckets.get(), bucket.name, entry);
+            }
         }
     }
 
     if (found) {
-        return std::make_pair(ENGINE_SUCCESS, timings.to_string());
+        auto json = timings.to_json();
+        cJSON_AddItemToObject(json.get(), "buckets", buckets.release());
+        return std::make_pair(ENGINE_SUCCESS, to_string(json.get(), false));
     }
 
     // We didn't have access to any buckets!
@@ -147,7 +162,7 @@ std::pair<ENGINE_ERROR_CODE, std::string> get_cmd_timer(Cookie& cookie) {
     }
 
     // The user specified a bucket... let's locate the bucket
-    std::pair<ENGINE_ERROR_CODE, TimingHistogram> ret;
+    std::pair<ENGINE_ERROR_CODE, CommandTimingHistogram> ret;
 
     for (auto& b : all_buckets) {
         ret = maybe_get_timings(cookie, b, opcode, bucket);
@@ -23,10 +23,13 @@
 #include <daemon/mcaudit.h>
 #include <daemon/mcbp.h>
 #include <daemon/memcached.h>
+#include <daemon/settings.h>
 #include <logger/logger.h>
 #include <xattr/utils.h>
 #include <gsl/gsl>
 
+#include <algorithm>
+
 ENGINE_ERROR_CODE GetCommandContext::getItem() {
     const auto key = cookie.getRequestKey();
     auto ret = bucket_get(cookie, key, vbucket);
@@ -48,6 +51,8 @@ ENGINE_ERROR_CODE GetCommandContext::getItem() {
 
         if (need_inflate) {
             state = State::InflateItem;
+        } else if (shouldCompressItem()) {
+            state = State::CompressItem;
         } else {
             state = State::SendResponse;
         }
@@ -60,15 +65,74 @@ ENGINE_ERROR_CODE GetCommandContext::getItem() {
 }
 
 ENGINE_ERROR_CODE GetCommandContext::inflateItem() {
-    try {
-        if (!cb::compression::inflate(cb::compression::Algorithm::Snappy,
-                                      payload, buffer)) {
-            LOG_WARNING("{}: Failed to inflate item", connection.getId());
-            return ENGINE_FAILED;
+    const auto size = cb::compression::get_uncompressed_length(
+            cb::compression::Algorithm::Snappy, payload);
+    const auto ret = runOffloadable(size, [this]() {
+        try {
+            if (!cb::compression::inflate(cb::compression::Algorithm::Snappy,
+                                          payload, buffer)) {
+                LOG_WARNING("{}: Failed to inflate item", connection.getId());
+                return ENGINE_FAILED;
+            }
+        } catch (const std::bad_alloc&) {
+            return ENGINE_ENOMEM;
         }
+        return ENGINE_SUCCESS;
+    });
+
+    if (ret == ENGINE_SUCCESS) {
         payload = buffer;
-    } catch (const std::bad_alloc&) {
-        return ENGINE_ENOMEM;
+        state = State::SendResponse;
+    }
+    return ret;
+}
+
+bool GetCommandContext::shouldCompressItem() const {
+    if (mcbp::datatype::is_snappy(info.datatype) ||
+        !connection.isSnappyEnabled()) {
+        return false;
+    }
+    const auto threshold = settings.getResponseCompressionThreshold();
+    return threshold != 0 && payload.len >= threshold;
+}
+
+ENGINE_ERROR_CODE GetCommandContext::compressItem() {
+    auto body = payload;
+    if (mcbp::datatype::is_xattr(info.datatype)) {
+        body = cb::xattr::get_body(payload);
+    }
+
+    const auto ret = runOffloadable(body.len, [this, body]() {
+        try {
+            if (!cb::compression::deflate(
+                        cb::compression::Algorithm::Snappy, body, buffer)) {
+                return ENGINE_FAILED;
+            }
+        } catch (const std::bad_alloc&) {
+            return ENGINE_ENOMEM;
+        }
+        return ENGINE_SUCCESS;
+    });
+
+    if (ret == ENGINE_EWOULDBLOCK) {
+        return ret;
+    }
+
+    // Failing to compress isn't fatal; just send the document uncompressed
+    if (ret == ENGINE_SUCCESS && buffer.size() != 0) {
+        const auto ratio = float(body.len) / float(buffer.size());
+        if (ratio >= bucket_min_compression_ratio(cookie)) {
+            auto* thread_stats = get_thread_stats(&connection);
+            thread_stats->cmd_get_compressed++;
+            thread_stats->bytes_get_compression_saved +=
+                    body.len - std::min(body.len, buffer.size());
+
+            // The xattrs were left behind in the uncompressed payload
+            payload = buffer;
+            info.datatype = protocol_binary_datatype_t(
+                    (info.datatype & ~PROTOCOL_BINARY_DATATYPE_XATTR) |
+                    PROTOCOL_BINARY_DATATYPE_SNAPPY);
+        }
     }
 
     state = State::SendResponse;
@@ -166,6 +230,9 @@ ENGINE_ERROR_CODE GetCommandContext::step() {
         case State::InflateItem:
             ret = inflateItem();
             break;
+        case State::CompressItem:
+            ret = compressItem();
+            break;
         case State::SendResponse:
             ret = sendResponse();
             break;
@@ -37,6 +37,7 @@ public:
         GetItem,
         NoSuchItem,
         InflateItem,
+        CompressItem,
         SendResponse,
         Done
     };
@@ -81,7 +82,8 @@ protected:
      *
      * If the object isn't compressed (or it doesn't contain any xattrs and
      * the client won't freak out if we send compressed data) we'll progress
-     * into the State::SendResponse state.
+     * into the State::SendResponse state (via State::CompressItem if
+     * shouldCompressItem() says so).
      *
      * @return ENGINE_EWOULDBLOCK if the underlying engine needs to block
      *         ENGINE_SUCCESS if we want to continue to run the state diagram
@@ -110,6 +112,24 @@ protected:
      */
     ENGINE_ERROR_CODE inflateItem();
 
+    /**
+     * Should we try to compress the (uncompressed) document before sending
+     * it? That's the case if the client has negotiated Snappy and the
+     * document is at least response_compression_threshold bytes.
+     */
+    bool shouldCompressItem() const;
+
+    /**
+     * Snappy compress the document body before progressing to
+     * State::SendResponse. The compressed version is only used if the
+     * compression ratio is at least the bucket's min_compression_ratio;
+     * otherwise (or if compression fails) the document is sent as is.
+     *
+     * @return ENGINE_EWOULDBLOCK if the compression was offloaded
+     *         ENGINE_SUCCESS to go to the next state
+     */
+    ENGINE_ERROR_CODE compressItem();
+
     /**
      * Craft up the response message and send it to the client. Given that
      * the command context object lives until we start the next command
@@ -26,6 +26,7 @@
 #include <daemon/connection.h>
 #include <daemon/cookie.h>
 #include <daemon/executorpool.h>
+#include <daemon/front_end_thread.h>
 #include <daemon/mc_time.h>
 #include <daemon/mcaudit.h>
 #include <daemon/memcached.h>
@@ -43,6 +44,7 @@
 #include <platform/checked_snprintf.h>
 
 #include <gsl/gsl>
+#include <array>
 
 /*************************** ADD STAT CALLBACKS ***************************/
 
@@ -230,11 +232,17 @@ static ENGINE_ERROR_CODE server_stats(ADD_STAT add_stat_callback,
         add_stat(cookie, add_stat_callback, "bytes_read", thread_stats.bytes_read);
         add_stat(cookie, add_stat_callback, "bytes_written",
                  thread_stats.bytes_written);
+        add_stat(cookie, add_stat_callback, "cmd_get_compressed",
+                 thread_stats.cmd_get_compressed);
+        add_stat(cookie, add_stat_callback, "bytes_get_compression_saved",
+                 thread_stats.bytes_get_compression_saved);
         add_stat(cookie, add_stat_callback, "accepting_conns",
                  is_listen_disabled() ? 0 : 1);
         add_stat(cookie, add_stat_callback, "listen_disabled_num",
                  get_listen_disabled_num());
         add_stat(cookie, add_stat_callback, "rejected_conns", stats.rejected_conns);
+        add_stat(cookie, add_stat_callback, "offloaded_commands",
+                 stats.offloaded_commands);
         add_stat(cookie, add_stat_callback, "threads", settings.getNumWorkerThreads());
         add_stat(cookie, add_stat_callback, "conn_yields", thread_stats.conn_yields);
         add_stat(cookie, add_stat_callback, "rbufs_allocated",
@@ -499,7 +507,17 @@ static ENGINE_ERROR_CODE stat_reset_executor(const std::string& arg,
  * Handler for the <code>stats sched</code> used to get the
  * histogram for the scheduler histogram.
  *
- * @param arg - should be empty
+ * With the argument "notify" it returns the number of times each worker
+ * thread has been woken up by other threads (<code>N:wakeups</code>), and
+ * the number of notifications which didn't need to wake the thread as it
+ * was already about to wake up (<code>N:notifications_coalesced</code>).
+ *
+ * With the argument "buffers" it returns the number of network buffers
+ * each worker thread has pooled (and the bytes allocated for them), and
+ * the number of buffers held by its connections (<code>N:rbufs_*</code>
+ * and <code>N:wbufs_*</code>).
+ *
+ * @param arg - should be empty, "aggregate", "notify" or "buffers"
  * @param cookie the command context
  */
 static ENGINE_ERROR_CODE stat_sched_executor(const std::string& arg,
@@ -529,6 +547,40 @@ static ENGINE_ERROR_CODE stat_sched_executor(const std::string& arg,
                      gsl::narrow<uint32_t>(hist.size()),
                      &cookie);
         return ENGINE_SUCCESS;
+    } else if (arg == "notify") {
+        const auto notifyStats = get_worker_thread_notify_stats();
+        for (size_t ii = 0; ii < notifyStats.size(); ++ii) {
+            const auto prefix = std::to_string(ii) + ":";
+            add_stat(cookie,
+                     append_stats,
+                     (prefix + "wakeups").c_str(),
+                     std::to_string(notifyStats[ii].wakeups));
+            add_stat(cookie,
+                     append_stats,
+                     (prefix + "notifications_coalesced").c_str(),
+                     std::to_string(notifyStats[ii].coalesced));
+        }
+        return ENGINE_SUCCESS;
+    } else if (arg == "buffers") {
+        const auto bufferStats = get_worker_thread_buffer_stats();
+        for (size_t ii = 0; ii < bufferStats.size(); ++ii) {
+            const auto prefix = std::to_string(ii) + ":";
+            const auto& s = bufferStats[ii];
+            const std::array<std::pair<const char*, size_t>, 6> values = {
+                    {{"rbufs_pooled", s.rbufs_pooled},
+                     {"rbufs_pooled_bytes", s.rbufs_pooled_bytes},
+                     {"rbufs_in_use", s.rbufs_in_use},
+                     {"wbufs_pooled", s.wbufs_pooled},
+                     {"wbufs_pooled_bytes", s.wbufs_pooled_bytes},
+                     {"wbufs_in_use", s.wbufs_in_use}}};
+            for (const auto& value : values) {
+                add_stat(cookie,
+                         append_stats,
+                         (prefix + value.first).c_str(),
+                         std::to_string(value.second));
+            }
+        }
+        return ENGINE_SUCCESS;
     } else {
         return ENGINE_EINVAL;
     }
@@ -18,8 +18,10 @@
 
 #include <daemon/connection.h>
 #include <daemon/cookie.h>
+#include <daemon/executorpool.h>
 #include <daemon/front_end_thread.h>
 #include <daemon/memcached.h>
+#include <daemon/offload_task.h>
 #include <daemon/stats.h>
 #include <logger/logger.h>
 
@@ -85,3 +87,24 @@ void SteppableCommandContext::setDatatypeJSONFromValue(
         datatype &= ~PROTOCOL_BINARY_DATATYPE_JSON;
     }
 }
+
+ENGINE_ERROR_CODE SteppableCommandContext::runOffloadable(
+        size_t nbytes, std::function<ENGINE_ERROR_CODE()> function) {
+    if (offloadTask) {
+        // We've been notified that the offloaded function completed
+        const auto ret = offloadTask->getStatus();
+        offloadTask.reset();
+        return ret;
+    }
+
+    if (!shouldOffload(nbytes)) {
+        return function();
+    }
+
+    stats.offloaded_commands++;
+    offloadTask = std::make_shared<OffloadTask>(cookie, std::move(function));
+    std::shared_ptr<Task> task = offloadTask;
+    std::lock_guard<std::mutex> guard(task->getMutex());
+    executorPool->schedule(task, true);
+    return ENGINE_EWOULDBLOCK;
+}
@@ -21,11 +21,15 @@
 #include <memcached/types.h>
 #include <platform/sized_buffer.h>
 
+#include <functional>
+#include <memory>
+
 #include "command_context.h"
 
 // Forward declaration
 class Connection;
 class Cookie;
+class OffloadTask;
 
 /**
  * The steppable command context is an iterface to a command context
@@ -65,6 +69,23 @@ protected:
     void setDatatypeJSONFromValue(const cb::const_byte_buffer& value,
                                   protocol_binary_datatype_t& datatype);
 
+    /**
+     * Run a CPU intensive part of the command (for instance inflating a
+     * document) which operates on nbytes of data. If shouldOffload(nbytes)
+     * the function is run by the executor pool and ENGINE_EWOULDBLOCK is
+     * returned; the cookie is notified once it completes, and the state
+     * machine should then call runOffloadable() again (from the same
+     * state) to get the result of the function. Otherwise the function is
+     * run inline.
+     *
+     * The function may be run on a different thread, so it must only
+     * touch the state of this command context.
+     *
+     * @return the result of the function, or ENGINE_EWOULDBLOCK
+     */
+    ENGINE_ERROR_CODE runOffloadable(
+            size_t nbytes, std::function<ENGINE_ERROR_CODE()> function);
+
     /**
      * The cookie executing this command
      */
@@ -75,4 +96,10 @@ protected:
      * should be removed (it is part of the cookie))
      */
     Connection& connection;
+
+    /**
+     * The task running the offloaded function (if any), see
+     * runOffloadable()
+     */
+    std::shared_ptr<OffloadTask> offloadTask;
 };
@@ -28,6 +28,7 @@
 #include <platform/strerror.h>
 #include <exception>
 #include <memory>
+#include <mutex>
 #include <string>
 #ifndef WIN32
 #include <sys/resource.h>
@@ -37,7 +38,8 @@ ServerSocket::ServerSocket(SOCKET fd,
                            event_base* b,
                            in_port_t port,
                            sa_family_t fam,
-                           const NetworkInterface& interf)
+                           const NetworkInterface& interf,
+                           FrontEndThread* thr)
     : sfd(fd),
       listen_port(port),
       family(fam),
@@ -45,6 +47,8 @@ ServerSocket::ServerSocket(SOCKET fd,
       backlog(interf.backlog),
       ssl(!interf.ssl.cert.empty()),
       management(interf.management),
+      interface(interf),
+      thread(thr),
       ev(event_new(b,
                    sfd,
                    EV_READ | EV_PERSIST,
@@ -62,6 +66,7 @@ ServerSocket::~ServerSocket() {
 }
 
 void ServerSocket::enable() {
+    std::lock_guard<std::mutex> guard(mutex);
     if (!registered_in_libevent) {
         LOG_INFO("{} Listen on {}", sfd, sockname);
         if (cb::net::listen(sfd, backlog) == SOCKET_ERROR) {
@@ -81,6 +86,7 @@ void ServerSocket::enable() {
 }
 
 void ServerSocket::disable() {
+    std::lock_guard<std::mutex> guard(mutex);
     if (registered_in_libevent) {
         if (sfd != INVALID_SOCKET) {
             /*
@@ -122,7 +128,7 @@ void ServerSocket::acceptNewClient() {
             LOG_WARNING("Too many open files. Current limit: {}",
                         limit.rlim_cur);
 #endif
-            disable_listen();
+            disable_listen(thread);
         } else if (!cb::net::is_blocking(error)) {
             LOG_WARNING("Failed to accept new client: {}", cb_strerror(error));
         }
@@ -170,7 +176,11 @@ void ServerSocket::acceptNewClient() {
         return;
     }
 
-    dispatch_conn_new(client, listen_port);
+    if (thread == nullptr) {
+        dispatch_conn_new(client, listen_port);
+    } else {
+        accept_conn_new(*thread, client, listen_port);
+    }
 }
 
 unique_cJSON_ptr ServerSocket::getDetails() {
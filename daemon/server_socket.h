@@ -17,11 +17,13 @@
 #pragma once
 
 #include "connection.h"
+#include "network_interface.h"
 
 #include <cJSON_utils.h>
 #include <memory>
+#include <mutex>
 
-class NetworkInterface;
+struct FrontEndThread;
 
 /**
  * The ServerSocket represents the socket used to accept new clients.
@@ -40,12 +42,16 @@ public:
      * @param fam The address family for the port (IPv4/6)
      * @param interf The interface object containing properties to use (backlog,
      *               ssl, management etc)
+     * @param thr The front-end thread which should serve the clients
+     *            accepted (b must be its event base), or nullptr to
+     *            dispatch them to the front-end threads round robin
      */
     ServerSocket(SOCKET sfd,
                  event_base* b,
                  in_port_t port,
                  sa_family_t fam,
-                 const NetworkInterface& interf);
+                 const NetworkInterface& interf,
+                 FrontEndThread* thr = nullptr);
 
     ~ServerSocket();
 
@@ -63,6 +69,29 @@ public:
         return sfd;
     }
 
+    /// Get the port number we're listening on
+    in_port_t getPort() const {
+        return listen_port;
+    }
+
+    /// Get the address family of the socket
+    sa_family_t getFamily() const {
+        return family;
+    }
+
+    /// Get the interface the socket was created for
+    const NetworkInterface& getInterface() const {
+        return interface;
+    }
+
+    /**
+     * Get the front-end thread accepting clients on this socket (nullptr
+     * if it is the dispatcher)
+     */
+    FrontEndThread* getThread() const {
+        return thread;
+    }
+
     void enable();
 
     void disable();
@@ -97,6 +126,12 @@ protected:
     /// Is this socket supposed to be used for management traffic?
     const bool management;
 
+    /// The interface this socket was created for
+    const NetworkInterface interface;
+
+    /// The front-end thread serving the clients accepted (if not dispatched)
+    FrontEndThread* const thread;
+
     struct EventDeleter {
         void operator()(struct event* ev) {
             if (ev != nullptr) {
@@ -105,6 +140,13 @@ protected:
         }
     };
 
+    /**
+     * Serialises enable() and disable(): a socket served by a front-end
+     * thread is disabled by that thread, but enabled again by the
+     * dispatcher.
+     */
+    std::mutex mutex;
+
     /// Are we currently registered in libevent or not
     bool registered_in_libevent = {false};
 
@@ -300,6 +300,25 @@ static void handle_stdin_listener(Settings& s, cJSON* obj) {
     }
 }
 
+/**
+ * Handle the "reuseport_listeners" tag in the settings
+ *
+ *  The value must be a boolean value
+ *
+ * @param s the settings object to update
+ * @param obj the object in the configuration
+ */
+static void handle_reuseport_listeners(Settings& s, cJSON* obj) {
+    if (obj->type == cJSON_True) {
+        s.setReuseportListenersEnabled(true);
+    } else if (obj->type == cJSON_False) {
+        s.setReuseportListenersEnabled(false);
+    } else {
+        throw std::invalid_argument(
+                R"("reuseport_listeners" must be a boolean value)");
+    }
+}
+
 /**
  * Handle "default_reqs_per_event", "reqs_per_event_high_priority",
  * "reqs_per_event_med_priority" and "reqs_per_event_low_priority" tag in
@@ -478,6 +497,39 @@ static void handle_ssl_minimum_protocol(Settings& s, cJSON* obj) {
     s.setSslMinimumProtocol(obj->valuestring);
 }
 
+/**
+ * Handle the "offload_threshold" tag in the settings
+ *
+ *  The value must be a non-negative integer (in bytes)
+ *
+ * @param s the settings object to update
+ * @param obj the object in the configuration
+ */
+static void handle_offload_threshold(Settings& s, cJSON* obj) {
+    if (obj->type != cJSON_Number || obj->valueint < 0) {
+        throw std::invalid_argument(
+                R"("offload_threshold" must be a non-negative integer)");
+    }
+    s.setOffloadThreshold(size_t(obj->valueint));
+}
+
+/**
+ * Handle the "response_compression_threshold" tag in the settings
+ *
+ *  The value must be a non-negative integer (in bytes)
+ *
+ * @param s the settings object to update
+ * @param obj the object in the configuration
+ */
+static void handle_response_compression_threshold(Settings& s, cJSON* obj) {
+    if (obj->type != cJSON_Number || obj->valueint < 0) {
+        throw std::invalid_argument(
+                R"("response_compression_threshold" must be a non-negative )"
+                "integer");
+    }
+    s.setResponseCompressionThreshold(size_t(obj->valueint));
+}
+
 /**
  * Handle the "get_max_packet_size" tag in the settings
  *
@@ -706,6 +758,7 @@ void Settings::reconfigure(const unique_cJSON_ptr& json) {
             {"sasl_mechanisms", handle_sasl_mechanisms},
             {"ssl_sasl_mechanisms", handle_ssl_sasl_mechanisms},
             {"stdin_listener", handle_stdin_listener},
+            {"reuseport_listeners", handle_reuseport_listeners},
             {"dedupe_nmvb_maps", handle_dedupe_nmvb_maps},
             {"xattr_enabled", handle_xattr_enabled},
             {"client_cert_auth", handle_client_cert_auth},
@@ -716,7 +769,10 @@ void Settings::reconfigure(const unique_cJSON_ptr& json) {
             {"scramsha_fallback_salt", handle_scramsha_fallback_salt},
             {"external_auth_service", handle_external_auth_service},
             {"active_external_users_push_interval",
-             handle_active_external_users_push_interval}};
+             handle_active_external_users_push_interval},
+            {"offload_threshold", handle_offload_threshold},
+            {"response_compression_threshold",
+             handle_response_compression_threshold}};
 
     cJSON* obj = json->child;
     while (obj != nullptr) {
@@ -832,6 +888,13 @@ void Settings::updateSettings(const Settings& other, bool apply) {
         }
     }
 
+    if (other.has.reuseport_listeners) {
+        if (other.reuseport_listeners.load() != reuseport_listeners.load()) {
+            throw std::invalid_argument(
+                    "reuseport_listeners can't be changed dynamically");
+        }
+    }
+
     if (other.has.logger) {
         if (other.logger_settings != logger_settings)
             throw std::invalid_argument(
@@ -1182,6 +1245,26 @@ void Settings::updateSettings(const Settings& other, bool apply) {
                     other.getActiveExternalUsersPushInterval());
         }
     }
+
+    if (other.has.offload_threshold) {
+        if (getOffloadThreshold() != other.getOffloadThreshold()) {
+            LOG_INFO("Change offload threshold from {} to {}",
+                     getOffloadThreshold(),
+                     other.getOffloadThreshold());
+            setOffloadThreshold(other.getOffloadThreshold());
+        }
+    }
+
+    if (other.has.response_compression_threshold) {
+        if (getResponseCompressionThreshold() !=
+            other.getResponseCompressionThreshold()) {
+            LOG_INFO("Change response compression threshold from {} to {}",
+                     getResponseCompressionThreshold(),
+                     other.getResponseCompressionThreshold());
+            setResponseCompressionThreshold(
+                    other.getResponseCompressionThreshold());
+        }
+    }
 }
 
 /**
@@ -174,6 +174,28 @@ public:
         notify_changed("stdin_listener");
     }
 
+    /**
+     * Should each front-end thread accept clients on its own SO_REUSEPORT
+     * listening socket (rather than the dispatcher thread accepting all
+     * clients and handing them over to the front-end threads)?
+     *
+     * @return true if enabled, false otherwise
+     */
+    bool isReuseportListenersEnabled() const {
+        return reuseport_listeners.load();
+    }
+
+    /**
+     * Set the mode for the listening sockets
+     *
+     * @param enabled the new value
+     */
+    void setReuseportListenersEnabled(bool enabled) {
+        reuseport_listeners.store(enabled);
+        has.reuseport_listeners = true;
+        notify_changed("reuseport_listeners");
+    }
+
     cb::logger::Config getLoggerConfig() const {
         auto config = logger_settings;
         // log_level is synthesised from settings.verbose.
@@ -740,6 +762,37 @@ public:
         notify_changed("active_external_users_push_interval");
     }
 
+    /**
+     * Get the size (in bytes) of the data a command must work on (e.g. a
+     * document to inflate) before that work is moved off the front-end
+     * thread and onto the executor pool. 0 means never.
+     */
+    size_t getOffloadThreshold() const {
+        return offload_threshold.load(std::memory_order_acquire);
+    }
+
+    void setOffloadThreshold(size_t threshold) {
+        offload_threshold.store(threshold, std::memory_order_release);
+        has.offload_threshold = true;
+        notify_changed("offload_threshold");
+    }
+
+    /**
+     * Get the size (in bytes) a document must have before we try to Snappy
+     * compress it when returning it to a client which has negotiated Snappy.
+     * 0 means never.
+     */
+    size_t getResponseCompressionThreshold() const {
+        return response_compression_threshold.load(std::memory_order_acquire);
+    }
+
+    void setResponseCompressionThreshold(size_t threshold) {
+        response_compression_threshold.store(threshold,
+                                             std::memory_order_release);
+        has.response_compression_threshold = true;
+        notify_changed("response_compression_threshold");
+    }
+
 protected:
 
     /**
@@ -904,6 +957,11 @@ protected:
      */
     std::atomic_bool stdin_listener{true};
 
+    /**
+     * Should each front-end thread have its own listening sockets
+     */
+    std::atomic_bool reuseport_listeners{false};
+
     /**
      * Should we allow for using the external authentication service or not
      */
@@ -912,6 +970,18 @@ protected:
     std::atomic<std::chrono::microseconds> active_external_users_push_interval{
             std::chrono::minutes(5)};
 
+    /**
+     * Commands working on more data than this are offloaded to the executor
+     * pool (see getOffloadThreshold())
+     */
+    std::atomic<size_t> offload_threshold{1024 * 1024};
+
+    /**
+     * Uncompressed documents of at least this size are compressed before
+     * being sent to Snappy clients (see getResponseCompressionThreshold())
+     */
+    std::atomic<size_t> response_compression_threshold{0};
+
 public:
     /**
      * Flags for each of the above config options, indicating if they were
@@ -955,6 +1025,9 @@ public:
         bool scramsha_fallback_salt;
         bool external_auth_service;
         bool active_external_users_push_interval = false;
+        bool offload_threshold = false;
+        bool response_compression_threshold = false;
+        bool reuseport_listeners = false;
     } has;
 
 protected:
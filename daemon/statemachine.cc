@@ -245,6 +245,12 @@ bool StateMachine::conn_read_packet_header() {
         return true;
     }
 
+    if (connection.resumeReorderedCookie()) {
+        // We were woken up as a reordered command may continue
+        connection.setState(StateMachine::State::execute);
+        return true;
+    }
+
     auto res = connection.tryReadNetwork();
     switch (res) {
     case Connection::TryReadResult::NoDataReceived:
@@ -307,7 +313,16 @@ bool StateMachine::conn_new_cmd() {
         connection.getCookieObject().reset();
 
         connection.shrinkBuffers();
-        if (connection.read->rsize() >= sizeof(cb::mcbp::Header)) {
+        if (connection.resumeReorderedCookie()) {
+            // Complete the reordered commands before starting new ones
+            connection.setState(StateMachine::State::execute);
+        } else if (connection.isHoldingCookie()) {
+            // Don't start on any more commands before the held one has
+            // run. The engine will notify us once the reordered commands
+            // ahead of it may continue.
+            connection.unregisterEvent();
+            return false;
+        } else if (connection.read->rsize() >= sizeof(cb::mcbp::Header)) {
             connection.setState(StateMachine::State::parse_cmd);
         } else if (connection.isSslEnabled()) {
             connection.setState(StateMachine::State::read_packet_header);
@@ -353,9 +368,29 @@ bool StateMachine::conn_execute() {
     }
 
     auto& cookie = connection.getCookieObject();
+    const auto reordered = connection.getNumberOfReorderedCookies();
+    if (!cookie.isReordered() && reordered > 0 &&
+        (!cookie.mayReorder() ||
+         reordered >= Connection::MaxReorderedCookies)) {
+        // This command may not overtake the reordered commands still
+        // blocked in the engine (or there are too many of them); set it
+        // aside until they've completed.
+        connection.reorderCurrentCookie(true);
+        connection.setState(StateMachine::State::new_cmd);
+        return true;
+    }
+
     cookie.setEwouldblock(false);
 
     if (!cookie.execute()) {
+        if (connection.allowUnorderedExecution() && cookie.mayReorder()) {
+            // Carry on with the following commands while this one is
+            // blocked. It is completed from conn_new_cmd once the engine
+            // notifies it.
+            connection.reorderCurrentCookie(false);
+            connection.setState(StateMachine::State::new_cmd);
+            return true;
+        }
         connection.unregisterEvent();
         return false;
     }
@@ -370,16 +405,22 @@ bool StateMachine::conn_execute() {
 
     mcbp_collect_timings(cookie);
 
-    // Consume the packet we just executed from the input buffer
-    connection.read->consume([&cookie](
-                                     cb::const_byte_buffer buffer) -> ssize_t {
-        size_t size = cookie.getPacket(Cookie::PacketContent::Full).size();
-        if (size > buffer.size()) {
-            throw std::logic_error(
-                    "conn_execute: Not enough data in input buffer");
-        }
-        return gsl::narrow<ssize_t>(size);
-    });
+    // Consume the packet we just executed from the input buffer (unless
+    // it was copied out of it when the command was reordered)
+    if (!cookie.isReordered()) {
+        connection.read->consume(
+                [&cookie](cb::const_byte_buffer buffer) -> ssize_t {
+                    size_t size =
+                            cookie.getPacket(Cookie::PacketContent::Full)
+                                    .size();
+                    if (size > buffer.size()) {
+                        throw std::logic_error(
+                                "conn_execute: Not enough data in input "
+                                "buffer");
+                    }
+                    return gsl::narrow<ssize_t>(size);
+                });
+    }
     // We've cleared the memory for this packet so we need to mark it
     // as cleared in the cookie to avoid having it dumped in toJSON and
     // using freed memory. We cannot call reset on the cookie as we
@@ -63,6 +63,9 @@ struct thread_stats {
         bytes_subdoc_mutation_total = 0;
         bytes_subdoc_mutation_inserted = 0;
 
+        cmd_get_compressed = 0;
+        bytes_get_compression_saved = 0;
+
         rbufs_allocated = 0;
         rbufs_loaned = 0;
         rbufs_existing = 0;
@@ -105,6 +108,9 @@ struct thread_stats {
         bytes_subdoc_mutation_total += other.bytes_subdoc_mutation_total;
         bytes_subdoc_mutation_inserted += other.bytes_subdoc_mutation_inserted;
 
+        cmd_get_compressed += other.cmd_get_compressed;
+        bytes_get_compression_saved += other.bytes_get_compression_saved;
+
         rbufs_allocated += other.rbufs_allocated;
         rbufs_loaned += other.rbufs_loaned;
         rbufs_existing += other.rbufs_existing;
@@ -168,6 +174,13 @@ struct thread_stats {
        received from the client). */
     Couchbase::RelaxedAtomic<uint64_t> bytes_subdoc_mutation_inserted;
 
+    /* # of documents we Snappy compressed before sending them to the client
+       (see response_compression_threshold) */
+    Couchbase::RelaxedAtomic<uint64_t> cmd_get_compressed;
+    /* # of bytes not sent to the client thanks to those documents being
+       compressed (uncompressed size - compressed size) */
+    Couchbase::RelaxedAtomic<uint64_t> bytes_get_compression_saved;
+
     /* # of read buffers allocated. */
     Couchbase::RelaxedAtomic<uint64_t> rbufs_allocated;
     /* # of read buffers which could be loaned (and hence didn't need to be allocated). */
@@ -281,6 +294,9 @@ struct stats {
     /** The number of times I reject a client */
     Couchbase::RelaxedAtomic<uint64_t> rejected_conns;
 
+    /** The number of command steps run on the executor pool (OffloadTask) */
+    Couchbase::RelaxedAtomic<uint64_t> offloaded_commands;
+
     std::vector<ListeningPort> listening_ports;
 };
 
@@ -33,6 +33,10 @@
 #ifndef WIN32
 #include <netinet/tcp.h> // For TCP_NODELAY etc
 #endif
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
 #include <memory>
 #include <queue>
 
@@ -145,6 +149,25 @@ static bool create_notification_pipe(FrontEndThread& me) {
     return true;
 }
 
+/*
+ * Create the notification channel for a worker thread. Where available
+ * this is an eventfd: a single descriptor and an 8 byte counter instead of
+ * a socket pair with a byte queued per notification.
+ */
+bool create_notification_channel(FrontEndThread& me) {
+#ifdef __linux__
+    const int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd != -1) {
+        me.notify[0] = fd;
+        me.notify_eventfd = true;
+        return true;
+    }
+    LOG_WARNING("Can't create notify eventfd: {}, using a pipe",
+                cb_strerror(errno));
+#endif
+    return create_notification_pipe(me);
+}
+
 static void setup_dispatcher(struct event_base *main_base,
                              void (*dispatcher_callback)(evutil_socket_t, short, void *))
 {
@@ -209,8 +232,21 @@ static void worker_libevent(void *arg) {
     ERR_remove_state(0);
 }
 
-static void drain_notification_channel(evutil_socket_t fd)
-{
+static void drain_notification_channel(FrontEndThread& me,
+                                       evutil_socket_t fd) {
+#ifdef __linux__
+    if (me.notify_eventfd) {
+        // Reading the eventfd resets its counter (however many times
+        // we've been notified)
+        uint64_t count;
+        if (read(fd, &count, sizeof(count)) == -1 && errno != EAGAIN) {
+            LOG_WARNING("Can't read from notify eventfd: {}",
+                        cb_strerror(errno));
+        }
+        return;
+    }
+#endif
+
     /* Every time we want to notify a thread, we send 1 byte to its
      * notification pipe. When the thread wakes up, it tries to drain
      * it's notification channel before executing any other events.
@@ -234,6 +270,17 @@ static void drain_notification_channel(evutil_socket_t fd)
     }
 }
 
+void acknowledge_notification(FrontEndThread& me) {
+    // Drain the channel *before* clearing notify_pending. A notifier which
+    // finds the flag clear writes to the channel, so once it is cleared
+    // we'll be woken again. Clearing it first would let a notifier set it
+    // and write in between, and the drain would then swallow that wakeup
+    // while the flag stays set, stopping anyone else waking us (for
+    // either kind of channel).
+    drain_notification_channel(me, me.notify[0]);
+    me.notify_pending.store(false);
+}
+
 static void dispatch_new_connections(FrontEndThread& me) {
     std::unique_ptr<ConnectionQueueItem> item;
     while ((item = me.new_conn_queue.pop()) != nullptr) {
@@ -252,12 +299,12 @@ static void dispatch_new_connections(FrontEndThread& me) {
 static void thread_libevent_process(evutil_socket_t fd, short which, void *arg) {
     auto& me = *reinterpret_cast<FrontEndThread*>(arg);
 
-    // Start by draining the notification channel before doing any work.
-    // By doing so we know that we'll be notified again if someone
-    // tries to notify us while we're doing the work below (so we don't have
-    // to care about race conditions for stuff people try to notify us
-    // about.
-    drain_notification_channel(fd);
+    // Start by draining the notification channel and then clearing the
+    // pending flag before doing any work. By doing so we know that we'll be
+    // notified again if someone tries to notify us while we're doing the
+    // work below (so we don't have to care about race conditions for stuff
+    // people try to notify us about.
+    acknowledge_notification(me);
 
     if (memcached_shutdown) {
         // Someone requested memcached to shut down. The listen thread should
@@ -288,9 +335,8 @@ static void thread_libevent_process(evutil_socket_t fd, short which, void *arg)
                           "thread_libevent_process::threadLock",
                           SlowMutexThreshold);
 
-    for (auto io : pending) {
+    for (const auto& io : pending) {
         auto* c = io.first;
-        auto status = io.second;
         if (c->getSocketDescriptor() != INVALID_SOCKET &&
             !c->isRegisteredInLibevent()) {
             /* The socket may have been shut down while we're looping */
@@ -298,10 +344,10 @@ static void thread_libevent_process(evutil_socket_t fd, short which, void *arg)
             c->registerEvent();
         }
 
-        // @todo we need to refactor this so we keep the _cookies_ and not
-        //       the connections
-        c->getCookieObject().setAiostat(status);
-        c->getCookieObject().setEwouldblock(false);
+        for (const auto& notified : io.second) {
+            notified.first->setAiostat(notified.second);
+            notified.first->setEwouldblock(false);
+        }
         /*
          * We don't want the thread to keep on serving all of the data
          * from the context of the notification pipe, so just let it
@@ -356,7 +402,7 @@ void notify_io_complete(gsl::not_null<const void*> void_cookie,
               status);
 
     /* kick the thread in the butt */
-    if (add_conn_to_pending_io_list(&cookie.getConnection(), status)) {
+    if (add_conn_to_pending_io_list(&cookie.getConnection(), &cookie, status)) {
         notify_thread(*thr);
     }
 }
@@ -387,6 +433,19 @@ void dispatch_conn_new(SOCKET sfd, in_port_t parent_port) {
     notify_thread(thread);
 }
 
+void accept_conn_new(FrontEndThread& thread,
+                     SOCKET sfd,
+                     in_port_t parent_port) {
+    if (conn_new(sfd, parent_port, thread.base, &thread) == nullptr) {
+        LOG_WARNING("Failed to dispatch event for socket {}", long(sfd));
+        safe_close(sfd);
+    }
+}
+
+FrontEndThread& get_worker_thread(size_t index) {
+    return threads.at(index);
+}
+
 /*
  * Returns true if this is the thread that listens for new TCP connections.
  */
@@ -395,7 +454,13 @@ int is_listen_thread() {
 }
 
 void notify_dispatcher() {
-    notify_thread(dispatcher_thread);
+    // The dispatcher counts the bytes it receives (see
+    // dispatch_event_handler) so every notification must be sent
+    if (cb::net::send(dispatcher_thread.notify[1], "", 1, 0) != 1 &&
+        !cb::net::is_blocking(cb::net::get_socket_error())) {
+        LOG_WARNING("Failed to notify dispatcher thread: {}",
+                    cb_strerror(cb::net::get_socket_error()));
+    }
 }
 
 /******************************* GLOBAL STATS ******************************/
@@ -429,7 +494,7 @@ void thread_init(size_t nthr,
     setup_dispatcher(main_base, dispatcher_callback);
 
     for (size_t ii = 0; ii < nthr; ii++) {
-        if (!create_notification_pipe(threads[ii])) {
+        if (!create_notification_channel(threads[ii])) {
             FATAL_ERROR(EXIT_FAILURE, "Cannot create notification pipe");
         }
         threads[ii].index = ii;
@@ -500,6 +565,25 @@ void threads_initiate_bucket_deletion() {
 }
 
 void notify_thread(FrontEndThread& thread) {
+    if (thread.notify_pending.exchange(true)) {
+        // The thread is already going to wake up, and will see whatever
+        // the caller queued for it before notifying us
+        thread.notifications_coalesced.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    thread.wakeups.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef __linux__
+    if (thread.notify_eventfd) {
+        const uint64_t one = 1;
+        if (write(thread.notify[0], &one, sizeof(one)) == -1 &&
+            errno != EAGAIN) {
+            LOG_WARNING("Failed to notify thread: {}", cb_strerror(errno));
+        }
+        return;
+    }
+#endif
+
     if (cb::net::send(thread.notify[1], "", 1, 0) != 1 &&
         !cb::net::is_blocking(cb::net::get_socket_error())) {
         LOG_WARNING("Failed to notify thread: {}",
@@ -507,14 +591,71 @@ void notify_thread(FrontEndThread& thread) {
     }
 }
 
-int add_conn_to_pending_io_list(Connection* c, ENGINE_ERROR_CODE status) {
+std::vector<FrontEndThreadNotifyStats> get_worker_thread_notify_stats() {
+    std::vector<FrontEndThreadNotifyStats> ret;
+    ret.reserve(threads.size());
+    for (const auto& thread : threads) {
+        ret.push_back({thread.wakeups.load(std::memory_order_relaxed),
+                       thread.notifications_coalesced.load(
+                               std::memory_order_relaxed)});
+    }
+    return ret;
+}
+
+std::vector<FrontEndThreadBufferStats> get_worker_thread_buffer_stats() {
+    std::vector<FrontEndThreadBufferStats> ret;
+    ret.reserve(threads.size());
+    for (const auto& thread : threads) {
+        ret.push_back({thread.read.getPooled(),
+                       thread.read.getPooledBytes(),
+                       thread.read.getInUse(),
+                       thread.write.getPooled(),
+                       thread.write.getPooledBytes(),
+                       thread.write.getInUse()});
+    }
+    return ret;
+}
+
+NetworkBufferPool::~NetworkBufferPool() = default;
+
+std::unique_ptr<cb::Pipe> NetworkBufferPool::take() {
+    if (buffers.empty()) {
+        return {};
+    }
+
+    auto ret = std::move(buffers.back());
+    buffers.pop_back();
+    pooled--;
+    pooled_bytes -= ret->capacity();
+    in_use++;
+    return ret;
+}
+
+void NetworkBufferPool::put(std::unique_ptr<cb::Pipe> buffer) {
+    in_use--;
+    if (buffers.size() >= MaxPooledBuffers ||
+        buffer->capacity() > MaxPooledBufferSize || !buffer->empty()) {
+        // Let it go
+        return;
+    }
+
+    pooled_bytes += buffer->capacity();
+    pooled++;
+    buffers.emplace_back(std::move(buffer));
+}
+
+int add_conn_to_pending_io_list(Connection* c,
+                                Cookie* cookie,
+                                ENGINE_ERROR_CODE status) {
     auto* thread = c->getThread();
 
-    std::pair<FrontEndThread::PendingIoMap::iterator, bool> result;
+    bool first;
     {
         std::lock_guard<std::mutex> lock(thread->pending_io.mutex);
-        result = thread->pending_io.map.emplace(c, status);
+        auto& cookies = thread->pending_io.map[c];
+        first = cookies.empty();
+        cookies.emplace_back(cookie, status);
     }
-    int notify = result.second ? 1 : 0;
+    int notify = first ? 1 : 0;
     return notify;
 }
@@ -15,24 +15,179 @@
  *   limitations under the License.
  */
 #include "timings.h"
+#include <cJSON.h>
 #include <memcached/protocol_binary.h>
 #include <platform/platform.h>
-#include "timing_histogram.h"
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+CommandTimingHistogram::CommandTimingHistogram()
+    : HdrHistogram(0, max_value, 1) {
+}
+
+void CommandTimingHistogram::add(std::chrono::nanoseconds nsec) {
+    using namespace std::chrono;
+    uint64_t usec = 0;
+    if (nsec.count() > 0) {
+        usec = uint64_t(duration_cast<microseconds>(nsec).count());
+    }
+    addValue(std::min(usec, max_value));
+}
+
+unique_cJSON_ptr CommandTimingHistogram::percentiles_to_json() const {
+    unique_cJSON_ptr json(cJSON_CreateObject());
+    if (!json) {
+        throw std::bad_alloc();
+    }
+
+    static const std::array<std::pair<const char*, double>, 4> percentiles = {
+            {{"50", 50.0}, {"99", 99.0}, {"99.9", 99.9}, {"99.99", 99.99}}};
+    for (const auto& p : percentiles) {
+        cJSON_AddNumberToObject(
+                json.get(), p.first, double(getValueAtPercentile(p.second)));
+    }
+    return json;
+}
+
+unique_cJSON_ptr CommandTimingHistogram::to_json() const {
+    // Map each bucket onto the TimingHistogram buckets by the lowest value
+    // it holds; a value close to a boundary may therefore land in the
+    // neighbouring bucket, but by no more than the bucket width (< 1%).
+    uint64_t ns = 0;
+    std::array<uint64_t, 100> usec{};
+    std::array<uint64_t, 50> msec{};
+    std::array<uint64_t, 10> halfsec{};
+    std::array<uint64_t, 5> wayout{};
+
+    auto iter = makeRecordedIterator();
+    while (auto next = getNextValueAndCount(iter)) {
+        const uint64_t us = next->first;
+        const uint64_t count = next->second;
+        if (us == 0) {
+            ns += count;
+        } else if (us < 1000) {
+            usec[us / 10] += count;
+        } else if (us < 50000) {
+            msec[us / 1000] += count;
+        } else if (us < 5000000) {
+            halfsec[us / 500000] += count;
+        } else {
+            // [5-9], [10-19], [20-39], [40-79], [80-inf].
+            const uint64_t sec = us / 1000000;
+            if (sec < 10) {
+                wayout[0] += count;
+            } else if (sec < 20) {
+                wayout[1] += count;
+            } else if (sec < 40) {
+                wayout[2] += count;
+            } else if (sec < 80) {
+                wayout[3] += count;
+            } else {
+                wayout[4] += count;
+            }
+        }
+    }
+
+    unique_cJSON_ptr json(cJSON_CreateObject());
+    cJSON* root = json.get();
+    if (root == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    cJSON_AddNumberToObject(root, "ns", double(ns));
+
+    cJSON* array = cJSON_CreateArray();
+    for (auto us : usec) {
+        cJSON_AddItemToArray(array, cJSON_CreateNumber(double(us)));
+    }
+    cJSON_AddItemToObject(root, "us", array);
+
+    array = cJSON_CreateArray();
+    // element 0 isn't used
+    for (size_t ii = 1; ii < msec.size(); ++ii) {
+        cJSON_AddItemToArray(array, cJSON_CreateNumber(double(msec[ii])));
+    }
+    cJSON_AddItemToObject(root, "ms", array);
+
+    array = cJSON_CreateArray();
+    for (auto hs : halfsec) {
+        cJSON_AddItemToArray(array, cJSON_CreateNumber(double(hs)));
+    }
+    cJSON_AddItemToObject(root, "500ms", array);
+
+    cJSON_AddNumberToObject(root, "5s-9s", double(wayout[0]));
+    cJSON_AddNumberToObject(root, "10s-19s", double(wayout[1]));
+    cJSON_AddNumberToObject(root, "20s-39s", double(wayout[2]));
+    cJSON_AddNumberToObject(root, "40s-79s", double(wayout[3]));
+    cJSON_AddNumberToObject(root, "80s-inf", double(wayout[4]));
+
+    // for backwards compatibility, add the old wayouts
+    uint64_t aggregated = 0;
+    for (auto wo : wayout) {
+        aggregated += wo;
+    }
+    cJSON_AddNumberToObject(root, "wayout", double(aggregated));
+
+    cJSON_AddItemToObject(root, "percentiles", percentiles_to_json().release());
+    return json;
+}
+
+std::string CommandTimingHistogram::to_string() const {
+    auto json = to_json();
+    return ::to_string(json.get(), false);
+}
 
 Timings::Timings() {
-    reset();
+    set_num_threads(1);
 }
 
 Timings& Timings::operator=(const Timings& other) {
-    timings = other.timings;
+    if (this == &other) {
+        return *this;
+    }
+    set_num_threads(other.threads.size());
+    for (size_t thread = 0; thread < threads.size(); ++thread) {
+        auto& ours = *threads[thread];
+        const auto& theirs = *other.threads[thread];
+        std::lock_guard<std::mutex> guard(theirs.mutex);
+        for (size_t op = 0; op < MAX_NUM_OPCODES; ++op) {
+            if (theirs.histograms[op]) {
+                ours.histograms[op] = std::make_unique<CommandTimingHistogram>(
+                        *theirs.histograms[op]);
+            }
+        }
+        ours.intervals = theirs.intervals;
+    }
+    std::lock_guard<std::mutex> guard(other.lock);
     interval_latency_lookups = other.interval_latency_lookups;
     interval_latency_mutations = other.interval_latency_mutations;
     return *this;
 }
 
+void Timings::set_num_threads(size_t num) {
+    if (num == 0) {
+        throw std::invalid_argument(
+                "Timings::set_num_threads: num must be non-zero");
+    }
+    threads.clear();
+    for (size_t ii = 0; ii < num; ++ii) {
+        threads.push_back(std::make_unique<ThreadTimings>());
+    }
+}
+
 void Timings::reset() {
-    for (auto& t : timings) {
-        t.reset();
+    for (auto& thread : threads) {
+        std::lock_guard<std::mutex> guard(thread->mutex);
+        for (auto& hist : thread->histograms) {
+            if (hist) {
+                hist->reset();
+            }
+        }
+        for (auto& interval : thread->intervals) {
+            interval.reset();
+        }
     }
 
     {
@@ -43,17 +198,48 @@ void Timings::reset() {
 }
 
 void Timings::collect(cb::mcbp::ClientOpcode opcode,
-                      std::chrono::nanoseconds nsec) {
-    timings[std::underlying_type<cb::mcbp::ClientOpcode>::type(opcode)].add(
-            nsec);
-    auto& interval = interval_counters
-            [std::underlying_type<cb::mcbp::ClientOpcode>::type(opcode)];
+                      std::chrono::nanoseconds nsec,
+                      size_t thread) {
+    const auto op = std::underlying_type<cb::mcbp::ClientOpcode>::type(opcode);
+    auto& timings = *threads[std::min(thread, threads.size() - 1)];
+
+    std::lock_guard<std::mutex> guard(timings.mutex);
+    auto& hist = timings.histograms[op];
+    if (!hist) {
+        hist = std::make_unique<CommandTimingHistogram>();
+    }
+    hist->add(nsec);
+
+    auto& interval = timings.intervals[op];
     interval.count++;
     interval.duration_ns += nsec.count();
 }
 
+CommandTimingHistogram Timings::get_timing_histogram(uint8_t opcode) const {
+    CommandTimingHistogram ret;
+    for (const auto& thread : threads) {
+        std::lock_guard<std::mutex> guard(thread->mutex);
+        if (thread->histograms[opcode]) {
+            ret += *thread->histograms[opcode];
+        }
+    }
+    return ret;
+}
+
+uint64_t Timings::get_total(uint8_t opcode) const {
+    uint64_t ret = 0;
+    for (const auto& thread : threads) {
+        std::lock_guard<std::mutex> guard(thread->mutex);
+        if (thread->histograms[opcode]) {
+            ret += thread->histograms[opcode]->get_total();
+        }
+    }
+    return ret;
+}
+
 std::string Timings::generate(cb::mcbp::ClientOpcode opcode) {
-    return timings[std::underlying_type<cb::mcbp::ClientOpcode>::type(opcode)]
+    return get_timing_histogram(
+                   std::underlying_type<cb::mcbp::ClientOpcode>::type(opcode))
             .to_string();
 }
 
@@ -107,8 +293,8 @@ uint64_t Timings::get_aggregated_mutation_stats() {
 
     uint64_t ret = 0;
     for (auto cmd : timings_mutations) {
-        ret += timings[std::underlying_type<cb::mcbp::ClientOpcode>::type(cmd)]
-                       .get_total();
+        ret += get_total(
+                std::underlying_type<cb::mcbp::ClientOpcode>::type(cmd));
     }
     return ret;
 }
@@ -117,8 +303,8 @@ uint64_t Timings::get_aggregated_retrival_stats() {
 
     uint64_t ret = 0;
     for (auto cmd : timings_retrievals) {
-        ret += timings[std::underlying_type<cb::mcbp::ClientOpcode>::type(cmd)]
-                       .get_total();
+        ret += get_total(
+                std::underlying_type<cb::mcbp::ClientOpcode>::type(cmd));
     }
     return ret;
 }
@@ -133,24 +319,25 @@ cb::sampling::Interval Timings::get_interval_lookup_latency() {
     return interval_latency_lookups.getAggregate();
 }
 
-void Timings::sample(std::chrono::seconds sample_interval) {
-    cb::sampling::Interval interval_lookup, interval_mutation;
-
-    for (auto op : timings_mutations) {
-        interval_mutation += interval_counters
-                [std::underlying_type<cb::mcbp::ClientOpcode>::type(op)];
-        interval_counters[std::underlying_type<cb::mcbp::ClientOpcode>::type(
-                                  op)]
-                .reset();
+template <size_t N>
+cb::sampling::Interval Timings::take_intervals(
+        const cb::mcbp::ClientOpcode (&ops)[N]) {
+    cb::sampling::Interval ret;
+    for (auto& thread : threads) {
+        std::lock_guard<std::mutex> guard(thread->mutex);
+        for (auto op : ops) {
+            auto& interval = thread->intervals
+                    [std::underlying_type<cb::mcbp::ClientOpcode>::type(op)];
+            ret += interval;
+            interval.reset();
+        }
     }
+    return ret;
+}
 
-    for (auto op : timings_retrievals) {
-        interval_lookup += interval_counters
-                [std::underlying_type<cb::mcbp::ClientOpcode>::type(op)];
-        interval_counters[std::underlying_type<cb::mcbp::ClientOpcode>::type(
-                                  op)]
-                .reset();
-    }
+void Timings::sample(std::chrono::seconds sample_interval) {
+    const auto interval_mutation = take_intervals(timings_mutations);
+    const auto interval_lookup = take_intervals(timings_retrievals);
 
     {
         std::lock_guard<std::mutex> lg(lock);
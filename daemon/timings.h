@@ -16,29 +16,93 @@
  */
 #pragma once
 
-#include "timing_histogram.h"
 #include "timing_interval.h"
 
+#include <cJSON_utils.h>
 #include <mcbp/protocol/opcode.h>
+#include <utilities/hdrhistogram.h>
 
 #include <array>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <mutex>
+#include <vector>
 
 
 #define MAX_NUM_OPCODES 0x100
 
+/**
+ * A histogram of command durations in microseconds, with 1 significant
+ * figure (values below 32us are exact, and every larger value is known to
+ * within 1/16) up to max_value.
+ *
+ * One is kept per thread for each opcode the thread has seen, so it is
+ * kept small: ~3KB, against ~21KB with 2 significant figures.
+ */
+class CommandTimingHistogram : public HdrHistogram {
+public:
+    /// Largest value tracked (~134 seconds); larger values are counted as it.
+    static const uint64_t max_value = (uint64_t(1) << 27) - 1;
+
+    CommandTimingHistogram();
+
+    void add(std::chrono::nanoseconds nsec);
+
+    uint64_t get_total() const {
+        return getValueCount();
+    }
+
+    /**
+     * Get the histogram in the same JSON layout as TimingHistogram (so
+     * existing consumers such as mctimings keep working), plus a
+     * "percentiles" object as returned by percentiles_to_json().
+     */
+    unique_cJSON_ptr to_json() const;
+    std::string to_string() const;
+
+    /// Get the p50/p99/p99.9/p99.99 latencies (in microseconds) as JSON.
+    unique_cJSON_ptr percentiles_to_json() const;
+};
+
 /** Records timings for each memcached opcode. Each opcode has a histogram of
  * times.
+ *
+ * To keep the front-end threads from contending on the same cache lines,
+ * each thread records into its own histograms (allocated the first time the
+ * thread sees an opcode) and interval counters. They are only merged when
+ * someone asks for them; each thread's are guarded by a mutex which only
+ * such a reader contends on.
  */
 class Timings {
 public:
     Timings();
+
+    /**
+     * Copy other's histograms, the interval counters not yet consumed by
+     * sample(), and the sampled interval series.
+     */
     Timings& operator=(const Timings& other);
     Timings(const Timings&) = delete;
 
+    /**
+     * Set the number of threads which record timings (indexed by
+     * FrontEndThread::index). Must be called before any timings are
+     * collected; any existing timings are discarded.
+     */
+    void set_num_threads(size_t num);
+
     void reset();
-    void collect(cb::mcbp::ClientOpcode opcode, std::chrono::nanoseconds nsec);
+
+    /**
+     * Record a timing for the opcode.
+     *
+     * @param thread index of the calling front-end thread. Threads outside
+     *        of the range given to set_num_threads share the last slot.
+     */
+    void collect(cb::mcbp::ClientOpcode opcode,
+                 std::chrono::nanoseconds nsec,
+                 size_t thread);
     void sample(std::chrono::seconds sample_interval);
     std::string generate(cb::mcbp::ClientOpcode opcode);
     uint64_t get_aggregated_mutation_stats();
@@ -48,20 +112,42 @@ public:
     cb::sampling::Interval get_interval_lookup_latency();
 
     /**
-     * Get the underlying timings histogram for the specified opcode
+     * Get the timings histogram for the specified opcode, merged across all
+     * of the threads.
      */
-    TimingHistogram get_timing_histogram(uint8_t opcode) const {
-        return timings[opcode];
-    }
+    CommandTimingHistogram get_timing_histogram(uint8_t opcode) const;
 
 private:
+    /// The timings recorded by one front-end thread.
+    struct ThreadTimings {
+        /// Held by the recording thread, and by readers.
+        mutable std::mutex mutex;
+        /// Histogram per opcode, null until first used.
+        std::array<std::unique_ptr<CommandTimingHistogram>, MAX_NUM_OPCODES>
+                histograms;
+        /// Counts since the last sample(), per opcode.
+        std::array<cb::sampling::Interval, MAX_NUM_OPCODES> intervals;
+    };
+
+    /// @return the total number of timings recorded for the opcode.
+    uint64_t get_total(uint8_t opcode) const;
+
+    /**
+     * Sum, and reset, the interval counters of the given opcodes across all
+     * of the threads.
+     */
+    template <size_t N>
+    cb::sampling::Interval take_intervals(
+            const cb::mcbp::ClientOpcode (&ops)[N]);
+
     // This lock is only held by sample() and some blocks within generate().
     // It guards the various IntervalSeries variables which internally
     // contain cb::RingBuffer objects which are not thread safe.
-    std::mutex lock;
+    mutable std::mutex lock;
 
     cb::sampling::IntervalSeries interval_latency_lookups;
     cb::sampling::IntervalSeries interval_latency_mutations;
-    std::array<TimingHistogram, MAX_NUM_OPCODES> timings;
-    std::array<cb::sampling::Interval, MAX_NUM_OPCODES> interval_counters;
+    /// One entry per front-end thread; each is a separate allocation so
+    /// threads don't share cache lines.
+    std::vector<std::unique_ptr<ThreadTimings>> threads;
 };
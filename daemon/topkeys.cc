@@ -27,83 +27,75 @@
 #include <cstring>
 #include <gsl/gsl>
 #include <stdexcept>
+#include <unordered_map>
 
 /*
  * Implementation Details
  *
  * === TopKeys ===
  *
- * The TopKeys class is split into NUM_SHARDS shards, each which owns
- * 1/NUM_SHARDS of the keyspace. This is to allow some level of
- * concurrent access - each shard has a mutex guarding all access.
- * Other than that the TopKeys class is pretty uninteresting - it
- * simply passes on requests to the correct Shard, and when statistics
- * are requested it aggregates information from each shard.
+ * Every front-end thread tracks the keys it accesses in its own
+ * ThreadKeys, so updates never contend with other threads. When
+ * statistics are requested the keys of every thread are merged (the
+ * counts of a key accessed by several threads are summed) and the most
+ * accessed mkeys * KEYS_MULTIPLIER keys reported.
  *
- * === TopKeys::Shard ===
+ * === TopKeys::ThreadKeys ===
  *
- * This is where the action happens. Each Shard maintains an ordered
- * list of key names and related statistics, orded by when they were
- * last accessed. There is a fixed number of keys each Shard tracks.
-
- * Given we generally track only a small number of keys per shard (10
- * by default), it's highly likely that any one key access will 'miss'
- * - i.e. not find an existing topkey. Therefore this class is
- * optimized for that case, attempting to minimise memory allocation
- * in steady-state.
+ * Implements the Space-Saving heavy-hitter algorithm over a fixed number
+ * of counters (TRACKING_FACTOR times the number of keys reported):
  *
- * Internally Shard consists of a vector of topkey_t, storing the
- * current max_keys top_keys, and a list of topkey_t pointers, used to
- * main the current most -> least recently used ordering:
-
- * max_keys elements. Each element is a tuple of
- * {hash(key), key, topkey_stats}:
- *
- *
- *       vector<topkey_t>
- *   +----------+-------------+---------------+
- *   | size_t   | std::string | topkey_item_t |
- *   +----------+-------------+---------------+
- *   | <hash 1> | <key 1>     | stats 1       | <--- Node1
- *   | <hash 2> | <key 2>     | stats 2       | <--- Node2
- *   | <hash 3> | <key 3>     | stats 3       | <--- Node3
- *   . ....                                   .
- *   | <hash N> | <key N>     | stats N       | <--- NodeN
- *   +----------------------------------------+
+ * - If the key already has a counter, its count is incremented.
+ * - Otherwise, if a counter is unused the key takes it with a count of 1.
+ * - Otherwise the key takes over the counter with the smallest count, and
+ *   increments it.
  *
- *   Node3 <---> Node1 <---> ... <---> Node2
- *   ^^^                               ^^^
- *   MRU                               LRU
+ * Counts are therefore over-estimates (by at most the smallest count),
+ * but any key accessed more than N / capacity times out of N is
+ * guaranteed to be tracked.
  *
+ * So that keys which were hot a while ago don't stay at the top forever,
+ * every count is halved each DECAY_INTERVAL. The owning thread does so on
+ * its next update (halving keeps the heap in order); readers apply any
+ * halvings the thread hasn't yet, so the counts of an idle thread decay
+ * too.
  *
- * Upon a key 'hit', TopKeys::updateKey() is called. That hashes the
- * key, and finds the Shard responsible for that
- * key. TopKeys::Shard::updateKey() is then called.
+ *       counters[]                                  heap[]
+ *   +---------------------------------------+     +-----+
+ *   | seq | nkey | count | ctime | key ...  | <-- | min |  (min-heap of
+ *   | seq | nkey | count | ctime | key ...  |     | ... |   counter indexes
+ *   . ...                                   .     |     |   by count)
+ *   +---------------------------------------+     +-----+
+ *            ^
+ *            +---- index[] (hash of key -> counter, linear probing)
  *
- * Shard::updateKey() iterates over the vector, searching for a hash
- * match with an existing element, using the actual key string to
- * validate (in case of a hash collision). If it is found, then the
- * stats are simply updated.  If it is not found, then the
- * least-recently-used element is selected as a 'victim' and it's
- * contents is replaced by the incoming key.  Finally the linked-list
- * is updated to move the updated element to the head of the list.
+ * All storage is allocated up front, so an update does not allocate. Only
+ * the owning thread modifies a ThreadKeys; stats readers read the counters
+ * directly, using each counter's sequence number to detect (and retry) a
+ * read which raced with the key being replaced.
  */
 
 
-TopKeys::TopKeys(int mkeys) {
-    for (auto& shard : shards) {
-        shard.setMaxKeys(mkeys);
+TopKeys::TopKeys(int mkeys, size_t numThreads)
+    : reportedKeys(std::max(mkeys, 0) * KEYS_MULTIPLIER),
+      threadKeys(std::max(numThreads, size_t(1))) {
+    for (auto& tk : threadKeys) {
+        tk.store(nullptr);
     }
 }
 
 TopKeys::~TopKeys() {
+    for (auto& tk : threadKeys) {
+        delete tk.load();
+    }
 }
 
 void TopKeys::updateKey(const void* key,
                         size_t nkey,
-                        rel_time_t operation_time) {
+                        rel_time_t operation_time,
+                        size_t threadIndex) {
     if (settings.isTopkeysEnabled()) {
-        doUpdateKey(key, nkey, operation_time);
+        doUpdateKey(key, nkey, operation_time, threadIndex);
     }
 }
 
@@ -126,94 +118,253 @@ ENGINE_ERROR_CODE TopKeys::json_stats(nlohmann::json& object,
     return ENGINE_SUCCESS;
 }
 
-TopKeys::Shard& TopKeys::getShard(size_t key_hash) {
-    /* This is special-cased for 8 */
-    static_assert(NUM_SHARDS == 8,
-                  "Topkeys::getShard() special-cased for SHARDS==8");
-    return shards[key_hash & 0x7];
+TopKeys::ThreadKeys* TopKeys::getThreadKeys(size_t threadIndex,
+                                            rel_time_t operation_time) {
+    if (threadIndex >= threadKeys.size()) {
+        return nullptr;
+    }
+    auto* tk = threadKeys[threadIndex].load(std::memory_order_acquire);
+    if (tk == nullptr) {
+        // Only this thread creates its ThreadKeys.
+        tk = new ThreadKeys(reportedKeys * TRACKING_FACTOR, operation_time);
+        threadKeys[threadIndex].store(tk, std::memory_order_release);
+    }
+    return tk;
 }
 
-TopKeys::Shard::topkey_t*
-TopKeys::Shard::searchForKey(size_t key_hash,
-                             const cb::const_char_buffer& key) {
-
-    for (auto& topkey : storage) {
-        if (topkey.first.hash == key_hash) {
-            // Double-check with full compare
-            if (topkey.first.key.compare(0, topkey.first.key.size(),
-                                         key.buf, key.len) == 0) {
-                // Match found.
-                return &topkey;
-            }
+TopKeys::ThreadKeys::ThreadKeys(size_t capacity, rel_time_t current_time)
+    : capacity(capacity),
+      lastDecay(current_time),
+      counters(new Counter[capacity]),
+      states(new CounterState[capacity]),
+      heap(new uint32_t[capacity]) {
+    // Size the index to at most half full.
+    size_t indexSize = 1;
+    while (indexSize < capacity * 2) {
+        indexSize <<= 1;
+    }
+    indexMask = indexSize - 1;
+    index.reset(new uint32_t[indexSize]);
+    std::fill(index.get(), index.get() + indexSize, uint32_t(EMPTY));
+}
+
+bool TopKeys::ThreadKeys::keyEquals(const Counter& counter,
+                                    const cb::const_char_buffer& key) const {
+    if (counter.nkey.load(std::memory_order_relaxed) != key.len) {
+        return false;
+    }
+    for (size_t offset = 0, word = 0; offset < key.len;
+         offset += sizeof(uint64_t), ++word) {
+        uint64_t value = 0;
+        std::memcpy(&value,
+                    key.buf + offset,
+                    std::min(sizeof(uint64_t), key.len - offset));
+        if (counter.key[word].load(std::memory_order_relaxed) != value) {
+            return false;
         }
     }
-    return nullptr;
+    return true;
 }
 
-bool TopKeys::Shard::updateKey(const cb::const_char_buffer& key,
-                               size_t key_hash,
-                               const rel_time_t ct) {
-    try {
-        std::lock_guard<std::mutex> lock(mutex);
-
-        topkey_t* found_key = searchForKey(key_hash, key);
-
-        if (found_key == NULL) {
-            // Key not found.
-            if (storage.size() == max_keys) {
-                // Re-use the lowest keys' storage.
-                found_key = list.back();
-                found_key->first.hash = key_hash;
-                found_key->first.key.assign(key.buf, key.len);
-                found_key->second = topkey_item_t(ct);
-
-                // Move back element to the front, shuffling down the
-                // rest.
-                list.splice(list.begin(), list, --list.end());
-
-            } else {
-                // add a new element to the storage array.
-
-                storage.emplace_back(
-                    std::make_pair(KeyId{key_hash,
-                                         std::string(key.buf, key.len)},
-                                   topkey_item_t(ct)));
-                found_key = &storage.back();
-
-                // Insert the new item to the front of the list
-                list.push_front(found_key);
-            }
-        } else {
-            // Found - shuffle to the front.
-            auto it = std::find(list.begin(), list.end(),
-                                found_key);
-            list.splice(list.begin(), list, it);
+uint32_t TopKeys::ThreadKeys::find(const cb::const_char_buffer& key,
+                                   size_t key_hash) const {
+    for (size_t ii = key_hash & indexMask;; ii = (ii + 1) & indexMask) {
+        const auto counter = index[ii];
+        if (counter == EMPTY) {
+            return EMPTY;
         }
+        if (states[counter].hash == key_hash &&
+            keyEquals(counters[counter], key)) {
+            return counter;
+        }
+    }
+}
 
-        // Increment access count.
-        found_key->second.ti_access_count++;
-        return true;
+void TopKeys::ThreadKeys::indexInsert(uint32_t counter) {
+    size_t ii = states[counter].hash & indexMask;
+    while (index[ii] != EMPTY) {
+        ii = (ii + 1) & indexMask;
+    }
+    index[ii] = counter;
+}
 
-    } catch (const std::bad_alloc&) {
-        // Failed to update.
-        return false;
+void TopKeys::ThreadKeys::indexErase(uint32_t counter) {
+    size_t ii = states[counter].hash & indexMask;
+    while (index[ii] != counter) {
+        ii = (ii + 1) & indexMask;
+    }
+    index[ii] = EMPTY;
+
+    // Shift back any following entries which can no longer be reached
+    // across the gap.
+    for (size_t jj = (ii + 1) & indexMask; index[jj] != EMPTY;
+         jj = (jj + 1) & indexMask) {
+        const size_t home = states[index[jj]].hash & indexMask;
+        const bool reachable = (ii <= jj) ? (ii < home && home <= jj)
+                                          : (ii < home || home <= jj);
+        if (!reachable) {
+            index[ii] = index[jj];
+            index[jj] = EMPTY;
+            ii = jj;
+        }
+    }
+}
+
+void TopKeys::ThreadKeys::swapHeap(uint32_t a, uint32_t b) {
+    std::swap(heap[a], heap[b]);
+    states[heap[a]].heapPos = a;
+    states[heap[b]].heapPos = b;
+}
+
+void TopKeys::ThreadKeys::siftDown(uint32_t pos) {
+    const uint32_t size =
+            gsl::narrow_cast<uint32_t>(used.load(std::memory_order_relaxed));
+    while (true) {
+        const uint32_t left = 2 * pos + 1;
+        const uint32_t right = left + 1;
+        uint32_t smallest = pos;
+        if (left < size && getCount(heap[left]) < getCount(heap[smallest])) {
+            smallest = left;
+        }
+        if (right < size &&
+            getCount(heap[right]) < getCount(heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == pos) {
+            return;
+        }
+        swapHeap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+void TopKeys::ThreadKeys::siftUp(uint32_t pos) {
+    while (pos > 0) {
+        const uint32_t parent = (pos - 1) / 2;
+        if (getCount(heap[parent]) <= getCount(heap[pos])) {
+            return;
+        }
+        swapHeap(pos, parent);
+        pos = parent;
+    }
+}
+
+rel_time_t TopKeys::ThreadKeys::getDecayPeriods(
+        rel_time_t current_time) const {
+    const auto last = lastDecay.load(std::memory_order_acquire);
+    if (current_time <= last) {
+        return 0;
+    }
+    return (current_time - last) / DECAY_INTERVAL;
+}
+
+static int decayCount(int count, rel_time_t periods) {
+    return periods < 31 ? count >> periods : 0;
+}
+
+void TopKeys::ThreadKeys::decay(rel_time_t current_time) {
+    const auto periods = getDecayPeriods(current_time);
+    if (periods == 0) {
+        return;
+    }
+    // Halving every count keeps them in the same order, so the heap (and
+    // index) remain valid.
+    const auto inUse = used.load(std::memory_order_relaxed);
+    for (size_t ii = 0; ii < inUse; ++ii) {
+        counters[ii].count.store(decayCount(getCount(ii), periods),
+                                 std::memory_order_relaxed);
+    }
+    lastDecay.store(lastDecay.load(std::memory_order_relaxed) +
+                            periods * DECAY_INTERVAL,
+                    std::memory_order_release);
+}
+
+void TopKeys::ThreadKeys::updateKey(const cb::const_char_buffer& key,
+                                    size_t key_hash,
+                                    const rel_time_t ct) {
+    decay(ct);
+
+    auto found = find(key, key_hash);
+    if (found != EMPTY) {
+        counters[found].count.store(getCount(found) + 1,
+                                    std::memory_order_relaxed);
+        siftDown(states[found].heapPos);
+        return;
+    }
+
+    if (capacity == 0) {
+        return;
+    }
+
+    // Take an unused counter, else the one with the smallest count.
+    const size_t inUse = used.load(std::memory_order_relaxed);
+    const bool isNew = inUse < capacity;
+    uint32_t pos;
+    int count;
+    if (isNew) {
+        found = gsl::narrow_cast<uint32_t>(inUse);
+        pos = found;
+        heap[pos] = found;
+        states[found].heapPos = pos;
+        count = 0;
+    } else {
+        pos = 0;
+        found = heap[pos];
+        count = getCount(found);
+        indexErase(found);
+    }
+
+    Counter& counter = counters[found];
+    const auto seq = counter.seq.load(std::memory_order_relaxed);
+    counter.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    counter.nkey.store(gsl::narrow_cast<uint32_t>(key.len),
+                       std::memory_order_relaxed);
+    for (size_t offset = 0, word = 0; offset < key.len;
+         offset += sizeof(uint64_t), ++word) {
+        uint64_t value = 0;
+        std::memcpy(&value,
+                    key.buf + offset,
+                    std::min(sizeof(uint64_t), key.len - offset));
+        counter.key[word].store(value, std::memory_order_relaxed);
+    }
+    counter.ctime.store(ct, std::memory_order_relaxed);
+    counter.count.store(count + 1, std::memory_order_relaxed);
+
+    counter.seq.store(seq + 2, std::memory_order_release);
+
+    states[found].hash = key_hash;
+    indexInsert(found);
+    if (isNew) {
+        used.store(inUse + 1, std::memory_order_release);
+        siftUp(pos);
+    } else {
+        siftDown(pos);
     }
 }
 
 void TopKeys::doUpdateKey(const void* key,
                           size_t nkey,
-                          rel_time_t operation_time) {
+                          rel_time_t operation_time,
+                          size_t threadIndex) {
     if (key == nullptr || nkey == 0) {
         throw std::invalid_argument(
                 "TopKeys::doUpdateKey: key must be specified");
     }
+    if (nkey > MAX_KEY_LENGTH) {
+        return;
+    }
 
     try {
         cb::const_char_buffer key_buf(static_cast<const char*>(key), nkey);
         std::hash<cb::const_char_buffer > hash_fn;
         const size_t key_hash = hash_fn(key_buf);
 
-        getShard(key_hash).updateKey(key_buf, key_hash, operation_time);
+        auto* tk = getThreadKeys(threadIndex, operation_time);
+        if (tk != nullptr) {
+            tk->updateKey(key_buf, key_hash, operation_time);
+        }
     } catch (const std::bad_alloc&) {
         // Failed to increment topkeys, continue...
     }
@@ -282,13 +433,52 @@ static void tk_jsonfunc(const std::string& key, const topkey_item_t& it,
     c->array->push_back(obj);
 }
 
+static void tk_mergefunc(const cb::const_char_buffer& key,
+                         const topkey_item_t& it,
+                         void* arg) {
+    auto& merged =
+            *static_cast<std::unordered_map<std::string, topkey_item_t>*>(arg);
+    auto result = merged.emplace(std::string(key.buf, key.len), it);
+    if (!result.second) {
+        auto& item = result.first->second;
+        item.ti_access_count += it.ti_access_count;
+        item.ti_ctime = std::min(item.ti_ctime, it.ti_ctime);
+    }
+}
+
+std::vector<TopKeys::TopKey> TopKeys::getTopKeys(rel_time_t current_time) {
+    std::unordered_map<std::string, topkey_item_t> merged;
+    for (auto& tk : threadKeys) {
+        const auto* keys = tk.load(std::memory_order_acquire);
+        if (keys != nullptr) {
+            keys->accept_visitor(tk_mergefunc, &merged, current_time);
+        }
+    }
+
+    std::vector<TopKey> topkeys;
+    topkeys.reserve(merged.size());
+    for (auto& entry : merged) {
+        topkeys.push_back({entry.first, entry.second});
+    }
+    const auto count = std::min(topkeys.size(), reportedKeys);
+    std::partial_sort(topkeys.begin(),
+                      topkeys.begin() + count,
+                      topkeys.end(),
+                      [](const TopKey& a, const TopKey& b) {
+                          return a.item.ti_access_count >
+                                 b.item.ti_access_count;
+                      });
+    topkeys.erase(topkeys.begin() + count, topkeys.end());
+    return topkeys;
+}
+
 ENGINE_ERROR_CODE TopKeys::doStats(const void* cookie,
                                    rel_time_t current_time,
                                    ADD_STAT add_stat) {
     struct tk_context context(cookie, add_stat, current_time, nullptr);
 
-    for (auto& shard : shards) {
-        shard.accept_visitor(tk_iterfunc, &context);
+    for (const auto& topkey : getTopKeys(current_time)) {
+        tk_iterfunc(topkey.key, topkey.item, &context);
     }
 
     return ENGINE_SUCCESS;
@@ -310,18 +500,50 @@ ENGINE_ERROR_CODE TopKeys::do_json_stats(nlohmann::json& object,
     struct tk_context context(nullptr, nullptr, current_time, &topkeys);
 
     /* Collate the topkeys JSON object */
-    for (auto& shard : shards) {
-        shard.accept_visitor(tk_jsonfunc, &context);
+    for (const auto& topkey : getTopKeys(current_time)) {
+        tk_jsonfunc(topkey.key, topkey.item, &context);
     }
 
     object["topkeys"] = topkeys;
     return ENGINE_SUCCESS;
 }
 
-void TopKeys::Shard::accept_visitor(iterfunc_t visitor_func,
-                                    void* visitor_ctx) {
-    std::lock_guard<std::mutex> lock(mutex);
-    for (const auto key : list) {
-        visitor_func(key->first.key, key->second, visitor_ctx);
+void TopKeys::ThreadKeys::accept_visitor(iterfunc_t visitor_func,
+                                         void* visitor_ctx,
+                                         rel_time_t current_time) const {
+    // Give up on a counter whose key is being replaced repeatedly.
+    const int maxAttempts = 10;
+    // (A read racing with the thread's own decay may see a count halved
+    // once more than it should be; it is only an estimate.)
+    const auto periods = getDecayPeriods(current_time);
+
+    std::array<uint64_t, KEY_WORDS> key;
+    const auto inUse = used.load(std::memory_order_acquire);
+    for (size_t ii = 0; ii < inUse; ++ii) {
+        const Counter& counter = counters[ii];
+        for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+            const auto seq = counter.seq.load(std::memory_order_acquire);
+            if (seq & 1) {
+                continue;
+            }
+            const size_t nkey = std::min(
+                    size_t(counter.nkey.load(std::memory_order_relaxed)),
+                    size_t(MAX_KEY_LENGTH));
+            const size_t words = (nkey + sizeof(uint64_t) - 1) /
+                                 sizeof(uint64_t);
+            for (size_t word = 0; word < words; ++word) {
+                key[word] = counter.key[word].load(std::memory_order_relaxed);
+            }
+            topkey_item_t item(counter.ctime.load(std::memory_order_relaxed));
+            item.ti_access_count = decayCount(
+                    counter.count.load(std::memory_order_relaxed), periods);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (counter.seq.load(std::memory_order_relaxed) == seq) {
+                visitor_func({reinterpret_cast<const char*>(key.data()), nkey},
+                             item,
+                             visitor_ctx);
+                break;
+            }
+        }
     }
 }
@@ -20,17 +20,17 @@
 #include <memcached/engine.h>
 #include <nlohmann/json_fwd.hpp>
 #include <platform/sized_buffer.h>
-#include <array>
 
-#include <mutex>
-#include <list>
+#include <array>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
 /*
  * TopKeys
  *
- * Tracks the top N most recently accessed keys. The details are
+ * Tracks the most frequently accessed keys. The details are
  * accessible by a stats call, which is used by ns_server to print the
  * top keys list in the GUI.
  */
@@ -49,13 +49,22 @@ struct topkey_item_t {
 class TopKeys {
 public:
     /* Constructor.
-     * @param mkeys Number of keys stored in each shard (i.e. up to
-     * mkeys * SHARDS will be tracked).
+     * @param mkeys Scales the number of keys reported; up to
+     * mkeys * KEYS_MULTIPLIER keys are returned by stats.
+     * @param numThreads Number of threads which update keys; each thread
+     * must pass a distinct threadIndex in [0, numThreads) to updateKey().
      */
-    explicit TopKeys(int mkeys);
+    TopKeys(int mkeys, size_t numThreads);
     ~TopKeys();
 
-    void updateKey(const void* key, size_t nkey, rel_time_t operation_time);
+    /**
+     * Record an access of the given key by the calling thread. Does not
+     * lock or (other than on a thread's first update) allocate.
+     */
+    void updateKey(const void* key,
+                   size_t nkey,
+                   rel_time_t operation_time,
+                   size_t threadIndex);
 
     ENGINE_ERROR_CODE stats(const void* cookie,
                             rel_time_t current_time,
@@ -78,8 +87,26 @@ public:
     ENGINE_ERROR_CODE json_stats(nlohmann::json& object,
                                  rel_time_t current_time);
 
+    /// The number of keys reported is mkeys * KEYS_MULTIPLIER. (Keys used to
+    /// be tracked in this many shards of mkeys each.)
+    static const int KEYS_MULTIPLIER = 8;
+
+    /// Each thread tracks this many times the number of keys reported, so
+    /// the reported keys are accurate despite Space-Saving's evictions.
+    static const int TRACKING_FACTOR = 4;
+
+    /// Longest key which is tracked.
+    static const size_t MAX_KEY_LENGTH = 256;
+
+    /// Every DECAY_INTERVAL seconds the access counts are halved, so a key
+    /// which is no longer accessed drops out of the top keys.
+    static const rel_time_t DECAY_INTERVAL = 60;
+
 protected:
-    void doUpdateKey(const void* key, size_t nkey, rel_time_t operation_time);
+    void doUpdateKey(const void* key,
+                     size_t nkey,
+                     rel_time_t operation_time,
+                     size_t threadIndex);
 
     ENGINE_ERROR_CODE doStats(const void* cookie,
                               rel_time_t current_time,
@@ -89,79 +116,112 @@ protected:
                                     rel_time_t current_time);
 
 private:
-    // Number of shards the keyspace is broken into. Permits some level of
-    // concurrent update (there is one mutex per shard).
-    static const int NUM_SHARDS = 8;
-
-    class Shard;
+    /// A key and its statistics, merged over all threads.
+    struct TopKey {
+        std::string key;
+        topkey_item_t item;
+    };
 
-    Shard& getShard(size_t key_hash);
+    /// @return the top keys over all threads, most accessed first.
+    std::vector<TopKey> getTopKeys(rel_time_t current_time);
 
-    // One of N Shards which the keyspace has been broken
-    // into.
-    // Responsible for tracking the top {mkeys} within it's keyspace.
-    class Shard {
+    // The keys accessed by a single thread, tracked with the Space-Saving
+    // algorithm: a fixed set of counters, where a key without a counter
+    // takes over the counter with the lowest count. Only the owning thread
+    // updates it; stats readers see a consistent copy of each counter via a
+    // per-counter sequence lock. The counts are halved every DECAY_INTERVAL.
+    class ThreadKeys {
     public:
+        ThreadKeys(size_t capacity, rel_time_t current_time);
 
-        void setMaxKeys(int mkeys) {
-            max_keys = mkeys;
-            storage.reserve(max_keys);
-            // reallocating storage invalidates the LRU list.
-            list.clear();
-        }
-
-        // Updates the topkey 'ranking' for the specified key.
-        // If the item does not exist it will be created (with it's creation
-        // time set to operation_time), otherwise the existing item will be
-        // updated.
-        // On success returns true, If insufficient memory to create a
-        // new item, returns false.
-        bool updateKey(const cb::const_char_buffer& key,
+        void updateKey(const cb::const_char_buffer& key,
                        size_t key_hash,
                        rel_time_t operation_time);
 
-        typedef void (*iterfunc_t)(const std::string& key,
+        typedef void (*iterfunc_t)(const cb::const_char_buffer& key,
                                    const topkey_item_t& it,
-                                   void *arg);
+                                   void* arg);
 
-        /* For each key in this shard, invoke the given callback function.
+        /* For each key tracked by this thread, invoke the given callback
+         * function with its count as of current_time (including any
+         * decay not yet applied by the thread). May be called concurrently
+         * with updateKey().
          */
-        void accept_visitor(iterfunc_t visitor_func, void* visitor_ctx);
+        void accept_visitor(iterfunc_t visitor_func,
+                            void* visitor_ctx,
+                            rel_time_t current_time) const;
 
     private:
+        static const size_t KEY_WORDS = MAX_KEY_LENGTH / sizeof(uint64_t);
+
+        // A counter. Every field is atomic so it may be read while the
+        // owning thread updates it; seq is odd while the key is replaced.
+        struct Counter {
+            std::atomic<uint32_t> seq{0};
+            std::atomic<uint32_t> nkey{0};
+            std::atomic<int> count{0};
+            std::atomic<rel_time_t> ctime{0};
+            std::array<std::atomic<uint64_t>, KEY_WORDS> key;
+        };
 
-        struct KeyId {
+        // Owner-only state of a counter, used to find it.
+        struct CounterState {
             size_t hash;
-            std::string key;
+            // Position of the counter in the heap.
+            uint32_t heapPos;
         };
 
-        // Pair of the key's string and the statistics related to it.
-        typedef std::pair<KeyId, topkey_item_t> topkey_t;
+        static const uint32_t EMPTY = ~uint32_t(0);
+
+        // @return the counter tracking key, or EMPTY.
+        uint32_t find(const cb::const_char_buffer& key, size_t key_hash) const;
 
-        // An ordered list of topkey_t*, used for LRU.
-        typedef std::list<topkey_t*> key_history_t;
+        bool keyEquals(const Counter& counter,
+                       const cb::const_char_buffer& key) const;
 
-        // Vector topket_t, used for actual topke storage.
-        typedef std::vector<topkey_t> key_storage_t;
+        void indexInsert(uint32_t counter);
+        void indexErase(uint32_t counter);
 
-        // Searches for the given key. If found returns a pointer to the
-        // topkey_t, else returns NULL.
-        topkey_t* searchForKey(size_t hash, const cb::const_char_buffer& key);
+        // Restore the heap order for the counter at the given heap position
+        // after its count has increased.
+        void siftDown(uint32_t pos);
 
-        // Maxumum numbers of keys to be tracked per shard.
-        unsigned int max_keys;
+        // Restore the heap order for a counter added at the given position.
+        void siftUp(uint32_t pos);
 
-        // mutex to serial access to this shard.
-        std::mutex mutex;
+        void swapHeap(uint32_t a, uint32_t b);
 
-        // list of keys, ordered from most-recently used (front) to least recently
-        // used (back).
-        key_history_t list;
+        // Halve every count once for each DECAY_INTERVAL since lastDecay.
+        void decay(rel_time_t current_time);
+
+        // @return the number of halvings due at current_time.
+        rel_time_t getDecayPeriods(rel_time_t current_time) const;
+
+        int getCount(uint32_t counter) const {
+            return counters[counter].count.load(std::memory_order_relaxed);
+        }
 
-        // Underlying topkey storage.
-        key_storage_t storage;
+        const size_t capacity;
+        // Number of counters in use; read by stats readers.
+        std::atomic<size_t> used{0};
+        // When the counts were last halved; read by stats readers.
+        std::atomic<rel_time_t> lastDecay;
+
+        std::unique_ptr<Counter[]> counters;
+        std::unique_ptr<CounterState[]> states;
+
+        // Min-heap of counter indexes, ordered by count.
+        std::unique_ptr<uint32_t[]> heap;
+
+        // Open-addressed (linear probing) hash index of counter indexes.
+        size_t indexMask;
+        std::unique_ptr<uint32_t[]> index;
     };
 
-    // array of topkey shards.
-    std::array<Shard, NUM_SHARDS> shards;
+    ThreadKeys* getThreadKeys(size_t threadIndex, rel_time_t operation_time);
+
+    const size_t reportedKeys;
+
+    // Per-thread key tracking, created on each thread's first update.
+    std::vector<std::atomic<ThreadKeys*>> threadKeys;
 };
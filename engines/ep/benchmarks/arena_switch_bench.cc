@@ -0,0 +1,95 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmark the cost of running an engine operation for a bucket with a
+ * dedicated allocator arena: ObjectRegistry::onSwitchThread() moves the
+ * thread to the bucket's arena and back around every engine call.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "daemon/alloc_hooks.h"
+
+#include <platform/cb_malloc.h>
+
+#include <vector>
+
+enum class ArenaMode : int {
+    /// The bucket uses the default arena - the thread never switches.
+    Default,
+    /// Dedicated arena, with the thread cache flushed on every switch.
+    FlushOnSwitch,
+    /// Dedicated arena, with the thread cache disabled (as switch_arena()
+    /// does for threads which use dedicated arenas).
+    NoThreadCache
+};
+
+/*
+ * Each iteration is one "operation": switch to the bucket's arena, make
+ * range(1) small allocations and free them, and switch back. Reports the
+ * operations per second as items_per_second.
+ */
+static void ArenaSwitchOperation(benchmark::State& state) {
+    const auto mode = ArenaMode(state.range(0));
+    unsigned arena = 0;
+    if (mode != ArenaMode::Default && !AllocHooks::create_arena(&arena)) {
+        state.SkipWithError("The allocator doesn't support arenas");
+        return;
+    }
+
+    // switch_arena() disables the thread cache the first time the thread
+    // switches to a dedicated arena; set it explicitly for each mode.
+    AllocHooks::switch_arena(arena);
+    AllocHooks::switch_arena(0);
+    AllocHooks::enable_thread_cache(mode != ArenaMode::NoThreadCache);
+
+    auto switchTo = [mode](unsigned to) {
+        AllocHooks::switch_arena(to);
+        if (mode == ArenaMode::FlushOnSwitch) {
+            AllocHooks::set_allocator_property(
+                    "thread.tcache.flush", nullptr, 0);
+        }
+    };
+
+    std::vector<void*> allocations(state.range(1));
+    while (state.KeepRunning()) {
+        switchTo(arena);
+        for (auto& ptr : allocations) {
+            ptr = cb_malloc(64);
+            benchmark::DoNotOptimize(ptr);
+        }
+        for (auto* ptr : allocations) {
+            cb_free(ptr);
+        }
+        switchTo(0);
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (mode != ArenaMode::Default) {
+        AllocHooks::release_arena(arena);
+    }
+    AllocHooks::enable_thread_cache(true);
+}
+
+BENCHMARK(ArenaSwitchOperation)
+        ->Args({int(ArenaMode::Default), 8})
+        ->Args({int(ArenaMode::FlushOnSwitch), 8})
+        ->Args({int(ArenaMode::NoThreadCache), 8})
+        ->Args({int(ArenaMode::Default), 64})
+        ->Args({int(ArenaMode::FlushOnSwitch), 64})
+        ->Args({int(ArenaMode::NoThreadCache), 64});
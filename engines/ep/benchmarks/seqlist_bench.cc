@@ -0,0 +1,138 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmarks comparing the SequenceList implementations used by ephemeral
+ * vBuckets, for the operations done by DCPBackfillMemoryBuffered and by
+ * front-end writes.
+ */
+
+#include "configuration.h"
+#include "hash_table.h"
+#include "indexed_linked_list.h"
+#include "item.h"
+#include "linked_list.h"
+#include "module_tests/test_helpers.h"
+#include "stats.h"
+#include "stored_value_factories.h"
+
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+enum class SeqListType { Basic, Indexed };
+
+/*
+ * Fixture holding a SequenceList of state.range(1) items.
+ * state.range(0) selects the implementation (SeqListType).
+ */
+class SeqListBench : public benchmark::Fixture {
+public:
+    SeqListBench()
+        : ht(stats,
+             std::make_unique<OrderedStoredValueFactory>(stats),
+             Configuration().getHtSize(),
+             Configuration().getHtLocks()) {
+    }
+
+    void SetUp(benchmark::State& state) override {
+        if (SeqListType(state.range(0)) == SeqListType::Indexed) {
+            list = std::make_unique<IndexedLinkedList>(Vbid(0), stats);
+        } else {
+            list = std::make_unique<BasicLinkedList>(Vbid(0), stats);
+        }
+        highSeqno = 0;
+        numItems = state.range(1);
+        ht.resize(numItems);
+        for (size_t i = 0; i < numItems; ++i) {
+            append("key" + std::to_string(i));
+        }
+    }
+
+    void TearDown(benchmark::State& state) override {
+        list.reset();
+        ht.clear();
+    }
+
+    void append(const std::string& keyStr) {
+        const std::string val("data");
+        std::mutex fakeSeqLock;
+        std::lock_guard<std::mutex> lg(fakeSeqLock);
+
+        const auto key = makeStoredDocKey(keyStr);
+        Item item(key, 0, 0, val.data(), val.length());
+        ASSERT_EQ(MutationStatus::WasClean, ht.set(item));
+        auto* osv = ht.find(key, TrackReference::No, WantsDeleted::No)
+                            ->toOrderedStoredValue();
+
+        std::lock_guard<std::mutex> listWriteLg(list->getListWriteLock());
+        list->appendToList(lg, listWriteLg, *osv);
+        osv->setBySeqno(++highSeqno);
+        list->updateHighSeqno(listWriteLg, *osv);
+    }
+
+    EPStats stats;
+    HashTable ht;
+    std::unique_ptr<SequenceList> list;
+    seqno_t highSeqno;
+    size_t numItems;
+};
+
+// Benchmark positioning a range iterator near the end of the list, as a
+// backfill for a DCP stream resuming from a recent seqno does.
+BENCHMARK_DEFINE_F(SeqListBench, RangeIteratorSeek)(benchmark::State& state) {
+    const seqno_t start = highSeqno - highSeqno / 10;
+    while (state.KeepRunning()) {
+        auto itr = list->makeRangeIterator(true /*isBackfill*/, start);
+        benchmark::DoNotOptimize(itr->curr());
+    }
+}
+
+// Benchmark a backfill reading the last 10% of the list.
+BENCHMARK_DEFINE_F(SeqListBench, BackfillTail)(benchmark::State& state) {
+    const seqno_t start = highSeqno - highSeqno / 10;
+    size_t itemsRead = 0;
+    while (state.KeepRunning()) {
+        auto itr = list->makeRangeIterator(true /*isBackfill*/, start);
+        while (itr->curr() != itr->end()) {
+            benchmark::DoNotOptimize((*(*itr)).getBySeqno());
+            ++(*itr);
+            ++itemsRead;
+        }
+    }
+    state.SetItemsProcessed(itemsRead);
+}
+
+// Benchmark front-end appends, to show the cost of maintaining the index.
+BENCHMARK_DEFINE_F(SeqListBench, Append)(benchmark::State& state) {
+    size_t iteration = 0;
+    while (state.KeepRunning()) {
+        append("append" + std::to_string(iteration++));
+    }
+}
+
+static void SeqListArgs(benchmark::internal::Benchmark* b) {
+    for (auto type : {SeqListType::Basic, SeqListType::Indexed}) {
+        for (int items : {10000, 1000000}) {
+            b->Args({int(type), items});
+        }
+    }
+    b->ArgNames({"indexed", "items"});
+}
+
+BENCHMARK_REGISTER_F(SeqListBench, RangeIteratorSeek)->Apply(SeqListArgs);
+BENCHMARK_REGISTER_F(SeqListBench, BackfillTail)->Apply(SeqListArgs);
+BENCHMARK_REGISTER_F(SeqListBench, Append)->Apply(SeqListArgs);
@@ -21,6 +21,8 @@
 
 #include "benchmark_memory_tracker.h"
 #include "checkpoint_manager.h"
+#include "dcp/dcpconnmap.h"
+#include "dcp/producer.h"
 #include "engine_fixture.h"
 #include "fakes/fake_executorpool.h"
 #include "stored_value_factories.h"
@@ -199,6 +201,57 @@ BENCHMARK_DEFINE_F(MemTrackingVBucketBench, QueueDirty)
     state.counters["PeakBytesPerItem"] = (peakBytes - baseBytes) / itemCount;
 }
 
+/**
+ * Benchmark queueing unique mutations directly into the CheckpointManager,
+ * reporting the memory retained per queued mutation (the Item itself plus
+ * the checkpoint list and index entries).
+ */
+BENCHMARK_DEFINE_F(MemTrackingVBucketBench, CheckpointQueueDirty)
+(benchmark::State& state) {
+    const auto itemCount = state.range(1);
+    auto* vb = engine->getKVBucket()->getVBucket(vbid).get();
+    auto& ckptMgr = *vb->checkpointManager;
+
+    int itemsQueuedTotal = 0;
+    size_t retainedBytes = 0;
+    size_t overheadBytes = 0;
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        const size_t baseBytes = memoryTracker->getCurrentAlloc();
+        const size_t baseOverhead = ckptMgr.getMemoryOverhead();
+        state.ResumeTiming();
+
+        for (int i = 0; i < itemCount; ++i) {
+            // A key long enough to not fit in a std::string inline buffer,
+            // as is typical of real document keys.
+            queued_item qi{new Item(
+                    StoredDocKey("checkpoint_key_" + std::to_string(i),
+                                 CollectionID::Default),
+                    vbid,
+                    queue_op::mutation,
+                    0,
+                    0)};
+            ckptMgr.queueDirty(*vb,
+                               qi,
+                               GenerateBySeqno::Yes,
+                               GenerateCas::Yes,
+                               /*preLinkDocCtx*/ nullptr);
+        }
+        itemsQueuedTotal += itemCount;
+
+        state.PauseTiming();
+        retainedBytes = memoryTracker->getCurrentAlloc() - baseBytes;
+        overheadBytes = ckptMgr.getMemoryOverhead() - baseOverhead;
+        ckptMgr.clear(*vb, 0);
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(itemsQueuedTotal);
+    state.counters["BytesPerMutation"] = retainedBytes / itemCount;
+    state.counters["OverheadBytesPerMutation"] = overheadBytes / itemCount;
+}
+
 BENCHMARK_DEFINE_F(MemTrackingVBucketBench, FlushVBucket)
 (benchmark::State& state) {
     const auto itemCount = state.range(1);
@@ -252,6 +305,64 @@ BENCHMARK_DEFINE_F(VBucketBench, CreateDeleteStoredValue)
     }
 }
 
+/*
+ * Benchmark front-end Sets into a vBucket which state.range(1) DCP producers
+ * are streaming from (as replicas, indexers, XDCR etc do). The streams are
+ * not drained, so this measures the cost each mutation pays to notify
+ * streams which already have items to send.
+ */
+BENCHMARK_DEFINE_F(VBucketBench, SetWithStreams)(benchmark::State& state) {
+    const auto numStreams = state.range(1);
+    auto& connMap = engine->getDcpConnMap();
+
+    std::vector<const void*> cookies;
+    for (int i = 0; i < numStreams; ++i) {
+        cookies.push_back(create_mock_cookie());
+        auto* producer = connMap.newProducer(
+                cookies.back(), "bench_" + std::to_string(i), /*flags*/ 0);
+        uint64_t rollbackSeqno;
+        ASSERT_EQ(ENGINE_SUCCESS,
+                  producer->streamRequest(
+                          /*flags*/ 0,
+                          /*opaque*/ i,
+                          vbid,
+                          /*start_seqno*/ 0,
+                          /*end_seqno*/ ~0ull,
+                          /*vb_uuid*/ 0,
+                          /*snap_start*/ 0,
+                          /*snap_end*/ 0,
+                          &rollbackSeqno,
+                          [](vbucket_failover_t*,
+                             size_t,
+                             gsl::not_null<const void*>) {
+                              return ENGINE_SUCCESS;
+                          },
+                          {}));
+    }
+
+    // Cycle over a fixed set of keys to bound the HashTable size.
+    std::vector<std::string> keys;
+    for (int i = 0; i < 1000; ++i) {
+        keys.push_back("key" + std::to_string(i));
+    }
+    const std::string value(1, 'x');
+    size_t itemsSet = 0;
+    while (state.KeepRunning()) {
+        auto item = make_item(vbid, keys[itemsSet % keys.size()], value);
+        ASSERT_EQ(ENGINE_SUCCESS, engine->getKVBucket()->set(item, cookie));
+        ++itemsSet;
+    }
+    state.SetItemsProcessed(itemsSet);
+
+    for (auto* c : cookies) {
+        connMap.disconnect(c);
+    }
+    connMap.manageConnections();
+    for (auto* c : cookies) {
+        destroy_mock_cookie(c);
+    }
+}
+
 /*
  * Measures resource contention between a mc::worker (front-end thread) adding
  * incoming mutations to the CheckpointManager (CM) and the
@@ -465,6 +576,16 @@ BENCHMARK_REGISTER_F(MemTrackingVBucketBench, QueueDirty)
         ->Args({10000})
         ->Args({1000000});
 
+BENCHMARK_REGISTER_F(VBucketBench, SetWithStreams)
+        ->ArgPair(0, 0)
+        ->ArgPair(0, 1)
+        ->ArgPair(0, 8)
+        ->ArgPair(0, 32);
+
+BENCHMARK_REGISTER_F(MemTrackingVBucketBench, CheckpointQueueDirty)
+        ->ArgPair(0, 10000)
+        ->ArgPair(0, 1000000);
+
 static void FlushArguments(benchmark::internal::Benchmark* b) {
     // Add both couchstore (0) and rocksdb (1) variants for a range of sizes.
     for (size_t items = 1; items <= 1000000; items *= 100) {
@@ -0,0 +1,62 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmarks for the per-vBucket collections manifest lookup which every
+ * key-based operation performs, as the number of threads accessing the same
+ * vBucket increases.
+ */
+
+#include "collections/vbucket_manifest.h"
+#include "module_tests/test_helpers.h"
+#include "sharded_rwlock.h"
+
+#include <benchmark/benchmark.h>
+#include <platform/rwlock.h>
+
+static Collections::VB::Manifest manifest({/* no collection data */});
+
+// Lookup of a key's collection, as performed by the front-end operations.
+static void BM_ManifestCachingReadHandle(benchmark::State& state) {
+    const auto key = makeStoredDocKey("key" +
+                                      std::to_string(state.thread_index));
+    while (state.KeepRunning()) {
+        auto handle = manifest.lock(key);
+        benchmark::DoNotOptimize(handle.valid());
+    }
+}
+BENCHMARK(BM_ManifestCachingReadHandle)->ThreadRange(1, 64)->UseRealTime();
+
+// For comparison: the cost of just taking the manifest's read lock, and of
+// taking a conventional (single reader count) cb::RWLock.
+static ShardedRWLock shardedLock;
+
+static void BM_ShardedRWLockRead(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        std::lock_guard<ShardedRWLock::ReaderLock> guard(shardedLock.reader());
+    }
+}
+BENCHMARK(BM_ShardedRWLockRead)->ThreadRange(1, 64)->UseRealTime();
+
+static cb::RWLock rwLock;
+
+static void BM_RWLockRead(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        std::lock_guard<cb::ReaderLock> guard(rwLock.reader());
+    }
+}
+BENCHMARK(BM_RWLockRead)->ThreadRange(1, 64)->UseRealTime();
@@ -114,7 +114,32 @@ size_t BgFetcher::doFetch(Vbid vbId, vb_bgfetch_queue_t& itemsToFetch) {
     return fetchedItems.size();
 }
 
+std::chrono::microseconds BgFetcher::getBatchWindow() const {
+    // Only worth waiting if requests are arriving concurrently; a lone
+    // fetch on an idle bucket should not pay any extra latency.
+    if (lastBatchSize <= 1) {
+        return std::chrono::microseconds(0);
+    }
+    const std::chrono::microseconds maxDelay(store->getEPEngine()
+                                                     .getConfiguration()
+                                                     .getBgfetcherMaxBatchDelayUs());
+    return std::min(maxDelay, lastBatchDuration / 2);
+}
+
 bool BgFetcher::run(GlobalTask *task) {
+    if (!batchWindowTaken) {
+        const auto window = getBatchWindow();
+        if (window.count() > 0) {
+            // Leave pendingFetch set while waiting, so further notifications
+            // don't wake the task early; they join this batch instead.
+            batchWindowTaken = true;
+            stats.getMultiWindowHisto.add(window);
+            task->snooze(std::chrono::duration<double>(window).count());
+            return true;
+        }
+    }
+    batchWindowTaken = false;
+
     // Setup to snooze forever, and *then* clear the pending flag.
     // The ordering of these two statements is important - if we were
     // to clear the flag *before* snoozing, then we could have a Lost
@@ -140,6 +165,7 @@ bool BgFetcher::run(GlobalTask *task) {
         pendingVbs.clear();
     }
 
+    const auto startTime = std::chrono::steady_clock::now();
     size_t num_fetched_items = 0;
     for (const auto vbId : bg_vbs) {
         VBucketPtr vb = shard->getBucket(vbId);
@@ -162,6 +188,9 @@ bool BgFetcher::run(GlobalTask *task) {
     }
 
     stats.numRemainingBgItems.fetch_sub(num_fetched_items);
+    lastBatchSize = num_fetched_items;
+    lastBatchDuration = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - startTime);
 
     return true;
 }
@@ -20,6 +20,7 @@
 
 #include "config.h"
 
+#include <chrono>
 #include <list>
 #include <set>
 #include <string>
@@ -46,8 +47,15 @@ public:
      * @param k  The shard to which this background fetcher belongs
      * @param st reference to statistics
      */
-    BgFetcher(KVBucket* s, KVShard* k, EPStats &st) :
-        store(s), shard(k), taskId(0), stats(st), pendingFetch(false) {}
+    BgFetcher(KVBucket* s, KVShard* k, EPStats& st)
+        : store(s),
+          shard(k),
+          taskId(0),
+          stats(st),
+          pendingFetch(false),
+          lastBatchSize(0),
+          batchWindowTaken(false) {
+    }
 
     /**
      * Construct a BgFetcher
@@ -81,6 +89,18 @@ private:
     /// been woken.
     void wakeUpTaskIfSnoozed();
 
+    /**
+     * Decide how long to wait for more fetches to be queued before
+     * processing the pending ones. Fetches for a vBucket are coalesced
+     * into a single getMulti() batch (read in key order from the index and
+     * in file order from the data), so briefly delaying under load gives
+     * larger batches. The wait adapts to the cost of the previous batch and
+     * is bounded by the bgfetcher_max_batch_delay_us config.
+     *
+     * @return the time to wait, zero if the fetches should run now.
+     */
+    std::chrono::microseconds getBatchWindow() const;
+
     KVBucket* store;
     KVShard* shard;
     size_t taskId;
@@ -89,6 +109,13 @@ private:
 
     std::atomic<bool> pendingFetch;
     std::set<Vbid> pendingVbs;
+
+    /// Number of items fetched and time taken by the previous run. Only
+    /// accessed by the task itself.
+    size_t lastBatchSize;
+    std::chrono::microseconds lastBatchDuration{0};
+    /// True if the current run has already waited for its batch window.
+    bool batchWindowTaken;
 };
 
 #endif  // SRC_BGFETCHER_H_
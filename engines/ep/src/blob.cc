@@ -20,6 +20,7 @@
 #include "objectregistry.h"
 
 #include <cstring>
+#include <memory>
 
 Blob* Blob::New(const char* start, const size_t len) {
     size_t total_len = getAllocationSize(len);
@@ -39,6 +40,40 @@ Blob* Blob::Copy(const Blob& other) {
     return t;
 }
 
+Blob* Blob::Append(const Blob& head, const char* start, const size_t len) {
+    return ChunkedBlob::Concat(
+            head, start, len, ChunkedBlob::Position::Back);
+}
+
+Blob* Blob::Prepend(const Blob& tail, const char* start, const size_t len) {
+    return ChunkedBlob::Concat(
+            tail, start, len, ChunkedBlob::Position::Front);
+}
+
+void Blob::Delete(Blob* blob) {
+    if (blob != nullptr && blob->isChunked()) {
+        delete static_cast<ChunkedBlob*>(blob);
+    } else {
+        delete blob;
+    }
+}
+
+cb::const_char_buffer Blob::getLeadingData() const {
+    if (!isChunked()) {
+        return {data, valueSize()};
+    }
+    const auto& chunked = static_cast<const ChunkedBlob&>(*this);
+    if (chunked.isFlattened()) {
+        return {getData(), valueSize()};
+    }
+    const auto& first = chunked.getSegments().front();
+    return {first->getData(), first->valueSize()};
+}
+
+const char* Blob::getFlattenedData() const {
+    return static_cast<const ChunkedBlob*>(this)->getFlattened()->getData();
+}
+
 Blob::Blob(const char* start, const size_t len)
     : size(static_cast<uint32_t>(len)), age(0) {
     if (start != NULL) {
@@ -55,17 +90,143 @@ Blob::Blob(const size_t len) : Blob(nullptr, len) {
 }
 
 Blob::Blob(const Blob& other)
-    : size(other.size.load()),
+    : // A copy of a chunked Blob is always contiguous.
+      size(other.size.load() & ~chunkedFlag),
       // While this is a copy, it is a new allocation therefore reset age.
       age(0) {
-    std::memcpy(data, other.data, other.valueSize());
+    std::memcpy(data, other.getData(), other.valueSize());
+    ObjectRegistry::onCreateBlob(this);
+}
+
+Blob::Blob(const size_t len, ChunkedTag)
+    : size(static_cast<uint32_t>(len) | chunkedFlag), age(0) {
     ObjectRegistry::onCreateBlob(this);
 }
 
 const std::string Blob::to_s() const {
-    return std::string(data, valueSize());
+    return std::string(getData(), valueSize());
 }
 
 Blob::~Blob() {
     ObjectRegistry::onDeleteBlob(this);
 }
+
+ChunkedBlob::ChunkedBlob(std::vector<value_t>&& segments, size_t len)
+    : Blob(len, ChunkedTag{}), segments(std::move(segments)) {
+}
+
+ChunkedBlob::~ChunkedBlob() {
+    delete flattened.load();
+}
+
+Blob* ChunkedBlob::Concat(const Blob& existing,
+                          const char* start,
+                          const size_t len,
+                          Position where) {
+    const size_t total = existing.valueSize() + len;
+    if (total < minChunkedSize) {
+        // Small enough that a plain copy is cheaper than chunking.
+        Blob* result = Blob::New(total);
+        const auto* existingData = existing.getData();
+        if (where == Position::Back) {
+            std::memcpy(result->data, existingData, existing.valueSize());
+            std::memcpy(result->data + existing.valueSize(), start, len);
+        } else {
+            std::memcpy(result->data, start, len);
+            std::memcpy(result->data + len, existingData, existing.valueSize());
+        }
+        return result;
+    }
+
+    // Share the segments of the existing value. If it has already been
+    // flattened then use that as a single (large) segment instead.
+    std::vector<value_t> segs;
+    if (existing.isChunked()) {
+        const auto& chunked = static_cast<const ChunkedBlob&>(existing);
+        auto* flat = chunked.flattened.load(std::memory_order_acquire);
+        if (flat != nullptr) {
+            segs.push_back(*flat);
+        } else {
+            segs = chunked.segments;
+        }
+    } else {
+        // existing is owned by a value_t in the caller, taking an additional
+        // reference here is safe.
+        segs.emplace_back(TaggedPtr<Blob>(const_cast<Blob*>(&existing)));
+    }
+
+    // Work out how many neighbouring segments the new data should absorb -
+    // merge while the neighbour is no larger than what we are building.
+    size_t mergedSize = len;
+    auto first = segs.begin();
+    auto last = segs.end();
+    if (where == Position::Back) {
+        while (last != segs.begin() && (*(last - 1))->valueSize() <= mergedSize) {
+            --last;
+            mergedSize += (*last)->valueSize();
+        }
+        first = last;
+        last = segs.end();
+    } else {
+        while (last != first && (*first)->valueSize() <= mergedSize) {
+            mergedSize += (*first)->valueSize();
+            ++first;
+        }
+        last = first;
+        first = segs.begin();
+    }
+
+    // Build the merged segment: [first, last) plus the new data.
+    Blob* merged = Blob::New(mergedSize);
+    char* dst = merged->data;
+    if (where == Position::Front) {
+        std::memcpy(dst, start, len);
+        dst += len;
+    }
+    for (auto it = first; it != last; ++it) {
+        std::memcpy(dst, (*it)->getData(), (*it)->valueSize());
+        dst += (*it)->valueSize();
+    }
+    if (where == Position::Back) {
+        std::memcpy(dst, start, len);
+    }
+
+    if (first == segs.begin() && last == segs.end()) {
+        // Absorbed everything - result is a plain Blob.
+        return merged;
+    }
+
+    const auto pos = segs.erase(first, last);
+    segs.emplace(pos, TaggedPtr<Blob>(merged));
+
+    if (segs.size() > maxSegments) {
+        return flatten(segs, total);
+    }
+    return new (::operator new(sizeof(ChunkedBlob)))
+            ChunkedBlob(std::move(segs), total);
+}
+
+Blob* ChunkedBlob::flatten(const std::vector<value_t>& segments, size_t len) {
+    Blob* result = Blob::New(len);
+    char* dst = result->data;
+    for (const auto& segment : segments) {
+        // Segments are always plain Blobs, getData() doesn't recurse.
+        std::memcpy(dst, segment->getData(), segment->valueSize());
+        dst += segment->valueSize();
+    }
+    return result;
+}
+
+const value_t& ChunkedBlob::getFlattened() const {
+    auto* flat = flattened.load(std::memory_order_acquire);
+    if (flat == nullptr) {
+        auto candidate = std::make_unique<value_t>(
+                TaggedPtr<Blob>(flatten(segments, valueSize())));
+        if (flattened.compare_exchange_strong(flat, candidate.get())) {
+            flat = candidate.release();
+        }
+        // Otherwise another thread published first; 'flat' now refers to
+        // its copy and ours is freed by candidate going out of scope.
+    }
+    return *flat;
+}
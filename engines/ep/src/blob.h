@@ -22,6 +22,12 @@
 #include "atomic.h"
 #include "tagged_ptr.h"
 
+#include <platform/sized_buffer.h>
+
+#include <vector>
+
+class ChunkedBlob;
+
 /**
  * A blob is a minimal sized storage for data up to 2^32 bytes long.
  */
@@ -50,24 +56,76 @@ public:
     static Blob* New(const size_t len);
 
     /**
-     * Creates an exact copy of the specified Blob.
+     * Creates an exact copy of the specified Blob. If the other Blob is
+     * chunked the copy is a single contiguous (flattened) Blob.
      */
     static Blob* Copy(const Blob& other);
 
+    /**
+     * Create a Blob holding the contents of head followed by the given data.
+     *
+     * For small results this is a plain contiguous Blob; for larger ones the
+     * new Blob is chunked - it references head's segments and only copies the
+     * appended data, so repeatedly appending to a document costs O(n log n)
+     * bytes copied rather than O(n^2). See ChunkedBlob.
+     *
+     * @param head the existing value to append to
+     * @param start the data to append
+     * @param len the amount of data to append
+     */
+    static Blob* Append(const Blob& head, const char* start, const size_t len);
+
+    /**
+     * Create a Blob holding the given data followed by the contents of tail.
+     * The mirror image of Append().
+     */
+    static Blob* Prepend(const Blob& tail, const char* start, const size_t len);
+
     // Actual accessorish things.
 
     /**
      * Get the pointer to the contents of the Value part of this Blob.
+     *
+     * For a chunked Blob this flattens the segments into a contiguous
+     * buffer on first access (the result is cached for later calls).
      */
     const char* getData() const {
-        return data;
+        return isChunked() ? getFlattenedData() : data;
     }
 
     /**
      * Get the size of this Blob's value.
      */
     size_t valueSize() const {
-        return size & ~(0x80000000);
+        return size & sizeMask;
+    }
+
+    /**
+     * Is this Blob's value held as a list of segments (see ChunkedBlob)
+     * rather than inline?
+     */
+    bool isChunked() const {
+        return (size & chunkedFlag) != 0;
+    }
+
+    /**
+     * Get the leading contiguous part of this Blob's value without
+     * flattening it - the whole value for a plain Blob, the first segment
+     * (or flattened copy if already built) for a chunked one.
+     */
+    cb::const_char_buffer getLeadingData() const;
+
+    /**
+     * Has this value been found to contain a JSON syntax error which no
+     * amount of appended data can fix? (e.g. a complete JSON object followed
+     * by more data). Allows APPEND to skip re-validating the whole document.
+     */
+    bool hasInvalidJSONPrefix() const {
+        return (size & invalidJSONPrefixFlag) != 0;
+    }
+
+    void setInvalidJSONPrefix() {
+        size |= invalidJSONPrefixFlag;
     }
 
     /**
@@ -77,6 +135,14 @@ public:
         return valueSize() + sizeof(Blob) - paddingSize;
     }
 
+    /**
+     * Get the number of bytes a (non-chunked) Blob holding a value of the
+     * given length needs.
+     */
+    static size_t getAllocationSize(size_t len) {
+        return sizeof(Blob) + len - sizeof(Blob(0, 0).data);
+    }
+
 
     /**
      * Returns how old this Blob is (how many epochs have passed since it was
@@ -109,7 +175,7 @@ public:
      * This should be fine given that the maximum value we support is 20 MiB
      */
     void setUncompressible() {
-        size |= 0x80000000;
+        size |= uncompressibleFlag;
     }
 
     /**
@@ -134,14 +200,31 @@ public:
     class Deleter {
     public:
         void operator()(TaggedPtr<Blob> item) {
-            delete item.get();
+            Blob::Delete(item.get());
         }
     };
 
+    /**
+     * Delete the given Blob, dispatching to the correct destructor for
+     * chunked Blobs (Blob has no vtable to keep its size to 12 bytes).
+     */
+    static void Delete(Blob* blob);
+
 private:
     //Ensure Blob size of 12 bytes by padding by 3.
     static constexpr int paddingSize{3};
 
+    // Flag bits stored in the top of 'size'; values are limited to 20 MiB
+    // so the remaining bits comfortably hold the length.
+    static constexpr uint32_t uncompressibleFlag{0x80000000};
+    static constexpr uint32_t chunkedFlag{0x40000000};
+    static constexpr uint32_t invalidJSONPrefixFlag{0x20000000};
+    static constexpr uint32_t sizeMask{
+            ~(uncompressibleFlag | chunkedFlag | invalidJSONPrefixFlag)};
+
+    /// Returns the (lazily flattened) contiguous data of a chunked Blob.
+    const char* getFlattenedData() const;
+
 protected:
     /* Constructor.
      * @param start If non-NULL, pointer to array which will be copied into
@@ -155,9 +238,14 @@ protected:
 
     explicit Blob(const Blob& other);
 
-    static size_t getAllocationSize(size_t len) {
-        return sizeof(Blob) + len - sizeof(Blob(0, 0).data);
-    }
+    /// Tag type selecting the chunked constructor.
+    struct ChunkedTag {};
+
+    /**
+     * Constructor used by ChunkedBlob - records the logical length of the
+     * value but does not allocate / copy any inline data.
+     */
+    Blob(const size_t len, ChunkedTag);
 
     // Size of the value. The highest bit is used to represent if the
     // value is compressible or not. If set, then the value is not
@@ -173,6 +261,7 @@ protected:
 
     DISALLOW_ASSIGN(Blob);
 
+    friend class ChunkedBlob;
     friend bool operator==(const Blob& lhs, const Blob& rhs);
     friend std::ostream& operator<<(std::ostream& os, const Blob& b);
 };
@@ -181,3 +270,79 @@ bool operator==(const Blob& lhs, const Blob& rhs);
 std::ostream& operator<<(std::ostream& os, const Blob& b);
 
 typedef SingleThreadedRCPtr<Blob, TaggedPtr<Blob>, Blob::Deleter> value_t;
+
+/**
+ * A Blob whose value is held as an ordered list of refcounted segments
+ * (themselves plain Blobs) instead of inline.
+ *
+ * Used for documents built up by APPEND / PREPEND: the new version of the
+ * document shares the segments of the previous version and only the newly
+ * added bytes are copied. Segments are kept in a "binary counter" shape -
+ * adjacent segments are merged whenever the newer one is at least as large
+ * as its neighbour - so there are O(log n) segments and each byte is copied
+ * O(log n) times over the life of the document.
+ *
+ * Segments are immutable once created, so a ChunkedBlob can be shared across
+ * threads like any other Blob. The contiguous representation needed by
+ * getData() (GET responses, persistence, DCP) is built lazily on first access
+ * and published with a single compare-exchange; subsequent appends reuse the
+ * flattened buffer as their first segment.
+ */
+class ChunkedBlob : public Blob {
+public:
+    /**
+     * Values smaller than this are always created as plain Blobs - the copy
+     * is cheap and avoids the cost of a later flatten.
+     */
+    static constexpr size_t minChunkedSize = 4096;
+
+    /**
+     * Upper bound on the number of segments. The merge policy keeps the
+     * count logarithmic in the value size; this is a safety net which
+     * flattens the value if it is ever exceeded.
+     */
+    static constexpr size_t maxSegments = 32;
+
+    ~ChunkedBlob();
+
+    /// @returns the segments making up this Blob's value, in order.
+    const std::vector<value_t>& getSegments() const {
+        return segments;
+    }
+
+    /// @returns true if the contiguous form of this Blob has been built.
+    bool isFlattened() const {
+        return flattened.load(std::memory_order_acquire) != nullptr;
+    }
+
+private:
+    friend class Blob;
+
+    enum class Position { Front, Back };
+
+    /**
+     * Build the value of existing + new data; either as a plain Blob or a
+     * ChunkedBlob depending on size.
+     */
+    static Blob* Concat(const Blob& existing,
+                        const char* start,
+                        const size_t len,
+                        Position where);
+
+    ChunkedBlob(std::vector<value_t>&& segments, size_t len);
+
+    /// Flatten the given segments into a new plain Blob of size len.
+    static Blob* flatten(const std::vector<value_t>& segments, size_t len);
+
+    /// @returns the flattened Blob, creating it if necessary.
+    const value_t& getFlattened() const;
+
+    const std::vector<value_t> segments;
+
+    /**
+     * Contiguous copy of the segments, created on first getData() call.
+     * Held via a heap-allocated value_t so it can be shared with later
+     * versions of the document (see Concat).
+     */
+    mutable std::atomic<value_t*> flattened{nullptr};
+};
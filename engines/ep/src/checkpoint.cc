@@ -123,7 +123,8 @@ void Checkpoint::setState_UNLOCKED(checkpoint_state state) {
 }
 
 bool Checkpoint::keyExists(const DocKey& key) {
-    return keyIndex.find(key) != keyIndex.end();
+    const StoredDocKey storedKey(key);
+    return keyIndex.find(storedKey) != keyIndex.end();
 }
 
 queue_dirty_t Checkpoint::queueDirty(const queued_item &qi,
@@ -226,14 +227,21 @@ queue_dirty_t Checkpoint::queueDirty(const queued_item &qi,
         index_entry entry = {--last, qi->getBySeqno()};
         // Set the index of the key to the new item that is pushed back into
         // the list.
+        auto& index = qi->isCheckPointMetaItem() ? metaKeyIndex : keyIndex;
         if (qi->isCheckPointMetaItem()) {
             // We add a meta item only once to a checkpoint
-            metaKeyIndex[qi->getKey()] = entry;
+            it = metaKeyIndex.find(qi->getKey());
+        }
+        if (it == index.end()) {
+            index.emplace(qi->getKey(), entry);
         } else {
-            keyIndex[qi->getKey()] = entry;
+            // The entry referred to the key of the item being replaced (which
+            // may have been freed) - refer to the new item's key instead.
+            it->first.repoint(qi->getKey());
+            it->second = entry;
         }
         if (rv == queue_dirty_t::NEW_ITEM) {
-            size_t newEntrySize = qi->getKey().size() +
+            size_t newEntrySize = sizeof(CheckpointIndexKey) +
                                   sizeof(index_entry) + sizeof(queued_item);
             memOverhead += newEntrySize;
             stats.coreLocal.get()->memOverhead.fetch_add(newEntrySize);
@@ -41,6 +41,9 @@
 #define DEFAULT_MAX_CHECKPOINTS 2
 #define MAX_CHECKPOINTS_UPPER_BOUND 5
 
+#define DEFAULT_CHECKPOINT_MEM_LOWER_MARK 30 // % of the bucket quota.
+#define DEFAULT_MAX_VBUCKETS 1024
+
 /**
  * The state of a given checkpoint.
  */
@@ -57,16 +60,67 @@ typedef std::list<queued_item> CheckpointQueue;
 
 /**
  * A checkpoint index entry.
+ *
+ * mutation_id is recorded when the item is queued rather than read back
+ * from the item at position: setOpenCheckpointId_UNLOCKED() re-seqnos the
+ * checkpoint_start and set_vbucket_state items after they've been indexed,
+ * and the cursor adjustment in queueDirty() relies on the original value.
  */
 struct index_entry {
     CheckpointQueue::iterator position;
     int64_t mutation_id;
 };
 
+/**
+ * The key of a checkpoint index entry.
+ *
+ * To avoid every queued mutation costing two copies of its key (one in the
+ * queued_item and one in the index), this refers to the key of the
+ * queued_item the index_entry points at rather than copying it. That item
+ * stays in the checkpoint for as long as the entry exists; when the key is
+ * de-duplicated the entry is re-pointed at the key of the new item (which is
+ * equal, so the entry's hash and place in the index are unchanged).
+ */
+class CheckpointIndexKey {
+public:
+    /// Implicit so the index can be searched by an Item's key.
+    CheckpointIndexKey(const StoredDocKey& key) : key(&key) {
+    }
+
+    /**
+     * Re-point at an equal key (i.e. of an item replacing the one this
+     * currently refers to).
+     */
+    void repoint(const StoredDocKey& newKey) const {
+        key = &newKey;
+    }
+
+    const StoredDocKey& get() const {
+        return *key;
+    }
+
+    bool operator==(const CheckpointIndexKey& other) const {
+        return *key == *other.key;
+    }
+
+private:
+    // Mutable so it can be re-pointed while in the index; see repoint().
+    mutable const StoredDocKey* key;
+};
+
+namespace std {
+template <>
+struct hash<CheckpointIndexKey> {
+    std::size_t operator()(const CheckpointIndexKey& key) const {
+        return key.get().hash();
+    }
+};
+} // namespace std
+
 /**
  * The checkpoint index maps a key to a checkpoint index_entry.
  */
-typedef std::unordered_map<StoredDocKey, index_entry> checkpoint_index;
+typedef std::unordered_map<CheckpointIndexKey, index_entry> checkpoint_index;
 
 class Checkpoint;
 class CheckpointManager;
@@ -515,7 +569,8 @@ public:
 
     /**
      * Returns the overhead of the checkpoint. For each item in the checkpoint,
-     * this is the sum of key size + sizeof(index_entry) + sizeof(queued_item).
+     * this is the sum of sizeof(CheckpointIndexKey) + sizeof(index_entry) +
+     * sizeof(queued_item) (the key itself is only held by the item).
      * When it comes to cursor dropping, this is the theoretical guaranteed
      * memory which can be freed, as the checkpoint contains the only references
      * to them.
@@ -37,6 +37,9 @@ public:
             config.setCheckpointMaxItems(value);
         } else if (key.compare("max_checkpoints") == 0) {
             config.setMaxCheckpoints(value);
+        } else if (key.compare("cursor_dropping_checkpoint_mem_lower_mark") ==
+                   0) {
+            config.setCheckpointMemLowerMark(value);
         }
     }
 
@@ -45,6 +48,8 @@ public:
             config.allowItemNumBasedNewCheckpoint(value);
         } else if (key.compare("keep_closed_chks") == 0) {
             config.allowKeepClosedCheckpoints(value);
+        } else if (key.compare("chk_mem_based_new_chk") == 0) {
+            config.allowMemBasedNewCheckpoint(value);
         }
     }
 
@@ -58,7 +63,10 @@ CheckpointConfig::CheckpointConfig()
       maxCheckpoints(DEFAULT_MAX_CHECKPOINTS),
       itemNumBasedNewCheckpoint(true),
       keepClosedCheckpoints(false),
-      persistenceEnabled(true) { /* empty */
+      persistenceEnabled(true),
+      memBasedNewCheckpoint(true),
+      checkpointMemLowerMark(DEFAULT_CHECKPOINT_MEM_LOWER_MARK),
+      maxVBuckets(DEFAULT_MAX_VBUCKETS) { /* empty */
 }
 
 CheckpointConfig::CheckpointConfig(rel_time_t period,
@@ -72,7 +80,10 @@ CheckpointConfig::CheckpointConfig(rel_time_t period,
       maxCheckpoints(max_ckpts),
       itemNumBasedNewCheckpoint(item_based_new_ckpt),
       keepClosedCheckpoints(keep_closed_ckpts),
-      persistenceEnabled(persistence_enabled) {
+      persistenceEnabled(persistence_enabled),
+      memBasedNewCheckpoint(true),
+      checkpointMemLowerMark(DEFAULT_CHECKPOINT_MEM_LOWER_MARK),
+      maxVBuckets(DEFAULT_MAX_VBUCKETS) {
 }
 
 CheckpointConfig::CheckpointConfig(EventuallyPersistentEngine& e) {
@@ -83,6 +94,10 @@ CheckpointConfig::CheckpointConfig(EventuallyPersistentEngine& e) {
     itemNumBasedNewCheckpoint = config.isItemNumBasedNewChk();
     keepClosedCheckpoints = config.isKeepClosedChks();
     persistenceEnabled = config.getBucketType() == "persistent";
+    memBasedNewCheckpoint = config.isChkMemBasedNewChk();
+    checkpointMemLowerMark =
+            config.getCursorDroppingCheckpointMemLowerMark();
+    maxVBuckets = config.getMaxVbuckets();
 }
 
 void CheckpointConfig::addConfigChangeListener(
@@ -103,6 +118,12 @@ void CheckpointConfig::addConfigChangeListener(
     configuration.addValueChangedListener(
             "keep_closed_chks",
             std::make_unique<ChangeListener>(engine.getCheckpointConfig()));
+    configuration.addValueChangedListener(
+            "chk_mem_based_new_chk",
+            std::make_unique<ChangeListener>(engine.getCheckpointConfig()));
+    configuration.addValueChangedListener(
+            "cursor_dropping_checkpoint_mem_lower_mark",
+            std::make_unique<ChangeListener>(engine.getCheckpointConfig()));
 }
 
 bool CheckpointConfig::validateCheckpointMaxItemsParam(
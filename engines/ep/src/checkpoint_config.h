@@ -64,6 +64,23 @@ public:
         return persistenceEnabled;
     }
 
+    bool isMemBasedNewCheckpoint() const {
+        return memBasedNewCheckpoint;
+    }
+
+    /**
+     * @return the checkpoint memory (as a percentage of the bucket quota)
+     *         cursor dropping aims to get down to; the budget memory based
+     *         checkpoint creation divides between vBuckets.
+     */
+    size_t getCheckpointMemLowerMark() const {
+        return checkpointMemLowerMark;
+    }
+
+    size_t getMaxVBuckets() const {
+        return maxVBuckets;
+    }
+
 protected:
     friend class CheckpointConfigChangeListener;
     friend class EventuallyPersistentEngine;
@@ -84,6 +101,14 @@ protected:
         keepClosedCheckpoints = value;
     }
 
+    void allowMemBasedNewCheckpoint(bool value) {
+        memBasedNewCheckpoint = value;
+    }
+
+    void setCheckpointMemLowerMark(size_t value) {
+        checkpointMemLowerMark = value;
+    }
+
     static void addConfigChangeListener(EventuallyPersistentEngine& engine);
 
 private:
@@ -106,4 +131,13 @@ private:
 
     // Flag indicating if persistence is enabled.
     bool persistenceEnabled;
+
+    // Flag indicating if a new checkpoint is created once the open
+    // checkpoint uses more than its share of checkpoint memory while memory
+    // usage is above the low water mark.
+    bool memBasedNewCheckpoint;
+    // Percentage of the bucket quota checkpoints should be kept under.
+    size_t checkpointMemLowerMark;
+    // Number of vBuckets the checkpoint memory budget is divided between.
+    size_t maxVBuckets;
 };
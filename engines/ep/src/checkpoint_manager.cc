@@ -26,6 +26,8 @@
 
 #include <gsl.h>
 
+#include <algorithm>
+
 CheckpointManager::CheckpointManager(EPStats& st,
                                      Vbid vbucket,
                                      CheckpointConfig& config,
@@ -381,7 +383,41 @@ bool CheckpointManager::isCheckpointCreationForHighMemUsage_UNLOCKED(
          openCkpt.getNumItems() == vbucket.ht.getNumInMemoryItems())) {
         forceCreation = true;
     }
-    return forceCreation;
+    return forceCreation || isOpenCheckpointOverMemLimit_UNLOCKED(lh);
+}
+
+bool CheckpointManager::isOpenCheckpointOverMemLimit_UNLOCKED(
+        const LockHolder& lh) {
+    if (!checkpointConfig.isMemBasedNewCheckpoint()) {
+        return false;
+    }
+    const auto& openCkpt = getOpenCheckpoint_UNLOCKED(lh);
+    if (openCkpt.getNumItems() < MIN_CHECKPOINT_ITEMS) {
+        return false;
+    }
+
+    const double memoryUsed = stats.getEstimatedTotalMemoryUsed();
+    const double lowWat = stats.mem_low_wat;
+    const double highWat = stats.mem_high_wat;
+    if (memoryUsed <= lowWat) {
+        return false;
+    }
+
+    // This vBucket's share of the checkpoint memory budget, scaled down
+    // linearly to an eighth of it as memory usage rises to the high water
+    // mark.
+    double limit = double(stats.getMaxDataSize()) *
+                   checkpointConfig.getCheckpointMemLowerMark() / 100 /
+                   std::max(checkpointConfig.getMaxVBuckets(), size_t(1));
+    const double minFactor = 0.125;
+    double factor = minFactor;
+    if (memoryUsed < highWat) {
+        factor = std::max(minFactor,
+                          (highWat - memoryUsed) / (highWat - lowWat));
+    }
+    limit *= factor;
+
+    return openCkpt.getMemConsumption() >= limit;
 }
 
 size_t CheckpointManager::removeClosedUnrefCheckpoints(
@@ -511,6 +547,10 @@ std::vector<Cursor> CheckpointManager::getListOfCursorsToDrop() {
         num_checkpoints_to_unref = 2;
     }
 
+    // Candidate cursors and the number of items each has remaining.
+    std::vector<std::pair<size_t, std::shared_ptr<CheckpointCursor>>>
+            candidates;
+
     auto it = checkpointList.begin();
     while (num_checkpoints_to_unref != 0 && it != checkpointList.end()) {
         if ((*it)->isEligibleToBeUnreferenced()) {
@@ -518,7 +558,9 @@ std::vector<Cursor> CheckpointManager::getListOfCursorsToDrop() {
             for (const auto& cursor : cursors) {
                 auto itr = connCursors.find(cursor);
                 if (itr != connCursors.end()) {
-                    cursorsToDrop.emplace_back(itr->second);
+                    candidates.emplace_back(
+                            getNumItemsForCursor_UNLOCKED(itr->second.get()),
+                            itr->second);
                 }
             }
         } else {
@@ -527,9 +569,53 @@ std::vector<Cursor> CheckpointManager::getListOfCursorsToDrop() {
         --num_checkpoints_to_unref;
         ++it;
     }
+
+    // Drop the slowest cursors first; the caller stops once enough memory
+    // has been freed, so cursors which are keeping up are spared a backfill
+    // where possible.
+    std::stable_sort(candidates.begin(),
+                     candidates.end(),
+                     [](const auto& a, const auto& b) {
+                         return a.first > b.first;
+                     });
+    for (const auto& candidate : candidates) {
+        cursorsToDrop.emplace_back(candidate.second);
+    }
     return cursorsToDrop;
 }
 
+size_t CheckpointManager::getMemoryPinnedByCursor(
+        const CheckpointCursor* cursor) const {
+    LockHolder lh(queueLock);
+    if (!cursor) {
+        return 0;
+    }
+    return getMemoryPinnedByCursor_UNLOCKED(lh, *cursor);
+}
+
+size_t CheckpointManager::getMemoryPinnedByCursor_UNLOCKED(
+        const LockHolder& lh, const CheckpointCursor& cursor) const {
+    size_t memUsage = 0;
+    bool found = false;
+    for (const auto& checkpoint : checkpointList) {
+        if (checkpoint->getState() == CHECKPOINT_OPEN) {
+            break;
+        }
+        const auto& cursors = checkpoint->getCursorNameList();
+        const auto count = cursors.count(cursor.name);
+        if (cursors.size() > count) {
+            // Referenced by some other cursor too.
+            break;
+        }
+        found = found || count > 0;
+        // Checkpoints before the cursor's are already unreferenced.
+        if (found) {
+            memUsage += checkpoint->getMemConsumption();
+        }
+    }
+    return memUsage;
+}
+
 bool CheckpointManager::hasClosedCheckpointWhichCanBeRemoved() const {
     LockHolder lh(queueLock);
     // Check oldest checkpoint; if closed and contains no cursors then
@@ -568,7 +654,8 @@ bool CheckpointManager::queueDirty(
 
     if (vb.getState() == vbucket_state_active && canCreateNewCheckpoint) {
         // Only the master active vbucket can create a next open checkpoint.
-        checkOpenCheckpoint_UNLOCKED(lh, false, true);
+        checkOpenCheckpoint_UNLOCKED(
+                lh, isOpenCheckpointOverMemLimit_UNLOCKED(lh), true);
     }
 
     auto& openCkpt = getOpenCheckpoint_UNLOCKED(lh);
@@ -1203,6 +1290,16 @@ void CheckpointManager::addStats(ADD_STAT add_stat, const void *cookie) {
                              cursor.second->name.c_str());
             add_casted_stat(
                     buf, cursor.second->numVisits.load(), add_stat, cookie);
+            checked_snprintf(buf,
+                             sizeof(buf),
+                             "vb_%d:%s:cursor_mem_pinned",
+                             vbucketId.get(),
+                             cursor.second->name.c_str());
+            add_casted_stat(buf,
+                            getMemoryPinnedByCursor_UNLOCKED(
+                                    lh, *cursor.second),
+                            add_stat,
+                            cookie);
             if (cursor.second.get() != persistenceCursor) {
                 checked_snprintf(buf,
                                  sizeof(buf),
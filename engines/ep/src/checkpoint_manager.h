@@ -300,10 +300,18 @@ public:
      */
     size_t getMemoryUsageOfUnrefCheckpoints() const;
 
+    /**
+     * Return the memory of the closed checkpoints which are referenced only
+     * by the given cursor, i.e. which would become unreferenced (and could be
+     * removed) if the cursor were dropped.
+     */
+    size_t getMemoryPinnedByCursor(const CheckpointCursor* cursor) const;
+
     /**
      * Function returns a list of cursors to drop so as to unreference
      * certain checkpoints within the manager, invoked by the cursor-dropper.
-     * @return a container of weak_ptr to cursors
+     * @return a container of weak_ptr to cursors, the cursors furthest behind
+     *         (with the most items remaining) first
      */
     std::vector<Cursor> getListOfCursorsToDrop();
 
@@ -460,6 +468,20 @@ protected:
     bool isCheckpointCreationForHighMemUsage_UNLOCKED(const LockHolder& lh,
                                                       const VBucket& vbucket);
 
+    /**
+     * Check if the open checkpoint should be closed because of its memory
+     * usage. While memory usage is above the low water mark each vBucket's
+     * open checkpoint is limited to its share of the checkpoint memory budget
+     * (cursor_dropping_checkpoint_mem_lower_mark of the quota), a limit which
+     * shrinks as memory usage approaches the high water mark. Closing
+     * checkpoints early lets cursors which keep up move on from them, so they
+     * can be removed without dropping any cursor.
+     */
+    bool isOpenCheckpointOverMemLimit_UNLOCKED(const LockHolder& lh);
+
+    size_t getMemoryPinnedByCursor_UNLOCKED(
+            const LockHolder& lh, const CheckpointCursor& cursor) const;
+
     void resetCursors(bool resetPersistenceCursor = true);
 
     queued_item createCheckpointItem(uint64_t id,
@@ -20,6 +20,7 @@
 #include "collections/collections_types.h"
 #include "collections/manifest.h"
 #include "collections/vbucket_manifest_entry.h"
+#include "sharded_rwlock.h"
 #include "systemevent.h"
 
 #include <platform/non_negative_counter.h>
@@ -77,7 +78,7 @@ public:
      */
     class ReadHandle {
     public:
-        ReadHandle(const Manifest& m, cb::RWLock& lock)
+        ReadHandle(const Manifest& m, ShardedRWLock& lock)
             : readLock(lock), manifest(m) {
         }
 
@@ -168,7 +169,9 @@ public:
     protected:
         friend std::ostream& operator<<(std::ostream& os,
                                         const Manifest::ReadHandle& readHandle);
-        std::unique_lock<cb::ReaderLock> readLock;
+        /// Movable, so it may be released by another thread. A thread must
+        /// not hold two ReadHandles of the same manifest (see ShardedRWLock).
+        ShardedRWLock::SharedLock readLock;
         const Manifest& manifest;
     };
 
@@ -200,7 +203,7 @@ public:
          *        should not be allowed, whereas a disk backfill is allowed
          */
         CachingReadHandle(const Manifest& m,
-                          cb::RWLock& lock,
+                          ShardedRWLock& lock,
                           DocKey key,
                           bool allowSystem)
             : ReadHandle(m, lock),
@@ -321,8 +324,8 @@ public:
      */
     class WriteHandle {
     public:
-        WriteHandle(Manifest& m, cb::RWLock& lock)
-            : writeLock(lock), manifest(m) {
+        WriteHandle(Manifest& m, ShardedRWLock& lock)
+            : writeLock(lock.writer()), manifest(m) {
         }
 
         WriteHandle(WriteHandle&& rhs)
@@ -411,7 +414,7 @@ public:
         }
 
     private:
-        std::unique_lock<cb::WriterLock> writeLock;
+        std::unique_lock<ShardedRWLock::WriterLock> writeLock;
         Manifest& manifest;
     };
 
@@ -877,9 +880,11 @@ protected:
     ManifestUid manifestUid{0};
 
     /**
-     * shared lock to allow concurrent readers and safe updates
+     * shared lock to allow concurrent readers and safe updates. Every
+     * key-based operation takes this for read, so it is sharded to keep
+     * readers from contending on a single reader count.
      */
-    mutable cb::RWLock rwlock;
+    mutable ShardedRWLock rwlock;
 
     friend std::ostream& operator<<(std::ostream& os, const Manifest& manifest);
 
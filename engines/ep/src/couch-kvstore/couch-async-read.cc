@@ -0,0 +1,484 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "config.h"
+
+#include "couch-kvstore/couch-async-read.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef HAVE_LIBURING
+#include <fcntl.h>
+#include <liburing.h>
+#include <unistd.h>
+
+namespace {
+/// Maximum number of reads a thread has in flight via io_uring.
+const unsigned ringDepth = 64;
+
+/// A thread's io_uring instance, created on first use.
+struct Ring {
+    Ring() {
+        ok = io_uring_queue_init(ringDepth, &ring, 0) == 0;
+    }
+
+    ~Ring() {
+        if (ok) {
+            io_uring_queue_exit(&ring);
+        }
+    }
+
+    io_uring ring;
+    bool ok;
+    /// Number of reads submitted and not yet reaped.
+    unsigned inflight = 0;
+};
+
+/// @return the calling thread's ring, or null if it could not be created.
+Ring* getRing() {
+    thread_local Ring ring;
+    return ring.ok ? &ring : nullptr;
+}
+
+/// @return true if the running kernel supports io_uring.
+bool isIoUringSupported() {
+    io_uring ring;
+    if (io_uring_queue_init(1, &ring, 0) != 0) {
+        return false;
+    }
+    io_uring_queue_exit(&ring);
+    return true;
+}
+} // anonymous namespace
+#endif
+
+AsyncReadOps::AsyncReadOps(FileOpsInterface& ops,
+                           Backend preferred,
+                           size_t numThreads,
+                           MicrosecondHistogram& waitHisto)
+    : wrapped_ops(ops), backend(Backend::ThreadPool), waitHisto(waitHisto) {
+#ifdef HAVE_LIBURING
+    if (preferred == Backend::IoUring && isIoUringSupported()) {
+        backend = Backend::IoUring;
+    }
+#endif
+    if (backend == Backend::ThreadPool) {
+        numThreads = std::max(numThreads, size_t(1));
+        for (size_t ii = 0; ii < numThreads; ++ii) {
+            cb_thread_t thread;
+            const auto name = "mc:async_io_" + std::to_string(ii);
+            if (cb_create_named_thread(
+                        &thread, launchIOThread, this, 0, name.c_str()) !=
+                0) {
+                throw std::runtime_error(
+                        "AsyncReadOps: Error creating I/O thread");
+            }
+            ioThreads.push_back(thread);
+        }
+    }
+}
+
+AsyncReadOps::~AsyncReadOps() {
+    // Any remaining batch was never submitted against a file (those which
+    // were are ended when the file is closed), so has no reads in flight.
+    {
+        std::lock_guard<std::mutex> lh(queueMutex);
+        stopping = true;
+    }
+    queueCond.notify_all();
+    for (auto& thread : ioThreads) {
+        cb_join_thread(thread);
+    }
+}
+
+void AsyncReadOps::prefetch(std::vector<Range> ranges) {
+    endPrefetch();
+    if (ranges.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lh(batchesMutex);
+    batches[std::this_thread::get_id()] =
+            std::make_unique<Batch>(std::move(ranges));
+    ++numBatches;
+}
+
+void AsyncReadOps::endPrefetch() {
+    std::unique_ptr<Batch> batch;
+    {
+        std::lock_guard<std::mutex> lh(batchesMutex);
+        auto it = batches.find(std::this_thread::get_id());
+        if (it == batches.end()) {
+            return;
+        }
+        batch = std::move(it->second);
+        batches.erase(it);
+        --numBatches;
+    }
+    drain(*batch);
+}
+
+AsyncReadOps::Batch* AsyncReadOps::getBatch() {
+    std::lock_guard<std::mutex> lh(batchesMutex);
+    auto it = batches.find(std::this_thread::get_id());
+    return it == batches.end() ? nullptr : it->second.get();
+}
+
+void AsyncReadOps::submit(Batch& batch, AsyncFile& file) {
+    batch.file = &file;
+
+#ifdef HAVE_LIBURING
+    if (backend == Backend::IoUring) {
+        if (file.fd < 0) {
+            file.fd = ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        if (file.fd < 0 || getRing() == nullptr) {
+            // Leave the batch empty; all reads go to the wrapped ops.
+            batch.ranges.clear();
+            return;
+        }
+    }
+#endif
+
+    // Round each range out to whole blocks (couchstore's read buffer reads
+    // whole blocks) and merge those which overlap or touch.
+    auto ranges = std::move(batch.ranges);
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<Range> merged;
+    size_t totalBytes = 0;
+    for (const auto& range : ranges) {
+        const cs_off_t start = range.first - (range.first % blockSize);
+        cs_off_t end = range.first + range.second;
+        end = ((end + blockSize - 1) / blockSize) * blockSize;
+        if (!merged.empty() &&
+            start <= merged.back().first + cs_off_t(merged.back().second)) {
+            auto& last = merged.back();
+            const cs_off_t lastEnd = last.first + last.second;
+            if (end > lastEnd) {
+                totalBytes += end - lastEnd;
+                last.second = end - last.first;
+            }
+        } else {
+            totalBytes += end - start;
+            merged.emplace_back(start, end - start);
+        }
+        if (totalBytes >= maxPrefetchBytes) {
+            break;
+        }
+    }
+
+    batch.reads.reserve(merged.size());
+    for (const auto& range : merged) {
+        batch.reads.push_back(
+                std::make_unique<Read>(batch, range.first, range.second));
+    }
+
+    if (backend == Backend::IoUring) {
+        submitToRing(batch);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lh(batch.mutex);
+        batch.outstanding = batch.reads.size();
+    }
+    {
+        std::lock_guard<std::mutex> lh(queueMutex);
+        for (auto& read : batch.reads) {
+            queue.push_back(read.get());
+        }
+    }
+    queueCond.notify_all();
+}
+
+bool AsyncReadOps::readFromBatch(Batch& batch,
+                                 void* buf,
+                                 size_t nbytes,
+                                 cs_off_t offset) {
+    auto it = std::upper_bound(
+            batch.reads.begin(),
+            batch.reads.end(),
+            offset,
+            [](cs_off_t off, const std::unique_ptr<Read>& read) {
+                return off < read->offset;
+            });
+    if (it == batch.reads.begin()) {
+        return false;
+    }
+    Read& read = **(--it);
+    const cs_off_t begin = offset - read.offset;
+    if (begin + nbytes > read.data.size()) {
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    waitFor(batch, read);
+    waitHisto.add(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start));
+
+    // A failed or short read leaves the region to the wrapped ops, which
+    // will report any error as normal.
+    if (read.result < 0 || begin + nbytes > size_t(read.result)) {
+        return false;
+    }
+    std::memcpy(buf, read.data.data() + begin, nbytes);
+    return true;
+}
+
+void AsyncReadOps::waitFor(Batch& batch, Read& read) {
+    if (backend == Backend::IoUring) {
+        while (!read.done) {
+            submitToRing(batch);
+            reapRing(batch);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lh(batch.mutex);
+    batch.cond.wait(lh, [&read]() { return read.done; });
+}
+
+void AsyncReadOps::drain(Batch& batch) {
+    if (backend == Backend::IoUring) {
+        batch.cancelled = true;
+        batch.nextToSubmit = batch.reads.size();
+        while (batch.outstanding > 0) {
+            reapRing(batch);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lh(batch.mutex);
+    batch.cancelled = true;
+    batch.cond.wait(lh, [&batch]() { return batch.outstanding == 0; });
+}
+
+void AsyncReadOps::launchIOThread(void* arg) {
+    static_cast<AsyncReadOps*>(arg)->runIOThread();
+}
+
+void AsyncReadOps::runIOThread() {
+    std::unique_lock<std::mutex> lh(queueMutex);
+    while (true) {
+        queueCond.wait(lh, [this]() { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+        Read* read = queue.front();
+        queue.pop_front();
+        lh.unlock();
+
+        Batch& batch = read->batch;
+        bool cancelled;
+        {
+            std::lock_guard<std::mutex> blh(batch.mutex);
+            cancelled = batch.cancelled;
+        }
+        ssize_t result = -1;
+        if (!cancelled) {
+            couchstore_error_info_t errinfo;
+            result = wrapped_ops.pread(&errinfo,
+                                       batch.file->orig_handle,
+                                       read->data.data(),
+                                       read->data.size(),
+                                       read->offset);
+        }
+        {
+            std::lock_guard<std::mutex> blh(batch.mutex);
+            read->result = result;
+            read->done = true;
+            --batch.outstanding;
+        }
+        batch.cond.notify_all();
+
+        lh.lock();
+    }
+}
+
+void AsyncReadOps::submitToRing(Batch& batch) {
+#ifdef HAVE_LIBURING
+    Ring* ring = getRing();
+    bool queued = false;
+    while (batch.nextToSubmit < batch.reads.size() &&
+           ring->inflight < ringDepth) {
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring->ring);
+        if (sqe == nullptr) {
+            break;
+        }
+        Read& read = *batch.reads[batch.nextToSubmit++];
+        io_uring_prep_read(sqe,
+                           batch.file->fd,
+                           read.data.data(),
+                           read.data.size(),
+                           read.offset);
+        io_uring_sqe_set_data(sqe, &read);
+        ++ring->inflight;
+        ++batch.outstanding;
+        queued = true;
+    }
+    if (queued) {
+        // Any entries the kernel does not accept now are submitted by the
+        // next reapRing().
+        io_uring_submit(&ring->ring);
+    }
+#else
+    throw std::logic_error(
+            "AsyncReadOps::submitToRing: built without io_uring support");
+#endif
+}
+
+void AsyncReadOps::reapRing(Batch& batch) {
+#ifdef HAVE_LIBURING
+    Ring* ring = getRing();
+    int rc;
+    do {
+        rc = io_uring_submit_and_wait(&ring->ring, 1);
+    } while (rc == -EINTR || rc == -EAGAIN);
+    if (rc < 0) {
+        throw std::system_error(-rc,
+                                std::system_category(),
+                                "AsyncReadOps::reapRing: "
+                                "io_uring_submit_and_wait");
+    }
+
+    // Completions may belong to any batch of this thread.
+    io_uring_cqe* cqe;
+    unsigned head;
+    unsigned count = 0;
+    io_uring_for_each_cqe(&ring->ring, head, cqe) {
+        auto* read = static_cast<Read*>(io_uring_cqe_get_data(cqe));
+        read->result = cqe->res;
+        read->done = true;
+        --read->batch.outstanding;
+        --ring->inflight;
+        ++count;
+    }
+    io_uring_cq_advance(&ring->ring, count);
+#else
+    throw std::logic_error(
+            "AsyncReadOps::reapRing: built without io_uring support");
+#endif
+}
+
+couch_file_handle AsyncReadOps::constructor(couchstore_error_info_t* errinfo) {
+    auto* af = new AsyncFile(wrapped_ops.constructor(errinfo));
+    return reinterpret_cast<couch_file_handle>(af);
+}
+
+couchstore_error_t AsyncReadOps::open(couchstore_error_info_t* errinfo,
+                                      couch_file_handle* h,
+                                      const char* path,
+                                      int flags) {
+    auto* af = reinterpret_cast<AsyncFile*>(*h);
+    if (backend == Backend::IoUring) {
+        af->path = path;
+    }
+    return wrapped_ops.open(errinfo, &af->orig_handle, path, flags);
+}
+
+couchstore_error_t AsyncReadOps::close(couchstore_error_info_t* errinfo,
+                                       couch_file_handle h) {
+    auto* af = reinterpret_cast<AsyncFile*>(h);
+    if (numBatches.load() != 0) {
+        auto* batch = getBatch();
+        if (batch && batch->file == af) {
+            endPrefetch();
+        }
+    }
+#ifdef HAVE_LIBURING
+    if (af->fd >= 0) {
+        ::close(af->fd);
+        af->fd = -1;
+    }
+#endif
+    return wrapped_ops.close(errinfo, af->orig_handle);
+}
+
+couchstore_error_t AsyncReadOps::set_periodic_sync(couch_file_handle h,
+                                                   uint64_t period_bytes) {
+    auto* af = reinterpret_cast<AsyncFile*>(h);
+    return wrapped_ops.set_periodic_sync(af->orig_handle, period_bytes);
+}
+
+ssize_t AsyncReadOps::pread(couchstore_error_info_t* errinfo,
+                            couch_file_handle h,
+                            void* buf,
+                            size_t sz,
+                            cs_off_t off) {
+    auto* af = reinterpret_cast<AsyncFile*>(h);
+    if (numBatches.load() != 0) {
+        auto* batch = getBatch();
+        if (batch) {
+            if (batch->file == nullptr) {
+                submit(*batch, *af);
+            }
+            if (batch->file == af && readFromBatch(*batch, buf, sz, off)) {
+                return sz;
+            }
+        }
+    }
+    return wrapped_ops.pread(errinfo, af->orig_handle, buf, sz, off);
+}
+
+ssize_t AsyncReadOps::pwrite(couchstore_error_info_t* errinfo,
+                             couch_file_handle h,
+                             const void* buf,
+                             size_t sz,
+                             cs_off_t off) {
+    auto* af = reinterpret_cast<AsyncFile*>(h);
+    return wrapped_ops.pwrite(errinfo, af->orig_handle, buf, sz, off);
+}
+
+cs_off_t AsyncReadOps::goto_eof(couchstore_error_info_t* errinfo,
+                                couch_file_handle h) {
+    auto* af = reinterpret_cast<AsyncFile*>(h);
+    return wrapped_ops.goto_eof(errinfo, af->orig_handle);
+}
+
+couchstore_error_t AsyncReadOps::sync(couchstore_error_info_t* errinfo,
+                                      couch_file_handle h) {
+    auto* af = reinterpret_cast<AsyncFile*>(h);
+    return wrapped_ops.sync(errinfo, af->orig_handle);
+}
+
+couchstore_error_t AsyncReadOps::advise(couchstore_error_info_t* errinfo,
+                                        couch_file_handle h,
+                                        cs_off_t offs,
+                                        cs_off_t len,
+                                        couchstore_file_advice_t adv) {
+    auto* af = reinterpret_cast<AsyncFile*>(h);
+    return wrapped_ops.advise(errinfo, af->orig_handle, offs, len, adv);
+}
+
+FileOpsInterface::FHStats* AsyncReadOps::get_stats(couch_file_handle h) {
+    auto* af = reinterpret_cast<AsyncFile*>(h);
+    return wrapped_ops.get_stats(af->orig_handle);
+}
+
+void AsyncReadOps::destructor(couch_file_handle h) {
+    auto* af = reinterpret_cast<AsyncFile*>(h);
+#ifdef HAVE_LIBURING
+    if (af->fd >= 0) {
+        ::close(af->fd);
+    }
+#endif
+    wrapped_ops.destructor(af->orig_handle);
+    delete af;
+}
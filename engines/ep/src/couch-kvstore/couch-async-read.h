@@ -0,0 +1,223 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include "config.h"
+
+#include <libcouchstore/couch_db.h>
+#include <platform/histogram.h>
+#include <platform/platform.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * FileOpsInterface implementation which allows a thread to issue the reads
+ * it is about to make ahead of time, so that many reads can be outstanding
+ * at once rather than couchstore blocking on each pread() in turn.
+ *
+ * A caller which knows which parts of a file it will read (for example the
+ * document bodies of a getMulti batch) passes them to prefetch(). When the
+ * calling thread next reads from a file, the ranges are submitted against
+ * that file; subsequent preads which fall within a prefetched range are
+ * served from it once it completes. Any other read, or one whose prefetch
+ * failed, goes to the wrapped FileOps as normal.
+ *
+ * Prefetched reads are issued via io_uring when built with liburing and
+ * supported by the running kernel, otherwise by a small pool of I/O threads.
+ */
+class AsyncReadOps : public FileOpsInterface {
+public:
+    enum class Backend { ThreadPool, IoUring };
+
+    /// A region of a file to read: offset and length in bytes.
+    using Range = std::pair<cs_off_t, size_t>;
+
+    /**
+     * @param ops FileOps to wrap
+     * @param backend The preferred backend. IoUring falls back to ThreadPool
+     *        if io_uring is not available.
+     * @param numThreads Number of I/O threads for the ThreadPool backend
+     * @param waitHisto Histogram of time spent waiting for prefetched reads
+     */
+    AsyncReadOps(FileOpsInterface& ops,
+                 Backend backend,
+                 size_t numThreads,
+                 MicrosecondHistogram& waitHisto);
+
+    ~AsyncReadOps() override;
+
+    /// @return the backend in use.
+    Backend getBackend() const {
+        return backend;
+    }
+
+    /**
+     * Prefetch the given ranges of the next file the calling thread reads
+     * from. Replaces any previous prefetch of the calling thread.
+     */
+    void prefetch(std::vector<Range> ranges);
+
+    /**
+     * Discard the calling thread's prefetch, waiting for any of its reads
+     * which are still in flight.
+     */
+    void endPrefetch();
+
+    couch_file_handle constructor(couchstore_error_info_t* errinfo) override;
+    couchstore_error_t open(couchstore_error_info_t* errinfo,
+                            couch_file_handle* handle,
+                            const char* path,
+                            int oflag) override;
+    couchstore_error_t close(couchstore_error_info_t* errinfo,
+                             couch_file_handle handle) override;
+    couchstore_error_t set_periodic_sync(couch_file_handle handle,
+                                         uint64_t period_bytes) override;
+    ssize_t pread(couchstore_error_info_t* errinfo,
+                  couch_file_handle handle,
+                  void* buf,
+                  size_t nbytes,
+                  cs_off_t offset) override;
+    ssize_t pwrite(couchstore_error_info_t* errinfo,
+                   couch_file_handle handle,
+                   const void* buf,
+                   size_t nbytes,
+                   cs_off_t offset) override;
+    cs_off_t goto_eof(couchstore_error_info_t* errinfo,
+                      couch_file_handle handle) override;
+    couchstore_error_t sync(couchstore_error_info_t* errinfo,
+                            couch_file_handle handle) override;
+    couchstore_error_t advise(couchstore_error_info_t* errinfo,
+                              couch_file_handle handle,
+                              cs_off_t offset,
+                              cs_off_t len,
+                              couchstore_file_advice_t advice) override;
+    FHStats* get_stats(couch_file_handle handle) override;
+    void destructor(couch_file_handle handle) override;
+
+    /// Prefetched ranges are rounded out to multiples of this size.
+    static const size_t blockSize = 4096;
+
+    /// Upper limit on the bytes prefetched by a single thread at once.
+    static const size_t maxPrefetchBytes = 16 * 1024 * 1024;
+
+protected:
+    struct AsyncFile {
+        explicit AsyncFile(couch_file_handle handle) : orig_handle(handle) {
+        }
+
+        couch_file_handle orig_handle;
+        /// Path the file was opened with, used to open fd on demand.
+        std::string path;
+        /// Read-only descriptor for io_uring reads; -1 if not open.
+        int fd = -1;
+    };
+
+    struct Batch;
+
+    struct Read {
+        Read(Batch& batch, cs_off_t offset, size_t length)
+            : batch(batch), offset(offset), data(length) {
+        }
+
+        Batch& batch;
+        const cs_off_t offset;
+        std::vector<char> data;
+        /// Bytes read, or negative on error. Valid once done is set.
+        ssize_t result = 0;
+        bool done = false;
+    };
+
+    /// The reads prefetched by one thread.
+    struct Batch {
+        explicit Batch(std::vector<Range> r) : ranges(std::move(r)) {
+        }
+
+        /// Ranges to read, until they are submitted against a file.
+        std::vector<Range> ranges;
+        /// The file the reads were submitted against; null until submitted.
+        AsyncFile* file = nullptr;
+        /// Reads, ordered by offset.
+        std::vector<std::unique_ptr<Read>> reads;
+
+        std::mutex mutex;
+        std::condition_variable cond;
+        /// Number of reads submitted but not yet completed.
+        size_t outstanding = 0;
+        /// Set when the batch is discarded; queued reads are skipped.
+        bool cancelled = false;
+        /// IoUring: index of the next read to submit.
+        size_t nextToSubmit = 0;
+    };
+
+    /// @return the calling thread's batch, or null if none.
+    Batch* getBatch();
+
+    /// Submit the batch's ranges as reads against the given file.
+    void submit(Batch& batch, AsyncFile& file);
+
+    /**
+     * Copy the given region from a completed prefetched read, waiting for
+     * it if necessary.
+     *
+     * @return true if the region was served from the batch
+     */
+    bool readFromBatch(Batch& batch, void* buf, size_t nbytes, cs_off_t offset);
+
+    /// Wait for the given read to complete.
+    void waitFor(Batch& batch, Read& read);
+
+    /// Cancel the batch and wait for all of its outstanding reads.
+    void drain(Batch& batch);
+
+    /// Main loop of the ThreadPool backend's I/O threads.
+    void runIOThread();
+
+    /// Entry point of the ThreadPool backend's I/O threads (arg is this).
+    static void launchIOThread(void* arg);
+
+    /// Submit as many of the batch's pending reads to io_uring as fit.
+    void submitToRing(Batch& batch);
+
+    /// Process io_uring completions, waiting for at least one.
+    void reapRing(Batch& batch);
+
+    FileOpsInterface& wrapped_ops;
+    Backend backend;
+    MicrosecondHistogram& waitHisto;
+
+    /// Number of entries in batches, to skip the lookup when zero.
+    std::atomic<size_t> numBatches{0};
+    std::mutex batchesMutex;
+    std::unordered_map<std::thread::id, std::unique_ptr<Batch>> batches;
+
+    /// ThreadPool backend state.
+    std::mutex queueMutex;
+    std::condition_variable queueCond;
+    std::deque<Read*> queue;
+    bool stopping = false;
+    std::vector<cb_thread_t> ioThreads;
+};
@@ -28,6 +28,7 @@
 #include <phosphor/phosphor.h>
 #include <platform/cb_malloc.h>
 #include <platform/dirutils.h>
+#include <snappy.h>
 #include <algorithm>
 #include <cctype>
 #include <cstdlib>
@@ -166,6 +167,33 @@ static DocKey makeDocKey(const sized_buf buf, bool restoreNamespace) {
                                    : DocKeyEncodesCollectionId::No);
 }
 
+/**
+ * A document body read found by the by-id lookup of a getMulti(). Body reads
+ * are deferred until the lookup completes so they can be issued in file
+ * offset order. The DocInfo is copied as couchstore frees its own once the
+ * lookup callback returns.
+ */
+struct GetMultiBodyRead {
+    GetMultiBodyRead(const DocInfo& info, vb_bgfetch_item_ctx_t& fetch)
+        : docinfo(info),
+          id(info.id.buf, info.id.size),
+          revMeta(info.rev_meta.buf, info.rev_meta.size),
+          fetch(&fetch) {
+    }
+
+    /// @return the DocInfo, pointing at this object's copies of its buffers
+    DocInfo* getDocInfo() {
+        docinfo.id = {&id[0], id.size()};
+        docinfo.rev_meta = {&revMeta[0], revMeta.size()};
+        return &docinfo;
+    }
+
+    DocInfo docinfo;
+    std::string id;
+    std::string revMeta;
+    vb_bgfetch_item_ctx_t* fetch;
+};
+
 struct GetMultiCbCtx {
     GetMultiCbCtx(CouchKVStore& c, Vbid v, vb_bgfetch_queue_t& f)
         : cks(c), vbId(v), fetches(f) {
@@ -174,6 +202,8 @@ struct GetMultiCbCtx {
     CouchKVStore &cks;
     Vbid vbId;
     vb_bgfetch_queue_t &fetches;
+    /// Full document reads, issued once the by-id lookup completes.
+    std::vector<GetMultiBodyRead> bodyReads;
 };
 
 struct AllKeysCtx {
@@ -273,7 +303,18 @@ CouchKVStore::CouchKVStore(KVStoreConfig& config,
       logger(config.getLogger()),
       base_ops(ops) {
     createDataDir(dbname);
-    statCollectingFileOps = getCouchstoreStatsOps(st.fsStats, base_ops);
+    FileOpsInterface* readOps = &base_ops;
+    const auto& asyncReads = configuration.getAsyncReads();
+    if (readOnly && asyncReads != "off") {
+        asyncReadOps = std::make_unique<AsyncReadOps>(
+                base_ops,
+                asyncReads == "io_uring" ? AsyncReadOps::Backend::IoUring
+                                         : AsyncReadOps::Backend::ThreadPool,
+                configuration.getAsyncReadThreads(),
+                st.asyncReadWaitHisto);
+        readOps = asyncReadOps.get();
+    }
+    statCollectingFileOps = getCouchstoreStatsOps(st.fsStats, *readOps);
     statCollectingFileOpsCompaction = getCouchstoreStatsOps(
         st.fsStatsCompaction, base_ops);
 
@@ -412,15 +453,13 @@ void CouchKVStore::set(const Item& itm,
     MutationRequestCallback requestcb;
     uint64_t fileRev = (*dbFileRevMap)[itm.getVBucketId().get()];
 
-    // each req will be de-allocated after commit
+    // each req will be destroyed after commit
     requestcb.setCb = &cb;
-    CouchRequest* req =
-            new CouchRequest(itm,
-                             fileRev,
-                             requestcb,
-                             deleteItem,
-                             configuration.shouldPersistDocNamespace());
-    pendingReqsQ.push_back(req);
+    pendingReqsQ.emplace_back(itm,
+                              fileRev,
+                              requestcb,
+                              deleteItem,
+                              configuration.shouldPersistDocNamespace());
 }
 
 GetValue CouchKVStore::get(const StoredDocKey& key, Vbid vb, bool fetchDelete) {
@@ -547,10 +586,39 @@ void CouchKVStore::getMulti(Vbid vb, vb_bgfetch_queue_t& itms) {
     }
 
     GetMultiCbCtx ctx(*this, vb, itms);
+    ctx.bodyReads.reserve(itms.size());
 
     errCode = couchstore_docinfos_by_id(
             db, ids.data(), itms.size(), 0, getMultiCbC, &ctx);
-    if (errCode != COUCHSTORE_SUCCESS) {
+    if (errCode == COUCHSTORE_SUCCESS) {
+        // The lookup returns documents in key order, which is unrelated to
+        // where their bodies are in the file. Read the bodies in file order
+        // instead, so the batch reads (mostly) forwards through the file and
+        // neighbouring bodies are served from couchstore's read buffer.
+        std::sort(ctx.bodyReads.begin(),
+                  ctx.bodyReads.end(),
+                  [](const GetMultiBodyRead& a, const GetMultiBodyRead& b) {
+                      return a.docinfo.bp < b.docinfo.bp;
+                  });
+        if (asyncReadOps && ctx.bodyReads.size() > 1) {
+            // Issue all the body reads up front. Each body is preceded by a
+            // chunk header and has a marker byte in each 4k block it spans,
+            // so allow for those on top of its size.
+            std::vector<AsyncReadOps::Range> ranges;
+            ranges.reserve(ctx.bodyReads.size());
+            for (const auto& read : ctx.bodyReads) {
+                const auto& info = read.docinfo;
+                ranges.emplace_back(info.bp, info.size + info.size / 4095 + 16);
+            }
+            asyncReadOps->prefetch(std::move(ranges));
+        }
+        for (auto& read : ctx.bodyReads) {
+            fetchForGetMulti(db, read.getDocInfo(), *read.fetch, vb);
+        }
+        if (asyncReadOps) {
+            asyncReadOps->endPrefetch();
+        }
+    } else {
         st.numGetFailure += numItems;
         logger.warn(
                 "CouchKVStore::getMulti: "
@@ -587,13 +655,11 @@ void CouchKVStore::del(const Item& itm, Callback<TransactionContext, int>& cb) {
     uint64_t fileRev = (*dbFileRevMap)[itm.getVBucketId().get()];
     MutationRequestCallback requestcb;
     requestcb.delCb = &cb;
-    CouchRequest* req =
-            new CouchRequest(itm,
-                             fileRev,
-                             requestcb,
-                             true,
-                             configuration.shouldPersistDocNamespace());
-    pendingReqsQ.push_back(req);
+    pendingReqsQ.emplace_back(itm,
+                              fileRev,
+                              requestcb,
+                              true,
+                              configuration.shouldPersistDocNamespace());
 }
 
 void CouchKVStore::delVBucket(Vbid vbucket, uint64_t fileRev) {
@@ -1895,7 +1961,7 @@ bool CouchKVStore::commit2couchstore(Collections::VB::Flush& collectionsFlush) {
 
     // Use the vbucket of the first item or the manifest item
     auto vbucket2flush =
-            pendingCommitCnt ? pendingReqsQ[0]->getVBucketId()
+            pendingCommitCnt ? pendingReqsQ.front().getVBucketId()
                              : collectionsFlush.getCollectionsManifestItem()
                                        ->getVBucketId();
 
@@ -1920,29 +1986,58 @@ bool CouchKVStore::commit2couchstore(Collections::VB::Flush& collectionsFlush) {
                         .to_string());
     }
 
-    std::vector<Doc*> docs(pendingCommitCnt);
-    std::vector<DocInfo*> docinfos(pendingCommitCnt);
+    // Compress the bodies before couchstore sees them, so that the time
+    // spent compressing is accounted separately from the time writing.
+    const bool precompress =
+            configuration.shouldPrecompressDocs() && pendingCommitCnt > 0;
+    if (precompress) {
+        auto compress_begin = std::chrono::steady_clock::now();
+        compressPendingBodies();
+        st.compressHisto.add(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - compress_begin));
+    }
+
+    auto encode_begin = std::chrono::steady_clock::now();
+    pendingDocs.clear();
+    pendingDocInfos.clear();
+    pendingDocs.reserve(pendingCommitCnt);
+    pendingDocInfos.reserve(pendingCommitCnt);
 
+    size_t commitBytes = 0;
     for (size_t i = 0; i < pendingCommitCnt; ++i) {
-        CouchRequest *req = pendingReqsQ[i];
-        docs[i] = (Doc *)req->getDbDoc();
-        docinfos[i] = req->getDbDocInfo();
-        if (vbucket2flush != req->getVBucketId()) {
+        CouchRequest& req = pendingReqsQ[i];
+        auto* doc = static_cast<Doc*>(req.getDbDoc());
+        pendingDocs.push_back(doc);
+        pendingDocInfos.push_back(req.getDbDocInfo());
+        if (doc) {
+            commitBytes += doc->data.size;
+        }
+        if (vbucket2flush != req.getVBucketId()) {
             throw std::logic_error(
                     "CouchKVStore::commit2couchstore: "
                     "mismatch between vbucket2flush (which is " +
                     vbucket2flush.to_string() + ") and pendingReqsQ[" +
                     std::to_string(i) + "] (which is " +
-                    req->getVBucketId().to_string() + ")");
+                    req.getVBucketId().to_string() + ")");
         }
     }
+    st.encodeHisto.add(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - encode_begin));
+    if (pendingCommitCnt) {
+        st.commitBytesHisto.add(commitBytes);
+    }
 
     // The docinfo callback needs to know if the CollectionID feature is on
     kvstats_ctx kvctx(configuration.shouldPersistDocNamespace(),
                       collectionsFlush);
     // flush all
-    couchstore_error_t errCode =
-            saveDocs(vbucket2flush, docs, docinfos, kvctx, collectionsFlush);
+    couchstore_error_t errCode = saveDocs(vbucket2flush,
+                                          pendingDocs,
+                                          pendingDocInfos,
+                                          kvctx,
+                                          collectionsFlush,
+                                          precompress);
 
     if (errCode) {
         success = false;
@@ -1956,13 +2051,45 @@ bool CouchKVStore::commit2couchstore(Collections::VB::Flush& collectionsFlush) {
     commitCallback(pendingReqsQ, kvctx, errCode);
 
     // clean up
-    for (size_t i = 0; i < pendingCommitCnt; ++i) {
-        delete pendingReqsQ[i];
-    }
     pendingReqsQ.clear();
+    if (compressedBodies.capacity() > maxRetainedCompressedBodies) {
+        // Don't hold on to the memory of an unusually large batch.
+        std::vector<char>().swap(compressedBodies);
+    }
     return success;
 }
 
+void CouchKVStore::compressPendingBodies() {
+    // Size the buffer for the worst case up front; the requests keep
+    // pointers into it so it must not be resized once we start compressing.
+    size_t bufferSize = 0;
+    for (auto& req : pendingReqsQ) {
+        if (req.needsCompression()) {
+            bufferSize += snappy::MaxCompressedLength(
+                    static_cast<Doc*>(req.getDbDoc())->data.size);
+        }
+    }
+    if (compressedBodies.size() < bufferSize) {
+        compressedBodies.resize(bufferSize);
+    }
+
+    size_t offset = 0;
+    for (auto& req : pendingReqsQ) {
+        if (!req.needsCompression()) {
+            continue;
+        }
+        const auto& body = static_cast<Doc*>(req.getDbDoc())->data;
+        size_t compressedSize = 0;
+        snappy::RawCompress(body.buf,
+                            body.size,
+                            compressedBodies.data() + offset,
+                            &compressedSize);
+        req.setCompressedBody({compressedBodies.data() + offset,
+                               compressedSize});
+        offset += compressedSize;
+    }
+}
+
 // Callback when the btree is updated which we use for tracking create/update
 // type statistics.
 static void saveDocsCallback(const DocInfo* oldInfo,
@@ -2002,7 +2129,8 @@ couchstore_error_t CouchKVStore::saveDocs(
         const std::vector<Doc*>& docs,
         std::vector<DocInfo*>& docinfos,
         kvstats_ctx& kvctx,
-        Collections::VB::Flush& collectionsFlush) {
+        Collections::VB::Flush& collectionsFlush,
+        bool precompressed) {
     couchstore_error_t errCode;
     DbInfo info;
     DbHolder db(*this);
@@ -2038,7 +2166,13 @@ couchstore_error_t CouchKVStore::saveDocs(
 
             auto cs_begin = std::chrono::steady_clock::now();
 
-            uint64_t flags = COMPRESS_DOC_BODIES | COUCHSTORE_SEQUENCE_AS_IS;
+            // Bodies which have been compressed already are written as-is;
+            // their DocInfo still carries COUCH_DOC_IS_COMPRESSED so they
+            // are inflated on read.
+            uint64_t flags = COUCHSTORE_SEQUENCE_AS_IS;
+            if (!precompressed) {
+                flags |= COMPRESS_DOC_BODIES;
+            }
             errCode = couchstore_save_documents_and_callback(
                     db,
                     docs.data(),
@@ -2135,22 +2269,20 @@ couchstore_error_t CouchKVStore::saveDocs(
     return errCode;
 }
 
-void CouchKVStore::commitCallback(std::vector<CouchRequest *> &committedReqs,
-                                  kvstats_ctx &kvctx,
+void CouchKVStore::commitCallback(std::deque<CouchRequest>& committedReqs,
+                                  kvstats_ctx& kvctx,
                                   couchstore_error_t errCode) {
-    size_t commitSize = committedReqs.size();
-
-    for (size_t index = 0; index < commitSize; index++) {
-        size_t dataSize = committedReqs[index]->getNBytes();
-        size_t keySize = committedReqs[index]->getKeySize();
+    for (auto& req : committedReqs) {
+        size_t dataSize = req.getNBytes();
+        size_t keySize = req.getKeySize();
         /* update ep stats */
         ++st.io_num_write;
         st.io_write_bytes += (keySize + dataSize);
 
-        if (committedReqs[index]->isDelete()) {
+        if (req.isDelete()) {
             int rv = getMutationStatus(errCode);
             if (rv != -1) {
-                const auto& key = committedReqs[index]->getKey();
+                const auto& key = req.getKey();
                 if (kvctx.keyStats[key]) {
                     rv = 1; // Deletion is for an existing item on DB file.
                 } else {
@@ -2160,23 +2292,21 @@ void CouchKVStore::commitCallback(std::vector<CouchRequest *> &committedReqs,
             if (errCode) {
                 ++st.numDelFailure;
             } else {
-                st.delTimeHisto.add(committedReqs[index]->getDelta());
+                st.delTimeHisto.add(req.getDelta());
             }
-            committedReqs[index]->getDelCallback()->callback(*transactionCtx,
-                                                             rv);
+            req.getDelCallback()->callback(*transactionCtx, rv);
         } else {
             int rv = getMutationStatus(errCode);
-            const auto& key = committedReqs[index]->getKey();
+            const auto& key = req.getKey();
             bool insertion = !kvctx.keyStats[key];
             if (errCode) {
                 ++st.numSetFailure;
             } else {
-                st.writeTimeHisto.add(committedReqs[index]->getDelta());
+                st.writeTimeHisto.add(req.getDelta());
                 st.writeSizeHisto.add(dataSize + keySize);
             }
             mutation_result p(rv, insertion);
-            committedReqs[index]->getSetCallback()->callback(*transactionCtx,
-                                                             p);
+            req.getSetCallback()->callback(*transactionCtx, p);
         }
     }
 }
@@ -2581,7 +2711,6 @@ int CouchKVStore::getMultiCb(Db *db, DocInfo *docinfo, void *ctx) {
     // Collections: TODO: Permanently restore to stored namespace
     DocKey key = makeDocKey(docinfo->id,
                             cbCtx->cks.getConfig().shouldPersistDocNamespace());
-    KVStoreStats& st = cbCtx->cks.getKVStoreStat();
 
     vb_bgfetch_queue_t::iterator qitr = cbCtx->fetches.find(key);
     if (qitr == cbCtx->fetches.end()) {
@@ -2598,15 +2727,29 @@ int CouchKVStore::getMultiCb(Db *db, DocInfo *docinfo, void *ctx) {
     }
 
     vb_bgfetch_item_ctx_t& bg_itm_ctx = (*qitr).second;
+    if (bg_itm_ctx.isMetaOnly == GetMetaOnly::No) {
+        // Defer reading the body until all the docinfos are known.
+        cbCtx->bodyReads.emplace_back(*docinfo, bg_itm_ctx);
+        return 0;
+    }
+
+    cbCtx->cks.fetchForGetMulti(db, docinfo, bg_itm_ctx, cbCtx->vbId);
+    return 0;
+}
+
+void CouchKVStore::fetchForGetMulti(Db* db,
+                                    DocInfo* docinfo,
+                                    vb_bgfetch_item_ctx_t& bg_itm_ctx,
+                                    Vbid vbId) {
     GetMetaOnly meta_only = bg_itm_ctx.isMetaOnly;
 
-    couchstore_error_t errCode = cbCtx->cks.fetchDoc(
-            db, docinfo, bg_itm_ctx.value, cbCtx->vbId, meta_only);
+    couchstore_error_t errCode =
+            fetchDoc(db, docinfo, bg_itm_ctx.value, vbId, meta_only);
     if (errCode != COUCHSTORE_SUCCESS && (meta_only == GetMetaOnly::No)) {
         st.numGetFailure++;
     }
 
-    bg_itm_ctx.value.setStatus(cbCtx->cks.couchErr2EngineErr(errCode));
+    bg_itm_ctx.value.setStatus(couchErr2EngineErr(errCode));
 
     bool return_val_ownership_transferred = false;
     for (auto& fetch : bg_itm_ctx.bgfetched_list) {
@@ -2623,14 +2766,12 @@ int CouchKVStore::getMultiCb(Db *db, DocInfo *docinfo, void *ctx) {
         }
     }
     if (!return_val_ownership_transferred) {
-        cbCtx->cks.logger.warn(
+        logger.warn(
                 "CouchKVStore::getMultiCb called with zero"
                 "items in bgfetched_list, {}, seqno:{}",
-                cbCtx->vbId,
+                vbId,
                 docinfo->rev_seq);
     }
-
-    return 0;
 }
 
 
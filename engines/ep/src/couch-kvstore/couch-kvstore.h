@@ -23,6 +23,7 @@
 #include "atomicqueue.h"
 #include "configuration.h"
 #include "couch-kvstore/couch-fs-stats.h"
+#include "couch-kvstore/couch-async-read.h"
 #include "couch-kvstore/couch-kvstore-metadata.h"
 #include "item.h"
 #include "kvstore.h"
@@ -34,6 +35,7 @@
 #include <platform/strerror.h>
 #include <relaxed_atomic.h>
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <string>
@@ -109,6 +111,27 @@ public:
         return &dbDocInfo;
     }
 
+    /**
+     * Does the document body need compressing before it is handed to
+     * couchstore?
+     *
+     * @return true if the document has a body flagged COUCH_DOC_IS_COMPRESSED
+     */
+    bool needsCompression() const {
+        return dbDoc.data.size > 0 &&
+               (dbDocInfo.content_meta & COUCH_DOC_IS_COMPRESSED);
+    }
+
+    /**
+     * Replace the body handed to couchstore with an already compressed
+     * copy. The buffer is owned by the caller and must outlive the commit.
+     *
+     * @param compressed the Snappy compressed body
+     */
+    void setCompressedBody(sized_buf compressed) {
+        dbDoc.data = compressed;
+    }
+
     /**
      * Get the length of a document body to be persisted
      *
@@ -159,6 +182,12 @@ struct kvstats_ctx;
 class CouchKVStore : public KVStore
 {
 public:
+    /**
+     * Most capacity kept in the pre-compression buffer between commits; a
+     * larger (unusually big) batch's buffer is released once committed.
+     */
+    static const size_t maxRetainedCompressedBodies = 4 * 1024 * 1024;
+
     /**
      * Constructor - creates a read/write CouchKVStore
      *
@@ -405,6 +434,15 @@ public:
     static int recordDbDump(Db *db, DocInfo *docinfo, void *ctx);
     static int recordDbStat(Db *db, DocInfo *docinfo, void *ctx);
     static int getMultiCb(Db *db, DocInfo *docinfo, void *ctx);
+
+    /**
+     * Fetch the document described by docinfo for a getMulti() request and
+     * hand the result to every waiting bgfetch of that key.
+     */
+    void fetchForGetMulti(Db* db,
+                          DocInfo* docinfo,
+                          vb_bgfetch_item_ctx_t& bg_itm_ctx,
+                          Vbid vbId);
     ENGINE_ERROR_CODE readVBState(Db* db, Vbid vbId);
 
     couchstore_error_t fetchDoc(Db* db,
@@ -566,6 +604,8 @@ protected:
      * @param kvctx a stats context object to update
      * @param collectionsManifest a pointer to an item which contains the
      *        manifest update data (can be nullptr)
+     * @param precompressed true if the document bodies flagged as
+     *        COUCH_DOC_IS_COMPRESSED have already been compressed
      *
      * @returns COUCHSTORE_SUCCESS or a failure code (failure paths log)
      */
@@ -573,9 +613,17 @@ protected:
                                 const std::vector<Doc*>& docs,
                                 std::vector<DocInfo*>& docinfos,
                                 kvstats_ctx& kvctx,
-                                Collections::VB::Flush& collectionsFlush);
+                                Collections::VB::Flush& collectionsFlush,
+                                bool precompressed);
 
-    void commitCallback(std::vector<CouchRequest *> &committedReqs,
+    /**
+     * Snappy compress the bodies of all pending requests which need it into
+     * the (reused) compressedBodies buffer, and point the requests at their
+     * compressed copies.
+     */
+    void compressPendingBodies();
+
+    void commitCallback(std::deque<CouchRequest>& committedReqs,
                         kvstats_ctx &kvctx,
                         couchstore_error_t errCode);
     couchstore_error_t saveVBState(Db *db, const vbucket_state &vbState);
@@ -671,10 +719,34 @@ protected:
     cb::RWLock openDbMutex;
 
     uint16_t numDbFiles;
-    std::vector<CouchRequest *> pendingReqsQ;
+    /**
+     * Requests queued by set()/del() for the next commit. A deque so that
+     * requests are constructed in place in blocks (rather than one heap
+     * allocation each) and don't move once queued - couchstore's Doc and
+     * DocInfo point into them.
+     */
+    std::deque<CouchRequest> pendingReqsQ;
+
+    /**
+     * The Doc / DocInfo arrays handed to couchstore, and the buffer holding
+     * pre-compressed document bodies. Kept across commits so the flusher
+     * reuses their capacity instead of re-allocating them for every batch
+     * (up to maxRetainedCompressedBodies for the buffer).
+     */
+    std::vector<Doc*> pendingDocs;
+    std::vector<DocInfo*> pendingDocInfos;
+    std::vector<char> compressedBodies;
     bool intransaction;
     std::unique_ptr<TransactionContext> transactionCtx;
 
+    /**
+     * FileOpsInterface implementation which issues the document reads of a
+     * getMulti() ahead of couchstore. Only created for read-only stores
+     * when enabled by couchstore_async_reads; wraps base_ops and is
+     * wrapped by statCollectingFileOps.
+     */
+    std::unique_ptr<AsyncReadOps> asyncReadOps;
+
     /**
      * FileOpsInterface implementation for couchstore which tracks
      * all bytes read/written by couchstore *except* compaction.
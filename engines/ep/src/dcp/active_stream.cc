@@ -18,6 +18,7 @@
 #include "active_stream_impl.h"
 
 #include "checkpoint_manager.h"
+#include "dcp/dcpconnmap.h"
 #include "dcp/producer.h"
 #include "ep_time.h"
 #include "kv_bucket.h"
@@ -134,6 +135,10 @@ std::unique_ptr<DcpResponse> ActiveStream::next(
         std::lock_guard<std::mutex>& lh) {
     std::unique_ptr<DcpResponse> response;
 
+    // Read before looking for items; see armVBNotification() below.
+    auto& connMap = engine->getDcpConnMap();
+    const auto notifyCount = connMap.getVBNotifyCount(vb_);
+
     switch (state_.load()) {
     case StreamState::Pending:
         break;
@@ -167,7 +172,16 @@ std::unique_ptr<DcpResponse> ActiveStream::next(
         break;
     }
 
-    itemsReady.store(response ? true : false);
+    if (response) {
+        itemsReady.store(true);
+    } else {
+        itemsReady.store(false);
+        // Ask for the next mutation to notify us, and re-notify ourselves if
+        // one arrived while we were looking (it may not have visited us).
+        if (connMap.armVBNotification(vb_, notifyCount)) {
+            notifyStreamReady();
+        }
+    }
     return response;
 }
 
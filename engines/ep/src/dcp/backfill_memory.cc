@@ -187,16 +187,17 @@ backfill_status_t DCPBackfillMemoryBuffered::create() {
         return backfill_finished;
     }
 
-    /* Create range read cursor */
+    /* Create range read cursor, positioned at startSeqno */
     try {
-        auto rangeItrOptional = evb->makeRangeIterator(true /*isBackfill*/);
+        auto rangeItrOptional = evb->makeRangeIterator(
+                true /*isBackfill*/, static_cast<seqno_t>(startSeqno));
         if (rangeItrOptional) {
             rangeItr = std::move(*rangeItrOptional);
         } else {
             stream->log(spdlog::level::level_enum::debug,
                         "{}"
-                        " Deferring backfill creation as another "
-                        "range iterator is already on the sequence list",
+                        " Deferring backfill creation as a range "
+                        "iterator cannot be created on the sequence list",
                         getVBucketId());
             return backfill_snooze;
         }
@@ -225,8 +226,8 @@ backfill_status_t DCPBackfillMemoryBuffered::create() {
         return backfill_finished;
     }
 
-    /* Advance the cursor till start, mark snapshot and update backfill
-       remaining count */
+    /* Advance the cursor till start (if the iterator is not already there),
+       mark snapshot and update backfill remaining count */
     while (rangeItr.curr() != rangeItr.end()) {
         if (static_cast<uint64_t>((*rangeItr).getBySeqno()) >= startSeqno) {
             /* Incr backfill remaining
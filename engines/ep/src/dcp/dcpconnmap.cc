@@ -44,7 +44,8 @@ private:
 
 DcpConnMap::DcpConnMap(EventuallyPersistentEngine &e)
     : ConnMap(e),
-      aggrDcpConsumerBufferSize(0) {
+      aggrDcpConsumerBufferSize(0),
+      vbNotifications(e.getConfiguration().getMaxVbuckets()) {
     backfills.numActiveSnoozing = 0;
     updateMaxActiveSnoozingBackfills(engine.getEpStats().getMaxDataSize());
     minCompressionRatioForProducer.store(
@@ -395,6 +396,16 @@ void DcpConnMap::removeVBConnections(DcpProducer& prod) {
 }
 
 void DcpConnMap::notifyVBConnections(Vbid vbid, uint64_t bySeqno) {
+    auto& notification = vbNotifications[vbid.get()];
+    notification->count.fetch_add(1);
+
+    // Unless a stream has asked to be notified since the streams were last
+    // visited they all have items to send. The load avoids writing the
+    // (shared) flag when it's clear, which is most of the time.
+    if (!notification->armed.load() || !notification->armed.exchange(false)) {
+        return;
+    }
+
     size_t lock_num = vbid.get() % vbConnLockNum;
     std::lock_guard<std::mutex> lh(vbConnLocks[lock_num]);
 
@@ -406,6 +417,20 @@ void DcpConnMap::notifyVBConnections(Vbid vbid, uint64_t bySeqno) {
     }
 }
 
+uint64_t DcpConnMap::getVBNotifyCount(Vbid vbid) const {
+    return vbNotifications[vbid.get()]->count.load();
+}
+
+bool DcpConnMap::armVBNotification(Vbid vbid, uint64_t notifyCount) {
+    auto& notification = vbNotifications[vbid.get()];
+    notification->armed.store(true);
+
+    // A notification issued after the stream last looked for items but
+    // before we armed may have skipped visiting the streams. The count was
+    // bumped before that notification tested the flag, so we see it here.
+    return notification->count.load() != notifyCount;
+}
+
 void DcpConnMap::notifyBackfillManagerTasks() {
     LockHolder lh(connsLock);
     for (const auto& cookieToConn : map_) {
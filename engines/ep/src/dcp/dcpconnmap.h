@@ -22,11 +22,13 @@
 #include "connmap.h"
 
 #include <memcached/engine.h>
+#include <platform/cacheline_padded.h>
 #include <platform/sized_buffer.h>
 
 #include <atomic>
 #include <list>
 #include <string>
+#include <vector>
 
 class CheckpointCursor;
 class DcpProducer;
@@ -60,8 +62,38 @@ public:
      */
     DcpConsumer *newConsumer(const void* cookie, const std::string &name);
 
+    /**
+     * Notify the DCP streams of a vBucket that a new seqno (e.g. a
+     * mutation) is available.
+     *
+     * This is called for every front-end mutation, so the streams of the
+     * vBucket are only visited if one of them has run out of items to send
+     * (see armVBNotification()) since they were last visited. Otherwise all
+     * we do is bump the vBucket's notification count; the streams already
+     * have items to send and will pick this seqno up when they get to it.
+     * Back to back and concurrent notifications are hence coalesced into at
+     * most one visit per batch a stream sends.
+     */
     void notifyVBConnections(Vbid vbid, uint64_t bySeqno);
 
+    /**
+     * @return the number of notifications issued (by notifyVBConnections)
+     *         for the given vBucket so far.
+     */
+    uint64_t getVBNotifyCount(Vbid vbid) const;
+
+    /**
+     * Called by a stream of the given vBucket which has run out of items to
+     * send, so that the next notification of the vBucket visits its streams.
+     *
+     * @param vbid the vBucket the stream belongs to
+     * @param notifyCount the value of getVBNotifyCount() from before the
+     *        stream last looked for items
+     * @return true if there have been notifications since notifyCount,
+     *         which the stream may have missed
+     */
+    bool armVBNotification(Vbid vbid, uint64_t notifyCount);
+
     void notifyBackfillManagerTasks();
 
     void removeVBConnections(DcpProducer& prod);
@@ -203,5 +235,16 @@ protected:
     /* Total memory used by all DCP consumer buffers */
     std::atomic<size_t> aggrDcpConsumerBufferSize;
 
+    /// Per-vBucket notification state, see notifyVBConnections()
+    struct VBNotification {
+        /// Number of notifications issued for the vBucket
+        std::atomic<uint64_t> count{0};
+        /// Set when a stream of the vBucket is waiting to be notified
+        std::atomic<bool> armed{true};
+    };
+
+    /// Indexed by vBucket id; padded as written on every mutation
+    std::vector<cb::CachelinePadded<VBNotification>> vbNotifications;
+
     class DcpConfigChangeListener;
 };
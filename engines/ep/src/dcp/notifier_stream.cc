@@ -18,6 +18,7 @@
 #include "notifier_stream.h"
 
 #include "bucket_logger.h"
+#include "dcp/dcpconnmap.h"
 #include "dcp/producer.h"
 #include "dcp/response.h"
 #include "ep_engine.h"
@@ -48,6 +49,7 @@ NotifierStream::NotifierStream(EventuallyPersistentEngine* e,
              snap_start_seqno,
              snap_end_seqno,
              Type::Notifier),
+      engine(e),
       producerPtr(p) {
     LockHolder lh(streamMutex);
     VBucketPtr vbucket = e->getVBucket(vb_);
@@ -81,7 +83,10 @@ uint32_t NotifierStream::setDead(end_stream_status_t status) {
 
 void NotifierStream::notifySeqnoAvailable(uint64_t seqno) {
     std::unique_lock<std::mutex> lh(streamMutex);
-    if (isActive() && start_seqno_ < seqno) {
+    if (isActive()) {
+        if (start_seqno_ >= seqno && !waitForSeqno()) {
+            return;
+        }
         pushToReadyQ(std::make_unique<StreamEndResponse>(
                 opaque_, END_STREAM_OK, vb_));
         transitionState(StreamState::Dead);
@@ -90,12 +95,28 @@ void NotifierStream::notifySeqnoAvailable(uint64_t seqno) {
     }
 }
 
+bool NotifierStream::waitForSeqno() {
+    // Ask for the next notification of the vBucket to visit us. One which
+    // was issued before we did so may have skipped us, so check the high
+    // seqno afterwards (its seqno is visible by then).
+    auto& connMap = engine->getDcpConnMap();
+    connMap.armVBNotification(vb_, connMap.getVBNotifyCount(vb_));
+    VBucketPtr vbucket = engine->getVBucket(vb_);
+    return vbucket &&
+           static_cast<uint64_t>(vbucket->getHighSeqno()) > start_seqno_;
+}
+
 std::unique_ptr<DcpResponse> NotifierStream::next() {
     LockHolder lh(streamMutex);
 
     if (readyQ.empty()) {
-        itemsReady.store(false);
-        return nullptr;
+        if (!isActive() || !waitForSeqno()) {
+            itemsReady.store(false);
+            return nullptr;
+        }
+        pushToReadyQ(std::make_unique<StreamEndResponse>(
+                opaque_, END_STREAM_OK, vb_));
+        transitionState(StreamState::Dead);
     }
 
     auto& response = readyQ.front();
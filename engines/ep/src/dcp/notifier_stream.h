@@ -58,5 +58,15 @@ private:
      */
     void notifyStreamReady();
 
+    /**
+     * Ask to be visited by the next notification of our vBucket (see
+     * DcpConnMap::armVBNotification()).
+     *
+     * @return true if the vBucket has already moved past our start seqno
+     */
+    bool waitForSeqno();
+
+    EventuallyPersistentEngine* engine;
+
     std::weak_ptr<DcpProducer> producerPtr;
 };
@@ -326,6 +326,7 @@ process_items_error_t PassiveStream::processBufferedMessages(
     uint32_t message_bytes = 0;
     uint32_t total_bytes_processed = 0;
     bool failed = false, noMem = false;
+    std::vector<MutationConsumerMessage*> run;
 
     while (count < batchSize && !buffer.messages.empty()) {
         ENGINE_ERROR_CODE ret = ENGINE_SUCCESS;
@@ -337,6 +338,43 @@ process_items_error_t PassiveStream::processBufferedMessages(
             return all_processed;
         }
 
+        // Apply any run of mutations at the front in one go, only taking
+        // bufMutex again to remove the whole run (as for single messages,
+        // see MB-31410 below, they stay in the buffer until processed).
+        buffer.frontMutationRun(lh, batchSize - count, run);
+        if (!run.empty()) {
+            lh.unlock();
+
+            // MB-31410: Only used for testing
+            if (processBufferedMessages_postFront_Hook) {
+                processBufferedMessages_postFront_Hook();
+            }
+
+            size_t applied = 0;
+            uint32_t appliedBytes = 0;
+            ret = processMutationRun(run, applied, appliedBytes);
+            if (ret == ENGINE_TMPFAIL || ret == ENGINE_ENOMEM) {
+                failed = true;
+                if (ret == ENGINE_ENOMEM) {
+                    noMem = true;
+                }
+            }
+
+            lh.lock();
+            // The buffer is cleared if the stream was set dead meanwhile
+            for (size_t ii = 0; ii < applied && !buffer.messages.empty();
+                 ++ii) {
+                buffer.pop_front(lh);
+            }
+            count += applied;
+            total_bytes_processed += appliedBytes;
+
+            if (failed && isActive()) {
+                break;
+            }
+            continue;
+        }
+
         // MB-31410: The front-end thread can process new incoming messages
         // only /after/ all the buffered ones have been processed.
         // So, here we get only a reference. We remove the message from the
@@ -439,6 +477,46 @@ process_items_error_t PassiveStream::processBufferedMessages(
     return all_processed;
 }
 
+ENGINE_ERROR_CODE PassiveStream::processMutationRun(
+        const std::vector<MutationConsumerMessage*>& run,
+        size_t& applied,
+        uint32_t& appliedBytes) {
+    applied = 0;
+    appliedBytes = 0;
+
+    VBucketPtr vb = engine->getVBucket(vb_);
+    auto consumer = consumerPtr.lock();
+
+    for (auto* message : run) {
+        // As for single messages; the caller clears the buffer of a dead
+        // stream.
+        if (!isActive()) {
+            break;
+        }
+
+        ENGINE_ERROR_CODE ret;
+        if (!vb) {
+            ret = ENGINE_NOT_MY_VBUCKET;
+        } else if (!consumer) {
+            ret = ENGINE_DISCONNECT;
+        } else if (message->getEvent() == DcpResponse::Event::Mutation) {
+            ret = applyMutation(message, vb, consumer->getCookie());
+        } else {
+            ret = applyDeletion(message, vb, consumer->getCookie());
+        }
+
+        if (ret == ENGINE_TMPFAIL || ret == ENGINE_ENOMEM) {
+            return ret;
+        }
+
+        ++applied;
+        if (ret != ENGINE_ERANGE) {
+            appliedBytes += message->getMessageSize();
+        }
+    }
+    return ENGINE_SUCCESS;
+}
+
 ENGINE_ERROR_CODE PassiveStream::processMutation(
         MutationConsumerMessage* mutation) {
     VBucketPtr vb = engine->getVBucket(vb_);
@@ -451,6 +529,11 @@ ENGINE_ERROR_CODE PassiveStream::processMutation(
         return ENGINE_DISCONNECT;
     }
 
+    return applyMutation(mutation, vb, consumer->getCookie());
+}
+
+ENGINE_ERROR_CODE PassiveStream::applyMutation(
+        MutationConsumerMessage* mutation, VBucketPtr& vb, const void* cookie) {
     if (uint64_t(*mutation->getBySeqno()) < cur_snapshot_start.load() ||
         uint64_t(*mutation->getBySeqno()) > cur_snapshot_end.load()) {
         log(spdlog::level::level_enum::warn,
@@ -488,7 +571,7 @@ ENGINE_ERROR_CODE PassiveStream::processMutation(
         ret = engine->getKVBucket()->setWithMeta(*mutation->getItem(),
                                                  0,
                                                  NULL,
-                                                 consumer->getCookie(),
+                                                 cookie,
                                                  {vbucket_state_active,
                                                   vbucket_state_replica,
                                                   vbucket_state_pending},
@@ -526,6 +609,11 @@ ENGINE_ERROR_CODE PassiveStream::processDeletion(
         return ENGINE_DISCONNECT;
     }
 
+    return applyDeletion(deletion, vb, consumer->getCookie());
+}
+
+ENGINE_ERROR_CODE PassiveStream::applyDeletion(
+        MutationConsumerMessage* deletion, VBucketPtr& vb, const void* cookie) {
     if (uint64_t(*deletion->getBySeqno()) < cur_snapshot_start.load() ||
         uint64_t(*deletion->getBySeqno()) > cur_snapshot_end.load()) {
         log(spdlog::level::level_enum::warn,
@@ -543,7 +631,7 @@ ENGINE_ERROR_CODE PassiveStream::processDeletion(
     // The deleted value has a body, send it through the mutation path so we
     // set the deleted item with a value
     if (deletion->getItem()->getNBytes()) {
-        return processMutation(deletion);
+        return applyMutation(deletion, vb, cookie);
     }
 
     uint64_t delCas = 0;
@@ -565,7 +653,7 @@ ENGINE_ERROR_CODE PassiveStream::processDeletion(
                                                 delCas,
                                                 nullptr,
                                                 deletion->getVBucket(),
-                                                consumer->getCookie(),
+                                                cookie,
                                                 {vbucket_state_active,
                                                  vbucket_state_replica,
                                                  vbucket_state_pending},
@@ -22,6 +22,8 @@
 
 #include <memcached/engine_error.h>
 
+#include <vector>
+
 class BucketLogger;
 class ChangeSeparatorCollectionEvent;
 class CreateOrDeleteCollectionEvent;
@@ -90,6 +92,41 @@ protected:
 
     ENGINE_ERROR_CODE processDeletion(MutationConsumerMessage* deletion);
 
+    /**
+     * Apply a mutation, given the vBucket and the cookie of our consumer
+     * (which processMutation() looks up).
+     */
+    ENGINE_ERROR_CODE applyMutation(MutationConsumerMessage* mutation,
+                                    VBucketPtr& vb,
+                                    const void* cookie);
+
+    /**
+     * Apply a deletion or expiration, given the vBucket and the cookie of
+     * our consumer (which processDeletion() looks up).
+     */
+    ENGINE_ERROR_CODE applyDeletion(MutationConsumerMessage* deletion,
+                                    VBucketPtr& vb,
+                                    const void* cookie);
+
+    /**
+     * Apply a run of consecutive buffered mutations / deletions. As a run
+     * contains no snapshot markers all its messages belong to the current
+     * snapshot, so the vBucket and consumer are looked up once for the run
+     * rather than once per message.
+     *
+     * @param run the messages to apply, in seqno order
+     * @param[out] applied the number of messages (from the front of run)
+     *             which have been processed and can be removed from the
+     *             buffer
+     * @param[out] appliedBytes the flow control bytes to ack for those
+     * @return ENGINE_TMPFAIL / ENGINE_ENOMEM if applying message [applied]
+     *         failed and should be retried later, else ENGINE_SUCCESS
+     */
+    ENGINE_ERROR_CODE processMutationRun(
+            const std::vector<MutationConsumerMessage*>& run,
+            size_t& applied,
+            uint32_t& appliedBytes);
+
     /**
      * Handle DCP system events against this stream.
      *
@@ -189,6 +226,32 @@ protected:
             return messages.front();
         }
 
+        /*
+         * Collect the run of (at most max) mutations / deletions at the
+         * front of the buffer into run. The messages stay in the buffer and
+         * the pointers stay valid until popped, as the front-end thread only
+         * appends to it.
+         * The user must pass a lock to bufMutex.
+         */
+        void frontMutationRun(std::unique_lock<std::mutex>& lh,
+                              size_t max,
+                              std::vector<MutationConsumerMessage*>& run) {
+            run.clear();
+            for (const auto& message : messages) {
+                if (run.size() == max) {
+                    break;
+                }
+                const auto event = message->getEvent();
+                if (event != DcpResponse::Event::Mutation &&
+                    event != DcpResponse::Event::Deletion &&
+                    event != DcpResponse::Event::Expiration) {
+                    break;
+                }
+                run.push_back(
+                        static_cast<MutationConsumerMessage*>(message.get()));
+            }
+        }
+
         /*
          * Caller must of locked bufMutex and pass as lh (not asserted)
          */
@@ -66,8 +66,12 @@ bool DefragmenterTask::run(void) {
         // want any of the new Blobs in tcache).
         bool old_tcache = alloc_hooks->enable_thread_cache(false);
 
-        // Prepare the underlying visitor.
+        // Prepare the underlying visitor. Reading the resident bytes also
+        // refreshes the allocator's statistics for getSizeClasses().
         auto& visitor = getDefragVisitor();
+        const size_t residentBefore = getResidentBytes();
+        visitor.setSizeClasses(
+                getSizeClasses(alloc_hooks, getUtilisationThreshold()));
         const auto start = std::chrono::steady_clock::now();
         const auto deadline = start + getChunkDuration();
         visitor.setDeadline(deadline);
@@ -84,12 +88,20 @@ bool DefragmenterTask::run(void) {
         // Update stats
         stats.defragNumMoved.fetch_add(visitor.getDefragCount());
         stats.defragNumVisited.fetch_add(visitor.getVisitedCount());
+        stats.defragStoredValueNumMoved.fetch_add(
+                visitor.getStoredValueDefragCount());
 
         // Release any free memory we now have in the allocator back to the OS.
         // TODO: Benchmark this - is it necessary? How much of a slowdown does it
         // add? How much memory does it return?
         alloc_hooks->release_free_memory();
 
+        const size_t residentAfter = getResidentBytes();
+        const size_t reclaimed =
+                residentBefore > residentAfter ? residentBefore - residentAfter
+                                               : 0;
+        stats.defragResidentBytesReclaimed.fetch_add(reclaimed);
+
         // Check if the visitor completed a full pass.
         bool completed = (epstore_position ==
                                     engine->getKVBucket()->endPosition());
@@ -107,7 +119,9 @@ bool DefragmenterTask::run(void) {
                                                                       start);
         ss << " Took " << duration.count() << " us."
            << " moved " << visitor.getDefragCount() << "/"
-           << visitor.getVisitedCount() << " visited documents."
+           << visitor.getVisitedCount() << " visited documents"
+           << " and " << visitor.getStoredValueDefragCount()
+           << " StoredValues, reclaiming " << reclaimed << " resident bytes."
            << " mem_used=" << stats.getEstimatedTotalMemoryUsed()
            << ", mapped_bytes=" << getMappedBytes() << ". Sleeping for "
            << getSleepTime() << " seconds.";
@@ -153,6 +167,10 @@ size_t DefragmenterTask::getAgeThreshold() const {
     return engine->getConfiguration().getDefragmenterAgeThreshold();
 }
 
+float DefragmenterTask::getUtilisationThreshold() const {
+    return engine->getConfiguration().getDefragmenterUtilisationThreshold();
+}
+
 size_t DefragmenterTask::getMaxValueSize(ServerAllocatorIface* alloc_hooks) {
     size_t nbins{0};
     alloc_hooks->get_allocator_property("arenas.nbins", &nbins);
@@ -169,6 +187,51 @@ size_t DefragmenterTask::getMaxValueSize(ServerAllocatorIface* alloc_hooks) {
     return largest_bin_size;
 }
 
+DefragSizeClasses DefragmenterTask::getSizeClasses(
+        ServerAllocatorIface* alloc_hooks, float utilisationThreshold) {
+    // jemalloc's MALLCTL_ARENAS_ALL - statistics merged across all arenas.
+    const std::string arenaStats = "stats.arenas.4096.bins.";
+
+    DefragSizeClasses sizeClasses;
+    size_t nbins{0};
+    if (!alloc_hooks->get_allocator_property("arenas.nbins", &nbins)) {
+        return sizeClasses;
+    }
+
+    for (size_t bin = 0; bin < nbins; ++bin) {
+        const std::string binName = "arenas.bin." + std::to_string(bin);
+        const std::string binStats = arenaStats + std::to_string(bin);
+        size_t size;
+        size_t slabSize;
+        size_t curRegs;
+        size_t curSlabs;
+        if (!alloc_hooks->get_allocator_property((binName + ".size").c_str(),
+                                                 &size) ||
+            !alloc_hooks->get_allocator_property(
+                    (binName + ".slab_size").c_str(), &slabSize) ||
+            !alloc_hooks->get_allocator_property(
+                    (binStats + ".curregs").c_str(), &curRegs) ||
+            !alloc_hooks->get_allocator_property(
+                    (binStats + ".curslabs").c_str(), &curSlabs) ||
+            size == 0) {
+            // Without every size class we can't tell which one an object
+            // belongs to.
+            return DefragSizeClasses();
+        }
+
+        // Objects can only be compacted into fewer slabs if there is more
+        // than one, and moving more objects than there are free regions
+        // cannot free any more slabs.
+        const size_t capacity = (slabSize / size) * curSlabs;
+        size_t budget = 0;
+        if (curSlabs > 1 && curRegs < capacity * utilisationThreshold) {
+            budget = capacity - curRegs;
+        }
+        sizeClasses.add(size, budget);
+    }
+    return sizeClasses;
+}
+
 std::chrono::milliseconds DefragmenterTask::getChunkDuration() const {
     return std::chrono::milliseconds(
             engine->getConfiguration().getDefragmenterChunkDuration());
@@ -185,6 +248,16 @@ size_t DefragmenterTask::getMappedBytes() {
     return mapped_bytes;
 }
 
+size_t DefragmenterTask::getResidentBytes() {
+    ServerAllocatorIface* alloc_hooks = engine->getServerApi()->alloc_hooks;
+
+    allocator_stats stats = {0};
+    stats.ext_stats.resize(alloc_hooks->get_extra_stats_size());
+    alloc_hooks->get_allocator_stats(&stats);
+
+    return stats.resident_size;
+}
+
 DefragmentVisitor& DefragmenterTask::getDefragVisitor() {
     return dynamic_cast<DefragmentVisitor&>(prAdapter->getHTVisitor());
 }
@@ -23,6 +23,7 @@
 #include "globaltask.h"
 #include "kv_bucket_iface.h"
 
+class DefragSizeClasses;
 class DefragmentVisitor;
 class EPStats;
 class PauseResumeVBAdapter;
@@ -88,6 +89,19 @@ class PauseResumeVBAdapter;
  * 2. Document size - Skip documents which are larger than the largest
  *    size class, or are zero-sized.
  *
+ * 3. Size class utilisation - where the allocator reports per size class
+ *    statistics (jemalloc), before each chunk we find the size classes whose
+ *    slabs are less than defragmenter_utilisation_threshold full, and only
+ *    move objects of those sizes - at most as many as there are free regions
+ *    in the size class, as moving more cannot free any more slabs. Values
+ *    in other size classes are left where they are, however old. With this
+ *    information StoredValues are also moved, as they are just as
+ *    susceptible to fragmentation as the values they hold.
+ *
+ * The resident memory the allocator releases after each chunk is reported as
+ * ep_defragmenter_resident_bytes_reclaimed. As the allocator is shared by all
+ * buckets this is an estimate.
+ *
  * An additional policy consideration is how to locate
  * candidate documents. In a large instance, the simple act of
  * visiting each element in the HashTable is a expensive operation -
@@ -114,6 +128,16 @@ public:
     /// Maximum allocation size the defragmenter should consider
     static size_t getMaxValueSize(ServerAllocatorIface* alloc_hooks);
 
+    /**
+     * Get the allocator's size classes, with a budget for each one whose
+     * slabs are less than utilisationThreshold full. Returns no size classes
+     * if the allocator doesn't report the required statistics.
+     * The allocator's statistics must have been refreshed beforehand (see
+     * ServerAllocatorIface::get_allocator_stats).
+     */
+    static DefragSizeClasses getSizeClasses(ServerAllocatorIface* alloc_hooks,
+                                            float utilisationThreshold);
+
 private:
 
     /// Duration (in seconds) defragmenter should sleep for between iterations.
@@ -123,6 +147,9 @@ private:
     // must be to be considered for defragmentation.
     size_t getAgeThreshold() const;
 
+    // Size classes whose slabs are less than this full are defragmented.
+    float getUtilisationThreshold() const;
+
     // Upper limit on how long each defragmention chunk can run for, before
     // being paused.
     std::chrono::milliseconds getChunkDuration() const;
@@ -130,6 +157,9 @@ private:
     /// Return the current number of mapped bytes from the allocator.
     size_t getMappedBytes();
 
+    /// Return the current number of resident bytes from the allocator.
+    size_t getResidentBytes();
+
     /// Returns the underlying DefragmentVisitor instance.
     DefragmentVisitor& getDefragVisitor();
 
@@ -17,6 +17,39 @@
 
 #include "defragmenter_visitor.h"
 
+#include "blob.h"
+
+#include <algorithm>
+
+// DefragSizeClasses implementation ///////////////////////////////////////////
+
+void DefragSizeClasses::add(size_t size, size_t budget) {
+    classes.push_back({size, budget});
+}
+
+bool DefragSizeClasses::empty() const {
+    return classes.empty();
+}
+
+bool DefragSizeClasses::consume(size_t allocSize) {
+    auto it = std::lower_bound(
+            classes.begin(),
+            classes.end(),
+            allocSize,
+            [](const SizeClass& sc, size_t size) { return sc.size < size; });
+    if (it == classes.end() || it->budget == 0) {
+        return false;
+    }
+    --it->budget;
+    return true;
+}
+
+size_t DefragSizeClasses::getNumFragmented() const {
+    return std::count_if(classes.begin(),
+                         classes.end(),
+                         [](const SizeClass& sc) { return sc.budget > 0; });
+}
+
 // DegragmentVisitor implementation ///////////////////////////////////////////
 
 DefragmentVisitor::DefragmentVisitor(uint8_t age_threshold_,
@@ -25,6 +58,7 @@ DefragmentVisitor::DefragmentVisitor(uint8_t age_threshold_,
       age_threshold(age_threshold_),
       defrag_count(0),
       visited_count(0),
+      sv_defrag_count(0),
       currentVb(nullptr) {
 }
 
@@ -36,6 +70,10 @@ void DefragmentVisitor::setDeadline(
     progressTracker.setDeadline(deadline);
 }
 
+void DefragmentVisitor::setSizeClasses(DefragSizeClasses sizeClasses_) {
+    sizeClasses = std::move(sizeClasses_);
+}
+
 bool DefragmentVisitor::visit(const HashTable::HashBucketLock& lh,
                               StoredValue& v) {
     const size_t value_len = v.valuelen();
@@ -43,23 +81,37 @@ bool DefragmentVisitor::visit(const HashTable::HashBucketLock& lh,
     // value must be at least non-zero (also covers Items with null Blobs)
     // and no larger than the biggest size class the allocator
     // supports, so it can be successfully reallocated to a run with other
-    // objects of the same size.
-    if (value_len > 0 && value_len <= max_size_class) {
+    // objects of the same size. Inline values have no Blob to reallocate.
+    if (value_len > 0 && value_len <= max_size_class && !v.isValueInline()) {
         // If sufficiently old and if it looks like nothing else holds a
         // reference to the blob reallocate, otherwise increment it's age.
         // It may be possible to add a reference to the blob without holding
         // any locks, therefore the check is somewhat of an estimate which
         // should be good enough.
-        if (v.getValue()->getAge() >= age_threshold &&
-            v.getValue().refCount() < 2) {
-            v.reallocate();
-            defrag_count++;
+        const auto& blob = v.getValueBlob();
+        if (blob->getAge() >= age_threshold && blob.refCount() < 2) {
+            // Only worth moving if its size class is fragmented.
+            if (sizeClasses.empty() ||
+                sizeClasses.consume(Blob::getAllocationSize(value_len))) {
+                v.reallocate();
+                defrag_count++;
+            }
         } else {
-            v.getValue()->incrementAge();
+            blob->incrementAge();
         }
     }
     visited_count++;
 
+    // Move the StoredValue itself if its size class is fragmented. An
+    // OrderedStoredValue is also linked into its vBucket's seqList, so can't
+    // simply be replaced by a copy.
+    if (!sizeClasses.empty() && currentVb && !v.isOrdered() &&
+        sizeClasses.consume(v.getObjectSize())) {
+        // Releases (and so frees) the original; v is no longer valid.
+        currentVb->ht.unlocked_replaceByCopy(lh, v);
+        sv_defrag_count++;
+    }
+
     // See if we have done enough work for this chunk. If so
     // stop visiting (for now).
     return progressTracker.shouldContinueVisiting(visited_count);
@@ -68,6 +120,7 @@ bool DefragmentVisitor::visit(const HashTable::HashBucketLock& lh,
 void DefragmentVisitor::clearStats() {
     defrag_count = 0;
     visited_count = 0;
+    sv_defrag_count = 0;
 }
 
 size_t DefragmentVisitor::getDefragCount() const {
@@ -78,6 +131,10 @@ size_t DefragmentVisitor::getVisitedCount() const {
     return visited_count;
 }
 
+size_t DefragmentVisitor::getStoredValueDefragCount() const {
+    return sv_defrag_count;
+}
+
 void DefragmentVisitor::setCurrentVBucket(VBucket& vb) {
     currentVb = &vb;
 }
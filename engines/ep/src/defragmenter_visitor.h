@@ -25,9 +25,54 @@
 #include "vb_visitors.h"
 #include "vbucket.h"
 
+#include <vector>
+
+/**
+ * The allocator's size classes, and how many objects of each it is worth
+ * moving to defragment it (its budget).
+ *
+ * An object is served from the smallest size class it fits in. A size class
+ * with a budget of zero isn't fragmented enough for moving objects of that
+ * size to free any memory.
+ */
+class DefragSizeClasses {
+public:
+    /**
+     * Add the next size class; size classes must be added smallest first.
+     * @param size Size of the allocations served from this size class.
+     * @param budget Number of objects of this size class worth moving.
+     */
+    void add(size_t size, size_t budget);
+
+    /// @return true if no size classes are known.
+    bool empty() const;
+
+    /**
+     * Check if an object of the given allocation size should be moved, and
+     * if so consume one from the budget of its size class.
+     * @return true if the object should be moved.
+     */
+    bool consume(size_t allocSize);
+
+    /// @return the number of size classes with a non-zero budget.
+    size_t getNumFragmented() const;
+
+private:
+    struct SizeClass {
+        size_t size;
+        size_t budget;
+    };
+
+    std::vector<SizeClass> classes;
+};
+
 /**
  * Defragmentation visitor - visit all objects in a VBucket, compress the
  * documents and defragment any which have reached the specified age.
+ *
+ * If the allocator's size classes are known (see setSizeClasses()) only
+ * objects in fragmented size classes are moved, up to each size class's
+ * budget, and StoredValues (not just their values) are also moved.
  */
 class DefragmentVisitor : public VBucketAwareHTVisitor {
 public:
@@ -38,6 +83,9 @@ public:
     // Set the deadline at which point the visitor will pause visiting.
     void setDeadline(std::chrono::steady_clock::time_point deadline_);
 
+    // Set the allocator's size classes (and their budgets) to consider.
+    void setSizeClasses(DefragSizeClasses sizeClasses_);
+
     // Implementation of HashTableVisitor interface:
     virtual bool visit(const HashTable::HashBucketLock& lh,
                        StoredValue& v) override;
@@ -51,6 +99,9 @@ public:
     // Returns the number of documents that have been visited.
     size_t getVisitedCount() const;
 
+    // Returns the number of StoredValues that have been defragmented.
+    size_t getStoredValueDefragCount() const;
+
     void setCurrentVBucket(VBucket& vb) override;
 
 private:
@@ -67,11 +118,17 @@ private:
     // Estimates how far we have got, and when we should pause.
     ProgressTracker progressTracker;
 
+    // Allocator size classes to defragment; if empty then all values up to
+    // max_size_class are considered.
+    DefragSizeClasses sizeClasses;
+
     /* Statistics */
     // Count of how many documents have been defrag'd.
     size_t defrag_count;
     // How many documents have been visited.
     size_t visited_count;
+    // Count of how many StoredValues have been defrag'd.
+    size_t sv_defrag_count;
 
     // The current vbucket that is being processed
     VBucket* currentVb;
@@ -151,7 +151,13 @@ static void checkNumeric(const char* str) {
 void EventuallyPersistentEngine::destroy(const bool force) {
     auto eng = acquireEngine(this);
     eng->destroyInner(force);
+    const unsigned bucketArena = eng->arena;
+    auto* alloc_hooks = eng->serverApi->alloc_hooks;
     delete eng.get();
+    if (bucketArena != 0) {
+        // Everything the bucket allocated has now been freed.
+        alloc_hooks->release_arena(bucketArena);
+    }
 }
 
 cb::EngineErrorItemPair EventuallyPersistentEngine::allocate(
@@ -332,6 +338,18 @@ cb::EngineErrorCasPair EventuallyPersistentEngine::store_if(
             cookie, item, cas, operation, predicate);
 }
 
+ENGINE_ERROR_CODE EventuallyPersistentEngine::append_prepend(
+        gsl::not_null<const void*> cookie,
+        const DocKey& key,
+        cb::const_char_buffer value,
+        AppendPrependMode mode,
+        uint64_t& cas,
+        Vbid vbucket,
+        mutation_descr_t& mut_info) {
+    return acquireEngine(this)->appendPrependInner(
+            cookie, key, value, mode, cas, vbucket, mut_info);
+}
+
 void EventuallyPersistentEngine::reset_stats(
         gsl::not_null<const void*> cookie) {
     acquireEngine(this)->resetStats();
@@ -399,6 +417,8 @@ cb::mcbp::Status EventuallyPersistentEngine::setCheckpointParam(
             getConfiguration().setItemNumBasedNewChk(cb_stob(valz));
         } else if (strcmp(keyz, "keep_closed_chks") == 0) {
             getConfiguration().setKeepClosedChks(cb_stob(valz));
+        } else if (strcmp(keyz, "chk_mem_based_new_chk") == 0) {
+            getConfiguration().setChkMemBasedNewChk(cb_stob(valz));
         } else if (strcmp(keyz, "cursor_dropping_checkpoint_mem_upper_mark") ==
                    0) {
             size_t v = std::stoull(valz);
@@ -453,6 +473,8 @@ cb::mcbp::Status EventuallyPersistentEngine::setFlushParam(const char* keyz,
     try {
         if (strcmp(keyz, "bg_fetch_delay") == 0) {
             getConfiguration().setBgFetchDelay(std::stoull(valz));
+        } else if (strcmp(keyz, "bgfetcher_max_batch_delay_us") == 0) {
+            getConfiguration().setBgfetcherMaxBatchDelayUs(std::stoull(valz));
         } else if (strcmp(keyz, "max_size") == 0) {
             size_t vsize = std::stoull(valz);
 
@@ -568,6 +590,9 @@ cb::mcbp::Status EventuallyPersistentEngine::setFlushParam(const char* keyz,
             getConfiguration().setDefragmenterAgeThreshold(std::stoull(valz));
         } else if (strcmp(keyz, "defragmenter_chunk_duration") == 0) {
             getConfiguration().setDefragmenterChunkDuration(std::stoull(valz));
+        } else if (strcmp(keyz, "defragmenter_utilisation_threshold") == 0) {
+            getConfiguration().setDefragmenterUtilisationThreshold(
+                    std::stof(valz));
         } else if (strcmp(keyz, "defragmenter_run") == 0) {
             runDefragmenterTask();
         } else if (strcmp(keyz, "compaction_write_queue_cap") == 0) {
@@ -1772,7 +1797,8 @@ ENGINE_ERROR_CODE create_instance(GET_SERVER_API get_server_api,
     BucketLogger::setLoggerAPI(api->log);
 
     MemoryTracker::getInstance(*api->alloc_hooks);
-    ObjectRegistry::initialize(api->alloc_hooks->get_allocation_size);
+    ObjectRegistry::initialize(api->alloc_hooks->get_allocation_size,
+                               api->alloc_hooks->switch_arena);
 
     std::atomic<size_t>* inital_tracking = new std::atomic<size_t>();
 
@@ -2008,6 +2034,20 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::initialize(const char* config) {
                     config);
     }
 
+    if (configuration.isDedicatedArena()) {
+        if (serverApi->alloc_hooks->create_arena(&arena)) {
+            EP_LOG_INFO("EPEngine::initialize: using allocator arena {}",
+                        arena);
+            // Direct the rest of initialization to the new arena.
+            ObjectRegistry::onSwitchThread(this);
+        } else {
+            arena = 0;
+            EP_LOG_WARN(
+                    "EPEngine::initialize: dedicated_arena is not supported "
+                    "by the allocator, using the default arena");
+        }
+    }
+
     maxFailoverEntries = configuration.getMaxFailoverEntries();
 
     // Start updating the variables from the config!
@@ -2503,6 +2543,38 @@ cb::EngineErrorCasPair EventuallyPersistentEngine::storeIfInner(
     return {cb::engine_errc(status), item.getCas()};
 }
 
+ENGINE_ERROR_CODE EventuallyPersistentEngine::appendPrependInner(
+        const void* cookie,
+        const DocKey& key,
+        cb::const_char_buffer value,
+        AppendPrependMode mode,
+        uint64_t& cas,
+        Vbid vbucket,
+        mutation_descr_t& mut_info) {
+    ScopeTimer2<MicrosecondStopwatch, TracerStopwatch> timer(
+            MicrosecondStopwatch(stats.storeCmdHisto),
+            TracerStopwatch(cookie, cb::tracing::TraceCode::STORE));
+
+    if (isDegradedMode()) {
+        return ENGINE_TMPFAIL;
+    }
+
+    auto status = kvBucket->appendPrepend(
+            key, value, mode, cas, vbucket, cookie, mut_info);
+    switch (status) {
+    case ENGINE_SUCCESS:
+        ++stats.numOpsStore;
+        kvBucket->checkAndMaybeFreeMemory();
+        break;
+    case ENGINE_ENOMEM:
+        status = memoryCondition();
+        break;
+    default:
+        break;
+    }
+    return status;
+}
+
 ENGINE_ERROR_CODE EventuallyPersistentEngine::storeInner(
         const void* cookie,
         item* itm,
@@ -2687,6 +2759,18 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::doEngineStats(const void *cookie,
                     add_stat, cookie);
     add_casted_stat("ep_bg_meta_fetched", epstats.bg_meta_fetched,
                     add_stat, cookie);
+    add_casted_stat("ep_evicted_meta_cache_hits",
+                    epstats.evictedMetaCacheHits,
+                    add_stat,
+                    cookie);
+    add_casted_stat("ep_evicted_meta_cache_misses",
+                    epstats.evictedMetaCacheMisses,
+                    add_stat,
+                    cookie);
+    add_casted_stat("ep_evicted_meta_cache_size",
+                    epstats.evictedMetaCacheSize,
+                    add_stat,
+                    cookie);
     add_casted_stat("ep_bg_remaining_items", epstats.numRemainingBgItems,
                     add_stat, cookie);
     add_casted_stat("ep_bg_remaining_jobs", epstats.numRemainingBgJobs,
@@ -2860,6 +2944,14 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::doEngineStats(const void *cookie,
                     add_stat, cookie);
     add_casted_stat("ep_defragmenter_num_moved", epstats.defragNumMoved,
                     add_stat, cookie);
+    add_casted_stat("ep_defragmenter_sv_num_moved",
+                    epstats.defragStoredValueNumMoved,
+                    add_stat,
+                    cookie);
+    add_casted_stat("ep_defragmenter_resident_bytes_reclaimed",
+                    epstats.defragResidentBytesReclaimed,
+                    add_stat,
+                    cookie);
 
     add_casted_stat("ep_item_compressor_num_visited",
                     epstats.compressorNumVisited,
@@ -3091,7 +3183,19 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::doMemoryStats(const void *cookie,
 #endif
     add_casted_stat(
             "ep_storedval_num", stats.getNumStoredVal(), add_stat, cookie);
+    add_casted_stat(
+            "ep_inline_value_num", stats.getNumInlineValue(), add_stat, cookie);
+    add_casted_stat("ep_inline_value_saved_bytes",
+                    stats.getInlineValueSavedBytes(),
+                    add_stat,
+                    cookie);
     add_casted_stat("ep_item_num", stats.getNumItem(), add_stat, cookie);
+    if (arena != 0) {
+        add_casted_stat("ep_arena_allocated",
+                        serverApi->alloc_hooks->get_arena_allocated(arena),
+                        add_stat,
+                        cookie);
+    }
 
     std::map<std::string, size_t> alloc_stats;
     MemoryTracker::getInstance(*getServerApiFunc()->alloc_hooks)->
@@ -3808,6 +3912,8 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::doTimingStats(const void *cookie,
                     add_stat, cookie);
     add_casted_stat("bg_batch_size", stats.getMultiBatchSizeHisto, add_stat,
                     cookie);
+    add_casted_stat("bg_batch_window", stats.getMultiWindowHisto, add_stat,
+                    cookie);
 
     // Checkpoint cursor stats
     add_casted_stat("persistence_cursor_get_all_items",
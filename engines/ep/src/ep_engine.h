@@ -161,6 +161,14 @@ public:
                                     cb::StoreIfPredicate predicate,
                                     DocumentState document_state) override;
 
+    ENGINE_ERROR_CODE append_prepend(gsl::not_null<const void*> cookie,
+                                     const DocKey& key,
+                                     cb::const_char_buffer value,
+                                     AppendPrependMode mode,
+                                     uint64_t& cas,
+                                     Vbid vbucket,
+                                     mutation_descr_t& mut_info) override;
+
     // Need to explicilty import EngineIface::flush to avoid warning about
     // DCPIface::flush hiding it.
     using EngineIface::flush;
@@ -422,6 +430,14 @@ public:
                                  uint64_t& cas,
                                  ENGINE_STORE_OPERATION operation);
 
+    ENGINE_ERROR_CODE appendPrependInner(const void* cookie,
+                                         const DocKey& key,
+                                         cb::const_char_buffer value,
+                                         AppendPrependMode mode,
+                                         uint64_t& cas,
+                                         Vbid vbucket,
+                                         mutation_descr_t& mut_info);
+
     cb::EngineErrorCasPair storeIfInner(const void* cookie,
                                         Item& itm,
                                         uint64_t cas,
@@ -597,6 +613,14 @@ public:
         return serverApi;
     }
 
+    /**
+     * @return the allocator arena dedicated to this bucket, or 0 (the default
+     *         arena) if it doesn't have one.
+     */
+    unsigned getArena() const {
+        return arena;
+    }
+
     Configuration& getConfiguration() {
         return configuration;
     }
@@ -1035,4 +1059,7 @@ protected:
     EpEngineTaskable taskable;
     std::atomic<BucketCompressionMode> compressionMode;
     std::atomic<float> minCompressionRatio;
+
+    // Allocator arena dedicated to this bucket (see dedicated_arena), or 0.
+    unsigned arena = 0;
 };
@@ -58,7 +58,8 @@ EPVBucket::EPVBucket(
               lastSnapEnd,
               std::move(table),
               flusherCb,
-              std::make_unique<StoredValueFactory>(st),
+              std::make_unique<StoredValueFactory>(
+                      st, config.getStoredValueInlineMaxSize()),
               std::move(newSeqnoCb),
               config,
               evictionPolicy,
@@ -73,6 +74,8 @@ EPVBucket::EPVBucket(
                                             .hasEfficientGet()
                                   : false),
       shard(kvshard) {
+    evictedMetaCache.setMaxSize(config.getEvictedMetaCacheMaxSize() /
+                                config.getMaxVbuckets());
 }
 
 EPVBucket::~EPVBucket() {
@@ -434,7 +437,7 @@ cb::mcbp::Status EPVBucket::evictKey(
     }
 
     if (v->isResident()) {
-        if (ht.unlocked_ejectItem(v, eviction)) {
+        if (ejectStoredValue(v)) {
             *msg = "Ejected.";
 
             // Add key to bloom filter in case of full eviction mode
@@ -452,6 +455,14 @@ cb::mcbp::Status EPVBucket::evictKey(
 }
 
 bool EPVBucket::pageOut(const HashTable::HashBucketLock& lh, StoredValue*& v) {
+    return ejectStoredValue(v);
+}
+
+bool EPVBucket::ejectStoredValue(StoredValue*& v) {
+    if (eviction == FULL_EVICTION && v->eligibleForEviction(eviction)) {
+        // Ejecting frees v, so record its metadata first
+        evictedMetaCache.insert(*v);
+    }
     return ht.unlocked_ejectItem(v, eviction);
 }
 
@@ -506,11 +517,12 @@ EPVBucket::updateStoredValue(const HashTable::HashBucketLock& hbl,
     MutationStatus status;
     if (justTouch) {
         status = MutationStatus::WasDirty;
-    } else {
-        status = ht.unlocked_updateStoredValue(hbl.getHTLock(), v, itm);
+        return std::make_tuple(&v, status, queueDirty(v, queueItmCtx));
     }
 
-    return std::make_tuple(&v, status, queueDirty(v, queueItmCtx));
+    status = ht.unlocked_updateStoredValue(hbl.getHTLock(), v, itm);
+    return std::make_tuple(
+            &v, status, queueDirty(v, queueItmCtx, itm.getValue()));
 }
 
 std::pair<StoredValue*, VBNotifyCtx> EPVBucket::addNewStoredValue(
@@ -519,13 +531,14 @@ std::pair<StoredValue*, VBNotifyCtx> EPVBucket::addNewStoredValue(
         const VBQueueItemCtx& queueItmCtx,
         GenerateRevSeqno genRevSeqno) {
     StoredValue* v = ht.unlocked_addNewStoredValue(hbl, itm);
+    evictedMetaCache.erase(itm.getKey());
 
     if (genRevSeqno == GenerateRevSeqno::Yes) {
         /* This item could potentially be recreated */
         updateRevSeqNoOfNewStoredValue(*v);
     }
 
-    return {v, queueDirty(*v, queueItmCtx)};
+    return {v, queueDirty(*v, queueItmCtx, itm.getValue())};
 }
 
 std::tuple<StoredValue*, VBNotifyCtx> EPVBucket::softDeleteStoredValue(
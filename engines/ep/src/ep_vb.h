@@ -179,6 +179,14 @@ protected:
                             BgFetcher* bgFetcher);
 
 private:
+    /**
+     * Eject v from the HashTable (just its value under value eviction),
+     * recording its metadata in the evictedMetaCache under full eviction.
+     *
+     * @return true if v was ejected
+     */
+    bool ejectStoredValue(StoredValue*& v);
+
     std::tuple<StoredValue*, MutationStatus, VBNotifyCtx> updateStoredValue(
             const HashTable::HashBucketLock& hbl,
             StoredValue& v,
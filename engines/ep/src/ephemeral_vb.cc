@@ -24,6 +24,7 @@
 #include "ephemeral_tombstone_purger.h"
 #include "executorpool.h"
 #include "failover-table.h"
+#include "indexed_linked_list.h"
 #include "linked_list.h"
 #include "stored_value_factories.h"
 #include "vbucket_bgfetch_item.h"
@@ -56,7 +57,8 @@ EphemeralVBucket::EphemeralVBucket(
               lastSnapEnd,
               std::move(table),
               /*flusherCb*/ nullptr,
-              std::make_unique<OrderedStoredValueFactory>(st),
+              std::make_unique<OrderedStoredValueFactory>(
+                      st, config.getStoredValueInlineMaxSize()),
               std::move(newSeqnoCb),
               config,
               evictionPolicy,
@@ -66,8 +68,13 @@ EphemeralVBucket::EphemeralVBucket(
               0, // Every item in ephemeral has a HLC cas
               mightContainXattrs,
               collectionsManifest),
-      seqList(std::make_unique<BasicLinkedList>(i, st)),
       backfillType(BackfillType::None) {
+    if (config.getEphemeralSeqlistType() == "indexed_linked_list") {
+        seqList = std::make_unique<IndexedLinkedList>(i, st);
+    } else {
+        seqList = std::make_unique<BasicLinkedList>(i, st);
+    }
+
     /* Get the flow control policy */
     std::string dcpBackfillType = config.getDcpEphemeralBackfillType();
     if (!dcpBackfillType.compare("buffered")) {
@@ -119,7 +126,7 @@ bool EphemeralVBucket::eligibleToPageOut(const HashTable::HashBucketLock& lh,
     if (getState() != vbucket_state_active) {
         return false;
     }
-    if (v.isDeleted() && !v.getValue()) {
+    if (v.isDeleted() && !v.hasValue()) {
         // If the item has already been deleted (and doesn't have a value
         // associated with it) then there's no further deletion possible,
         // until the deletion marker (tombstone) is later purged at the
@@ -287,8 +294,8 @@ EphemeralVBucket::inMemoryBackfill(uint64_t start, uint64_t end) {
 }
 
 boost::optional<SequenceList::RangeIterator>
-EphemeralVBucket::makeRangeIterator(bool isBackfill) {
-    return seqList->makeRangeIterator(isBackfill);
+EphemeralVBucket::makeRangeIterator(bool isBackfill, seqno_t start) {
+    return seqList->makeRangeIterator(isBackfill, start);
 }
 
 /* Vb level backfill queue is for items in a huge snapshot (disk backfill
@@ -395,7 +402,7 @@ EphemeralVBucket::updateStoredValue(const HashTable::HashBucketLock& hbl,
         }
 
         /* Put on checkpoint mgr */
-        notifyCtx = queueDirty(*newSv, queueItmCtx);
+        notifyCtx = queueDirty(*newSv, queueItmCtx, itm.getValue());
 
         /* Update the high seqno in the sequential storage */
         auto& osv = *(newSv->toOrderedStoredValue());
@@ -463,7 +470,7 @@ std::pair<StoredValue*, VBNotifyCtx> EphemeralVBucket::addNewStoredValue(
         seqList->appendToList(lh, listWriteLg, *osv);
 
         /* Put on checkpoint mgr */
-        notifyCtx = queueDirty(*v, queueItmCtx);
+        notifyCtx = queueDirty(*v, queueItmCtx, itm.getValue());
 
         /* Update the high seqno in the sequential storage */
         seqList->updateHighSeqno(listWriteLg, *osv);
@@ -0,0 +1,198 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "evicted_meta_cache.h"
+
+#include "item.h"
+#include "stats.h"
+#include "stored-value.h"
+
+#include <algorithm>
+
+std::unique_ptr<Item> EvictedMetaCache::Entry::toItem(const DocKey& key,
+                                                      Vbid vbid) const {
+    auto item = std::make_unique<Item>(key,
+                                       flags,
+                                       exptime,
+                                       /*data*/ nullptr,
+                                       /*size*/ 0,
+                                       datatype,
+                                       cas,
+                                       bySeqno,
+                                       vbid,
+                                       revSeqno);
+    if (deleted) {
+        item->setDeleted();
+    }
+    return item;
+}
+
+EvictedMetaCache::EvictedMetaCache(EPStats& stats, size_t maxSize)
+    : stats(stats), maxSize(maxSize) {
+}
+
+EvictedMetaCache::~EvictedMetaCache() {
+    stats.evictedMetaCacheSize.fetch_sub(size);
+}
+
+void EvictedMetaCache::setMaxSize(size_t newSize) {
+    maxSize = newSize;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lh(shard.mutex);
+        trimLocked(shard);
+    }
+}
+
+void EvictedMetaCache::insert(const StoredValue& v) {
+    if (!isEnabled() || v.isTempItem()) {
+        return;
+    }
+
+    const Entry entry{v.getCas(),
+                      v.getRevSeqno(),
+                      v.getBySeqno(),
+                      v.getFlags(),
+                      uint32_t(v.getExptime()),
+                      v.getDatatype(),
+                      v.isDeleted()};
+    const auto& key = v.getKey();
+    const uint32_t hash = key.hash();
+    auto& shard = getShard(hash);
+
+    std::lock_guard<std::mutex> lh(shard.mutex);
+    auto it = findLocked(shard, hash, key);
+    if (it != shard.entries.end()) {
+        // Update it, and make it the newest
+        it->second.entry = entry;
+        shard.age.splice(shard.age.end(), shard.age, it->second.ageIt);
+        return;
+    }
+
+    it = shard.entries.emplace(hash, Node{StoredDocKey(key), entry, {}});
+    it->second.ageIt = shard.age.insert(shard.age.end(), &it->second);
+    const size_t bytes = entrySize(it->second.key);
+    shard.size += bytes;
+    size += bytes;
+    stats.evictedMetaCacheSize.fetch_add(bytes);
+
+    trimLocked(shard);
+}
+
+boost::optional<EvictedMetaCache::Entry> EvictedMetaCache::take(
+        const DocKey& key) {
+    if (!isEnabled()) {
+        return {};
+    }
+
+    const uint32_t hash = key.hash();
+    auto& shard = getShard(hash);
+
+    std::lock_guard<std::mutex> lh(shard.mutex);
+    auto it = findLocked(shard, hash, key);
+    if (it == shard.entries.end()) {
+        ++stats.evictedMetaCacheMisses;
+        return {};
+    }
+
+    ++stats.evictedMetaCacheHits;
+    const Entry entry = it->second.entry;
+    eraseLocked(shard, it);
+    return entry;
+}
+
+void EvictedMetaCache::erase(const DocKey& key) {
+    // Called whenever a key is added to the HashTable, so avoid the lock
+    // when there is nothing to erase.
+    if (size == 0) {
+        return;
+    }
+
+    const uint32_t hash = key.hash();
+    auto& shard = getShard(hash);
+
+    std::lock_guard<std::mutex> lh(shard.mutex);
+    auto it = findLocked(shard, hash, key);
+    if (it != shard.entries.end()) {
+        eraseLocked(shard, it);
+    }
+}
+
+void EvictedMetaCache::clear() {
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lh(shard.mutex);
+        shard.entries.clear();
+        shard.age.clear();
+        size -= shard.size;
+        stats.evictedMetaCacheSize.fetch_sub(shard.size);
+        shard.size = 0;
+    }
+}
+
+size_t EvictedMetaCache::getNumItems() const {
+    size_t items = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lh(shard.mutex);
+        items += shard.entries.size();
+    }
+    return items;
+}
+
+EvictedMetaCache::Map::iterator EvictedMetaCache::findLocked(
+        Shard& shard, uint32_t hash, const DocKey& key) {
+    const auto wanted = key.getIdAndKey();
+    auto range = shard.entries.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const auto candidate = DocKey(it->second.key).getIdAndKey();
+        if (candidate.first == wanted.first &&
+            candidate.second.size() == wanted.second.size() &&
+            std::equal(candidate.second.begin(),
+                       candidate.second.end(),
+                       wanted.second.begin())) {
+            return it;
+        }
+    }
+    return shard.entries.end();
+}
+
+size_t EvictedMetaCache::entrySize(const StoredDocKey& key) {
+    // The map node (with its bucket and next pointers), the key's data and
+    // the age list node.
+    return sizeof(Map::value_type) + 2 * sizeof(void*) + key.size() +
+           sizeof(const Node*) + 2 * sizeof(void*);
+}
+
+void EvictedMetaCache::eraseLocked(Shard& shard, Map::iterator it) {
+    const size_t bytes = entrySize(it->second.key);
+    shard.age.erase(it->second.ageIt);
+    shard.entries.erase(it);
+    shard.size -= bytes;
+    size -= bytes;
+    stats.evictedMetaCacheSize.fetch_sub(bytes);
+}
+
+void EvictedMetaCache::trimLocked(Shard& shard) {
+    const size_t shardMax = maxSize / numShards;
+    while (shard.size > shardMax && !shard.age.empty()) {
+        const Node* oldest = shard.age.front();
+        auto range = shard.entries.equal_range(oldest->key.hash());
+        auto it = std::find_if(
+                range.first, range.second, [oldest](const Map::value_type& e) {
+                    return &e.second == oldest;
+                });
+        eraseLocked(shard, it);
+    }
+}
@@ -0,0 +1,168 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include "storeddockey.h"
+
+#include <memcached/protocol_binary.h>
+#include <memcached/vbucket.h>
+
+#include <boost/optional/optional.hpp>
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+class EPStats;
+class Item;
+class StoredValue;
+
+/**
+ * A memory-bounded cache of the metadata of documents which have recently
+ * left a vBucket's HashTable - evicted (full eviction) or, for deletes,
+ * removed once persisted.
+ *
+ * Operations which need the metadata of a document which isn't in the
+ * HashTable (setWithMeta / deleteWithMeta conflict resolution, getMeta and
+ * ADD under full eviction) would otherwise have to BG fetch it from disk;
+ * with a hit they can restore it into the HashTable directly, as the BG
+ * fetch would have done.
+ *
+ * An entry is only valid while its document is out of the HashTable, so the
+ * owning VBucket removes it whenever the key is added back. The oldest
+ * entries are discarded once the cache exceeds maxSize bytes; a maxSize of
+ * zero disables it.
+ *
+ * The metadata of a tombstone which compaction later purges may still be
+ * returned until its entry is discarded, just as the tombstone would have
+ * been had compaction not yet run.
+ */
+class EvictedMetaCache {
+public:
+    /// Number of independently locked shards; keys are spread by hash.
+    static const size_t numShards = 8;
+
+    /// The metadata needed to restore a document's StoredValue.
+    struct Entry {
+        uint64_t cas;
+        uint64_t revSeqno;
+        int64_t bySeqno;
+        uint32_t flags;
+        uint32_t exptime;
+        protocol_binary_datatype_t datatype;
+        bool deleted;
+
+        /// @return a value-less Item holding this metadata, for restoreMeta.
+        std::unique_ptr<Item> toItem(const DocKey& key, Vbid vbid) const;
+    };
+
+    EvictedMetaCache(EPStats& stats, size_t maxSize);
+
+    ~EvictedMetaCache();
+
+    EvictedMetaCache(const EvictedMetaCache&) = delete;
+    EvictedMetaCache& operator=(const EvictedMetaCache&) = delete;
+
+    bool isEnabled() const {
+        return maxSize != 0;
+    }
+
+    /**
+     * Set the size limit (in bytes); 0 disables the cache. Entries are
+     * discarded as needed to fit the new limit.
+     */
+    void setMaxSize(size_t size);
+
+    size_t getMaxSize() const {
+        return maxSize;
+    }
+
+    /**
+     * Record the metadata of v, which is about to leave the HashTable.
+     * Temporary items are ignored, as their metadata isn't the document's.
+     */
+    void insert(const StoredValue& v);
+
+    /**
+     * Remove and return the metadata for key, counting a hit or a miss.
+     */
+    boost::optional<Entry> take(const DocKey& key);
+
+    /// Discard any metadata for key (the key is being added back).
+    void erase(const DocKey& key);
+
+    /// Discard everything (e.g. the vBucket's data on disk has changed).
+    void clear();
+
+    /// @return the number of entries.
+    size_t getNumItems() const;
+
+    /// @return the bytes the entries are estimated to take.
+    size_t getSize() const {
+        return size;
+    }
+
+private:
+    struct Node {
+        StoredDocKey key;
+        Entry entry;
+        /// Position in the shard's age list, for removal.
+        std::list<const Node*>::iterator ageIt;
+    };
+
+    /// Nodes by key hash (so lookups needn't copy the key).
+    using Map = std::unordered_multimap<uint32_t, Node>;
+
+    struct Shard {
+        mutable std::mutex mutex;
+        Map entries;
+        /// Entries, oldest first.
+        std::list<const Node*> age;
+        size_t size = 0;
+    };
+
+    Shard& getShard(uint32_t hash) {
+        return shards[hash % numShards];
+    }
+
+    /// @return the entry for key in shard, or end(). Shard must be locked.
+    static Map::iterator findLocked(Shard& shard,
+                                    uint32_t hash,
+                                    const DocKey& key);
+
+    /// @return the estimated bytes held for an entry for key.
+    static size_t entrySize(const StoredDocKey& key);
+
+    void eraseLocked(Shard& shard, Map::iterator it);
+
+    /// Discard the oldest entries of shard until it fits its share of
+    /// maxSize.
+    void trimLocked(Shard& shard);
+
+    EPStats& stats;
+
+    std::atomic<size_t> maxSize;
+
+    /// Bytes held by all the shards' entries.
+    std::atomic<size_t> size{0};
+
+    std::array<Shard, numShards> shards;
+};
@@ -445,12 +445,15 @@ HashTable::unlocked_replaceByCopy(const HashBucketLock& hbl,
                 "call on a non-active HT object");
     }
 
+    /* Copy the StoredValue before releasing the original, so that if the
+     * copy fails the original is left in the hash table. */
+    auto newSv = valFact->copyStoredValue(vToCopy, nullptr);
+
     /* Release (remove) the StoredValue from the hash table */
     auto releasedSv = unlocked_release(hbl, vToCopy.getKey());
 
-    /* Copy the StoredValue and link it into the head of the bucket chain. */
-    auto newSv = valFact->copyStoredValue(
-            vToCopy, std::move(values[hbl.getBucketNum()]));
+    /* Link the copy into the head of the bucket chain. */
+    newSv->setNext(std::move(values[hbl.getBucketNum()]));
 
     // Adding a new item into the HashTable; update stats.
     const auto emptyProperties = valueStats.prologue(nullptr);
@@ -0,0 +1,71 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "indexed_linked_list.h"
+
+#include <algorithm>
+
+IndexedLinkedList::IndexedLinkedList(Vbid vbucketId,
+                                     EPStats& st,
+                                     size_t indexInterval)
+    : BasicLinkedList(vbucketId, st),
+      indexInterval(std::max(indexInterval, size_t(1))) {
+}
+
+void IndexedLinkedList::updateHighSeqno(
+        std::lock_guard<std::mutex>& listWriteLg, const OrderedStoredValue& v) {
+    BasicLinkedList::updateHighSeqno(listWriteLg, v);
+
+    /* v has just been given its seqno at the end of the list */
+    if (++sinceLastIndexed >= indexInterval) {
+        sinceLastIndexed = 0;
+        /* The list (not the SequenceList interface) owns the link to v */
+        index[v.getBySeqno()] = const_cast<OrderedStoredValue*>(&v);
+    }
+}
+
+size_t IndexedLinkedList::getIndexSize() const {
+    std::lock_guard<std::mutex> lckGd(getListWriteLock());
+    return index.size();
+}
+
+OrderedLL::iterator IndexedLinkedList::seekHint(
+        std::lock_guard<std::mutex>& writeGuard, seqno_t start) {
+    /* The last indexed element with seqno <= start */
+    auto it = index.upper_bound(start);
+    if (it == index.begin()) {
+        return seqList.begin();
+    }
+    --it;
+    return seqList.iterator_to(*it->second);
+}
+
+void IndexedLinkedList::willRemoveListElem(
+        std::lock_guard<std::mutex>& writeGuard, OrderedStoredValue& v) {
+    auto it = index.find(v.getBySeqno());
+    if (it == index.end() || it->second != &v) {
+        return;
+    }
+    index.erase(it);
+
+    /* Index the next element in its place (if that one has been given a
+       seqno yet) */
+    auto next = std::next(seqList.iterator_to(v));
+    if (next != seqList.end() && next->getBySeqno() > 0) {
+        index.emplace(next->getBySeqno(), &*next);
+    }
+}
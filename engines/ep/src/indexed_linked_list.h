@@ -0,0 +1,72 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include "linked_list.h"
+
+#include <map>
+
+/**
+ * A BasicLinkedList with an index over a sample of its elements, making it a
+ * two level skip list: every indexInterval'th element to be given a seqno is
+ * recorded in a seqno-ordered index, so range reads and range iterators
+ * starting at a given seqno can jump close to it in O(log n) and then walk at
+ * most (around) indexInterval elements, rather than walking the list from the
+ * front.
+ *
+ * Everything else - appends, updates, stale items, concurrent range reads and
+ * tombstone purging - behaves exactly as in BasicLinkedList. The index is
+ * guarded by the list writeLock, which every change to the list membership
+ * already holds, so appends pay only for an occasional index insertion.
+ *
+ * When an indexed element is removed from the list (moved to the end on an
+ * update, or purged) its index entry moves to the next element, so that
+ * purging does not leave long runs of the list unindexed.
+ */
+class IndexedLinkedList : public BasicLinkedList {
+public:
+    /// Default number of list elements per index entry.
+    static const size_t defaultIndexInterval = 64;
+
+    IndexedLinkedList(Vbid vbucketId,
+                      EPStats& st,
+                      size_t indexInterval = defaultIndexInterval);
+
+    void updateHighSeqno(std::lock_guard<std::mutex>& listWriteLg,
+                         const OrderedStoredValue& v) override;
+
+    /// @return the number of elements in the index.
+    size_t getIndexSize() const;
+
+protected:
+    OrderedLL::iterator seekHint(std::lock_guard<std::mutex>& writeGuard,
+                                 seqno_t start) override;
+
+    void willRemoveListElem(std::lock_guard<std::mutex>& writeGuard,
+                            OrderedStoredValue& v) override;
+
+private:
+    /// Number of list elements per index entry.
+    const size_t indexInterval;
+
+    /// Elements given a seqno since the last one was indexed.
+    size_t sinceLastIndexed = 0;
+
+    /// Sampled list elements by seqno. Guarded by writeLock.
+    std::map<seqno_t, OrderedStoredValue*> index;
+};
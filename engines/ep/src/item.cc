@@ -197,26 +197,28 @@ std::ostream& operator<<(std::ostream& os, const ItemMetaData& md) {
 }
 
 bool operator==(const Blob& lhs, const Blob& rhs) {
-    return (lhs.size == rhs.size) &&
+    return (lhs.valueSize() == rhs.valueSize()) &&
            (lhs.age == rhs.age) &&
-           (memcmp(lhs.data, rhs.data, lhs.size) == 0);
+           (memcmp(lhs.getData(), rhs.getData(), lhs.valueSize()) == 0);
 }
 
 std::ostream& operator<<(std::ostream& os, const Blob& b) {
     os << "Blob[" << &b << "] with"
-       << " size:" << b.size
+       << " size:" << b.valueSize()
        << " age:" << int(b.age)
+       << " chunked:" << b.isChunked()
        << " data: <" << std::hex;
     // Print at most 40 bytes of the body.
-    auto bytes_to_print = std::min(uint32_t(40), b.size.load());
+    const auto* data = b.getData();
+    auto bytes_to_print = std::min(size_t(40), b.valueSize());
     for (size_t ii = 0; ii < bytes_to_print; ii++) {
         if (ii != 0) {
             os << ' ';
         }
-        if (isprint(b.data[ii])) {
-            os << b.data[ii];
+        if (isprint(data[ii])) {
+            os << data[ii];
         } else {
-            os << std::setfill('0') << std::setw(2) << int(uint8_t(b.data[ii]));
+            os << std::setfill('0') << std::setw(2) << int(uint8_t(data[ii]));
         }
     }
     os << std::dec << '>';
@@ -42,7 +42,7 @@ bool ItemCompressorVisitor::visit(const HashTable::HashBucketLock& lh,
     if (compressMode == BucketCompressionMode::Active && v.isCompressible()) {
         cb::compression::Buffer deflated;
         if (cb::compression::deflate(cb::compression::Algorithm::Snappy,
-                                     {v.getValue()->getData(), v.valuelen()},
+                                     v.getValueView(),
                                      deflated)) {
             auto comp_ratio = static_cast<float>(v.valuelen()) /
                               static_cast<float>(deflated.size());
@@ -1698,9 +1698,10 @@ std::string KVBucket::validateKey(const DocKey& key,
 
         if (diskItem.getFlags() != v->getFlags()) {
             return "flags_mismatch";
-        } else if (v->isResident() && memcmp(diskItem.getData(),
-                                             v->getValue()->getData(),
-                                             diskItem.getNBytes())) {
+        } else if (v->isResident() &&
+                   memcmp(diskItem.getData(),
+                          v->getValueView().data(),
+                          diskItem.getNBytes())) {
             return "data_mismatch";
         } else {
             return "valid";
@@ -1750,6 +1751,49 @@ ENGINE_ERROR_CODE KVBucket::deleteItem(const DocKey& key,
     }
 }
 
+ENGINE_ERROR_CODE KVBucket::appendPrepend(const DocKey& key,
+                                          cb::const_char_buffer value,
+                                          AppendPrependMode mode,
+                                          uint64_t& cas,
+                                          Vbid vbucket,
+                                          const void* cookie,
+                                          mutation_descr_t& mutInfo) {
+    VBucketPtr vb = getVBucket(vbucket);
+    if (!vb) {
+        ++stats.numNotMyVBuckets;
+        return ENGINE_NOT_MY_VBUCKET;
+    }
+
+    // Obtain read-lock on VB state to ensure VB state changes are interlocked
+    // with this update
+    ReaderLockHolder rlh(vb->getStateLock());
+    if (vb->getState() == vbucket_state_dead ||
+        vb->getState() == vbucket_state_replica) {
+        ++stats.numNotMyVBuckets;
+        return ENGINE_NOT_MY_VBUCKET;
+    } else if (vb->getState() == vbucket_state_pending) {
+        if (vb->addPendingOp(cookie)) {
+            return ENGINE_EWOULDBLOCK;
+        }
+    } else if (vb->isTakeoverBackedUp()) {
+        EP_LOG_DEBUG(
+                "({}) Returned TMPFAIL to an append/prepend op, because "
+                "takeover is lagging",
+                vb->getId());
+        return ENGINE_TMPFAIL;
+    }
+
+    { // collections read scope
+        auto collectionsRHandle = vb->lockCollections(key);
+        if (!collectionsRHandle.valid()) {
+            return ENGINE_UNKNOWN_COLLECTION;
+        }
+
+        return vb->appendPrepend(
+                value, mode, cas, cookie, engine, mutInfo, collectionsRHandle);
+    }
+}
+
 ENGINE_ERROR_CODE KVBucket::deleteWithMeta(const DocKey& key,
                                            uint64_t& cas,
                                            uint64_t* seqno,
@@ -1822,6 +1866,7 @@ void KVBucket::reset() {
         auto vb = getLockedVBucket(vbid);
         if (vb) {
             vb->ht.clear();
+            vb->evictedMetaCache.clear();
             vb->checkpointManager->clear(vb->getState());
             vb->resetStats();
             vb->setPersistedSnapshot(0, 0);
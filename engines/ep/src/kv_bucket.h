@@ -252,6 +252,18 @@ public:
                                  ItemMetaData* itemMeta,
                                  mutation_descr_t& mutInfo);
 
+    /**
+     * Append / prepend data to an existing document under its hash bucket
+     * lock. See VBucket::appendPrepend().
+     */
+    ENGINE_ERROR_CODE appendPrepend(const DocKey& key,
+                                    cb::const_char_buffer value,
+                                    AppendPrependMode mode,
+                                    uint64_t& cas,
+                                    Vbid vbucket,
+                                    const void* cookie,
+                                    mutation_descr_t& mutInfo);
+
     ENGINE_ERROR_CODE deleteWithMeta(const DocKey& key,
                                      uint64_t& cas,
                                      uint64_t* seqno,
@@ -431,6 +431,10 @@ void KVStore::addTimingStats(ADD_STAT add_stat, const void *c) {
     addStat(prefix, "snapshot",    st.snapshotHisto,    add_stat, c);
     addStat(prefix, "delete",      st.delTimeHisto,     add_stat, c);
     addStat(prefix, "save_documents", st.saveDocsHisto, add_stat, c);
+    addStat(prefix, "flushEncode", st.encodeHisto, add_stat, c);
+    addStat(prefix, "flushCompress", st.compressHisto, add_stat, c);
+    addStat(prefix, "commitBytes", st.commitBytesHisto, add_stat, c);
+    addStat(prefix, "asyncReadWait", st.asyncReadWaitHisto, add_stat, c);
     addStat(prefix, "readTime", st.readTimeHisto, add_stat, c);
     addStat(prefix, "readSize", st.readSizeHisto, add_stat, c);
     addStat(prefix, "writeTime",   st.writeTimeHisto,   add_stat, c);
@@ -316,6 +316,7 @@ public:
       io_write_bytes(0),
       readSizeHisto(ExponentialGenerator<size_t>(1, 2), 25),
       writeSizeHisto(ExponentialGenerator<size_t>(1, 2), 25),
+      commitBytesHisto(ExponentialGenerator<size_t>(1, 2), 40),
       getMultiFsReadCount(0),
       getMultiFsReadHisto(ExponentialGenerator<uint32_t>(6, 1.2), 50),
       getMultiFsReadPerDocHisto(ExponentialGenerator<uint32_t>(6, 1.2),50) {
@@ -344,6 +345,10 @@ public:
         snapshotHisto.reset();
         commitHisto.reset();
         saveDocsHisto.reset();
+        encodeHisto.reset();
+        compressHisto.reset();
+        commitBytesHisto.reset();
+        asyncReadWaitHisto.reset();
         batchSize.reset();
         getMultiFsReadCount = 0;
         getMultiFsReadHisto.reset();
@@ -399,6 +404,14 @@ public:
     MicrosecondHistogram compactHisto;
     // Time spent in saving documents to disk
     MicrosecondHistogram saveDocsHisto;
+    // Time spent preparing the batch of documents for the storage engine
+    MicrosecondHistogram encodeHisto;
+    // Time spent compressing document bodies ahead of saving them
+    MicrosecondHistogram compressHisto;
+    // Bytes of document bodies handed to the storage engine per commit
+    Histogram<size_t> commitBytesHisto;
+    // Time spent waiting for reads issued ahead by AsyncReadOps
+    MicrosecondHistogram asyncReadWaitHisto;
     // Batch size while saving documents
     Histogram<size_t> batchSize;
     //Time spent in vbucket snapshot
@@ -33,6 +33,12 @@ public:
         }
     }
 
+    void booleanValueChanged(const std::string& key, bool value) override {
+        if (key == "couchstore_precompress_docs") {
+            config.setPrecompressDocs(value);
+        }
+    }
+
 private:
     KVStoreConfig& config;
 };
@@ -48,6 +54,12 @@ KVStoreConfig::KVStoreConfig(Configuration& config, uint16_t shardid)
     config.addValueChangedListener(
             "fsync_after_every_n_bytes_written",
             std::make_unique<ConfigChangeListener>(*this));
+    setPrecompressDocs(config.isCouchstorePrecompressDocs());
+    config.addValueChangedListener(
+            "couchstore_precompress_docs",
+            std::make_unique<ConfigChangeListener>(*this));
+    setAsyncReads(config.getCouchstoreAsyncReads());
+    setAsyncReadThreads(config.getCouchstoreAsyncReadThreads());
 }
 
 KVStoreConfig::KVStoreConfig(uint16_t _maxVBuckets,
@@ -63,7 +75,11 @@ KVStoreConfig::KVStoreConfig(uint16_t _maxVBuckets,
       shardId(_shardId),
       logger(globalBucketLogger.get()),
       buffered(true),
-      persistDocNamespace(_persistDocNamespace) {
+      persistDocNamespace(_persistDocNamespace),
+      periodicSyncBytes(0),
+      precompressDocs(false),
+      asyncReads("off"),
+      asyncReadThreads(4) {
 }
 
 KVStoreConfig::~KVStoreConfig() = default;
@@ -109,6 +109,46 @@ public:
         periodicSyncBytes = bytes;
     }
 
+    /**
+     * Indicates whether document bodies should be compressed by the flusher
+     * before they are handed to the storage engine, rather than by the
+     * storage engine while it writes them.
+     *
+     * Only recognised by CouchKVStore
+     */
+    bool shouldPrecompressDocs() const {
+        return precompressDocs;
+    }
+
+    KVStoreConfig& setPrecompressDocs(bool value) {
+        precompressDocs = value;
+        return *this;
+    }
+
+    /**
+     * How document reads are issued ahead of the storage engine: "off",
+     * "threadpool" or "io_uring".
+     *
+     * Only recognised by CouchKVStore
+     */
+    const std::string& getAsyncReads() const {
+        return asyncReads;
+    }
+
+    KVStoreConfig& setAsyncReads(const std::string& value) {
+        asyncReads = value;
+        return *this;
+    }
+
+    size_t getAsyncReadThreads() const {
+        return asyncReadThreads;
+    }
+
+    KVStoreConfig& setAsyncReadThreads(size_t value) {
+        asyncReadThreads = value;
+        return *this;
+    }
+
 private:
     class ConfigChangeListener;
 
@@ -126,4 +166,11 @@ private:
      * N bytes written.
      */
     uint64_t periodicSyncBytes;
+
+    /// If true the flusher compresses document bodies ahead of the write.
+    bool precompressDocs;
+
+    /// Asynchronous read mode, and I/O threads for the "threadpool" mode.
+    std::string asyncReads;
+    size_t asyncReadThreads;
 };
@@ -24,7 +24,6 @@
 
 BasicLinkedList::BasicLinkedList(Vbid vbucketId, EPStats& st)
     : SequenceList(),
-      readRange(0, 0),
       staleSize(0),
       staleMetaDataSize(0),
       highSeqno(0),
@@ -66,10 +65,10 @@ SequenceList::UpdateStatus BasicLinkedList::updateListElem(
         std::lock_guard<std::mutex>& seqLock,
         std::lock_guard<std::mutex>& writeLock,
         OrderedStoredValue& v) {
-    /* Lock that needed for consistent read of SeqRange 'readRange' */
+    /* Lock that needed for consistent read of the SeqRanges 'readRanges' */
     std::lock_guard<SpinLock> lh(rangeLock);
 
-    if (readRange.fallsInRange(v.getBySeqno())) {
+    if (fallsInAnyReadRange(lh, v.getBySeqno())) {
         /* Range read is in middle of a point-in-time snapshot, hence we cannot
            move the element to the end of the list. Return a temp failure */
         return UpdateStatus::Append;
@@ -77,6 +76,7 @@ SequenceList::UpdateStatus BasicLinkedList::updateListElem(
 
     /* Since there is no other reads or writes happenning in this range, we can
        move the item to the end of the list */
+    willRemoveListElem(writeLock, v);
     auto it = seqList.iterator_to(v);
     /* If the list is being updated at 'pausedPurgePoint', then we must save
        the new 'pausedPurgePoint' */
@@ -101,9 +101,8 @@ BasicLinkedList::rangeRead(seqno_t start, seqno_t end) {
         return std::make_tuple(ENGINE_ERANGE, std::vector<UniqueItemPtr>(), 0);
     }
 
-    /* Allows only 1 rangeRead for now */
-    std::lock_guard<std::mutex> lckGd(rangeReadLock);
-
+    ReadRanges::iterator readRange;
+    OrderedLL::iterator startIt;
     {
         std::lock_guard<std::mutex> listWriteLg(getListWriteLock());
         std::lock_guard<SpinLock> lh(rangeLock);
@@ -123,13 +122,19 @@ BasicLinkedList::rangeRead(seqno_t start, seqno_t end) {
         /* Mark the initial read range */
         end = std::min(end, static_cast<seqno_t>(highSeqno));
         end = std::max(end, static_cast<seqno_t>(highestDedupedSeqno));
-        readRange = SeqRange(1, end);
+        /* Start from the closest element we can find at or before 'start' */
+        startIt = seekHint(listWriteLg, start);
+        readRange = registerReadRange(
+                lh,
+                (startIt == seqList.begin()) ? 1 : startIt->getBySeqno(),
+                end);
     }
 
     /* Read items in the range */
     std::vector<UniqueItemPtr> items;
 
-    for (const auto& osv : seqList) {
+    for (auto it = startIt; it != seqList.end(); ++it) {
+        const auto& osv = *it;
         int64_t currSeqno(osv.getBySeqno());
 
         if (currSeqno > end || currSeqno < 0) {
@@ -140,9 +145,8 @@ BasicLinkedList::rangeRead(seqno_t start, seqno_t end) {
 
         {
             std::lock_guard<SpinLock> lh(rangeLock);
-            readRange.setBegin(currSeqno); /* [EPHE TODO]: should we
-                                                     update the min every time ?
-                                                   */
+            /* [EPHE TODO]: should we update the min every time ? */
+            readRange->setBegin(currSeqno);
         }
 
         if (currSeqno < start) {
@@ -177,15 +181,17 @@ BasicLinkedList::rangeRead(seqno_t start, seqno_t end) {
                     "item with seqno {}before streaming it",
                     vbid,
                     currSeqno);
+            std::lock_guard<SpinLock> lh(rangeLock);
+            releaseReadRange(lh, readRange);
             return std::make_tuple(
                     ENGINE_ENOMEM, std::vector<UniqueItemPtr>(), 0);
         }
     }
 
-    /* Done with range read, reset the range */
+    /* Done with range read, release the range */
     {
         std::lock_guard<SpinLock> lh(rangeLock);
-        readRange.reset();
+        releaseReadRange(lh, readRange);
     }
 
     /* Return all the range read items */
@@ -236,12 +242,13 @@ size_t BasicLinkedList::purgeTombstones(seqno_t purgeUpToSeqno,
     // Purge items marked as stale from the seqList.
     //
     // Strategy - we try to ensure that this function does not block
-    // frontend-writes (adding new OrderedStoredValues (OSVs) to the seqList).
-    // To achieve this (safely),
-    // we (try to) acquire the rangeReadLock and setup a 'read' range for the
-    // whole of the seqList. This prevents any other readers from iterating
-    // the list (and accessing stale items) while we purge on it; but permits
-    // front-end operations to continue as they:
+    // frontend-writes (adding new OrderedStoredValues (OSVs) to the seqList)
+    // or range reads of the list (DCP backfills).
+    // To achieve this (safely), we register a 'read' range from the purge
+    // start point up to purgeUpToSeqno. Like any other read range, this
+    // ensures front-end operations do not change the list membership of
+    // anything within the range while we iterate over it; but permits them
+    // to continue as they:
     //   a) Only read/modify non-stale items (we only change stale items) and
     //   b) Do not change the list membership of anything within the read-range.
     // However, we do need to be careful about what members of OSVs we access
@@ -253,18 +260,24 @@ size_t BasicLinkedList::purgeTombstones(seqno_t purgeUpToSeqno,
     // release the lock between each element so front-end operations can
     // have the opportunity to acquire it.
     //
-    // Attempt to acquire the readRangeLock, to block anyone else concurrently
-    // reading from the list while we remove elements from it.
-    std::unique_lock<std::mutex> rrGuard(rangeReadLock, std::try_to_lock);
-    if (!rrGuard) {
-        // If we cannot acquire the lock then another thread is
-        // running a range read. Given these are typically long-running,
-        // return without blocking.
+    // Range reads may be in progress (or start) while we purge. A reader may
+    // still access any element at or after the begin of its range - either
+    // directly or as the replacement of an older stale item - so we only
+    // remove elements below the begin of every other read range. Readers
+    // only move forwards, except that a new reader starts at the front of the
+    // list; hence the check and the removal are done under the same
+    // writeLock + rangeLock as registering a new reader's range.
+    //
+    // Only one purge runs at a time; if another is in progress return
+    // without blocking.
+    std::unique_lock<std::mutex> purgeGuard(purgeLock, std::try_to_lock);
+    if (!purgeGuard) {
         return 0;
     }
 
     // Determine the start and end iterators.
     OrderedLL::iterator startIt;
+    ReadRanges::iterator purgeRange;
     {
         std::lock_guard<std::mutex> writeGuard(getListWriteLock());
         if (seqList.empty()) {
@@ -285,52 +298,63 @@ size_t BasicLinkedList::purgeTombstones(seqno_t purgeUpToSeqno,
             return 0;
         }
 
-        // Update readRange
+        // Register our read range
         std::lock_guard<SpinLock> rangeGuard(rangeLock);
-        readRange = SeqRange(startIt->getBySeqno(), purgeUpToSeqno);
+        purgeRange = registerReadRange(
+                rangeGuard, startIt->getBySeqno(), purgeUpToSeqno);
     }
 
     // Iterate across all but the last item in the seqList, looking
     // for stale items.
     size_t purgedCount = 0;
-    bool stale;
     for (auto it = startIt; it != seqList.end();) {
         if ((it->getBySeqno() > purgeUpToSeqno) ||
             (it->getBySeqno() <= 0) /* last item with no valid seqno yet */) {
             break;
         }
 
-        {
-            // As we move past the items in the list, increment the begin of
-            // 'readRange' to reduce the window of creating stale items during
-            // updates
-            std::lock_guard<SpinLock> rangeGuard(rangeLock);
-            readRange.setBegin(it->getBySeqno());
-        }
-
+        // A purged element is only unlinked under writeLock; it is freed
+        // when this goes out of scope, after the lock has been released, as
+        // freeing is relatively expensive and blocks front-end writes.
+        StoredValue::UniquePtr purged;
         {
             std::lock_guard<std::mutex> writeGuard(getListWriteLock());
-            stale = it->isStale(writeGuard);
-        }
-        // Only stale items are purged.
-        if (!stale) {
-            ++it;
-        } else {
-            // Checks pass, remove from list and delete.
-            it = purgeListElem(it);
-            ++purgedCount;
+            std::lock_guard<SpinLock> rangeGuard(rangeLock);
+            // As we move past the items in the list, increment the begin of
+            // our read range to reduce the window of creating stale items
+            // during updates
+            purgeRange->setBegin(it->getBySeqno());
+
+            if (!passedByOtherReaders(rangeGuard, purgeRange,
+                                      it->getBySeqno())) {
+                // A range read has yet to move past this item (and hence
+                // everything after it); stop here and resume from this
+                // point next time.
+                pausedPurgePoint = it;
+                break;
+            }
+
+            // Only stale items are purged.
+            if (!it->isStale(writeGuard)) {
+                ++it;
+            } else {
+                // Checks pass, remove from list (freed below).
+                it = purgeListElem(writeGuard, it, purged);
+                ++purgedCount;
+            }
         }
 
         if (shouldPause()) {
+            std::lock_guard<std::mutex> writeGuard(getListWriteLock());
             pausedPurgePoint = it;
             break;
         }
     }
 
-    // Complete; reset the readRange.
+    // Complete; release our read range.
     {
         std::lock_guard<SpinLock> lh(rangeLock);
-        readRange.reset();
+        releaseReadRange(lh, purgeRange);
     }
     return purgedCount;
 }
@@ -381,20 +405,68 @@ seqno_t BasicLinkedList::getHighestPurgedDeletedSeqno() const {
 
 uint64_t BasicLinkedList::getRangeReadBegin() const {
     std::lock_guard<SpinLock> lh(rangeLock);
-    return readRange.getBegin();
+    if (readRanges.empty()) {
+        return 0;
+    }
+    seqno_t begin = readRanges.front().getBegin();
+    for (const auto& range : readRanges) {
+        begin = std::min(begin, range.getBegin());
+    }
+    return begin;
 }
 
 uint64_t BasicLinkedList::getRangeReadEnd() const {
     std::lock_guard<SpinLock> lh(rangeLock);
-    return readRange.getEnd();
+    seqno_t end = 0;
+    for (const auto& range : readRanges) {
+        end = std::max(end, range.getEnd());
+    }
+    return end;
+}
+
+BasicLinkedList::ReadRanges::iterator BasicLinkedList::registerReadRange(
+        std::lock_guard<SpinLock>& rangeGuard, seqno_t begin, seqno_t end) {
+    return readRanges.emplace(readRanges.end(), begin, end);
+}
+
+void BasicLinkedList::releaseReadRange(std::lock_guard<SpinLock>& rangeGuard,
+                                       ReadRanges::iterator range) {
+    readRanges.erase(range);
+}
+
+bool BasicLinkedList::fallsInAnyReadRange(
+        std::lock_guard<SpinLock>& rangeGuard, seqno_t seqno) const {
+    for (const auto& range : readRanges) {
+        if (range.fallsInRange(seqno)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+OrderedLL::iterator BasicLinkedList::seekHint(
+        std::lock_guard<std::mutex>& writeGuard, seqno_t start) {
+    return seqList.begin();
+}
+
+bool BasicLinkedList::passedByOtherReaders(
+        std::lock_guard<SpinLock>& rangeGuard,
+        ReadRanges::iterator self,
+        seqno_t seqno) const {
+    for (auto it = readRanges.begin(); it != readRanges.end(); ++it) {
+        if (it != ReadRanges::const_iterator(self) && seqno >= it->getBegin()) {
+            return false;
+        }
+    }
+    return true;
 }
 std::mutex& BasicLinkedList::getListWriteLock() const {
     return writeLock;
 }
 
 boost::optional<SequenceList::RangeIterator> BasicLinkedList::makeRangeIterator(
-        bool isBackfill) {
-    auto pRangeItr = RangeIteratorLL::create(*this, isBackfill);
+        bool isBackfill, seqno_t start) {
+    auto pRangeItr = RangeIteratorLL::create(*this, isBackfill, start);
     return pRangeItr ? RangeIterator(std::move(pRangeItr))
                      : boost::optional<SequenceList::RangeIterator>{};
 }
@@ -418,12 +490,13 @@ std::ostream& operator <<(std::ostream& os, const BasicLinkedList& ll) {
     return os;
 }
 
-OrderedLL::iterator BasicLinkedList::purgeListElem(OrderedLL::iterator it) {
-    StoredValue::UniquePtr purged(&*it);
-    {
-        std::lock_guard<std::mutex> lckGd(getListWriteLock());
-        it = seqList.erase(it);
-    }
+OrderedLL::iterator BasicLinkedList::purgeListElem(
+        std::lock_guard<std::mutex>& writeGuard,
+        OrderedLL::iterator it,
+        StoredValue::UniquePtr& purged) {
+    willRemoveListElem(writeGuard, *it);
+    purged.reset(&*it);
+    it = seqList.erase(it);
 
     /* Update the stats tracking the memory owned by the list */
     staleSize.fetch_sub(purged->size());
@@ -444,42 +517,68 @@ OrderedLL::iterator BasicLinkedList::purgeListElem(OrderedLL::iterator it) {
 }
 
 std::unique_ptr<BasicLinkedList::RangeIteratorLL>
-BasicLinkedList::RangeIteratorLL::create(BasicLinkedList& ll, bool isBackfill) {
+BasicLinkedList::RangeIteratorLL::create(BasicLinkedList& ll,
+                                         bool isBackfill,
+                                         seqno_t start) {
     /* Note: cannot use std::make_unique because the constructor of
        RangeIteratorLL is private */
-    std::unique_ptr<BasicLinkedList::RangeIteratorLL> pRangeItr(
-            new BasicLinkedList::RangeIteratorLL(ll, isBackfill));
-    return pRangeItr->tryLater() ? nullptr : std::move(pRangeItr);
+    return std::unique_ptr<BasicLinkedList::RangeIteratorLL>(
+            new BasicLinkedList::RangeIteratorLL(ll, isBackfill, start));
 }
 
 BasicLinkedList::RangeIteratorLL::RangeIteratorLL(BasicLinkedList& ll,
-                                                  bool isBackfill)
+                                                  bool isBackfill,
+                                                  seqno_t start)
     : list(ll),
-      /* Try to get range read lock, do not block */
-      readLockHolder(list.rangeReadLock, std::try_to_lock),
       itrRange(0, 0),
       numRemaining(0),
       earlySnapShotEndSeqno(0),
       isBackfill(isBackfill) {
-    if (!readLockHolder) {
-        /* no blocking */
-        return;
+    {
+        std::lock_guard<std::mutex> listWriteLg(list.getListWriteLock());
+        std::lock_guard<SpinLock> lh(list.rangeLock);
+        if (list.highSeqno < 1) {
+            /* No need of a read range for the snapshot as there are no items;
+               Also iterator range is at default (0, 0) */
+            return;
+        }
+        initRange(listWriteLg, lh, start);
     }
 
-    std::lock_guard<std::mutex> listWriteLg(list.getListWriteLock());
-    std::lock_guard<SpinLock> lh(list.rangeLock);
-    if (list.highSeqno < 1) {
-        /* No need of holding a lock for the snapshot as there are no items;
-           Also iterator range is at default (0, 0) */
-        readLockHolder.unlock();
-        return;
+    /* Move up to the requested start. Any items we skip past are released
+       from our read range as we go */
+    while (curr() != end() && curr() < start) {
+        ++(*this);
     }
 
-    /* Iterator to the beginning of linked list */
-    currIt = list.seqList.begin();
+    auto severity = isBackfill ? spdlog::level::level_enum::info
+                               : spdlog::level::level_enum::debug;
+
+    EP_LOG_FMT(severity,
+               "{} Created range iterator from {} to {}",
+               list.vbid,
+               curr(),
+               end());
+}
+
+void BasicLinkedList::RangeIteratorLL::initRange(
+        std::lock_guard<std::mutex>& listWriteLg,
+        std::lock_guard<SpinLock>& lh,
+        seqno_t start) {
+    /* Iterator to the closest element the list can find at or before the
+       requested start */
+    currIt = list.seekHint(listWriteLg, start);
 
-    /* Number of items that can be iterated over */
+    /* Number of items that can be iterated over. If we are not starting at
+       the front of the list this is an upper bound, as seqnos are unique and
+       increasing along the list */
     numRemaining = list.seqList.size();
+    if (currIt != list.seqList.begin()) {
+        numRemaining = std::min(
+                numRemaining,
+                static_cast<uint64_t>(list.seqList.back().getBySeqno() -
+                                      currIt->getBySeqno() + 1));
+    }
 
     /* The minimum seqno in the iterator that must be read to get a consistent
        read snapshot */
@@ -487,42 +586,36 @@ BasicLinkedList::RangeIteratorLL::RangeIteratorLL(BasicLinkedList& ll,
 
     /* Mark the snapshot range on linked list. The range that can be read by the
        iterator is inclusive of the start and the end. */
-    list.readRange =
-            SeqRange(currIt->getBySeqno(), list.seqList.back().getBySeqno());
+    readRange = list.registerReadRange(
+            lh, currIt->getBySeqno(), list.seqList.back().getBySeqno());
 
     /* Keep the range in the iterator obj. We store the range end seqno as one
        higher than the end seqno that can be read by this iterator.
        This is because, we must identify the end point of the iterator, and
-       we the read is inclusive of the end points of list.readRange.
+       we the read is inclusive of the end points of the read range.
 
        Further, since use the class 'SeqRange' for 'itrRange' we cannot use
        curr() == end() + 1 to identify the end point because 'SeqRange' does
        not internally allow curr > end */
     itrRange = SeqRange(currIt->getBySeqno(),
                         list.seqList.back().getBySeqno() + 1);
-
-    auto severity = isBackfill ? spdlog::level::level_enum::info
-                               : spdlog::level::level_enum::debug;
-
-    EP_LOG_FMT(severity,
-               "{} Created range iterator from {} to {}",
-               list.vbid,
-               curr(),
-               end());
 }
 
 BasicLinkedList::RangeIteratorLL::~RangeIteratorLL() {
+    releaseReadRange();
+}
+
+void BasicLinkedList::RangeIteratorLL::releaseReadRange() {
     std::lock_guard<SpinLock> lh(list.rangeLock);
-    if (readLockHolder.owns_lock()) {
-        /* we must reset the list readRange only if the list iterator still owns
-           the read lock on the list */
-        list.readRange.reset();
+    if (readRange) {
+        /* we must release the read range only if the iterator still holds it;
+           it may already have been released on reaching the end */
+        list.releaseReadRange(lh, *readRange);
+        readRange.reset();
         auto severity = isBackfill ? spdlog::level::level_enum::info
                                    : spdlog::level::level_enum::debug;
         EP_LOG_FMT(severity, "{} Releasing the range iterator", list.vbid);
     }
-    /* As readLockHolder goes out of scope here, it will automatically release
-       the snapshot read lock on the linked list */
 }
 
 OrderedStoredValue& BasicLinkedList::RangeIteratorLL::operator*() const {
@@ -562,15 +655,10 @@ void BasicLinkedList::RangeIteratorLL::incrOperatorHelper() {
     /* Check if the iterator is pointing to the last element. Increment beyond
        the last element indicates the end of the iteration */
     if (curr() == itrRange.getEnd() - 1) {
-        std::lock_guard<SpinLock> lh(list.rangeLock);
-        /* We reset the range and release the readRange lock here so that any
-           iterator client that does not delete the iterator obj will not end up
-           holding the list readRange lock forever */
-        list.readRange.reset();
-        auto severity = isBackfill ? spdlog::level::level_enum::info
-                                   : spdlog::level::level_enum::debug;
-        EP_LOG_FMT(severity, "{} Releasing the range iterator", list.vbid);
-        readLockHolder.unlock();
+        /* We release the read range here so that any iterator client that does
+           not delete the iterator obj will not end up holding a read range on
+           the list forever */
+        releaseReadRange();
 
         /* Update the begin to end() so the client can see that the iteration
            has ended */
@@ -584,7 +672,7 @@ void BasicLinkedList::RangeIteratorLL::incrOperatorHelper() {
            linked list. This helps reduce the stale items in the list during
            heavy update load from the front end */
         std::lock_guard<SpinLock> lh(list.rangeLock);
-        list.readRange.setBegin(currIt->getBySeqno());
+        (*readRange)->setBegin(currIt->getBySeqno());
     }
 
     /* Also update the current range stored in the iterator obj */
@@ -33,6 +33,8 @@
 #include <platform/non_negative_counter.h>
 #include <relaxed_atomic.h>
 
+#include <list>
+
 /* This option will configure "list" to use the member hook */
 using MemberHookOption =
         boost::intrusive::member_hook<OrderedStoredValue,
@@ -134,17 +136,31 @@ private:
  * Ordering/Hierarchy of Locks:
  * ===========================
  * BasicLinkedList has 3 locks namely:
- * (i) writeLock (ii) rangeLock (iii) rangeReadLock
+ * (i) writeLock (ii) rangeLock (iii) purgeLock
  * Description of each lock can be found below in the class declaration, here
  * we describe in what order the locks should be grabbed
  *
- * rangeReadLock ==> writeLock ==> rangeLock is the valid lock hierarchy.
+ * purgeLock ==> writeLock ==> rangeLock is the valid lock hierarchy.
  *
  * Preferred/Expected Lock Duration:
  * ================================
  * 'writeLock' and 'rangeLock' are held for short durations, typically for
  * single list element writes and reads.
- * 'rangeReadLock' is held for longer duration on the list (for entire range).
+ * 'purgeLock' is held for the duration of a purgeTombstones() run.
+ *
+ * Concurrent Readers:
+ * ==================
+ * Any number of range reads / range iterators may read the list at the same
+ * time, concurrently with the tombstone purger. Each registers the range it
+ * is yet to read in 'readRanges' (and shrinks it as it moves along), and:
+ * (i) an update to an item in any registered range appends a new version
+ *     instead of moving the item, so every reader sees a point-in-time
+ *     snapshot;
+ * (ii) the purger only removes stale items below the begin of every other
+ *      registered range, that is, items which all current readers have
+ *      already moved past. New readers may start anywhere in the list, so
+ *      registering a range and removing an item are both done under
+ *      writeLock + rangeLock.
  */
 class BasicLinkedList : public SequenceList {
 public:
@@ -204,7 +220,7 @@ public:
     std::mutex& getListWriteLock() const override;
 
     boost::optional<SequenceList::RangeIterator> makeRangeIterator(
-            bool isBackfill) override;
+            bool isBackfill, seqno_t start = 1) override;
 
     void dump() const override;
 
@@ -219,34 +235,75 @@ protected:
      */
     mutable std::mutex writeLock;
 
+    using ReadRanges = std::list<SeqRange>;
+
     /**
-     * Used to mark of the range where point-in-time snapshot is happening.
+     * Used to mark of the ranges where point-in-time snapshots are happening,
+     * one per in-flight range read / range iterator / purge.
      * To get a valid point-in-time snapshot and for correct list iteration we
-     * must not de-duplicate an item in the list in this range.
+     * must not de-duplicate an item in the list in any of these ranges.
      */
-    SeqRange readRange;
+    ReadRanges readRanges;
 
     /**
-     * Lock that protects readRange.
+     * Lock that protects readRanges.
      * We use spinlock here since the lock is held only for very small time
      * periods.
      */
     mutable SpinLock rangeLock;
 
     /**
-     * Lock that serializes range reads on the 'seqList' - i.e. serializes
-     * the addition / removal of range reads from the set in-flight.
-     * We need to serialize range reads because, range reads set a list level
-     * range in which items are read. If we have multiple range reads then we
-     * must handle the races in the updation of the range to have most inclusive
-     * range.
-     * For now we use this lock to allow only one range read at a time.
+     * Lock that serializes purgeTombstones() runs, which share the
+     * 'pausedPurgePoint'.
+     */
+    std::mutex purgeLock;
+
+    /**
+     * Registers a new read range [begin, end] on the list.
+     *
+     * @param rangeGuard must be holding rangeLock
+     * @return handle to pass to releaseReadRange() once the read is done
+     */
+    ReadRanges::iterator registerReadRange(std::lock_guard<SpinLock>& rangeGuard,
+                                           seqno_t begin,
+                                           seqno_t end);
+
+    /**
+     * Removes a read range previously registered with registerReadRange().
+     *
+     * @param rangeGuard must be holding rangeLock
+     */
+    void releaseReadRange(std::lock_guard<SpinLock>& rangeGuard,
+                          ReadRanges::iterator range);
+
+    /**
+     * @param rangeGuard must be holding rangeLock
+     * @return true if the seqno falls in any registered read range
+     */
+    bool fallsInAnyReadRange(std::lock_guard<SpinLock>& rangeGuard,
+                             seqno_t seqno) const;
+
+    /**
+     * Returns the list element from which to search for the first element with
+     * a seqno >= start; that is, an element at or before it in the list (or
+     * the end of the list if it is empty).
+     * BasicLinkedList has no index into the list so returns the front of the
+     * list.
      *
-     * It is also additionally used in purgeTombstones() to prevent the
-     * creation of any new rangeReads while purge is in-progress - see
-     * detailed comments there.
+     * @param writeGuard must be holding writeLock
      */
-    std::mutex rangeReadLock;
+    virtual OrderedLL::iterator seekHint(std::lock_guard<std::mutex>& writeGuard,
+                                         seqno_t start);
+
+    /**
+     * Called just before an element is unlinked from 'seqList', either to be
+     * moved to the end of the list (updateListElem) or to be purged.
+     *
+     * @param writeGuard must be holding writeLock
+     */
+    virtual void willRemoveListElem(std::lock_guard<std::mutex>& writeGuard,
+                                    OrderedStoredValue& v) {
+    }
 
     /* Overall memory consumed by (stale) OrderedStoredValues owned by the
        list */
@@ -257,7 +314,27 @@ protected:
     Couchbase::RelaxedAtomic<size_t> staleMetaDataSize;
 
 private:
-    OrderedLL::iterator purgeListElem(OrderedLL::iterator it);
+    /**
+     * Unlinks the (stale) element at 'it' from the list and updates the
+     * list stats. Ownership of the element is passed to 'purged', so that
+     * the caller can free it once it has released the writeLock.
+     *
+     * @return iterator to the element following the removed one
+     */
+    OrderedLL::iterator purgeListElem(std::lock_guard<std::mutex>& writeGuard,
+                                      OrderedLL::iterator it,
+                                      StoredValue::UniquePtr& purged);
+
+    /**
+     * Returns true if no reader, other than the one holding 'self', could
+     * still be reading the list element at 'seqno'; that is, seqno is below
+     * the begin of every other registered read range.
+     *
+     * @param rangeGuard must be holding rangeLock
+     */
+    bool passedByOtherReaders(std::lock_guard<SpinLock>& rangeGuard,
+                              ReadRanges::iterator self,
+                              seqno_t seqno) const;
 
     /**
      * We need to keep track of the highest seqno separately because there is a
@@ -317,20 +394,20 @@ private:
     class RangeIteratorLL : public SequenceList::RangeIteratorImpl {
     public:
         /**
-         * Method to create instances of RangeIteratorLL. We only
-         * allow one RangeIteratorLL object to exist at any one time,
-         * hence creation can fail and that's why object creation is via a
-         * public method and not constructor.
+         * Method to create instances of RangeIteratorLL. Any number of
+         * RangeIteratorLL objects may exist on a list at the same time; each
+         * registers its own read range on the list.
          *
          * @param ll ref to the linkedlist on which the iterator is created
          * @param isBackfill indicates if the iterator is for backfill (for
          *                   debug)
+         * @param start seqno of the first item to be read
          *
-         * @return Non-null pointer on success, or null if a RangeIteratorLL
-         *         already exists.
+         * @return Non-null pointer to the iterator
          */
         static std::unique_ptr<RangeIteratorLL> create(BasicLinkedList& ll,
-                                                       bool isBackfill);
+                                                       bool isBackfill,
+                                                       seqno_t start);
 
         ~RangeIteratorLL();
 
@@ -362,21 +439,23 @@ private:
         }
 
     private:
-        /* We have a private constructor because we want to create the iterator
-           optionally, that is, only when it is possible to get a read lock */
-        RangeIteratorLL(BasicLinkedList& ll, bool isBackfill);
+        /* We have a private constructor so that iterators are only created
+           via create() */
+        RangeIteratorLL(BasicLinkedList& ll, bool isBackfill, seqno_t start);
 
         /**
-         * Indicates if the client should try creating the iterator at a later
-         * point.
-         *
-         * @return true: iterator should be created later again
-         *         false: iterator created successfully
+         * Releases the iterator's read range on the list, if it still holds
+         * one.
          */
-        bool tryLater() const {
-            /* could not lock and the list has items */
-            return (!readLockHolder && (list.getHighSeqno() > 0));
-        }
+        void releaseReadRange();
+
+        /**
+         * Positions the iterator at the list's seekHint() for 'start' and
+         * registers the read range from there to the end of the list.
+         */
+        void initRange(std::lock_guard<std::mutex>& listWriteLg,
+                       std::lock_guard<SpinLock>& lh,
+                       seqno_t start);
 
         /**
          * Helps to increment the iterator. Moves the iterator to the next
@@ -400,8 +479,9 @@ private:
         /* The current list element pointed by the iterator */
         OrderedLL::iterator currIt;
 
-        /* Lock holder which allows having only one iterator at a time */
-        std::unique_lock<std::mutex> readLockHolder;
+        /* The read range registered on the list by this iterator, if the
+           iterator is still reading */
+        boost::optional<ReadRanges::iterator> readRange;
 
         /* Current range of the iterator */
         SeqRange itrRange;
@@ -35,6 +35,7 @@ extern "C" {
 }
 
 static get_allocation_size getAllocSize = defaultGetAllocSize;
+static switch_arena_func switchArena = nullptr;
 
 
 
@@ -69,12 +70,24 @@ static bool verifyEngine(EventuallyPersistentEngine *engine)
    return true;
 }
 
-void ObjectRegistry::initialize(get_allocation_size func) {
+void ObjectRegistry::initialize(get_allocation_size func,
+                                switch_arena_func switchArenaFunc) {
     getAllocSize = func;
+    switchArena = switchArenaFunc;
 }
 
 void ObjectRegistry::reset() {
     getAllocSize = defaultGetAllocSize;
+    switchArena = nullptr;
+}
+
+/**
+ * The bytes requested for the given Blob's own allocation. A chunked Blob
+ * only owns its header; each of its segments is a Blob which accounts for
+ * itself (once, however many versions of the document share it).
+ */
+static size_t getBlobRequestedSize(const Blob& blob) {
+    return blob.isChunked() ? sizeof(ChunkedBlob) : blob.getSize();
 }
 
 void ObjectRegistry::onCreateBlob(const Blob *blob)
@@ -83,11 +96,12 @@ void ObjectRegistry::onCreateBlob(const Blob *blob)
    if (verifyEngine(engine)) {
        auto& coreLocalStats = engine->getEpStats().coreLocal.get();
 
+       const size_t requested = getBlobRequestedSize(*blob);
        size_t size = getAllocSize(blob);
        if (size == 0) {
-           size = blob->getSize();
+           size = requested;
        } else {
-           coreLocalStats->blobOverhead.fetch_add(size - blob->getSize());
+           coreLocalStats->blobOverhead.fetch_add(size - requested);
        }
        coreLocalStats->currentSize.fetch_add(size);
        coreLocalStats->totalValueSize.fetch_add(size);
@@ -101,11 +115,12 @@ void ObjectRegistry::onDeleteBlob(const Blob *blob)
    if (verifyEngine(engine)) {
        auto& coreLocalStats = engine->getEpStats().coreLocal.get();
 
+       const size_t requested = getBlobRequestedSize(*blob);
        size_t size = getAllocSize(blob);
        if (size == 0) {
-           size = blob->getSize();
+           size = requested;
        } else {
-           coreLocalStats->blobOverhead.fetch_sub(size - blob->getSize());
+           coreLocalStats->blobOverhead.fetch_sub(size - requested);
        }
        coreLocalStats->currentSize.fetch_sub(size);
        coreLocalStats->totalValueSize.fetch_sub(size);
@@ -149,6 +164,26 @@ void ObjectRegistry::onDeleteStoredValue(const StoredValue *sv)
    }
 }
 
+void ObjectRegistry::onCreateInlineValue(const StoredValue* sv) {
+    EventuallyPersistentEngine* engine = th->get();
+    if (verifyEngine(engine)) {
+        auto& coreLocalStats = engine->getEpStats().coreLocal.get();
+        coreLocalStats->numInlineValue++;
+        coreLocalStats->inlineValueSavedBytes.fetch_add(
+                sv->getInlineValueSavedBytes());
+    }
+}
+
+void ObjectRegistry::onDeleteInlineValue(const StoredValue* sv) {
+    EventuallyPersistentEngine* engine = th->get();
+    if (verifyEngine(engine)) {
+        auto& coreLocalStats = engine->getEpStats().coreLocal.get();
+        coreLocalStats->numInlineValue--;
+        coreLocalStats->inlineValueSavedBytes.fetch_sub(
+                sv->getInlineValueSavedBytes());
+    }
+}
+
 
 void ObjectRegistry::onCreateItem(const Item *pItem)
 {
@@ -186,6 +221,9 @@ EventuallyPersistentEngine *ObjectRegistry::onSwitchThread(
     }
 
     th->set(engine);
+    if (switchArena) {
+        switchArena(engine ? engine->getArena() : 0);
+    }
     return old_engine;
 }
 
@@ -220,12 +258,13 @@ bool ObjectRegistry::memoryDeallocated(size_t mem) {
 }
 
 NonBucketAllocationGuard::NonBucketAllocationGuard() {
-    engine = th->get();
-    th->set(nullptr);
+    // Also moves the thread to the default arena, so the block's allocations
+    // don't land in the bucket's dedicated arena.
+    engine = ObjectRegistry::onSwitchThread(nullptr, true);
 }
 
 NonBucketAllocationGuard::~NonBucketAllocationGuard() {
-    th->set(engine);
+    ObjectRegistry::onSwitchThread(engine);
 }
 
 #endif
@@ -28,13 +28,21 @@ class StoredValue;
 
 extern "C" {
     typedef size_t (*get_allocation_size)(const void *ptr);
+    typedef void (*switch_arena_func)(unsigned arena);
 }
 
 class StoredValue;
 
 class ObjectRegistry {
 public:
-    static void initialize(get_allocation_size func);
+    /**
+     * @param func returns the size of an allocation
+     * @param switchArena if non-null, called on every onSwitchThread() to
+     *        direct the thread's allocations to the engine's dedicated arena
+     *        (or the default arena, 0, if it has none).
+     */
+    static void initialize(get_allocation_size func,
+                           switch_arena_func switchArena = nullptr);
 
     /**
      * Resets the ObjectRegistry back to initial state (before initialize()
@@ -51,6 +59,10 @@ public:
     static void onCreateStoredValue(const StoredValue *sv);
     static void onDeleteStoredValue(const StoredValue *sv);
 
+    /// Called when a StoredValue starts / stops holding its value inline.
+    static void onCreateInlineValue(const StoredValue* sv);
+    static void onDeleteInlineValue(const StoredValue* sv);
+
 
     static EventuallyPersistentEngine *getCurrentEngine();
 
@@ -63,7 +75,8 @@ public:
 };
 
 /**
- * To avoid mem accounting within a block
+ * To avoid mem accounting within a block (and to allocate from the default
+ * arena rather than the bucket's dedicated one)
  */
 class NonBucketAllocationGuard {
 public:
@@ -156,8 +156,8 @@ public:
      * Note: (a) Do not hold the iterator for long, as it will result in stale
      *           items in list and hence increased memory usage.
      *       (b) Make sure to delete the iterator after using it.
-     *       (c) For now, we allow on one RangeIterator. Try to create more
-     *           iterators will result in the create call(s) being blocked.
+     *       (c) Multiple RangeIterators may be in use on a list at the same
+     *           time; each keeps the items in its (remaining) range alive.
      */
     class RangeIterator {
     public:
@@ -399,12 +399,14 @@ public:
     virtual seqno_t getHighestPurgedDeletedSeqno() const = 0;
 
     /**
-     * Returns the current range read begin sequence number.
+     * Returns the current range read begin sequence number (the lowest begin
+     * if there are multiple range reads in progress).
      */
     virtual uint64_t getRangeReadBegin() const = 0;
 
     /**
-     * Returns the current range read end sequence number.
+     * Returns the current range read end sequence number (the highest end
+     * if there are multiple range reads in progress).
      */
     virtual uint64_t getRangeReadEnd() const = 0;
 
@@ -421,12 +423,14 @@ public:
      * the SequenceList, new range iterator will not be allowed
      *
      * @param isBackfill indicates if the iterator is for backfill (for debug)
+     * @param start the iterator is positioned at the first item with a seqno
+     *              >= start (how quickly depends on the implementation)
      *
      * @return range iterator object when possible
      *         null when not possible
      */
     virtual boost::optional<SequenceList::RangeIterator> makeRangeIterator(
-            bool isBackfill) = 0;
+            bool isBackfill, seqno_t start = 1) = 0;
 
     /**
      * Debug - prints a representation of the list to stderr.
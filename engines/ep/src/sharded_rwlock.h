@@ -0,0 +1,324 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <platform/sysinfo.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+/**
+ * A reader-writer lock for read-mostly data, where readers only write to a
+ * cache line of their own.
+ *
+ * A conventional RW lock keeps one reader count which every reader must
+ * modify; with many threads reading (e.g. every front-end operation taking a
+ * read lock on a hot vBucket's collections manifest) that cache line
+ * ping-pongs between cores even though the readers never block each other.
+ *
+ * Here each thread is given one of getNumShards() cache-line sized reader
+ * counters (a slot) the first time it uses any ShardedRWLock, and gives it
+ * back when it exits. Most slots are only ever held by a single thread, and
+ * there are enough of those for nearly two threads per CPU, so normally no
+ * two live threads share one. A reader increments its shard and then checks
+ * no writer is present; a writer announces itself and then waits for every
+ * shard to drain. Readers therefore touch no shared-writable state unless a
+ * writer is present, at the cost of writers being more expensive - which
+ * suits data that is read on every operation but rarely changed.
+ *
+ * Writers are preferred: once a writer has announced itself, new readers
+ * wait for it. A thread which already holds a read lock (its shard is
+ * non-zero) is let in regardless, as the writer can't get the lock until
+ * that one is released anyway, so a nested read lock doesn't deadlock.
+ * That is only possible while the thread has a slot of its own: should more
+ * threads use ShardedRWLocks at once than there are such slots, the extra
+ * threads share the remaining slots, and for them a nested read lock taken
+ * while a writer waits deadlocks, as with other writer-preferring locks
+ * (e.g. SRWLock). Code must therefore still not take the read lock
+ * recursively, nor hold two read locks (e.g. two SharedLocks) of the same
+ * lock at once.
+ *
+ * ReaderLock and WriterLock meet the Lockable requirements so they can be
+ * used with std::lock_guard / std::unique_lock, as with cb::RWLock. A
+ * ReaderLock must be released by the thread which locked it; a read lock
+ * which may be moved to another thread must be held by a SharedLock.
+ */
+class ShardedRWLock {
+public:
+    /// Fewest reader counters per lock.
+    static const size_t minShards = 16;
+    /// Most reader counters per lock (16KB).
+    static const size_t maxShards = 256;
+
+    /**
+     * @return the number of reader counters per lock: the power of two
+     *         which fits two threads per CPU, within [minShards, maxShards].
+     */
+    static size_t getNumShards() {
+        static const size_t numShards = []() {
+            const size_t threads = 2 * Couchbase::get_available_cpu_count();
+            size_t shards = minShards;
+            while (shards < threads && shards < maxShards) {
+                shards *= 2;
+            }
+            return shards;
+        }();
+        return numShards;
+    }
+
+    class ReaderLock {
+    public:
+        explicit ReaderLock(ShardedRWLock& owner) : owner(owner) {
+        }
+
+        void lock() {
+            owner.lock_shared();
+        }
+
+        void unlock() {
+            owner.unlock_shared(getThreadSlot().index);
+        }
+
+    private:
+        ShardedRWLock& owner;
+    };
+
+    /**
+     * Holds a read lock for its lifetime, in the manner of
+     * std::shared_lock. It records the shard it incremented, so it may be
+     * moved to, and released by, a thread other than the one which locked.
+     */
+    class SharedLock {
+    public:
+        explicit SharedLock(ShardedRWLock& lock)
+            : owner(&lock), shard(lock.lock_shared()) {
+        }
+
+        SharedLock(SharedLock&& other) noexcept
+            : owner(other.owner), shard(other.shard) {
+            other.owner = nullptr;
+        }
+
+        SharedLock& operator=(SharedLock&& other) noexcept {
+            if (this != &other) {
+                release();
+                owner = other.owner;
+                shard = other.shard;
+                other.owner = nullptr;
+            }
+            return *this;
+        }
+
+        SharedLock(const SharedLock&) = delete;
+        SharedLock& operator=(const SharedLock&) = delete;
+
+        ~SharedLock() {
+            release();
+        }
+
+        bool owns_lock() const {
+            return owner != nullptr;
+        }
+
+    private:
+        void release() {
+            if (owner) {
+                owner->unlock_shared(shard);
+                owner = nullptr;
+            }
+        }
+
+        ShardedRWLock* owner;
+        size_t shard;
+    };
+
+    class WriterLock {
+    public:
+        explicit WriterLock(ShardedRWLock& owner) : owner(owner) {
+        }
+
+        void lock() {
+            owner.lock();
+        }
+
+        void unlock() {
+            owner.unlock();
+        }
+
+    private:
+        ShardedRWLock& owner;
+    };
+
+    ShardedRWLock()
+        : numShards(getNumShards()),
+          shardStorage(new char[(numShards + 1) * sizeof(Shard)]),
+          readerLock(*this),
+          writerLock(*this) {
+        // Start the shards on a cache line boundary.
+        void* base = shardStorage.get();
+        size_t space = (numShards + 1) * sizeof(Shard);
+        shards = static_cast<Shard*>(std::align(
+                alignof(Shard), numShards * sizeof(Shard), base, space));
+        for (size_t ii = 0; ii < numShards; ++ii) {
+            new (&shards[ii]) Shard();
+        }
+    }
+
+    ShardedRWLock(const ShardedRWLock&) = delete;
+    ShardedRWLock& operator=(const ShardedRWLock&) = delete;
+
+    ReaderLock& reader() {
+        return readerLock;
+    }
+
+    WriterLock& writer() {
+        return writerLock;
+    }
+
+    /**
+     * Acquire the lock for read.
+     * @return the shard incremented, to be passed to unlock_shared()
+     */
+    size_t lock_shared() {
+        const auto& slot = getThreadSlot();
+        auto& shard = shards[slot.index];
+        for (;;) {
+            const auto held =
+                    shard.readers.fetch_add(1, std::memory_order_seq_cst);
+            // Only this thread increments its own shard, so if it was
+            // already held, that's by a read lock which the writer is still
+            // waiting for.
+            if (!writerPresent.load(std::memory_order_seq_cst) ||
+                (held != 0 && slot.exclusive)) {
+                return slot.index;
+            }
+            // A writer got in first; back out and wait for it to finish.
+            shard.readers.fetch_sub(1, std::memory_order_release);
+            std::lock_guard<std::mutex> guard(writerMutex);
+        }
+    }
+
+    /// Release a read lock, given the shard returned by lock_shared().
+    void unlock_shared(size_t shard) {
+        shards[shard].readers.fetch_sub(1, std::memory_order_release);
+    }
+
+    void lock() {
+        writerMutex.lock();
+        writerPresent.store(true, std::memory_order_seq_cst);
+        for (size_t ii = 0; ii < numShards; ++ii) {
+            while (shards[ii].readers.load(std::memory_order_seq_cst) != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void unlock() {
+        writerPresent.store(false, std::memory_order_release);
+        writerMutex.unlock();
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint32_t> readers{0};
+    };
+
+    /// The reader counter used by a thread.
+    struct ThreadSlot {
+        ThreadSlot() {
+            auto& slots = getSlots();
+            std::lock_guard<std::mutex> guard(slots.mutex);
+            if (!slots.free.empty()) {
+                index = slots.free.back();
+                slots.free.pop_back();
+                exclusive = true;
+            } else if (slots.next < getNumExclusiveShards()) {
+                index = slots.next++;
+                exclusive = true;
+            } else {
+                // Every slot of its own is taken; share one of those kept
+                // for sharing (never one another thread has to itself).
+                const auto shared = getNumShards() - getNumExclusiveShards();
+                index = getNumExclusiveShards() + slots.overflow++ % shared;
+                exclusive = false;
+            }
+        }
+
+        ~ThreadSlot() {
+            if (exclusive) {
+                auto& slots = getSlots();
+                std::lock_guard<std::mutex> guard(slots.mutex);
+                slots.free.push_back(index);
+            }
+        }
+
+        size_t index;
+        /// Does this thread alone use the slot?
+        bool exclusive;
+    };
+
+    /// @return the number of shards which are given to a single thread;
+    ///         the remaining 1/8th are shared by any further threads.
+    static size_t getNumExclusiveShards() {
+        return getNumShards() - getNumShards() / 8;
+    }
+
+    /// The slots available to threads, shared by every ShardedRWLock.
+    struct Slots {
+        std::mutex mutex;
+        /// Slots released by exited threads.
+        std::vector<size_t> free;
+        /// The next slot never used.
+        size_t next = 0;
+        /// Round-robin counter for threads which must share a slot.
+        size_t overflow = 0;
+    };
+
+    static Slots& getSlots() {
+        // Never destroyed, so threads may exit after static destruction.
+        static Slots* slots = new Slots();
+        return *slots;
+    }
+
+    /// @return the calling thread's slot, assigned on first use.
+    static const ThreadSlot& getThreadSlot() {
+        static thread_local ThreadSlot slot;
+        return slot;
+    }
+
+    const size_t numShards;
+
+    /// Storage for the shards, with room to align them to a cache line.
+    std::unique_ptr<char[]> shardStorage;
+    Shard* shards;
+
+    /// Set while a writer holds, or is waiting to acquire, the lock.
+    std::atomic<bool> writerPresent{false};
+
+    /// Serialises writers, and is where readers wait for a writer.
+    std::mutex writerMutex;
+
+    ReaderLock readerLock;
+    WriterLock writerLock;
+};
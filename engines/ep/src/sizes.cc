@@ -69,6 +69,7 @@ int main(int, char **) {
                     DocKey("1234567890abcde", DocKeyEncodesCollectionId::No)));
     display("Ordered Stored Value", sizeof(OrderedStoredValue));
     display("Blob", sizeof(Blob));
+    display("ChunkedBlob", sizeof(ChunkedBlob));
     display("value_t", sizeof(value_t));
     display("HashTable", sizeof(HashTable));
     display("Item", sizeof(Item));
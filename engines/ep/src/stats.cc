@@ -82,6 +82,9 @@ EPStats::EPStats()
       pendingCompactions(0),
       bg_fetched(0),
       bg_meta_fetched(0),
+      evictedMetaCacheHits(0),
+      evictedMetaCacheMisses(0),
+      evictedMetaCacheSize(0),
       numRemainingBgItems(0),
       numRemainingBgJobs(0),
       bgNumOperations(0),
@@ -116,6 +119,8 @@ EPStats::EPStats()
       rollbackCount(0),
       defragNumVisited(0),
       defragNumMoved(0),
+      defragStoredValueNumMoved(0),
+      defragResidentBytesReclaimed(0),
       compressorNumVisited(0),
       compressorNumCompressed(0),
       dirtyAgeHisto(),
@@ -257,6 +262,22 @@ size_t EPStats::getStoredValSize() const {
     return std::max(int64_t(0), result);
 }
 
+size_t EPStats::getNumInlineValue() const {
+    int64_t result = 0;
+    for (const auto& core : coreLocal) {
+        result += core->numInlineValue;
+    }
+    return std::max(int64_t(0), result);
+}
+
+size_t EPStats::getInlineValueSavedBytes() const {
+    int64_t result = 0;
+    for (const auto& core : coreLocal) {
+        result += core->inlineValueSavedBytes;
+    }
+    return std::max(int64_t(0), result);
+}
+
 size_t EPStats::getMemOverhead() const {
     int64_t result = 0;
     for (const auto& core : coreLocal) {
@@ -120,6 +120,12 @@ public:
     /// @returns size of all StoredValue objects.
     size_t getStoredValSize() const;
 
+    /// @returns number of StoredValues holding their value inline.
+    size_t getNumInlineValue() const;
+
+    /// @returns bytes saved by holding values inline rather than in Blobs.
+    size_t getInlineValueSavedBytes() const;
+
     /// @returns amount of memory used to track items and what-not.
     size_t getMemOverhead() const;
 
@@ -276,6 +282,13 @@ public:
     Counter bg_fetched;
     //! Number of times meta background fetches occurred.
     Counter bg_meta_fetched;
+    //! Number of metadata lookups answered by an EvictedMetaCache (rather
+    //! than a meta background fetch).
+    Counter evictedMetaCacheHits;
+    //! Number of metadata lookups which missed the EvictedMetaCache.
+    Counter evictedMetaCacheMisses;
+    //! Bytes held by all the vBuckets' EvictedMetaCaches.
+    Counter evictedMetaCacheSize;
     //! Number of remaining bg fetch items
     Counter numRemainingBgItems;
     //! Number of remaining bg fetch jobs.
@@ -381,6 +394,16 @@ public:
      */
     Counter defragNumMoved;
 
+    /** The number of StoredValues that have been moved (defragmented) by the
+     * defragmenter task.
+     */
+    Counter defragStoredValueNumMoved;
+
+    /** Resident bytes released by the allocator after defragmenter task
+     * runs (an estimate, as the allocator is shared between buckets).
+     */
+    Counter defragResidentBytesReclaimed;
+
     Counter compressorNumVisited;
     Counter compressorNumCompressed;
 
@@ -477,6 +500,9 @@ public:
     //! Historgram of batch reads
     MicrosecondHistogram getMultiHisto;
 
+    //! Histogram of time BgFetchers waited for a batch to accumulate
+    MicrosecondHistogram getMultiWindowHisto;
+
     // ! Histograms of various task wait times, one per Task.
     std::vector<MicrosecondHistogram> schedulingHisto;
 
@@ -505,6 +531,8 @@ public:
         numFailedEjects.store(0);
         numNotMyVBuckets.store(0);
         bg_fetched.store(0);
+        evictedMetaCacheHits.store(0);
+        evictedMetaCacheMisses.store(0);
         bgNumOperations.store(0);
         bgWait.store(0);
         bgLoad.store(0);
@@ -525,6 +553,8 @@ public:
         accessScannerSkips.store(0),
         defragNumVisited.store(0),
         defragNumMoved.store(0);
+        defragStoredValueNumMoved.store(0);
+        defragResidentBytesReclaimed.store(0);
 
         compressorNumVisited.store(0);
         compressorNumCompressed.store(0);
@@ -555,6 +585,7 @@ public:
         getMultiBatchSizeHisto.reset();
         dirtyAgeHisto.reset();
         getMultiHisto.reset();
+        getMultiWindowHisto.reset();
         persistenceCursorGetItemsHisto.reset();
         dcpCursorsGetItemsHisto.reset();
 
@@ -642,6 +673,12 @@ public:
     //! Total size of StoredVal memory overhead
     Counter storedValOverhead;
 
+    //! The number of StoredValues holding their value inline
+    Counter numInlineValue;
+
+    //! Memory saved by holding values inline rather than in Blobs
+    Counter inlineValueSavedBytes;
+
     //! Amount of memory used to track items and what-not.
     Counter memOverhead;
 
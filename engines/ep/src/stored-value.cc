@@ -27,6 +27,8 @@
 #include <platform/cb_malloc.h>
 #include <platform/compress.h>
 
+#include <cstring>
+
 const int64_t StoredValue::state_pending_seqno = -2;
 const int64_t StoredValue::state_deleted_key = -3;
 const int64_t StoredValue::state_non_existent_key = -4;
@@ -36,16 +38,18 @@ const int64_t StoredValue::state_collection_open = -6;
 StoredValue::StoredValue(const Item& itm,
                          UniquePtr n,
                          EPStats& stats,
-                         bool isOrdered)
-    : value(itm.getValue()),
-      chain_next_or_replacement(std::move(n)),
+                         bool isOrdered,
+                         uint8_t inlineValueCapacity)
+    : chain_next_or_replacement(std::move(n)),
       cas(itm.getCas()),
       bySeqno(itm.getBySeqno()),
       lock_expiry_or_delete_time(0),
       exptime(itm.getExptime()),
       flags(itm.getFlags()),
       revSeqno(itm.getRevSeqno()),
-      datatype(itm.getDataType()) {
+      datatype(itm.getDataType()),
+      inlineValueCapacity(inlineValueCapacity),
+      inlineValueSize(noInlineValue) {
     // Initialise bit fields
     setDeletedPriv(itm.isDeleted());
     setNewCacheItem(true);
@@ -59,6 +63,10 @@ StoredValue::StoredValue(const Item& itm,
     // object.
     new (key()) SerialisedDocKey(itm.getKey());
 
+    // The key must be in place first, as the inline value follows it.
+    storeValue(itm.getValue());
+    setFreqCounterValue(itm.getFreqCounterValue());
+
     if (isTempInitialItem()) {
         markClean();
     } else {
@@ -73,6 +81,7 @@ StoredValue::StoredValue(const Item& itm,
 }
 
 StoredValue::~StoredValue() {
+    clearInlineValue();
     ObjectRegistry::onDeleteStoredValue(this);
 }
 
@@ -85,7 +94,9 @@ StoredValue::StoredValue(const StoredValue& other, UniquePtr n, EPStats& stats)
       exptime(other.exptime),
       flags(other.flags),
       revSeqno(other.revSeqno),
-      datatype(other.datatype) {
+      datatype(other.datatype),
+      inlineValueCapacity(other.inlineValueCapacity),
+      inlineValueSize(noInlineValue) {
     setDirty(other.isDirty());
     setDeletedPriv(other.isDeleted());
     setNewCacheItem(other.isNewCacheItem());
@@ -98,6 +109,12 @@ StoredValue::StoredValue(const StoredValue& other, UniquePtr n, EPStats& stats)
     StoredDocKey sKey(other.getKey());
     new (key()) SerialisedDocKey(sKey);
 
+    if (other.isValueInline()) {
+        std::memcpy(inlineValue(), other.inlineValue(), other.inlineValueSize);
+        inlineValueSize = other.inlineValueSize;
+        ObjectRegistry::onCreateInlineValue(this);
+    }
+
     ObjectRegistry::onCreateStoredValue(this);
 }
 
@@ -151,7 +168,8 @@ void StoredValue::restoreValue(const Item& itm) {
     }
     datatype = itm.getDataType();
     setDeletedPriv(itm.isDeleted());
-    value = itm.getValue(); // Implicitly also copies the frequency counter
+    storeValue(itm.getValue());
+    setFreqCounterValue(itm.getFreqCounterValue());
     setResident(true);
 }
 
@@ -176,17 +194,66 @@ void StoredValue::restoreMeta(const Item& itm) {
 }
 
 size_t StoredValue::uncompressedValuelen() const {
-    if (!value) {
+    if (!hasValue()) {
         return 0;
     }
     if (mcbp::datatype::is_snappy(datatype)) {
         return cb::compression::get_uncompressed_length(
-                cb::compression::Algorithm::Snappy,
-                {value->getData(), value->valueSize()});
+                cb::compression::Algorithm::Snappy, getValueView());
     }
     return valuelen();
 }
 
+value_t StoredValue::getValue() const {
+    if (isValueInline()) {
+        return value_t(Blob::New(inlineValue(), inlineValueSize));
+    }
+    return value;
+}
+
+cb::const_char_buffer StoredValue::getValueView() const {
+    if (isValueInline()) {
+        return {inlineValue(), inlineValueSize};
+    }
+    if (!value) {
+        return {};
+    }
+    return {value->getData(), value->valueSize()};
+}
+
+size_t StoredValue::getInlineValueSavedBytes() const {
+    if (!isValueInline()) {
+        return 0;
+    }
+    // A Blob would have needed its header plus the value, whereas the
+    // inline space is part of this object (and may be larger than the
+    // current value).
+    const size_t blobSize = Blob::getAllocationSize(inlineValueSize);
+    return blobSize > inlineValueCapacity ? blobSize - inlineValueCapacity : 0;
+}
+
+void StoredValue::storeValue(const value_t& data) {
+    auto freqCount = getFreqCounterValue();
+    clearInlineValue();
+    if (data && !data->isChunked() &&
+        data->valueSize() <= inlineValueCapacity) {
+        std::memcpy(inlineValue(), data->getData(), data->valueSize());
+        inlineValueSize = static_cast<uint8_t>(data->valueSize());
+        value.reset();
+        ObjectRegistry::onCreateInlineValue(this);
+    } else {
+        value.reset(data.get());
+    }
+    setFreqCounterValue(freqCount);
+}
+
+void StoredValue::clearInlineValue() {
+    if (isValueInline()) {
+        ObjectRegistry::onDeleteInlineValue(this);
+        inlineValueSize = noInlineValue;
+    }
+}
+
 bool StoredValue::del() {
     if (isOrdered()) {
         return static_cast<OrderedStoredValue*>(this)->deleteImpl();
@@ -195,16 +262,27 @@ bool StoredValue::del() {
     }
 }
 
-size_t StoredValue::getRequiredStorage(const DocKey& key) {
-    return sizeof(StoredValue) + SerialisedDocKey::getObjectSize(key.size());
+size_t StoredValue::getRequiredStorage(const DocKey& key,
+                                       size_t inlineValueCapacity) {
+    return sizeof(StoredValue) + SerialisedDocKey::getObjectSize(key.size()) +
+           inlineValueCapacity;
 }
 
-std::unique_ptr<Item> StoredValue::toItem(bool lck, Vbid vbucket) const {
+std::unique_ptr<Item> StoredValue::toItem(bool lck,
+                                          Vbid vbucket,
+                                          const value_t& valueBlob) const {
+    // An inline value has to be copied into a Blob for the Item, unless the
+    // caller has one holding the same data.
+    const bool shareValueBlob =
+            isValueInline() && valueBlob && !valueBlob->isChunked() &&
+            valueBlob->valueSize() == inlineValueSize &&
+            std::memcmp(valueBlob->getData(), inlineValue(), inlineValueSize) ==
+                    0;
     auto itm =
             std::make_unique<Item>(getKey(),
                                    getFlags(),
                                    getExptime(),
-                                   value,
+                                   shareValueBlob ? valueBlob : getValue(),
                                    datatype,
                                    lck ? static_cast<uint64_t>(-1) : getCas(),
                                    bySeqno,
@@ -244,6 +322,10 @@ std::unique_ptr<Item> StoredValue::toItemKeyOnly(Vbid vbucket) const {
 }
 
 void StoredValue::reallocate() {
+    if (isValueInline()) {
+        // Nothing allocated separately from this object.
+        return;
+    }
     // Allocate a new Blob for this stored value; copy the existing Blob to
     // the new one and free the old.
     value_t new_val(Blob::Copy(*value));
@@ -284,7 +366,7 @@ bool StoredValue::operator==(const StoredValue& other) const {
 }
 
 bool StoredValue::deleteImpl() {
-    if (isDeleted() && !getValue()) {
+    if (isDeleted() && !hasValue()) {
         // SV is already marked as deleted and has no value - no further
         // deletion possible.
         return false;
@@ -328,12 +410,13 @@ void StoredValue::setValueImpl(const Item& itm) {
         setResident(false);
     } else {
         setResident(true);
-        replaceValue(itm.getValue().get());
+        storeValue(itm.getValue());
     }
 }
 
 bool StoredValue::compressValue() {
-    if (!mcbp::datatype::is_snappy(datatype)) {
+    // Inline values are too small to be worth compressing.
+    if (!mcbp::datatype::is_snappy(datatype) && !isValueInline()) {
         // Attempt compression only if datatype indicates
         // that the value is not compressed already
         cb::compression::Buffer deflated;
@@ -381,9 +464,10 @@ boost::optional<item_info> StoredValue::getItemInfo(uint64_t vbuuid) const {
     info.datatype = datatype;
     info.document_state =
             isDeleted() ? DocumentState::Deleted : DocumentState::Alive;
-    if (getValue()) {
-        info.value[0].iov_base = const_cast<char*>(getValue()->getData());
-        info.value[0].iov_len = getValue()->valueSize();
+    if (hasValue()) {
+        const auto valueView = getValueView();
+        info.value[0].iov_base = const_cast<char*>(valueView.data());
+        info.value[0].iov_len = valueView.size();
     }
     info.key = getKey();
     return info;
@@ -430,15 +514,15 @@ std::ostream& operator<<(std::ostream& os, const StoredValue& sv) {
     }
 
     os << " vallen:" << sv.valuelen();
-    if (sv.getValue().get()) {
-        os << " val:\"";
-        const char* data = sv.getValue()->getData();
+    if (sv.hasValue()) {
+        os << (sv.isValueInline() ? " inline" : "") << " val:\"";
+        const auto data = sv.getValueView();
         // print up to first 40 bytes of value.
-        const size_t limit = std::min(size_t(40), sv.getValue()->valueSize());
+        const size_t limit = std::min(size_t(40), data.size());
         for (size_t ii = 0; ii < limit; ii++) {
             os << data[ii];
         }
-        if (limit < sv.getValue()->valueSize()) {
+        if (limit < data.size()) {
             os << " <cut>";
         }
         os << "\"";
@@ -450,8 +534,10 @@ bool OrderedStoredValue::operator==(const OrderedStoredValue& other) const {
     return StoredValue::operator==(other);
 }
 
-size_t OrderedStoredValue::getRequiredStorage(const DocKey& key) {
-    return sizeof(OrderedStoredValue) + SerialisedDocKey::getObjectSize(key);
+size_t OrderedStoredValue::getRequiredStorage(const DocKey& key,
+                                              size_t inlineValueCapacity) {
+    return sizeof(OrderedStoredValue) + SerialisedDocKey::getObjectSize(key) +
+           inlineValueCapacity;
 }
 
 /**
@@ -78,8 +78,19 @@ class OrderedStoredValue;
  *               + - - - - - - - - - +
  *  variable {   | key[]             |
  *   length  {   | ...               |
+ *               + - - - - - - - - - +
+ *  optional {   | inline value[]    |
  *               +-------------------+
  *
+ * Small values (up to stored_value_inline_max_size bytes) are stored inline,
+ * directly after the key, rather than in a separately allocated Blob. This
+ * saves the Blob's header and allocation, and a cache miss when reading the
+ * value. The space for an inline value is reserved when the StoredValue is
+ * created (based on the size of the initial value) and cannot grow; if the
+ * value is later replaced by one which doesn't fit it's held in a Blob as
+ * normal. When the value must outlive the HashBucketLock (e.g. to create an
+ * Item) a Blob holding a copy of the inline value is created on demand.
+ *
  * OrderedStoredValue is a "subclass" of StoredValue, which is used by
  * Ephemeral buckets as it supports maintaining a seqno ordering of items in
  * memory (for Persistent buckets this ordering is maintained on-disk).
@@ -224,7 +235,9 @@ public:
      *                  value exists but has zero length
      */
     bool isCompressible() {
-        if (mcbp::datatype::is_snappy(datatype) || !valuelen()) {
+        // Inline values are too small to be worth compressing.
+        if (mcbp::datatype::is_snappy(datatype) || !valuelen() ||
+            isValueInline()) {
             return false;
         }
         return value->isCompressible();
@@ -271,11 +284,43 @@ public:
 
     /**
      * Get this item's value.
+     *
+     * If the value is held inline a new Blob holding a copy of it is created
+     * on every call; to just read the value while holding the HashBucketLock
+     * use getValueView() instead.
+     */
+    value_t getValue() const;
+
+    /**
+     * Get a view of this item's value (empty if there is no value). Only
+     * valid while the HashBucketLock is held.
      */
-    const value_t &getValue() const {
+    cb::const_char_buffer getValueView() const;
+
+    /**
+     * Get the Blob holding this item's value. Null if there is no value or
+     * the value is held inline.
+     */
+    const value_t& getValueBlob() const {
         return value;
     }
 
+    /// True if this item has a value, either inline or in a Blob.
+    bool hasValue() const {
+        return isValueInline() || value;
+    }
+
+    /// True if this item's value is held inline (not in a Blob).
+    bool isValueInline() const {
+        return inlineValueSize != noInlineValue;
+    }
+
+    /**
+     * Returns how many bytes holding the value inline saves compared to
+     * holding it in a Blob; zero if the value isn't held inline.
+     */
+    size_t getInlineValueSavedBytes() const;
+
     /**
      * Get the expiration time of this item.
      *
@@ -482,6 +527,9 @@ public:
      }
 
     size_t valuelen() const {
+        if (isValueInline()) {
+            return inlineValueSize;
+        }
         if (!value) {
             return 0;
         }
@@ -500,7 +548,8 @@ public:
      * @return the amount of memory used by this item.
      */
     size_t size() const {
-        return getObjectSize() + valuelen();
+        // An inline value is already accounted for in getObjectSize().
+        return getObjectSize() + (isValueInline() ? 0 : valuelen());
     }
 
     /**
@@ -511,7 +560,7 @@ public:
      * For uncompressed items this is the same as size().
      */
     size_t uncompressedSize() const {
-        return getObjectSize() + uncompressedValuelen();
+        return size() - valuelen() + uncompressedValuelen();
     }
 
     size_t metaDataSize() const {
@@ -551,11 +600,13 @@ public:
 
     /// Discard the value from this document.
     void resetValue() {
+        clearInlineValue();
         value.reset();
     }
 
     /// Replace the existing value with new data.
     void replaceValue(TaggedPtr<Blob> data) {
+        clearInlineValue();
         // Maintain the frequency count for the storedValue.
         auto freqCount = getFreqCounterValue();
         value.reset(data);
@@ -605,8 +656,14 @@ public:
      *
      * @param lck if true, the new item will return a locked CAS ID.
      * @param vbucket the vbucket containing this item.
+     * @param valueBlob optionally a Blob holding the same data as this
+     *        object's value (e.g. the one it was just stored from). If the
+     *        value is held inline the Item shares that Blob rather than
+     *        getting a newly allocated copy.
      */
-    std::unique_ptr<Item> toItem(bool lck, Vbid vbucket) const;
+    std::unique_ptr<Item> toItem(bool lck,
+                                 Vbid vbucket,
+                                 const value_t& valueBlob = {}) const;
 
     /**
      * Generate a new Item with only key and metadata out of this object.
@@ -683,8 +740,10 @@ public:
     static const int64_t state_collection_open;
 
     /**
-     * Return the size in byte of this object; both the fixed fields and the
-     * variable-length key. Doesn't include value size (allocated externally).
+     * Return the size in byte of this object; the fixed fields, the
+     * variable-length key and any space reserved for an inline value.
+     * Doesn't include the size of a value held in a Blob (allocated
+     * externally).
      */
     inline size_t getObjectSize() const;
 
@@ -704,6 +763,11 @@ public:
     OrderedStoredValue* toOrderedStoredValue();
     const OrderedStoredValue* toOrderedStoredValue() const;
 
+    /// @return true if this object is an OrderedStoredValue.
+    bool isOrdered() const {
+        return bits.test(orderedIndex);
+    }
+
     /**
      * Check if the contents of the StoredValue is same as that of the other
      * one. Does not consider the intrusive hash bucket link.
@@ -712,8 +776,13 @@ public:
      */
     bool operator==(const StoredValue& other) const;
 
-    /// Return how many bytes are need to store item given key as a StoredValue
-    static size_t getRequiredStorage(const DocKey& key);
+    /// Return how many bytes are need to store item given key as a
+    /// StoredValue, with the given space reserved for an inline value.
+    static size_t getRequiredStorage(const DocKey& key,
+                                     size_t inlineValueCapacity = 0);
+
+    /// Largest space which can be reserved for an inline value.
+    static constexpr size_t maxInlineValueCapacity = 254;
 
 protected:
     /**
@@ -727,11 +796,14 @@ protected:
      *           which the new item is being inserted).
      * @param stats EPStats to update for this new StoredValue
      * @param isOrdered Are we constructing an OrderedStoredValue?
+     * @param inlineValueCapacity Bytes allocated after the key for holding
+     *        the value inline.
      */
     StoredValue(const Item& itm,
                 UniquePtr n,
                 EPStats& stats,
-                bool isOrdered);
+                bool isOrdered,
+                uint8_t inlineValueCapacity);
 
     // Destructor. protected, as needs to be carefully deleted (via
     // StoredValue::Destructor) depending on the value of isOrdered flag.
@@ -760,6 +832,27 @@ protected:
      */
     inline SerialisedDocKey* key();
 
+    /// Get the address of the space for an inline value (after the key).
+    const char* inlineValue() const {
+        return reinterpret_cast<const char*>(&getKey()) +
+               getKey().getObjectSize();
+    }
+
+    char* inlineValue() {
+        return const_cast<char*>(
+                const_cast<const StoredValue&>(*this).inlineValue());
+    }
+
+    /**
+     * Set the value to the given one - inline if it fits in the space
+     * reserved, otherwise by taking a reference to the Blob. The frequency
+     * counter is unchanged.
+     */
+    void storeValue(const value_t& data);
+
+    /// Discard the value if held inline.
+    void clearInlineValue();
+
     /**
      * Logically mark this SV as deleted.
      * Implementation for StoredValue instances (dispatched to by del() based
@@ -781,10 +874,6 @@ protected:
         bits.set(staleIndex, value);
     }
 
-    bool isOrdered() const {
-        return bits.test(orderedIndex);
-    }
-
     void setOrdered(bool value) {
         bits.set(orderedIndex, value);
     }
@@ -856,6 +945,15 @@ protected:
 
     folly::AtomicBitSet<sizeof(uint8_t)> bits;
 
+    /// Bytes reserved after the key for an inline value. Fixed at creation.
+    uint8_t inlineValueCapacity;
+
+    /// Length of the value held inline, or noInlineValue if there is no
+    /// inline value (the value, if any, is in a Blob).
+    uint8_t inlineValueSize;
+
+    static constexpr uint8_t noInlineValue = 0xff;
+
     friend std::ostream& operator<<(std::ostream& os, const StoredValue& sv);
 };
 
@@ -936,8 +1034,9 @@ public:
     bool operator==(const OrderedStoredValue& other) const;
 
     /// Return how many bytes are need to store item with given key as an
-    /// OrderedStoredValue
-    static size_t getRequiredStorage(const DocKey& key);
+    /// OrderedStoredValue, with the given space reserved for an inline value.
+    static size_t getRequiredStorage(const DocKey& key,
+                                     size_t inlineValueCapacity = 0);
 
     /**
      * Return the time the item was deleted. Only valid for deleted items.
@@ -972,8 +1071,13 @@ private:
     // OrderedStoredValueFactory.
     OrderedStoredValue(const Item& itm,
                        UniquePtr n,
-                       EPStats& stats)
-        : StoredValue(itm, std::move(n), stats, /*isOrdered*/ true) {
+                       EPStats& stats,
+                       uint8_t inlineValueCapacity)
+        : StoredValue(itm,
+                      std::move(n),
+                      stats,
+                      /*isOrdered*/ true,
+                      inlineValueCapacity) {
     }
 
     // Copy Constructor. Private, as needs to be carefully created via
@@ -1010,9 +1114,10 @@ SerialisedDocKey* StoredValue::key() {
 
 size_t StoredValue::getObjectSize() const {
     // Size of fixed part of OrderedStoredValue or StoredValue, plus size of
-    // (variable) key.
+    // (variable) key and inline value space.
     if (isOrdered()) {
-        return sizeof(OrderedStoredValue) + getKey().getObjectSize();
+        return sizeof(OrderedStoredValue) + getKey().getObjectSize() +
+               inlineValueCapacity;
     }
-    return sizeof(*this) + getKey().getObjectSize();
+    return sizeof(*this) + getKey().getObjectSize() + inlineValueCapacity;
 }
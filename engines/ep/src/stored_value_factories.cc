@@ -19,26 +19,55 @@
 
 #include "item.h"
 
+uint8_t AbstractStoredValueFactory::getInlineValueCapacity(
+        const Item& itm) const {
+    const auto& value = itm.getValue();
+    if (!value || value->valueSize() > maxInlineValueSize ||
+        itm.getBySeqno() == StoredValue::state_temp_init) {
+        return 0;
+    }
+    // Round up to a multiple of 8 bytes (at least 8), so values which
+    // change size a little (e.g. counters) can still be held inline.
+    const size_t capacity = std::max(size_t(8), (value->valueSize() + 7) & ~7);
+    return static_cast<uint8_t>(std::min(capacity, maxInlineValueSize));
+}
+
 StoredValue::UniquePtr StoredValueFactory::operator()(
         const Item& itm, StoredValue::UniquePtr next) {
     // Allocate a buffer to store the StoredValue and any trailing bytes
-    // that maybe required.
+    // that maybe required - the key and space for an inline value.
+    const auto inlineValueCapacity = getInlineValueCapacity(itm);
     return StoredValue::UniquePtr(
-            new (::operator new(StoredValue::getRequiredStorage(itm.getKey())))
+            new (::operator new(StoredValue::getRequiredStorage(
+                    itm.getKey(), inlineValueCapacity)))
                     StoredValue(itm,
                                 std::move(next),
                                 *stats,
-                                /*isOrdered*/ false));
+                                /*isOrdered*/ false,
+                                inlineValueCapacity));
+}
+
+StoredValue::UniquePtr StoredValueFactory::copyStoredValue(
+        const StoredValue& other, StoredValue::UniquePtr next) {
+    // Allocate a buffer to store the copy of StoredValue and any trailing
+    // bytes required for the key and an inline value.
+    return StoredValue::UniquePtr(
+            new (::operator new(other.getObjectSize()))
+                    StoredValue(other, std::move(next), *stats));
 }
 
 StoredValue::UniquePtr OrderedStoredValueFactory::operator()(
         const Item& itm, StoredValue::UniquePtr next) {
     // Allocate a buffer to store the OrderStoredValue and any trailing
-    // bytes required for the key.
+    // bytes required for the key and an inline value.
+    const auto inlineValueCapacity = getInlineValueCapacity(itm);
     return StoredValue::UniquePtr(
-            new (::operator new(
-                    OrderedStoredValue::getRequiredStorage(itm.getKey())))
-                    OrderedStoredValue(itm, std::move(next), *stats));
+            new (::operator new(OrderedStoredValue::getRequiredStorage(
+                    itm.getKey(), inlineValueCapacity)))
+                    OrderedStoredValue(itm,
+                                       std::move(next),
+                                       *stats,
+                                       inlineValueCapacity));
 }
 
 StoredValue::UniquePtr OrderedStoredValueFactory::copyStoredValue(
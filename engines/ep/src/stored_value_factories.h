@@ -21,6 +21,7 @@
  * Factories for creating StoredValue and subclasses of StoredValue.
  */
 
+#include <algorithm>
 #include <memory>
 
 #include "stored-value.h"
@@ -54,6 +55,26 @@ public:
      */
     virtual StoredValue::UniquePtr copyStoredValue(const StoredValue& other,
                                                    StoredValue::UniquePtr next) = 0;
+
+protected:
+    /**
+     * @param maxInlineValueSize The largest value to store inline in the
+     *        StoredValue (0 to disable inline values).
+     */
+    explicit AbstractStoredValueFactory(size_t maxInlineValueSize)
+        : maxInlineValueSize(
+                  std::min(maxInlineValueSize,
+                           size_t(StoredValue::maxInlineValueCapacity))) {
+    }
+
+    /**
+     * Returns how much space to reserve in a new StoredValue for holding the
+     * given item's value inline - zero if it's too large (or has no value).
+     * Rounded up a little so a slightly larger value can replace it.
+     */
+    uint8_t getInlineValueCapacity(const Item& itm) const;
+
+    const size_t maxInlineValueSize;
 };
 
 /**
@@ -63,7 +84,8 @@ class StoredValueFactory : public AbstractStoredValueFactory {
 public:
     using value_type = StoredValue;
 
-    StoredValueFactory(EPStats& s) : stats(&s) {
+    StoredValueFactory(EPStats& s, size_t maxInlineValueSize = 0)
+        : AbstractStoredValueFactory(maxInlineValueSize), stats(&s) {
     }
 
     /**
@@ -72,10 +94,11 @@ public:
     StoredValue::UniquePtr operator()(const Item& itm,
                                       StoredValue::UniquePtr next) override;
 
-    StoredValue::UniquePtr copyStoredValue(const StoredValue& other,
-                                           StoredValue::UniquePtr next) override {
-        throw std::logic_error("Copy of StoredValue is not supported");
-    }
+    /**
+     * Create a copy of StoredValue from the given one.
+     */
+    StoredValue::UniquePtr copyStoredValue(
+            const StoredValue& other, StoredValue::UniquePtr next) override;
 
 private:
     EPStats* stats;
@@ -88,7 +111,8 @@ class OrderedStoredValueFactory : public AbstractStoredValueFactory {
 public:
     using value_type = OrderedStoredValue;
 
-    OrderedStoredValueFactory(EPStats& s) : stats(&s) {
+    OrderedStoredValueFactory(EPStats& s, size_t maxInlineValueSize = 0)
+        : AbstractStoredValueFactory(maxInlineValueSize), stats(&s) {
     }
 
     /**
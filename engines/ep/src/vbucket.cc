@@ -35,6 +35,7 @@
 #include "vbucket.h"
 #include "vbucketdeletiontask.h"
 
+#include <JSON_checker.h>
 #include <memcached/server_document_iface.h>
 #include <platform/compress.h>
 #include <xattr/blob.h>
@@ -155,6 +156,7 @@ VBucket::VBucket(Vbid i,
                  bool mightContainXattrs,
                  const Collections::VB::PersistedManifest& collectionsManifest)
     : ht(st, std::move(valFact), config.getHtSize(), config.getHtLocks()),
+      evictedMetaCache(st, 0),
       checkpointManager(std::make_unique<CheckpointManager>(st,
                                                             i,
                                                             chkConfig,
@@ -469,9 +471,12 @@ void VBucket::addStat(const char *nm, const T &val, ADD_STAT add_stat,
 
 void VBucket::handlePreExpiry(const std::unique_lock<std::mutex>& hbl,
                               StoredValue& v) {
-    value_t value = v.getValue();
-    if (value) {
+    if (v.hasValue()) {
         std::unique_ptr<Item> itm(v.toItem(false, id));
+        // itm_info points into the Item's value; keep a reference to it as
+        // replaceValue() below drops the Item's one (for an inline value
+        // toItem() creates a Blob which nothing else refers to).
+        value_t value = itm->getValue();
         item_info itm_info;
         EventuallyPersistentEngine* engine = ObjectRegistry::getCurrentEngine();
         itm_info =
@@ -709,10 +714,11 @@ VBNotifyCtx VBucket::queueDirty(
         const GenerateBySeqno generateBySeqno,
         const GenerateCas generateCas,
         const bool isBackfillItem,
-        PreLinkDocumentContext* preLinkDocumentContext) {
+        PreLinkDocumentContext* preLinkDocumentContext,
+        const value_t& itmValue) {
     VBNotifyCtx notifyCtx;
 
-    queued_item qi(v.toItem(false, getId()));
+    queued_item qi(v.toItem(false, getId(), itmValue));
 
     // MB-27457: Timestamp deletes only when they don't already have a timestamp
     // assigned. This is here to ensure all deleted items have a timestamp which
@@ -1045,6 +1051,196 @@ ENGINE_ERROR_CODE VBucket::replace(
     }
 }
 
+static bool isJSONWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/// @returns the first non-whitespace character of buf, or 0 if there is none.
+static char firstNonWhitespace(cb::const_char_buffer buf) {
+    for (size_t ii = 0; ii < buf.size(); ++ii) {
+        if (!isJSONWhitespace(buf.data()[ii])) {
+            return buf.data()[ii];
+        }
+    }
+    return 0;
+}
+
+static bool isJSONNumberStart(char c) {
+    return c == '-' || (c >= '0' && c <= '9');
+}
+
+static bool isJSONValueStart(char c) {
+    return c == '{' || c == '[' || c == '"' || c == 't' || c == 'f' ||
+           c == 'n' || isJSONNumberStart(c);
+}
+
+/**
+ * Determine the datatype of the result of an append / prepend without
+ * validating (and hence flattening) it: the answer is deduced from the old
+ * datatype and the edges of the data. Called before the new value is built,
+ * so that documents which can't be handled here don't cost an allocation.
+ *
+ * @param[out] invalidJSONPrefix set if the result is proven to have an
+ *             invalid JSON prefix (see Blob::hasInvalidJSONPrefix()), so
+ *             subsequent appends are also cheap
+ * @returns the datatype, or none if it can only be found by validating the
+ *          whole of the new value.
+ */
+static boost::optional<protocol_binary_datatype_t> getAppendPrependDatatype(
+        const value_t& oldValue,
+        protocol_binary_datatype_t oldDatatype,
+        cb::const_char_buffer added,
+        AppendPrependMode mode,
+        bool& invalidJSONPrefix) {
+    const bool oldIsJSON = mcbp::datatype::is_json(oldDatatype);
+    const char addedStart = firstNonWhitespace(added);
+    if (oldIsJSON && addedStart == 0) {
+        // Only whitespace was added to a JSON document.
+        return PROTOCOL_BINARY_DATATYPE_JSON;
+    }
+
+    if (oldValue) {
+        const char oldStart = firstNonWhitespace(oldValue->getLeadingData());
+        if (mode == AppendPrependMode::Append) {
+            // A prefix which is already invalid JSON (or which can't start a
+            // JSON value), or a complete non-numeric JSON value followed by
+            // something other than whitespace can never become valid JSON.
+            if (oldValue->hasInvalidJSONPrefix() ||
+                (oldStart != 0 && !isJSONValueStart(oldStart)) ||
+                (oldIsJSON && oldStart != 0 && !isJSONNumberStart(oldStart))) {
+                invalidJSONPrefix = true;
+                return PROTOCOL_BINARY_RAW_BYTES;
+            }
+        } else if (oldIsJSON && oldStart != 0 &&
+                   !isJSONNumberStart(oldStart)) {
+            // Only a number can be extended at the front and stay JSON.
+            return PROTOCOL_BINARY_RAW_BYTES;
+        }
+    }
+    if (mode == AppendPrependMode::Prepend && addedStart != 0 &&
+        !isJSONValueStart(addedStart)) {
+        // Prepending something which can't start a JSON value.
+        return PROTOCOL_BINARY_RAW_BYTES;
+    }
+
+    return {};
+}
+
+ENGINE_ERROR_CODE VBucket::appendPrepend(
+        cb::const_char_buffer value,
+        AppendPrependMode mode,
+        uint64_t& cas,
+        const void* cookie,
+        EventuallyPersistentEngine& engine,
+        mutation_descr_t& mutInfo,
+        const Collections::VB::Manifest::CachingReadHandle& readHandle) {
+    auto hbl = ht.getLockedBucket(readHandle.getKey());
+    StoredValue* v = ht.unlocked_find(readHandle.getKey(),
+                                      hbl.getBucketNum(),
+                                      WantsDeleted::Yes,
+                                      TrackReference::No);
+
+    // Leave anything other than a plain, resident, alive document (including
+    // misses which may require a bg fetch) to the generic implementation.
+    if (!v || v->isTempItem() || isLogicallyNonExistent(*v, readHandle) ||
+        !v->isResident() || v->isExpired(ep_real_time()) ||
+        mcbp::datatype::is_snappy(v->getDatatype()) ||
+        mcbp::datatype::is_xattr(v->getDatatype())) {
+        return ENGINE_ENOTSUP;
+    }
+
+    // The generic implementation enforces the limit when allocating the new
+    // item; do the same here so a document can't be grown without bound.
+    const size_t newSize = v->valuelen() + value.size();
+    if (newSize > engine.getMaxItemSize()) {
+        return ENGINE_E2BIG;
+    }
+
+    auto itm = v->toItem(false, getId());
+    // Take a reference, as the Item's value is replaced below. (Use the
+    // Item's value as, unlike the StoredValue's, it's always held in a Blob.)
+    const value_t oldValue = itm->getValue();
+    bool invalidJSONPrefix = false;
+    auto datatype = getAppendPrependDatatype(
+            oldValue, v->getDatatype(), value, mode, invalidJSONPrefix);
+    if (!datatype && oldValue && newSize >= ChunkedBlob::minChunkedSize) {
+        // A value which might be JSON and may be chunked, e.g. an array
+        // being built up element by element. Rather than flatten it on every
+        // append, leave it to the generic implementation (which stores it
+        // contiguously).
+        return ENGINE_ENOTSUP;
+    }
+
+    Blob* newValue;
+    if (!oldValue) {
+        newValue = Blob::New(value.data(), value.size());
+    } else if (mode == AppendPrependMode::Append) {
+        newValue = Blob::Append(*oldValue, value.data(), value.size());
+    } else {
+        newValue = Blob::Prepend(*oldValue, value.data(), value.size());
+    }
+    itm->replaceValue(newValue);
+    if (invalidJSONPrefix) {
+        newValue->setInvalidJSONPrefix();
+    }
+    if (!datatype) {
+        // Small enough to be contiguous; validate it in full.
+        datatype = checkUTF8JSON(reinterpret_cast<const uint8_t*>(
+                                         newValue->getData()),
+                                 newValue->valueSize())
+                           ? PROTOCOL_BINARY_DATATYPE_JSON
+                           : PROTOCOL_BINARY_RAW_BYTES;
+    }
+    itm->setDataType(*datatype);
+
+    PreLinkDocumentContext preLinkDocumentContext(engine, cookie, itm.get());
+    VBQueueItemCtx queueItmCtx(GenerateBySeqno::Yes,
+                               GenerateCas::Yes,
+                               TrackCasDrift::No,
+                               /*isBackfillItem*/ false,
+                               &preLinkDocumentContext);
+
+    MutationStatus status;
+    boost::optional<VBNotifyCtx> notifyCtx;
+    std::tie(status, notifyCtx) = processSet(hbl,
+                                             v,
+                                             *itm,
+                                             cas,
+                                             /*allowExisting*/ true,
+                                             /*hasMetaData*/ false,
+                                             queueItmCtx,
+                                             cb::StoreIfStatus::Continue);
+
+    ENGINE_ERROR_CODE ret = ENGINE_SUCCESS;
+    switch (status) {
+    case MutationStatus::NoMem:
+        ret = ENGINE_ENOMEM;
+        break;
+    case MutationStatus::InvalidCas:
+        ret = ENGINE_KEY_EEXISTS;
+        break;
+    case MutationStatus::IsLocked:
+        ret = ENGINE_LOCKED;
+        break;
+    case MutationStatus::NotFound:
+        ret = ENGINE_KEY_ENOENT;
+        break;
+    case MutationStatus::WasDirty:
+    case MutationStatus::WasClean:
+        notifyNewSeqno(*notifyCtx);
+        cas = v->getCas();
+        mutInfo.seqno = v->getBySeqno();
+        mutInfo.vbucket_uuid = failovers->getLatestUUID();
+        break;
+    case MutationStatus::NeedBgFetch:
+        // Only resident items are handled above.
+        throw std::logic_error(
+                "VBucket::appendPrepend: "
+                "Unexpected NeedBgFetch from processSet");
+    }
+    return ret;
+}
+
 ENGINE_ERROR_CODE VBucket::addBackfillItem(Item& itm) {
     auto hbl = ht.getLockedBucket(itm.getKey());
     StoredValue* v = ht.unlocked_find(itm.getKey(),
@@ -1129,6 +1325,9 @@ ENGINE_ERROR_CODE VBucket::setWithMeta(
                                       hbl.getBucketNum(),
                                       WantsDeleted::Yes,
                                       TrackReference::No);
+    if (!v && checkConflicts == CheckConflicts::Yes) {
+        v = restoreEvictedMetaData(hbl, itm.getKey(), isReplication);
+    }
 
     bool maybeKeyExists = true;
 
@@ -1405,6 +1604,9 @@ ENGINE_ERROR_CODE VBucket::deleteWithMeta(
     auto hbl = ht.getLockedBucket(key);
     StoredValue* v = ht.unlocked_find(
             key, hbl.getBucketNum(), WantsDeleted::Yes, TrackReference::No);
+    if (!v && checkConflicts == CheckConflicts::Yes) {
+        v = restoreEvictedMetaData(hbl, key, isReplication);
+    }
 
     if (v && readHandle.isLogicallyDeleted(v->getBySeqno())) {
         return ENGINE_KEY_ENOENT;
@@ -1640,6 +1842,9 @@ ENGINE_ERROR_CODE VBucket::add(
                                       hbl.getBucketNum(),
                                       WantsDeleted::Yes,
                                       TrackReference::No);
+    if (!v && eviction == FULL_EVICTION) {
+        v = restoreEvictedMetaData(hbl, itm.getKey());
+    }
 
     bool maybeKeyExists = true;
     if ((v == nullptr || v->isTempInitialItem()) &&
@@ -1908,6 +2113,9 @@ ENGINE_ERROR_CODE VBucket::getMetaData(
                                       hbl.getBucketNum(),
                                       WantsDeleted::Yes,
                                       TrackReference::No);
+    if (!v) {
+        v = restoreEvictedMetaData(hbl, readHandle.getKey());
+    }
 
     if (v) {
         stats.numOpsGetMeta++;
@@ -2110,6 +2318,8 @@ void VBucket::deletedOnDiskCbk(const Item& queuedItem, bool deleted) {
     //  1. Item is existent in hashtable, and deleted flag is true
     //  2. rev seqno of queued item matches rev seqno of hash table item
     if (v && v->isDeleted() && (queuedItem.getRevSeqno() == v->getRevSeqno())) {
+        // The tombstone's metadata may still be needed, e.g. by XDCR
+        evictedMetaCache.insert(*v);
         bool isDeleted = deleteStoredValue(hbl, *v);
         if (!isDeleted) {
             throw std::logic_error(
@@ -2163,6 +2373,8 @@ void VBucket::postProcessRollback(const RollbackResult& rollbackResult,
     incrRollbackItemCount(prevHighSeqno - rollbackResult.highSeqno);
     checkpointManager->setOpenCheckpointId(1);
     setReceivingInitialDiskSnapshot(false);
+    // Documents on disk may now differ from their evicted metadata
+    evictedMetaCache.clear();
 }
 
 void VBucket::dump() const {
@@ -2448,6 +2660,7 @@ std::pair<AddStatus, boost::optional<VBNotifyCtx>> VBucket::processAdd(
             /* A 'temp initial item' is just added to the hash table. It is
              not put on checkpoint manager or sequence list */
             v = ht.unlocked_addNewStoredValue(hbl, itm);
+            evictedMetaCache.erase(itm.getKey());
             updateRevSeqNoOfNewStoredValue(*v);
         } else {
             std::tie(v, rv.second) = addNewStoredValue(hbl, itm, queueItmCtx,
@@ -2544,8 +2757,8 @@ VBucket::processExpiredItem(
      * but functionally correct and for performance reasons
      * only the system xattrs need to be stored.
      */
-    value_t value = v.getValue();
-    bool onlyMarkDeleted = value && mcbp::datatype::is_xattr(v.getDatatype());
+    bool onlyMarkDeleted =
+            v.hasValue() && mcbp::datatype::is_xattr(v.getDatatype());
     v.setRevSeqno(v.getRevSeqno() + 1);
     VBNotifyCtx notifyCtx;
     StoredValue* newSv;
@@ -2601,6 +2814,7 @@ TempAddStatus VBucket::addTempStoredValue(const HashTable::HashBucketLock& hbl,
     /* A 'temp initial item' is just added to the hash table. It is
        not put on checkpoint manager or sequence list */
     StoredValue* v = ht.unlocked_addNewStoredValue(hbl, itm);
+    evictedMetaCache.erase(key);
 
     updateRevSeqNoOfNewStoredValue(*v);
     itm.setRevSeqno(v->getRevSeqno());
@@ -2609,6 +2823,30 @@ TempAddStatus VBucket::addTempStoredValue(const HashTable::HashBucketLock& hbl,
     return TempAddStatus::BgFetch;
 }
 
+StoredValue* VBucket::restoreEvictedMetaData(
+        const HashTable::HashBucketLock& hbl,
+        const DocKey& key,
+        bool isReplication) {
+    // Only look where a meta BG fetch would be needed
+    if (!evictedMetaCache.isEnabled() || !maybeKeyExistsInFilter(key)) {
+        return nullptr;
+    }
+
+    auto evicted = evictedMetaCache.take(key);
+    if (!evicted) {
+        return nullptr;
+    }
+
+    if (addTempStoredValue(hbl, key, isReplication) == TempAddStatus::NoMem) {
+        return nullptr;
+    }
+    StoredValue* v = ht.unlocked_find(
+            key, hbl.getBucketNum(), WantsDeleted::Yes, TrackReference::No);
+    ht.unlocked_restoreMeta(
+            hbl.getHTLock(), *evicted->toItem(key, getId()), *v);
+    return v;
+}
+
 void VBucket::notifyNewSeqno(const VBNotifyCtx& notifyCtx) {
     if (newSeqnoCb) {
         newSeqnoCb->callback(getId(), notifyCtx);
@@ -2642,7 +2880,8 @@ int64_t VBucket::queueItem(Item* item, OptionalSeqno seqno) {
 }
 
 VBNotifyCtx VBucket::queueDirty(StoredValue& v,
-                                const VBQueueItemCtx& queueItmCtx) {
+                                const VBQueueItemCtx& queueItmCtx,
+                                const value_t& itmValue) {
     if (queueItmCtx.trackCasDrift == TrackCasDrift::Yes) {
         setMaxCasAndTrackDrift(v.getCas());
     }
@@ -2650,7 +2889,8 @@ VBNotifyCtx VBucket::queueDirty(StoredValue& v,
                       queueItmCtx.genBySeqno,
                       queueItmCtx.genCas,
                       queueItmCtx.isBackfillItem,
-                      queueItmCtx.preLinkDocumentContext);
+                      queueItmCtx.preLinkDocumentContext,
+                      itmValue);
 }
 
 void VBucket::updateRevSeqNoOfNewStoredValue(StoredValue& v) {
@@ -2776,9 +3016,8 @@ std::unique_ptr<Item> VBucket::pruneXattrDocument(
     // Need to take a copy of the value, prune it, and add it back
 
     // Create work-space document
-    std::vector<char> workspace(
-            v.getValue()->getData(),
-            v.getValue()->getData() + v.getValue()->valueSize());
+    const auto value = v.getValueView();
+    std::vector<char> workspace(value.begin(), value.end());
 
     // Now attach to the XATTRs in the document
     cb::xattr::Blob xattr({workspace.data(), workspace.size()},
@@ -23,6 +23,7 @@
 #include "checkpoint_config.h"
 #include "collections/vbucket_manifest.h"
 #include "dcp/dcp-types.h"
+#include "evicted_meta_cache.h"
 #include "hash_table.h"
 #include "hlc.h"
 #include "item_pager.h"
@@ -716,6 +717,10 @@ public:
 
     HashTable         ht;
 
+    /// Metadata of documents which have recently left ht, to save meta BG
+    /// fetches. Only enabled for persistent buckets, when configured.
+    EvictedMetaCache evictedMetaCache;
+
     /// Manager of this vBucket's checkpoints. unique_ptr for pimpl.
     std::unique_ptr<CheckpointManager> checkpointManager;
 
@@ -913,6 +918,35 @@ public:
             mutation_descr_t& mutInfo,
             const Collections::VB::Manifest::CachingReadHandle& readHandle);
 
+    /**
+     * Append or prepend data to an existing document in the vbucket, while
+     * holding the document's hash bucket lock.
+     *
+     * Only resident, alive documents which are neither compressed nor have
+     * xattrs are handled; for anything else ENGINE_ENOTSUP is returned and
+     * the caller should fall back to a get / modify / CAS-store sequence.
+     * The new value shares storage with the existing one where possible
+     * (see ChunkedBlob).
+     *
+     * @param value the data to add to the document
+     * @param mode whether to append or prepend value
+     * @param[in,out] cas value to match; new cas after the update
+     * @param cookie the cookie representing the client
+     * @param engine Reference to ep engine
+     * @param[out] mutInfo Info to uniquely identify (and order) the mutation
+     * @param readHandle Reader access to the affected key's collection data.
+     *
+     * @return the result of the operation
+     */
+    ENGINE_ERROR_CODE appendPrepend(
+            cb::const_char_buffer value,
+            AppendPrependMode mode,
+            uint64_t& cas,
+            const void* cookie,
+            EventuallyPersistentEngine& engine,
+            mutation_descr_t& mutInfo,
+            const Collections::VB::Manifest::CachingReadHandle& readHandle);
+
     /**
      * Delete an item in the vbucket from a non-front end operation (DCP, XDCR)
      *
@@ -1441,11 +1475,15 @@ protected:
      * @param queueItmCtx holds info needed to queue an item in chkpt or vb
      *                    backfill queue, whether to track cas, generate seqno,
      *                    generate new cas
+     * @param itmValue the value of the Item v was just updated from, if any
+     *                 (see StoredValue::toItem())
      *
      * @return Notification context containing info needed to notify the
      *         clients (like connections, flusher)
      */
-    VBNotifyCtx queueDirty(StoredValue& v, const VBQueueItemCtx& queueItmCtx);
+    VBNotifyCtx queueDirty(StoredValue& v,
+                           const VBQueueItemCtx& queueItmCtx,
+                           const value_t& itmValue = {});
 
     /**
      * Queue an item for persistence and replication
@@ -1462,6 +1500,9 @@ protected:
      * @param preLinkDocumentContext context object which allows running the
      *        document pre link callback after the cas is assinged (but
      *        but document not available for anyone)
+     * @param itmValue the value of the Item v was just updated from, if any.
+     *        Lets the queued item share it rather than copying a value
+     *        which v holds inline (see StoredValue::toItem()).
      *
      * @return Notification context containing info needed to notify the
      *         clients (like connections, flusher)
@@ -1471,7 +1512,8 @@ protected:
             GenerateBySeqno generateBySeqno = GenerateBySeqno::Yes,
             GenerateCas generateCas = GenerateCas::Yes,
             bool isBackfillItem = false,
-            PreLinkDocumentContext* preLinkDocumentContext = nullptr);
+            PreLinkDocumentContext* preLinkDocumentContext = nullptr,
+            const value_t& itmValue = {});
 
     /**
      * Adds a temporary StoredValue in in-memory data structures like HT.
@@ -1487,6 +1529,23 @@ protected:
                                      const DocKey& key,
                                      bool isReplication = false);
 
+    /**
+     * If the metadata of key (which must not be in the HT) is in the
+     * evictedMetaCache, add a StoredValue holding it to the HT - as a
+     * completed meta BG fetch would have done. Assumes that HT bucket lock
+     * is grabbed.
+     *
+     * @param hbl Hash table bucket lock that must be held
+     * @param key the key whose metadata is needed
+     * @param isReplication true if issued by consumer (for replication)
+     *
+     * @return the StoredValue added, or nullptr if the metadata must be
+     *         fetched from disk as before (or there is no memory for it)
+     */
+    StoredValue* restoreEvictedMetaData(const HashTable::HashBucketLock& hbl,
+                                        const DocKey& key,
+                                        bool isReplication = false);
+
     /**
      * Internal wrapper function around the callback to be called when a new
      * seqno is generated in the vbucket
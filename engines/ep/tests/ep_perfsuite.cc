@@ -1300,6 +1300,118 @@ static enum test_result perf_dcp_consumer_snap_end_mutation_latency(
     return SUCCESS;
 }
 
+/*
+ * Measures how fast a replica drains mutations which the Consumer had to
+ * buffer (e.g. while replication was throttled), i.e. the rate at which
+ * PassiveStream::processBufferedMessages applies them.
+ * Each round pauses replication (replication_throttle_threshold=0) so that
+ * a snapshot of items is buffered, then resumes it and times how long the
+ * DcpConsumerTask takes to bring the vbucket high-seqno up to the snapshot
+ * end.
+ */
+static enum test_result perf_dcp_consumer_buffered_ingest_rate(
+        EngineIface* h) {
+    const Vbid vbid = Vbid(0);
+    const uint32_t opaque = 1;
+
+    check(set_vbucket_state(h, vbid, vbucket_state_replica),
+          "set_vbucket_state failed");
+
+    auto& dcp = dynamic_cast<DcpIface&>(*h);
+
+    const void* cookie = testHarness->create_cookie();
+    checkeq(ENGINE_SUCCESS,
+            dcp.open(cookie, opaque, 0 /*seqno*/, 0 /*flags*/, "test_consumer"),
+            "dcp.open failed");
+    checkeq(ENGINE_SUCCESS,
+            dcp.add_stream(cookie, opaque, vbid, 0 /*flags*/),
+            "dcp.add_stream failed");
+
+    auto sendMutation = [&dcp, cookie, opaque, vbid](uint64_t seqno) {
+        std::string key = "key_" + std::to_string(seqno);
+        checkeq(ENGINE_SUCCESS,
+                dcp.mutation(
+                        cookie,
+                        opaque,
+                        DocKey(key, DocKeyEncodesCollectionId::No),
+                        cb::const_byte_buffer(
+                                reinterpret_cast<const uint8_t*>("value"), 5),
+                        0 /*priv_bytes*/,
+                        PROTOCOL_BINARY_RAW_BYTES,
+                        0 /*cas*/,
+                        vbid,
+                        0 /*flags*/,
+                        seqno,
+                        0 /*revSeqno*/,
+                        0 /*expiration*/,
+                        0 /*lockTime*/,
+                        {} /*meta*/,
+                        0 /*nru*/),
+                "dcp.mutation failed");
+    };
+
+    // Per-item time (ns) to drain the buffer, one sample per round.
+    std::vector<hrtime_t> timings;
+    const size_t numRounds = 20;
+    const size_t itemsPerRound = ITERATIONS / 20;
+    uint64_t seqno = 0;
+    for (size_t round = 0; round < numRounds; round++) {
+        check(set_param(h,
+                        protocol_binary_engine_param_replication,
+                        "replication_throttle_threshold",
+                        "0"),
+              "Failed to pause replication");
+
+        const uint64_t snapStart = seqno + 1;
+        const uint64_t snapEnd = seqno + itemsPerRound;
+        checkeq(ENGINE_SUCCESS,
+                dcp.snapshot_marker(cookie,
+                                    opaque,
+                                    vbid,
+                                    snapStart,
+                                    snapEnd,
+                                    dcp_marker_flag_t::MARKER_FLAG_MEMORY),
+                "dcp.snapshot_marker failed");
+        while (seqno < snapEnd - 1) {
+            sendMutation(++seqno);
+        }
+
+        check(set_param(h,
+                        protocol_binary_engine_param_replication,
+                        "replication_throttle_threshold",
+                        "99"),
+              "Failed to resume replication");
+
+        // The buffer is not empty so the last mutation is buffered too,
+        // which wakes the DcpConsumerTask from its throttled backoff.
+        auto begin = std::chrono::steady_clock::now();
+        sendMutation(++seqno);
+        while (get_ull_stat(h, "vb_0:high_seqno", "vbucket-seqno") < snapEnd) {
+            std::this_thread::yield();
+        }
+        const auto elapsed =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - begin);
+        timings.push_back(elapsed.count() / itemsPerRound);
+    }
+
+    std::vector<std::pair<std::string, std::vector<hrtime_t>*>> result;
+    result.push_back({"Datatype::Raw", &timings});
+
+    std::string title = "DCP Consumer buffered ingest";
+    // Note: output_result ignores the title for stdout
+    printf("\n=== %s - %zu rounds of %zu items === ",
+           title.c_str(),
+           numRounds,
+           itemsPerRound);
+    output_result(title, "Per-item drain time (ns) ", result, "ns");
+    printf("\n");
+
+    testHarness->destroy_cookie(cookie);
+
+    return SUCCESS;
+}
+
 static enum test_result perf_multi_thread_latency(engine_test_t* test) {
     return perf_latency_baseline_multi_thread_bucket(test,
                                                      1, /* bucket */
@@ -1627,6 +1739,14 @@ BaseTestCase testsuite_testcases[] = {
                  prepare,
                  cleanup),
 
+        TestCase("DCP Consumer buffered ingest rate",
+                 perf_dcp_consumer_buffered_ingest_rate,
+                 test_setup,
+                 teardown,
+                 "backend=couchdb;ht_size=393209",
+                 prepare,
+                 cleanup),
+
         TestCase("Baseline Stat latency", perf_stat_latency_baseline,
                  test_setup, teardown,
                  "backend=couchdb;ht_size=393209",
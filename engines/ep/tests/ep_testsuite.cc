@@ -6788,9 +6788,11 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_bfilter_key_count",
               "ep_bfilter_residency_threshold",
               "ep_bg_fetch_delay",
+              "ep_bgfetcher_max_batch_delay_us",
               "ep_bucket_type",
               "ep_cache_size",
               "ep_chk_max_items",
+              "ep_chk_mem_based_new_chk",
               "ep_chk_period",
               "ep_chk_remover_stime",
               "ep_collections_enabled",
@@ -6802,6 +6804,9 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_conflict_resolution_type",
               "ep_connection_manager_interval",
               "ep_couch_bucket",
+              "ep_couchstore_async_read_threads",
+              "ep_couchstore_async_reads",
+              "ep_couchstore_precompress_docs",
               "ep_cursor_dropping_lower_mark",
               "ep_cursor_dropping_upper_mark",
               "ep_cursor_dropping_checkpoint_mem_upper_mark",
@@ -6828,11 +6833,14 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_dcp_scan_byte_limit",
               "ep_dcp_scan_item_limit",
               "ep_dcp_takeover_max_time",
+              "ep_dedicated_arena",
               "ep_defragmenter_age_threshold",
               "ep_defragmenter_chunk_duration",
               "ep_defragmenter_enabled",
               "ep_defragmenter_interval",
+              "ep_defragmenter_utilisation_threshold",
               "ep_disk_backfill_queue",
+              "ep_evicted_meta_cache_max_size",
               "ep_exp_pager_enabled",
               "ep_exp_pager_initial_run_time",
               "ep_exp_pager_stime",
@@ -6903,6 +6911,7 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_rocksdb_write_rate_limit",
               "ep_rocksdb_uc_max_size_amplification_percent",
               "ep_scopes_max_size",
+              "ep_stored_value_inline_max_size",
               "ep_time_synchronization",
               "ep_uuid",
               "ep_vb0",
@@ -6974,12 +6983,14 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_bg_meta_fetched",
               "ep_bg_remaining_items",
               "ep_bg_remaining_jobs",
+              "ep_bgfetcher_max_batch_delay_us",
               "ep_blob_num",
               "ep_blob_overhead",
               "ep_bucket_priority",
               "ep_bucket_type",
               "ep_cache_size",
               "ep_chk_max_items",
+              "ep_chk_mem_based_new_chk",
               "ep_chk_period",
               "ep_chk_persistence_remains",
               "ep_chk_remover_stime",
@@ -6993,6 +7004,9 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_conflict_resolution_type",
               "ep_connection_manager_interval",
               "ep_couch_bucket",
+              "ep_couchstore_async_read_threads",
+              "ep_couchstore_async_reads",
+              "ep_couchstore_precompress_docs",
               "ep_cursor_dropping_lower_mark",
               "ep_cursor_dropping_lower_threshold",
               "ep_cursor_dropping_upper_mark",
@@ -7025,12 +7039,16 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_dcp_scan_byte_limit",
               "ep_dcp_scan_item_limit",
               "ep_dcp_takeover_max_time",
+              "ep_dedicated_arena",
               "ep_defragmenter_age_threshold",
               "ep_defragmenter_chunk_duration",
               "ep_defragmenter_enabled",
               "ep_defragmenter_interval",
               "ep_defragmenter_num_moved",
               "ep_defragmenter_num_visited",
+              "ep_defragmenter_resident_bytes_reclaimed",
+              "ep_defragmenter_sv_num_moved",
+              "ep_defragmenter_utilisation_threshold",
               "ep_degraded_mode",
               "ep_diskqueue_drain",
               "ep_diskqueue_fill",
@@ -7038,6 +7056,10 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_diskqueue_memory",
               "ep_diskqueue_pending",
               "ep_disk_backfill_queue",
+              "ep_evicted_meta_cache_hits",
+              "ep_evicted_meta_cache_max_size",
+              "ep_evicted_meta_cache_misses",
+              "ep_evicted_meta_cache_size",
               "ep_exp_pager_enabled",
               "ep_exp_pager_initial_run_time",
               "ep_exp_pager_stime",
@@ -7176,6 +7198,7 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
               "ep_startup_time",
               "ep_storage_age",
               "ep_storage_age_highwat",
+              "ep_stored_value_inline_max_size",
               "ep_storedval_num",
               "ep_storedval_overhead",
               "ep_storedval_size",
@@ -7350,6 +7373,7 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
                 "vb_0:persistence:cursor_checkpoint_id",
                 "vb_0:persistence:cursor_seqno",
                 "vb_0:persistence:num_visits",
+                "vb_0:persistence:cursor_mem_pinned",
                 "vb_0:num_items_for_persistence"};
         for (auto& stat : persistence_stats) {
             statsKeys.at("checkpoint").push_back(stat);
@@ -7382,6 +7406,7 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
                           "ep_ephemeral_metadata_purge_age",
                           "ep_ephemeral_metadata_purge_interval",
                           "ep_ephemeral_metadata_purge_stale_chunk_duration",
+                          "ep_ephemeral_seqlist_type",
 
                           "vb_active_auto_delete_count",
                           "vb_active_ht_tombstone_purged_count",
@@ -7436,7 +7461,8 @@ static enum test_result test_mb19687_fixed(EngineIface* h) {
                  "ep_ephemeral_metadata_mark_stale_chunk_duration",
                  "ep_ephemeral_metadata_purge_age",
                  "ep_ephemeral_metadata_purge_interval",
-                 "ep_ephemeral_metadata_purge_stale_chunk_duration"});
+                 "ep_ephemeral_metadata_purge_stale_chunk_duration",
+                 "ep_ephemeral_seqlist_type"});
     }
 
     // In addition to the exact stat keys above, we also use regex patterns
@@ -7548,6 +7574,8 @@ static enum test_result test_mb19687_variable(EngineIface* h) {
                      "bytes",
                      "ep_blob_num",
                      "ep_blob_overhead",
+                     "ep_inline_value_num",
+                     "ep_inline_value_saved_bytes",
                      "ep_item_num",
                      "ep_kv_size",
                      "ep_max_size",
@@ -46,19 +46,30 @@ public:
         return allSeqnos;
     }
 
-    /// Expose the rangeReadLock for testing.
-    std::mutex& getRangeReadLock() {
-        return rangeReadLock;
-    }
-
     /* Register fake read range for testing */
     void registerFakeReadRange(seqno_t start, seqno_t end) {
         std::lock_guard<SpinLock> lh(rangeLock);
-        readRange = SeqRange(start, end);
+        if (fakeReadRange) {
+            **fakeReadRange = SeqRange(start, end);
+        } else {
+            fakeReadRange = registerReadRange(lh, start, end);
+        }
     }
 
     void resetReadRange() {
         std::lock_guard<SpinLock> lh(rangeLock);
-        readRange.reset();
+        if (fakeReadRange) {
+            releaseReadRange(lh, *fakeReadRange);
+            fakeReadRange.reset();
+        }
+    }
+
+    /// @return the number of read ranges currently registered on the list.
+    size_t getNumReadRanges() const {
+        std::lock_guard<SpinLock> lh(rangeLock);
+        return readRanges.size();
     }
+
+private:
+    boost::optional<ReadRanges::iterator> fakeReadRange;
 };
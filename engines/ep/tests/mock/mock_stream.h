@@ -168,6 +168,14 @@ public:
     /// A callback to allow tests to inject code before we access the checkpoint
     std::function<void()> preGetOutstandingItemsCallback = [] { return; };
 
+    void notifySeqnoAvailable(uint64_t seqno) override {
+        ++numSeqnoNotifications;
+        ActiveStream::notifySeqnoAvailable(seqno);
+    }
+
+    /// Number of times the stream has been notified of a new seqno
+    std::atomic<size_t> numSeqnoNotifications{0};
+
     void public_registerCursor(CheckpointManager& manager,
                                const std::string& name,
                                int64_t seqno);
@@ -305,6 +313,13 @@ public:
         return buffer.messages;
     }
 
+    std::vector<MutationConsumerMessage*> getFrontMutationRun(size_t max) {
+        std::unique_lock<std::mutex> lh(buffer.bufMutex);
+        std::vector<MutationConsumerMessage*> run;
+        buffer.frontMutationRun(lh, max, run);
+        return run;
+    }
+
     void setProcessBufferedMessages_postFront_Hook(
             std::function<void()>& hook) {
         processBufferedMessages_postFront_Hook = hook;
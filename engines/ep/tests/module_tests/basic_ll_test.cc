@@ -22,6 +22,7 @@
 
 #include "../mock/mock_basic_ll.h"
 #include "hash_table.h"
+#include "indexed_linked_list.h"
 #include "item.h"
 #include "linked_list.h"
 #include "stats.h"
@@ -695,7 +696,7 @@ TEST_F(BasicLinkedListTest, RangeIteratorUpdateItemDuringRead) {
 }
 
 /* Creates 2 range iterators such that iterator2 is created after iterator1
-   has read all items, and has hence released the rangeReadLock, but before
+   has read all items, and has hence released its read range, but before
    iterator1 is deleted */
 TEST_F(BasicLinkedListTest, MultipleRangeIterator_MB24474) {
     const int numItems = 3;
@@ -733,7 +734,7 @@ TEST_F(BasicLinkedListTest, MultipleRangeIterator_MB24474) {
     EXPECT_EQ(expectedSeqno, actualSeqno);
 }
 
-TEST_F(BasicLinkedListTest, NonBlockingRangeIterators) {
+TEST_F(BasicLinkedListTest, ConcurrentRangeIterators) {
     const int numItems = 3;
     const std::string keyPrefix("key");
 
@@ -743,25 +744,123 @@ TEST_F(BasicLinkedListTest, NonBlockingRangeIterators) {
 
     {
         auto itr1 = getRangeIterator();
-        auto itr2 = basicLL->makeRangeIterator(true /*isBackfill*/);
-        /* itr1 is already using the list, we cannot have another iterator */
-        EXPECT_FALSE(itr2);
+        std::vector<seqno_t> actualSeqno1;
+        actualSeqno1.push_back((*itr1).getBySeqno());
+        ++itr1;
+
+        /* itr1 is already using the list, but we can have another iterator
+           reading the list at the same time */
+        auto itr2 = getRangeIterator();
+        EXPECT_EQ(2, basicLL->getNumReadRanges());
+        EXPECT_EQ(1, basicLL->getRangeReadBegin());
+        EXPECT_EQ(numItems, basicLL->getRangeReadEnd());
+
+        std::vector<seqno_t> actualSeqno2;
+        while (itr2.curr() != itr2.end()) {
+            actualSeqno2.push_back((*itr2).getBySeqno());
+            ++itr2;
+        }
+        EXPECT_EQ(expectedSeqno, actualSeqno2);
+
+        /* itr2 has read all items and released its range */
+        EXPECT_EQ(1, basicLL->getNumReadRanges());
+        EXPECT_EQ(2, basicLL->getRangeReadBegin());
 
-        /* itr1 goes out of scope and releases the read lock on the list */
+        while (itr1.curr() != itr1.end()) {
+            actualSeqno1.push_back((*itr1).getBySeqno());
+            ++itr1;
+        }
+        EXPECT_EQ(expectedSeqno, actualSeqno1);
     }
+    EXPECT_EQ(0, basicLL->getNumReadRanges());
+    EXPECT_EQ(0, basicLL->getRangeReadBegin());
+    EXPECT_EQ(0, basicLL->getRangeReadEnd());
+}
 
-    /* Iterator created now, should be able to read all items */
-    auto itr = getRangeIterator();
-    std::vector<seqno_t> actualSeqno;
+/* An update to an item in the range of any of the iterators must not move the
+   item, so that each iterator gets a point-in-time snapshot */
+TEST_F(BasicLinkedListTest, UpdateDuringConcurrentRangeIterators) {
+    const int numItems = 3;
+    const std::string keyPrefix("key");
 
-    /* Read all the items with the iterator */
-    while (itr.curr() != itr.end()) {
-        actualSeqno.push_back((*itr).getBySeqno());
-        ++itr;
+    std::vector<seqno_t> expectedSeqno =
+            addNewItemsToList(1, keyPrefix, numItems);
+
+    auto itr1 = getRangeIterator();
+    auto itr2 = getRangeIterator();
+
+    /* Move itr1 past key1 and key2; key2 is still in the range of itr2 */
+    ++itr1;
+    ++itr1;
+    updateItemDuringRangeRead(numItems /*highSeqno*/,
+                              keyPrefix + std::to_string(2));
+    EXPECT_EQ(1, basicLL->getNumStaleItems());
+
+    std::vector<seqno_t> actualSeqno;
+    while (itr2.curr() != itr2.end()) {
+        actualSeqno.push_back((*itr2).getBySeqno());
+        ++itr2;
     }
     EXPECT_EQ(expectedSeqno, actualSeqno);
 }
 
+/* The purger must only remove stale items which every iterator has already
+   moved past */
+TEST_F(BasicLinkedListTest, PurgeDuringRangeIterator) {
+    const std::string keyPrefix("key");
+
+    /* Seqnos 1, 3 and 5 are alive, 2 and 4 are stale */
+    addNewItemsToList(1, keyPrefix, 1);
+    addStaleItem("stale2", 2);
+    addNewItemsToList(3, keyPrefix, 1);
+    addStaleItem("stale4", 4);
+    addNewItemsToList(5, keyPrefix, 1);
+    ASSERT_EQ(2, basicLL->getNumStaleItems());
+
+    {
+        auto itr1 = getRangeIterator();
+        auto itr2 = getRangeIterator();
+
+        /* Both iterators are at the start of the list */
+        EXPECT_EQ(0, basicLL->purgeTombstones(5));
+
+        /* Move itr1 to seqno 3, itr2 is still at the start */
+        ++itr1;
+        ++itr1;
+        ASSERT_EQ(3, itr1.curr());
+        EXPECT_EQ(0, basicLL->purgeTombstones(5));
+
+        /* Move itr2 to seqno 4; only seqno 2 has been read by both */
+        ++itr2;
+        ++itr2;
+        ++itr2;
+        ASSERT_EQ(4, itr2.curr());
+        EXPECT_EQ(1, basicLL->purgeTombstones(5));
+        EXPECT_EQ(1, basicLL->getNumStaleItems());
+
+        /* The iterators can still read the rest of their ranges */
+        std::vector<seqno_t> actualSeqno;
+        while (itr1.curr() != itr1.end()) {
+            actualSeqno.push_back((*itr1).getBySeqno());
+            ++itr1;
+        }
+        EXPECT_EQ(std::vector<seqno_t>({3, 4, 5}), actualSeqno);
+
+        actualSeqno.clear();
+        while (itr2.curr() != itr2.end()) {
+            actualSeqno.push_back((*itr2).getBySeqno());
+            ++itr2;
+        }
+        EXPECT_EQ(std::vector<seqno_t>({4, 5}), actualSeqno);
+    }
+
+    /* With no iterators the rest of the stale items can be purged */
+    EXPECT_EQ(1, basicLL->purgeTombstones(5));
+    EXPECT_EQ(0, basicLL->getNumStaleItems());
+    EXPECT_EQ(std::vector<seqno_t>({1, 3, 5}),
+              basicLL->getAllSeqnoForVerification());
+}
+
 TEST_F(BasicLinkedListTest, RangeReadStopsOnInvalidSeqno) {
     /* MB-24376: rangeRead has to stop if it encounters an OSV with a seqno of
      * -1; this item is definitely past the end of the rangeRead, and has not
@@ -1037,3 +1136,134 @@ TEST_F(BasicLinkedListTest, PurgePauseResumeWithUpdateAtPausedPoint) {
     EXPECT_GE(numPaused, 1);
     EXPECT_EQ(numItems, basicLL->getNumItems());
 }
+
+class IndexedLinkedListTest : public ::testing::Test {
+public:
+    IndexedLinkedListTest()
+        : ht(global_stats, BasicLinkedListTest::makeFactory(), 2, 1),
+          list(Vbid(0), global_stats, indexInterval) {
+    }
+
+protected:
+    /**
+     * Adds or updates (moving it to the end of the list) the item with
+     * key == "key" + std::to_string(keyNum), giving it the next seqno.
+     */
+    void setItem(int keyNum) {
+        const std::string val("data");
+        std::mutex fakeSeqLock;
+        std::lock_guard<std::mutex> lg(fakeSeqLock);
+
+        const auto key = makeStoredDocKey("key" + std::to_string(keyNum));
+        auto* existing = ht.find(key, TrackReference::No, WantsDeleted::Yes);
+        std::lock_guard<std::mutex> listWriteLg(list.getListWriteLock());
+        OrderedStoredValue* osv;
+        if (existing) {
+            osv = existing->toOrderedStoredValue();
+            EXPECT_EQ(SequenceList::UpdateStatus::Success,
+                      list.updateListElem(lg, listWriteLg, *osv));
+        } else {
+            Item item(key, 0, 0, val.data(), val.length());
+            EXPECT_EQ(MutationStatus::WasClean, ht.set(item));
+            osv = ht.find(key, TrackReference::No, WantsDeleted::No)
+                          ->toOrderedStoredValue();
+            list.appendToList(lg, listWriteLg, *osv);
+        }
+        osv->setBySeqno(++highSeqno);
+        list.updateHighSeqno(listWriteLg, *osv);
+    }
+
+    /// Removes the item with the given keyNum from the HashTable, leaving a
+    /// stale copy in the list.
+    void makeStale(int keyNum) {
+        const auto key = makeStoredDocKey("key" + std::to_string(keyNum));
+        std::lock_guard<std::mutex> listWriteLg(list.getListWriteLock());
+        auto hbl = ht.getLockedBucket(key);
+        list.markItemStale(
+                listWriteLg, ht.unlocked_release(hbl, key), nullptr);
+    }
+
+    std::vector<seqno_t> readFrom(seqno_t start) {
+        auto itr = list.makeRangeIterator(true /*isBackfill*/, start);
+        EXPECT_TRUE(itr);
+        std::vector<seqno_t> seqnos;
+        while (itr->curr() != itr->end()) {
+            seqnos.push_back((*(*itr)).getBySeqno());
+            ++(*itr);
+        }
+        return seqnos;
+    }
+
+    static std::vector<seqno_t> seqnoRange(seqno_t begin, seqno_t end) {
+        std::vector<seqno_t> seqnos;
+        for (auto seqno = begin; seqno <= end; ++seqno) {
+            seqnos.push_back(seqno);
+        }
+        return seqnos;
+    }
+
+    static const size_t indexInterval = 4;
+    HashTable ht;
+    /* Declared after (and hence destroyed before) the HashTable, as in a
+       vbucket */
+    IndexedLinkedList list;
+    seqno_t highSeqno = 0;
+};
+
+TEST_F(IndexedLinkedListTest, SeekToStart) {
+    const int numItems = 50;
+    for (int i = 1; i <= numItems; ++i) {
+        setItem(i);
+    }
+    EXPECT_EQ(numItems / indexInterval, list.getIndexSize());
+
+    /* Before, on and after indexed elements */
+    for (seqno_t start : {1, 2, 4, 5, 23, 48, 50}) {
+        EXPECT_EQ(seqnoRange(start, numItems), readFrom(start))
+                << "start:" << start;
+    }
+
+    /* The count is an upper bound on the items left to read */
+    auto itr = list.makeRangeIterator(true /*isBackfill*/, 30);
+    ASSERT_TRUE(itr);
+    EXPECT_EQ(30, itr->curr());
+    EXPECT_LE(21, itr->count());
+    EXPECT_GE(23, itr->count());
+
+    /* Beyond the end there is nothing to read */
+    EXPECT_TRUE(readFrom(numItems + 1).empty());
+
+    /* rangeRead uses the index too */
+    auto res = list.rangeRead(23, 30);
+    EXPECT_EQ(ENGINE_SUCCESS, std::get<0>(res));
+    ASSERT_EQ(8, std::get<1>(res).size());
+    EXPECT_EQ(23, std::get<1>(res).front()->getBySeqno());
+}
+
+/* Moving or purging indexed elements moves their index entries along the
+   list */
+TEST_F(IndexedLinkedListTest, IndexFollowsRemovals) {
+    const int numItems = 16;
+    for (int i = 1; i <= numItems; ++i) {
+        setItem(i);
+    }
+    ASSERT_EQ(4, list.getIndexSize());
+
+    /* Update key4 and key8 (indexed), moving them to the end of the list */
+    setItem(4);
+    setItem(8);
+    EXPECT_EQ(4, list.getIndexSize());
+    EXPECT_EQ(std::vector<seqno_t>({5, 6, 7, 9, 10, 11, 12, 13, 14, 15, 16,
+                                    17, 18}),
+              readFrom(5));
+    EXPECT_EQ(std::vector<seqno_t>({9, 10, 11, 12, 13, 14, 15, 16, 17, 18}),
+              readFrom(8));
+
+    /* Make key12 (indexed) and key13 stale and purge them */
+    makeStale(12);
+    makeStale(13);
+    EXPECT_EQ(2, list.purgeTombstones(highSeqno - 1));
+    EXPECT_EQ(4, list.getIndexSize());
+    EXPECT_EQ(std::vector<seqno_t>({14, 15, 16, 17, 18}), readFrom(12));
+    EXPECT_EQ(std::vector<seqno_t>({11, 14, 15, 16, 17, 18}), readFrom(11));
+}
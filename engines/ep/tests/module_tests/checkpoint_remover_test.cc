@@ -28,6 +28,8 @@
 #include "checkpoint_manager.h"
 #include "test_helpers.h"
 
+#include <limits>
+
 size_t CheckpointRemoverTest::getMaxCheckpointItems(VBucket& vb) {
     return vb.checkpointManager->getCheckpointConfig().getCheckpointMaxItems();
 }
@@ -184,6 +186,12 @@ TEST_F(CheckpointRemoverEPTest, CursorDropMemoryFreed) {
             reinterpret_cast<ActiveStream&>(*producer->findStream(vbid));
     ASSERT_EQ(activeStream.getCursor().lock(), cursors[0].lock());
 
+    // The cursor is the only one referencing the closed checkpoint, so
+    // dropping it should free all of that checkpoint's memory.
+    EXPECT_EQ(expectedFreedMemoryFromItems + initialSize,
+              checkpointManager->getMemoryPinnedByCursor(
+                      cursors[0].lock().get()));
+
     // Manually handle the slow stream, this is the same logic as the checkpoint
     // remover task uses, just without the overhead of setting up the task
     auto memoryOverhead = checkpointManager->getMemoryOverhead();
@@ -205,3 +213,37 @@ TEST_F(CheckpointRemoverEPTest, CursorDropMemoryFreed) {
     // There should only be the one checkpoint cursor now for persistence
     ASSERT_EQ(1, checkpointManager->getNumOfCursors());
 }
+
+/**
+ * Check that while memory usage is above the low water mark a new checkpoint
+ * is created once the open checkpoint uses more than the vBucket's share of
+ * the checkpoint memory budget, before the item limit is reached.
+ */
+TEST_F(CheckpointRemoverEPTest, MemBasedCheckpointCreation) {
+    setVBucketStateAndRunPersistTask(vbid, vbucket_state_active);
+    auto vb = store->getVBuckets().getBucket(vbid);
+    auto& checkpointManager = vb->checkpointManager;
+    ASSERT_EQ(1, checkpointManager->getNumCheckpoints());
+
+    // Put memory usage above the low water mark, but far enough below the
+    // high water mark that the vBucket's share is (almost) not scaled down.
+    auto& stats = engine->getEpStats();
+    stats.mem_low_wat.store(0);
+    stats.mem_high_wat.store(std::numeric_limits<size_t>::max() / 2);
+
+    auto& config = engine->getConfiguration();
+    const size_t limit = stats.getMaxDataSize() *
+                         config.getCursorDroppingCheckpointMemLowerMark() /
+                         100 / config.getMaxVbuckets();
+    const size_t numItems = 25;
+    ASSERT_LT(numItems, getMaxCheckpointItems(*vb));
+
+    // Items of a twentieth of the limit should fill the checkpoint after
+    // around 20 items.
+    const std::string value(limit / 20, 'x');
+    for (size_t i = 0; i < numItems; i++) {
+        store_item(vbid, makeStoredDocKey("key_" + std::to_string(i)), value);
+    }
+    EXPECT_EQ(2, checkpointManager->getNumCheckpoints());
+    EXPECT_LT(checkpointManager->getNumOpenChkItems(), numItems);
+}
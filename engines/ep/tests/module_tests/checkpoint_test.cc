@@ -1014,6 +1014,29 @@ TYPED_TEST(CheckpointTest,
     EXPECT_FALSE(this->queueNewItem("key"));
 }
 
+// The checkpoint index refers to the keys of the queued items rather than
+// holding copies; check that the index still finds a key after the item it
+// was first indexed under has been de-duplicated (and freed), using a key too
+// long to be stored inline in a std::string.
+TYPED_TEST(CheckpointTest, DedupeIndexRefersToLatestItem) {
+    const std::string key(100, 'k');
+    ASSERT_TRUE(this->queueNewItem(key));
+    ASSERT_TRUE(this->queueNewItem("other"));
+
+    // Each duplicate is found via the entry for the one it replaces.
+    for (int ii = 0; ii < 3; ++ii) {
+        EXPECT_FALSE(this->queueNewItem(key));
+    }
+    EXPECT_EQ(2, this->manager->getNumOpenChkItems());
+
+    std::vector<queued_item> items;
+    this->manager->getAllItemsForPersistence(items);
+    ASSERT_EQ(3, items.size());
+    EXPECT_EQ(makeStoredDocKey("other"), items.at(1)->getKey());
+    EXPECT_EQ(makeStoredDocKey(key), items.at(2)->getKey());
+    EXPECT_EQ(1005, items.at(2)->getBySeqno());
+}
+
 /*
  * On a consumer only the first disk-snapshot (vbHighSeqno=0) is processed as
  * a real disk-snapshot, i.e. by enqueueing incoming mutations into the
@@ -1341,3 +1364,36 @@ TYPED_TEST(CheckpointTest, takeAndResetCursors) {
     EXPECT_EQ(0,
               manager2->getNumItemsForCursor(dcpCursor2.cursor.lock().get()));
 }
+
+// Test that getListOfCursorsToDrop() returns the cursors of the closed
+// checkpoint ordered by the number of items they have remaining, slowest
+// first (rather than e.g. by name).
+TYPED_TEST(CheckpointTest, CursorsToDropSlowestFirst) {
+    for (int ii = 0; ii < 10; ++ii) {
+        EXPECT_TRUE(this->queueNewItem("key" + std::to_string(ii)));
+    }
+
+    // Cursors at the start, middle and end of the checkpoint, named so that
+    // their name order differs from their progress order
+    auto fast = this->manager->registerCursorBySeqno("a_fast", 1008);
+    auto slow = this->manager->registerCursorBySeqno("b_slow", 0);
+    auto mid = this->manager->registerCursorBySeqno("c_mid", 1004);
+    ASSERT_GT(this->manager->getNumItemsForCursor(slow.cursor.lock().get()),
+              this->manager->getNumItemsForCursor(mid.cursor.lock().get()));
+    ASSERT_GT(this->manager->getNumItemsForCursor(mid.cursor.lock().get()),
+              this->manager->getNumItemsForCursor(fast.cursor.lock().get()));
+
+    // Close the checkpoint and move the persistence cursor out of it, so its
+    // cursors may be dropped
+    this->manager->createNewCheckpoint();
+    EXPECT_TRUE(this->queueNewItem("key10"));
+    std::vector<queued_item> items;
+    this->manager->getAllItemsForPersistence(items);
+    ASSERT_EQ(2, this->manager->getNumCheckpoints());
+
+    auto cursors = this->manager->getListOfCursorsToDrop();
+    ASSERT_EQ(3, cursors.size());
+    EXPECT_EQ(slow.cursor.lock(), cursors[0].lock());
+    EXPECT_EQ(mid.cursor.lock(), cursors[1].lock());
+    EXPECT_EQ(fast.cursor.lock(), cursors[2].lock());
+}
@@ -39,12 +39,12 @@ public:
     }
 
     bool exists(CollectionID identifier) const {
-        std::lock_guard<cb::ReaderLock> readLock(rwlock.reader());
+        std::lock_guard<ShardedRWLock::ReaderLock> readLock(rwlock.reader());
         return exists_UNLOCKED(identifier);
     }
 
     bool isOpen(CollectionID identifier) const {
-        std::lock_guard<cb::ReaderLock> readLock(rwlock.reader());
+        std::lock_guard<ShardedRWLock::ReaderLock> readLock(rwlock.reader());
         expect_true(exists_UNLOCKED(identifier));
         auto itr = map.find(identifier);
         return itr->second.isOpen();
@@ -52,20 +52,20 @@ public:
 
 
     bool isDeleting(CollectionID identifier) const {
-        std::lock_guard<cb::ReaderLock> readLock(rwlock.reader());
+        std::lock_guard<ShardedRWLock::ReaderLock> readLock(rwlock.reader());
         expect_true(exists_UNLOCKED(identifier));
         auto itr = map.find(identifier);
         return itr->second.isDeleting();
     }
 
     size_t size() const {
-        std::lock_guard<cb::ReaderLock> readLock(rwlock.reader());
+        std::lock_guard<ShardedRWLock::ReaderLock> readLock(rwlock.reader());
         return map.size();
     }
 
     bool compareEntry(CollectionID id,
                       const Collections::VB::ManifestEntry& entry) const {
-        std::lock_guard<cb::ReaderLock> readLock(rwlock.reader());
+        std::lock_guard<ShardedRWLock::ReaderLock> readLock(rwlock.reader());
         if (exists_UNLOCKED(id)) {
             auto itr = map.find(id);
             const auto& myEntry = itr->second;
@@ -75,7 +75,7 @@ public:
     }
 
     bool operator==(const MockVBManifest& rhs) const {
-        std::lock_guard<cb::ReaderLock> readLock(rwlock.reader());
+        std::lock_guard<ShardedRWLock::ReaderLock> readLock(rwlock.reader());
         if (rhs.size() != size()) {
             return false;
         }
@@ -94,17 +94,17 @@ public:
     }
 
     int64_t getGreatestEndSeqno() const {
-        std::lock_guard<cb::ReaderLock> readLock(rwlock.reader());
+        std::lock_guard<ShardedRWLock::ReaderLock> readLock(rwlock.reader());
         return greatestEndSeqno;
     }
 
     size_t getNumDeletingCollections() const {
-        std::lock_guard<cb::ReaderLock> readLock(rwlock.reader());
+        std::lock_guard<ShardedRWLock::ReaderLock> readLock(rwlock.reader());
         return nDeletingCollections;
     }
 
     bool isGreatestEndSeqnoCorrect() const {
-        std::lock_guard<cb::ReaderLock> readLock(rwlock.reader());
+        std::lock_guard<ShardedRWLock::ReaderLock> readLock(rwlock.reader());
         // If this is zero greatestEnd should not be a seqno
         if (nDeletingCollections == 0) {
             return greatestEndSeqno == StoredValue::state_collection_open;
@@ -113,7 +113,7 @@ public:
     }
 
     bool isNumDeletingCollectionsoCorrect() const {
-        std::lock_guard<cb::ReaderLock> readLock(rwlock.reader());
+        std::lock_guard<ShardedRWLock::ReaderLock> readLock(rwlock.reader());
         // If this is zero greatestEnd should not be a seqno
         if (greatestEndSeqno != StoredValue::state_collection_open) {
             return nDeletingCollections > 0;
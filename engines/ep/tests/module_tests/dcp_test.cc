@@ -2241,6 +2241,27 @@ TEST_P(ConnectionTest, test_mb17042_duplicate_cookie_producer_connections) {
         << "Dead connections still remain";
 }
 
+/*
+ * Checks that a stream which arms vBucket notifications is told about any
+ * notification issued after it last looked for items (which may have skipped
+ * visiting it), and only those.
+ */
+TEST_P(ConnectionTest, vb_notifications_since_last_look_are_reported) {
+    MockDcpConnMap connMap(*engine);
+    connMap.initialize();
+
+    const auto count = connMap.getVBNotifyCount(vbid);
+    connMap.notifyVBConnections(vbid, 1);
+    connMap.notifyVBConnections(vbid, 2);
+    EXPECT_EQ(count + 2, connMap.getVBNotifyCount(vbid));
+
+    EXPECT_TRUE(connMap.armVBNotification(vbid, count));
+    EXPECT_FALSE(connMap.armVBNotification(vbid, count + 2));
+
+    // Other vBuckets are unaffected
+    EXPECT_EQ(0, connMap.getVBNotifyCount(Vbid(1)));
+}
+
 /* Checks that the DCP producer does an async stream close when the DCP client
    expects "DCP_STREAM_END" msg. */
 TEST_P(ConnectionTest, test_producer_stream_end_on_client_close_stream) {
@@ -3939,3 +3960,215 @@ TEST_F(SingleThreadedStreamTest, MB31410) {
     // Cleanup
     ASSERT_EQ(ENGINE_SUCCESS, consumer->closeStream(opaque, vbid));
 }
+
+/*
+ * The DcpConsumerTask applies the run of mutations at the front of the
+ * buffer in one go. Check that a run stops at a snapshot marker, and that if
+ * a message in the run fails with TMPFAIL / ENOMEM only the messages before
+ * it are removed from the buffer (and acked), leaving the failing one at the
+ * front to be retried.
+ */
+TEST_F(SingleThreadedStreamTest, ProcessBufferedMutationRun) {
+    setVBucketStateAndRunPersistTask(vbid, vbucket_state_replica);
+
+    auto consumer =
+            std::make_shared<MockDcpConsumer>(*engine, cookie, "test_consumer");
+
+    uint32_t opaque = 0;
+
+    ASSERT_EQ(ENGINE_SUCCESS, consumer->addStream(opaque, vbid, 0 /*flags*/));
+
+    auto* passiveStream = static_cast<MockPassiveStream*>(
+            (consumer->getVbucketStream(vbid)).get());
+    ASSERT_TRUE(passiveStream->isActive());
+
+    // Only the checks made when applying the mutations should fail them
+    engine->getConfiguration().setReplicationThrottleThreshold(100);
+
+    SnapshotMarker snapshotMarker(opaque,
+                                  vbid,
+                                  1 /*snapStart*/,
+                                  2 /*snapEnd*/,
+                                  dcp_marker_flag_t::MARKER_FLAG_MEMORY);
+    passiveStream->processMarker(&snapshotMarker);
+
+    // Buffer [mutation:1, mutation:2, marker, mutation:3]; while takeover is
+    // backed up the first message fails and all later ones are buffered
+    // behind it. Mutation 2 is large, so we can later make only it fail.
+    auto vb = store->getVBuckets().getBucket(vbid);
+    vb->setTakeoverBackedUpState(true);
+
+    std::vector<std::unique_ptr<DcpResponse>> messages;
+    messages.push_back(makeMutationConsumerMessage(1, vbid, "value", opaque));
+    messages.push_back(makeMutationConsumerMessage(
+            2, vbid, std::string(2 * 1024 * 1024, 'x'), opaque));
+    messages.push_back(std::make_unique<SnapshotMarker>(
+            opaque, vbid, 3, 3, dcp_marker_flag_t::MARKER_FLAG_MEMORY));
+    messages.push_back(makeMutationConsumerMessage(3, vbid, "value", opaque));
+
+    std::vector<uint32_t> messageBytes;
+    for (auto& message : messages) {
+        messageBytes.push_back(message->getMessageSize());
+        ASSERT_EQ(ENGINE_TMPFAIL,
+                  passiveStream->messageReceived(std::move(message)));
+    }
+    ASSERT_EQ(4, passiveStream->getNumBufferItems());
+
+    // The run at the front stops at the marker, and at the given maximum
+    auto run = passiveStream->getFrontMutationRun(10);
+    ASSERT_EQ(2, run.size());
+    EXPECT_EQ(1, *run[0]->getBySeqno());
+    EXPECT_EQ(2, *run[1]->getBySeqno());
+    EXPECT_EQ(1, passiveStream->getFrontMutationRun(1).size());
+
+    // 1) The first message of the run fails: nothing is removed or acked
+    uint32_t bytesProcessed{0};
+    EXPECT_EQ(cannot_process,
+              passiveStream->processBufferedMessages(bytesProcessed,
+                                                     10 /*batchSize*/));
+    EXPECT_EQ(0, bytesProcessed);
+    ASSERT_EQ(4, passiveStream->getNumBufferItems());
+    EXPECT_EQ(1, *passiveStream->getBufferMessages().front()->getBySeqno());
+
+    // 2) Mutation 1 fits but mutation 2 does not: only mutation 1 is
+    // removed and acked, mutation 2 stays at the front
+    vb->setTakeoverBackedUpState(false);
+    auto& stats = engine->getEpStats();
+    const auto maxDataSize = stats.getMaxDataSize();
+    stats.setMaxDataSize(stats.getEstimatedTotalMemoryUsed() + 512 * 1024);
+
+    EXPECT_EQ(cannot_process,
+              passiveStream->processBufferedMessages(bytesProcessed,
+                                                     10 /*batchSize*/));
+    EXPECT_EQ(messageBytes[0], bytesProcessed);
+    ASSERT_EQ(3, passiveStream->getNumBufferItems());
+    EXPECT_EQ(2, *passiveStream->getBufferMessages().front()->getBySeqno());
+    EXPECT_EQ(1, vb->getHighSeqno());
+
+    // 3) With memory available the rest of the buffer is applied: the run
+    // of mutation 2, the marker and then the run of mutation 3
+    stats.setMaxDataSize(maxDataSize);
+
+    EXPECT_EQ(all_processed,
+              passiveStream->processBufferedMessages(bytesProcessed,
+                                                     10 /*batchSize*/));
+    EXPECT_EQ(messageBytes[1] + messageBytes[2] + messageBytes[3],
+              bytesProcessed);
+    EXPECT_EQ(0, passiveStream->getNumBufferItems());
+    EXPECT_EQ(3, vb->getHighSeqno());
+
+    // Cleanup
+    ASSERT_EQ(ENGINE_SUCCESS, consumer->closeStream(opaque, vbid));
+}
+
+/*
+ * A mutation only visits the streams of its vBucket if one of them has run
+ * out of items to send: an idle stream is woken by the next mutation, but a
+ * stream which already has items to send is not visited again until it has
+ * sent them.
+ */
+TEST_F(SingleThreadedStreamTest, MutationOnlyNotifiesIdleStreams) {
+    setVBucketStateAndRunPersistTask(vbid, vbucket_state_active);
+
+    auto producer = createDcpProducer(cookie, IncludeDeleteTime::No);
+    auto vb = store->getVBucket(vbid);
+    auto stream = producer->mockActiveStreamRequest(/*flags*/ 0,
+                                                    /*opaque*/ 0,
+                                                    *vb,
+                                                    /*st_seqno*/ 0,
+                                                    /*en_seqno*/ ~0,
+                                                    /*vb_uuid*/ 0xabcd,
+                                                    /*snap_start_seqno*/ 0,
+                                                    /*snap_end_seqno*/ ~0);
+    // Have the vBucket's mutations notify the producer
+    engine->getDcpConnMap().addVBConnByVBId(producer, vbid);
+
+    // Step the stream until it has nothing left to send (and so waits to be
+    // notified)
+    auto drainStream = [&producer, &stream]() {
+        while (true) {
+            if (stream->next()) {
+                continue;
+            }
+            auto& task = producer->getCheckpointSnapshotTask();
+            if (task.queueSize() == 0) {
+                return;
+            }
+            task.run();
+        }
+    };
+    drainStream();
+
+    // The idle stream is woken by the next mutation
+    ASSERT_EQ(0, stream->numSeqnoNotifications);
+    store_item(vbid, makeStoredDocKey("key1"), "value");
+    EXPECT_EQ(1, stream->numSeqnoNotifications);
+
+    // It now has items to send, so further mutations don't visit it
+    store_item(vbid, makeStoredDocKey("key2"), "value");
+    store_item(vbid, makeStoredDocKey("key3"), "value");
+    EXPECT_EQ(1, stream->numSeqnoNotifications);
+
+    // Once it has sent them it is woken again
+    drainStream();
+    store_item(vbid, makeStoredDocKey("key4"), "value");
+    EXPECT_EQ(2, stream->numSeqnoNotifications);
+
+    engine->getDcpConnMap().removeVBConnByVBId(cookie, vbid);
+    producer->cancelCheckpointCreatorTask();
+}
+
+/*
+ * A NotifierStream which is visited by a mutation before the vBucket has
+ * reached its start seqno must ask to be notified again, else it would miss
+ * the mutation which does reach it.
+ */
+TEST_F(SingleThreadedStreamTest, NotifierStreamRearmsUntilStartSeqno) {
+    setVBucketStateAndRunPersistTask(vbid, vbucket_state_active);
+    store_item(vbid, makeStoredDocKey("key1"), "value");
+
+    auto producer = std::make_shared<MockDcpProducer>(*engine,
+                                                      cookie,
+                                                      "test_notifier",
+                                                      DCP_OPEN_NOTIFIER,
+                                                      false /*startTask*/);
+    auto vb = store->getVBucket(vbid);
+    uint64_t rollbackSeqno;
+    ASSERT_EQ(ENGINE_SUCCESS,
+              producer->streamRequest(
+                      /*flags*/ 0,
+                      /*opaque*/ 0,
+                      vbid,
+                      /*start_seqno*/ 2,
+                      /*end_seqno*/ ~0,
+                      vb->failovers->getLatestUUID(),
+                      /*snap_start*/ 1,
+                      /*snap_end*/ 1,
+                      &rollbackSeqno,
+                      [](vbucket_failover_t*,
+                         size_t,
+                         gsl::not_null<const void*>) {
+                          return ENGINE_SUCCESS;
+                      },
+                      {}));
+    auto stream = producer->findStream(vbid);
+    ASSERT_TRUE(stream);
+
+    // Nothing to send yet; the stream waits to be notified
+    EXPECT_FALSE(stream->next());
+    ASSERT_TRUE(stream->isActive());
+
+    // Seqno 2 doesn't move the vBucket past the start seqno, so the stream
+    // stays open and waits for the next mutation
+    store_item(vbid, makeStoredDocKey("key2"), "value");
+    ASSERT_TRUE(stream->isActive());
+
+    // Which notifies it: the stream ends
+    store_item(vbid, makeStoredDocKey("key3"), "value");
+    EXPECT_FALSE(stream->isActive());
+    auto response = stream->next();
+    ASSERT_TRUE(response);
+    EXPECT_EQ(DcpResponse::Event::StreamEnd, response->getEvent());
+
+    engine->getDcpConnMap().removeVBConnByVBId(cookie, vbid);
+}
@@ -27,6 +27,8 @@
 
 #include <valgrind/valgrind.h>
 
+#include <limits>
+
 
 /* Return how many bytes the memory allocator has mapped in RAM - essentially
  * application-allocated bytes plus memory in allocators own data structures
@@ -350,6 +352,63 @@ TEST_P(DefragmenterTest, DISABLED_MaxDefragValueSize) {
                       get_mock_server_api()->alloc_hooks));
 }
 
+// Check that when the size class of StoredValues is fragmented they are moved
+// (replaced by copies), and the documents are unaffected.
+TEST_P(DefragmenterTest, StoredValuesMovedIfSizeClassFragmented) {
+    const size_t num_docs = 100;
+    setDocs(64, num_docs);
+
+    // A single size class covering every object, with budget for only half
+    // of the StoredValues.
+    DefragSizeClasses sizeClasses;
+    sizeClasses.add(std::numeric_limits<size_t>::max(), num_docs / 2);
+
+    PauseResumeVBAdapter prAdapter(std::make_unique<DefragmentVisitor>(
+            0, std::numeric_limits<size_t>::max()));
+    auto& visitor = dynamic_cast<DefragmentVisitor&>(prAdapter.getHTVisitor());
+    visitor.setSizeClasses(std::move(sizeClasses));
+    prAdapter.visit(*vbucket);
+
+    // The checkpoint still references every value, so none can be moved.
+    EXPECT_EQ(num_docs, visitor.getVisitedCount());
+    EXPECT_EQ(0, visitor.getDefragCount());
+    EXPECT_EQ(num_docs / 2, visitor.getStoredValueDefragCount());
+
+    EXPECT_EQ(num_docs, vbucket->ht.getNumItems());
+    for (size_t i = 0; i < num_docs; i++) {
+        const auto key = std::to_string(i);
+        auto* v = vbucket->ht.find(DocKey(key, DocKeyEncodesCollectionId::No),
+                                   TrackReference::No,
+                                   WantsDeleted::No);
+        ASSERT_NE(nullptr, v) << "key:" << key;
+        EXPECT_EQ(std::string(64, 'x'), v->getValue()->to_s());
+    }
+}
+
+TEST(DefragSizeClassesTest, Consume) {
+    DefragSizeClasses sizeClasses;
+    EXPECT_TRUE(sizeClasses.empty());
+    EXPECT_FALSE(sizeClasses.consume(8));
+
+    sizeClasses.add(16, 1);
+    sizeClasses.add(32, 0);
+    sizeClasses.add(48, 2);
+    EXPECT_FALSE(sizeClasses.empty());
+    EXPECT_EQ(2, sizeClasses.getNumFragmented());
+
+    // Objects are served from the smallest size class they fit in.
+    EXPECT_TRUE(sizeClasses.consume(10));
+    EXPECT_FALSE(sizeClasses.consume(16));
+    EXPECT_FALSE(sizeClasses.consume(17));
+    EXPECT_TRUE(sizeClasses.consume(33));
+    EXPECT_TRUE(sizeClasses.consume(48));
+    EXPECT_FALSE(sizeClasses.consume(48));
+    EXPECT_EQ(0, sizeClasses.getNumFragmented());
+
+    // Larger than every size class.
+    EXPECT_FALSE(sizeClasses.consume(49));
+}
+
 INSTANTIATE_TEST_CASE_P(
         FullAndValueEviction,
         DefragmenterTest,
@@ -1127,6 +1127,80 @@ TEST_F(EPStoreFullEvictionNoBloomFIlterTest, MB_29816) {
     ASSERT_EQ(ENGINE_KEY_ENOENT, gv.getStatus());
 }
 
+// Full eviction with the evicted metadata cache enabled.
+class EPStoreEvictedMetaCacheTest : public EPBucketTest {
+    void SetUp() override {
+        config_string += std::string{"item_eviction_policy=full_eviction;"
+                                     "evicted_meta_cache_max_size=104857600"};
+        EPBucketTest::SetUp();
+
+        // Have all the objects, activate vBucket zero so we can store data.
+        store->setVBucketState(vbid, vbucket_state_active, false);
+    }
+};
+
+// The metadata of an evicted item should be returned by getMeta without a
+// metadata BG fetch.
+TEST_F(EPStoreEvictedMetaCacheTest, GetMetaOfEvictedItem) {
+    auto key = makeStoredDocKey("key");
+    auto item = store_item(vbid, key, "value");
+    flush_vbucket_to_disk(vbid);
+    evict_key(vbid, key);
+    EXPECT_EQ(1, store->getVBucket(vbid)->evictedMetaCache.getNumItems());
+
+    ItemMetaData itemMeta;
+    uint32_t deleted = 0;
+    uint8_t datatype = 0;
+    ASSERT_EQ(ENGINE_SUCCESS,
+              store->getMetaData(
+                      key, vbid, cookie, itemMeta, deleted, datatype));
+    EXPECT_EQ(item.getCas(), itemMeta.cas);
+    EXPECT_EQ(item.getRevSeqno(), itemMeta.revSeqno);
+    EXPECT_EQ(0, deleted);
+
+    auto& stats = engine->getEpStats();
+    EXPECT_EQ(1, stats.evictedMetaCacheHits);
+    EXPECT_EQ(0, stats.bg_meta_fetched);
+    // The metadata is back in the HashTable, so is no longer cached.
+    EXPECT_EQ(0, store->getVBucket(vbid)->evictedMetaCache.getNumItems());
+}
+
+// The metadata of a persisted delete should be returned by getMeta without a
+// metadata BG fetch.
+TEST_F(EPStoreEvictedMetaCacheTest, GetMetaOfPersistedDelete) {
+    auto key = makeStoredDocKey("key");
+    store_item(vbid, key, "value");
+    flush_vbucket_to_disk(vbid);
+    delete_item(vbid, key);
+    flush_vbucket_to_disk(vbid);
+
+    ItemMetaData itemMeta;
+    uint32_t deleted = 0;
+    uint8_t datatype = 0;
+    ASSERT_EQ(ENGINE_SUCCESS,
+              store->getMetaData(
+                      key, vbid, cookie, itemMeta, deleted, datatype));
+    EXPECT_EQ(GET_META_ITEM_DELETED_FLAG, deleted);
+
+    auto& stats = engine->getEpStats();
+    EXPECT_EQ(1, stats.evictedMetaCacheHits);
+    EXPECT_EQ(0, stats.bg_meta_fetched);
+}
+
+// Storing a key again must discard its cached metadata, which is then stale.
+TEST_F(EPStoreEvictedMetaCacheTest, StoreInvalidates) {
+    auto key = makeStoredDocKey("key");
+    store_item(vbid, key, "value");
+    flush_vbucket_to_disk(vbid);
+    evict_key(vbid, key);
+    auto vb = store->getVBucket(vbid);
+    ASSERT_EQ(1, vb->evictedMetaCache.getNumItems());
+
+    store_item(vbid, key, "value2");
+    EXPECT_EQ(0, vb->evictedMetaCache.getNumItems());
+    EXPECT_EQ(0, vb->evictedMetaCache.getSize());
+}
+
 struct PrintToStringCombinedName {
     std::string operator()(
             const ::testing::TestParamInfo<::testing::tuple<std::string, bool>>&
@@ -851,9 +851,7 @@ TEST_F(HashTableTest, ReleaseItem) {
 
 /* Test copying an element in HT */
 TEST_F(HashTableTest, CopyItem) {
-    /* Setup with 2 hash buckets and 1 lock. Note: Copying is allowed only on
-       OrderedStoredValues and hence hash table must have
-       OrderedStoredValueFactory */
+    /* Setup with 2 hash buckets and 1 lock. */
     HashTable ht(global_stats, makeFactory(true), 2, 1);
 
     /* Write 3 items */
@@ -895,9 +893,7 @@ TEST_F(HashTableTest, CopyItem) {
 
 /* Test copying a deleted element in HT */
 TEST_F(HashTableTest, CopyDeletedItem) {
-    /* Setup with 2 hash buckets and 1 lock. Note: Copying is allowed only on
-       OrderedStoredValues and hence hash table must have
-       OrderedStoredValueFactory */
+    /* Setup with 2 hash buckets and 1 lock. */
     HashTable ht(global_stats, makeFactory(true), 2, 1);
 
     /* Write 3 items */
@@ -582,6 +582,256 @@ TEST_P(KVBucketParamTest, AddNMVB) {
     EXPECT_EQ(ENGINE_NOT_MY_VBUCKET, store->add(item, cookie));
 }
 
+// AppendPrepend tests ////////////////////////////////////////////////////////
+
+// Test append and prepend on a resident document are performed in the engine.
+TEST_P(KVBucketParamTest, AppendPrepend) {
+    auto key = makeStoredDocKey("key");
+    store_item(vbid, key, "value", 0, {cb::engine_errc::success},
+               PROTOCOL_BINARY_RAW_BYTES);
+
+    uint64_t cas = 0;
+    mutation_descr_t mutInfo = {};
+    EXPECT_EQ(ENGINE_SUCCESS,
+              store->appendPrepend(key,
+                                   {"_tail", 5},
+                                   AppendPrependMode::Append,
+                                   cas,
+                                   vbid,
+                                   cookie,
+                                   mutInfo));
+    EXPECT_NE(0, cas);
+    EXPECT_NE(0, mutInfo.seqno);
+    EXPECT_EQ(ENGINE_SUCCESS,
+              store->appendPrepend(key,
+                                   {"head_", 5},
+                                   AppendPrependMode::Prepend,
+                                   cas,
+                                   vbid,
+                                   cookie,
+                                   mutInfo));
+
+    auto gv = store->get(key, vbid, cookie, {});
+    ASSERT_EQ(ENGINE_SUCCESS, gv.getStatus());
+    EXPECT_EQ("head_value_tail", gv.item->getValue()->to_s());
+    EXPECT_EQ(cas, gv.item->getCas());
+}
+
+// Test a document built by many appends has the expected content and datatype
+TEST_P(KVBucketParamTest, AppendMany) {
+    auto key = makeStoredDocKey("key");
+    store_item(vbid, key, R"({"event":0})");
+
+    std::string expected = R"({"event":0})";
+    const std::string record = "\n" + std::string(100, 'x');
+    for (int ii = 0; ii < 1000; ++ii) {
+        uint64_t cas = 0;
+        mutation_descr_t mutInfo = {};
+        ASSERT_EQ(ENGINE_SUCCESS,
+                  store->appendPrepend(key,
+                                       {record.data(), record.size()},
+                                       AppendPrependMode::Append,
+                                       cas,
+                                       vbid,
+                                       cookie,
+                                       mutInfo));
+        expected += record;
+    }
+
+    auto gv = store->get(key, vbid, cookie, {});
+    ASSERT_EQ(ENGINE_SUCCESS, gv.getStatus());
+    EXPECT_EQ(expected, gv.item->getValue()->to_s());
+    EXPECT_EQ(PROTOCOL_BINARY_RAW_BYTES, gv.item->getDataType());
+}
+
+// Test a chunked document is accounted once - by its segments - and not also
+// by its logical size.
+TEST_P(KVBucketParamTest, AppendChunkedValueSize) {
+    auto key = makeStoredDocKey("key");
+    const std::string base(ChunkedBlob::minChunkedSize, 'a');
+    store_item(vbid, key, base, 0, {cb::engine_errc::success},
+               PROTOCOL_BINARY_RAW_BYTES);
+
+    auto& stats = engine->getEpStats();
+    const size_t initialSize = stats.getTotalValueSize();
+
+    std::string expected = base;
+    const std::string record(100, 'x');
+    for (int ii = 0; ii < 100; ++ii) {
+        uint64_t cas = 0;
+        mutation_descr_t mutInfo = {};
+        ASSERT_EQ(ENGINE_SUCCESS,
+                  store->appendPrepend(key,
+                                       {record.data(), record.size()},
+                                       AppendPrependMode::Append,
+                                       cas,
+                                       vbid,
+                                       cookie,
+                                       mutInfo));
+        expected += record;
+    }
+
+    // Only the latest version remains; it holds the appended bytes once
+    // plus a small per-segment / header overhead.
+    const size_t growth = stats.getTotalValueSize() - initialSize;
+    EXPECT_GE(growth, expected.size() - base.size());
+    EXPECT_LT(growth, expected.size());
+}
+
+// Test appending whitespace to a JSON document keeps it JSON.
+TEST_P(KVBucketParamTest, AppendWhitespaceKeepsJSON) {
+    auto key = makeStoredDocKey("key");
+    store_item(vbid, key, R"({"json":true})");
+
+    uint64_t cas = 0;
+    mutation_descr_t mutInfo = {};
+    ASSERT_EQ(ENGINE_SUCCESS,
+              store->appendPrepend(key,
+                                   {" \n", 2},
+                                   AppendPrependMode::Append,
+                                   cas,
+                                   vbid,
+                                   cookie,
+                                   mutInfo));
+    auto gv = store->get(key, vbid, cookie, {});
+    ASSERT_EQ(ENGINE_SUCCESS, gv.getStatus());
+    EXPECT_EQ(PROTOCOL_BINARY_DATATYPE_JSON, gv.item->getDataType());
+}
+
+// Test a large value whose datatype can only be found by validating all of it
+// is left to the caller rather than being flattened here.
+TEST_P(KVBucketParamTest, AppendMaybeJSONNotSupported) {
+    auto key = makeStoredDocKey("key");
+    // An unterminated JSON array.
+    store_item(vbid,
+               key,
+               "[" + std::string(ChunkedBlob::minChunkedSize, '1'),
+               0,
+               {cb::engine_errc::success},
+               PROTOCOL_BINARY_RAW_BYTES);
+
+    uint64_t cas = 0;
+    mutation_descr_t mutInfo = {};
+    EXPECT_EQ(ENGINE_ENOTSUP,
+              store->appendPrepend(key,
+                                   {"]", 1},
+                                   AppendPrependMode::Append,
+                                   cas,
+                                   vbid,
+                                   cookie,
+                                   mutInfo));
+}
+
+// Test prepending to a JSON object is known not to be JSON.
+TEST_P(KVBucketParamTest, PrependToJSONIsRaw) {
+    auto key = makeStoredDocKey("key");
+    store_item(vbid,
+               key,
+               R"({"a":")" + std::string(ChunkedBlob::minChunkedSize, 'a') +
+                       R"("})");
+
+    uint64_t cas = 0;
+    mutation_descr_t mutInfo = {};
+    ASSERT_EQ(ENGINE_SUCCESS,
+              store->appendPrepend(key,
+                                   {"[", 1},
+                                   AppendPrependMode::Prepend,
+                                   cas,
+                                   vbid,
+                                   cookie,
+                                   mutInfo));
+    auto gv = store->get(key, vbid, cookie, {});
+    ASSERT_EQ(ENGINE_SUCCESS, gv.getStatus());
+    EXPECT_EQ(PROTOCOL_BINARY_RAW_BYTES, gv.item->getDataType());
+}
+
+// Test a CAS mismatch is detected.
+TEST_P(KVBucketParamTest, AppendCASMismatch) {
+    auto key = makeStoredDocKey("key");
+    auto item = store_item(vbid, key, "value");
+
+    uint64_t cas = item.getCas() + 1;
+    mutation_descr_t mutInfo = {};
+    EXPECT_EQ(ENGINE_KEY_EEXISTS,
+              store->appendPrepend(key,
+                                   {"x", 1},
+                                   AppendPrependMode::Append,
+                                   cas,
+                                   vbid,
+                                   cookie,
+                                   mutInfo));
+}
+
+// Test a document can't be grown beyond max_item_size.
+TEST_P(KVBucketParamTest, AppendTooBig) {
+    engine->getConfiguration().setMaxItemSize(1024);
+    auto key = makeStoredDocKey("key");
+    store_item(vbid, key, std::string(1000, 'x'));
+
+    uint64_t cas = 0;
+    mutation_descr_t mutInfo = {};
+    const std::string tooMuch(25, 'y');
+    EXPECT_EQ(ENGINE_E2BIG,
+              store->appendPrepend(key,
+                                   {tooMuch.data(), tooMuch.size()},
+                                   AppendPrependMode::Append,
+                                   cas,
+                                   vbid,
+                                   cookie,
+                                   mutInfo));
+    EXPECT_EQ(ENGINE_E2BIG,
+              store->appendPrepend(key,
+                                   {tooMuch.data(), tooMuch.size()},
+                                   AppendPrependMode::Prepend,
+                                   cas,
+                                   vbid,
+                                   cookie,
+                                   mutInfo));
+
+    // Exactly max_item_size is fine.
+    const std::string fits(24, 'y');
+    EXPECT_EQ(ENGINE_SUCCESS,
+              store->appendPrepend(key,
+                                   {fits.data(), fits.size()},
+                                   AppendPrependMode::Append,
+                                   cas,
+                                   vbid,
+                                   cookie,
+                                   mutInfo));
+
+    auto gv = store->get(key, vbid, cookie, {});
+    ASSERT_EQ(ENGINE_SUCCESS, gv.getStatus());
+    EXPECT_EQ(std::string(1000, 'x') + fits, gv.item->getValue()->to_s());
+}
+
+// Test documents the engine doesn't handle are left to the caller.
+TEST_P(KVBucketParamTest, AppendNotSupported) {
+    uint64_t cas = 0;
+    mutation_descr_t mutInfo = {};
+    EXPECT_EQ(ENGINE_ENOTSUP,
+              store->appendPrepend(makeStoredDocKey("missing"),
+                                   {"x", 1},
+                                   AppendPrependMode::Append,
+                                   cas,
+                                   vbid,
+                                   cookie,
+                                   mutInfo));
+}
+
+// Check incorrect vbucket returns not-my-vbucket.
+TEST_P(KVBucketParamTest, AppendNMVB) {
+    uint64_t cas = 0;
+    mutation_descr_t mutInfo = {};
+    EXPECT_EQ(ENGINE_NOT_MY_VBUCKET,
+              store->appendPrepend(makeStoredDocKey("key"),
+                                   {"x", 1},
+                                   AppendPrependMode::Append,
+                                   cas,
+                                   Vbid(vbid.get() + 1),
+                                   cookie,
+                                   mutInfo));
+}
+
 // SetWithMeta tests //////////////////////////////////////////////////////////
 
 // Test basic setWithMeta
@@ -1126,6 +1376,68 @@ TEST_P(KVBucketParamTest, MB_25948) {
                  reinterpret_cast<char*>(blob.get("_sync").data()));
 }
 
+/// KVBucketParamTest which stores values of up to 254 bytes inline.
+class KVBucketInlineValueTest : public KVBucketParamTest {
+protected:
+    void SetUp() override {
+        config_string += "stored_value_inline_max_size=254;";
+        KVBucketParamTest::SetUp();
+    }
+};
+
+// Expiring a document whose value (with xattrs) is held inline runs the
+// pre_expiry hook on a Blob copied from the StoredValue; that copy must stay
+// alive while the hook prunes it.
+TEST_P(KVBucketInlineValueTest, ExpireInlineValueWithXattrs) {
+    auto key = makeStoredDocKey("key");
+    // createXattrValue() is too large to be held inline
+    cb::xattr::Blob xattrs;
+    xattrs.set("_sync", "{\"cas\":\"0xdeadbeefcafefeed\"}");
+    xattrs.set("meta", "{\"content-type\":\"text\"}");
+    const auto xattrValue = xattrs.finalize();
+    std::string value(xattrValue.buf, xattrValue.len);
+    value.append("body");
+    ASSERT_LE(value.size(), 254u);
+
+    store_item(vbid,
+               key,
+               value,
+               1,
+               {cb::engine_errc::success},
+               PROTOCOL_BINARY_DATATYPE_XATTR);
+    auto vb = store->getVBucket(vbid);
+    auto* sv = vb->ht.find(key, TrackReference::No, WantsDeleted::No);
+    ASSERT_TRUE(sv);
+    ASSERT_TRUE(sv->isValueInline());
+
+    TimeTraveller docBrown(20);
+
+    // Expire the item on access; the deleted item keeps the system xattrs.
+    get_options_t options =
+            static_cast<get_options_t>(QUEUE_BG_FETCH | GET_DELETED_VALUE);
+    store->get(key, vbid, cookie, options);
+
+    sv = vb->ht.find(key, TrackReference::No, WantsDeleted::Yes);
+    ASSERT_TRUE(sv);
+    EXPECT_TRUE(sv->isDeleted());
+    ASSERT_TRUE(sv->hasValue());
+    const auto pruned = sv->getValueView();
+    cb::xattr::Blob blob({const_cast<char*>(pruned.data()), pruned.size()},
+                         false);
+    EXPECT_EQ(0, blob.get("meta").size());
+    EXPECT_STREQ("{\"cas\":\"0xdeadbeefcafefeed\"}",
+                 reinterpret_cast<char*>(blob.get("_sync").data()));
+}
+
+INSTANTIATE_TEST_CASE_P(EphemeralOrPersistent,
+                        KVBucketInlineValueTest,
+                        ::testing::Values("item_eviction_policy=value_only",
+                                          "item_eviction_policy=full_eviction",
+                                          "bucket_type=ephemeral"),
+                        [](const ::testing::TestParamInfo<std::string>& info) {
+                            return info.param.substr(info.param.find('=') + 1);
+                        });
+
 /**
  * Test performs the following operations
  * 1. Store an item
@@ -38,6 +38,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <kvstore.h>
+#include <map>
 #include <thread>
 #include <unordered_map>
 #include <vector>
@@ -324,6 +325,200 @@ TEST_F(CouchKVStoreTest, StatsTest) {
     EXPECT_GE(io_total_write_bytes, io_write_bytes);
 }
 
+// Verify that documents compressed by the flusher ahead of the couchstore
+// write read back correctly, and that the per-commit breakdown is recorded.
+TEST_F(CouchKVStoreTest, PrecompressedDocs) {
+    KVStoreConfig config(
+            1024, 4, data_dir, "couchdb", 0, false /*persistnamespace*/);
+    config.setPrecompressDocs(true);
+    auto kvstore = setup_kv_store(config);
+
+    const std::string bigValue(8192, 'x');
+    kvstore->begin(std::make_unique<TransactionContext>());
+    WriteCallback wc;
+    for (int i = 1; i <= 5; i++) {
+        const auto& value = (i % 2) ? bigValue : std::string("value");
+        Item item(makeStoredDocKey("key" + std::to_string(i)),
+                  0,
+                  0,
+                  value.data(),
+                  value.size(),
+                  PROTOCOL_BINARY_RAW_BYTES,
+                  0,
+                  i);
+        kvstore->set(item, wc);
+    }
+    EXPECT_TRUE(kvstore->commit(flush));
+
+    for (int i = 1; i <= 5; i++) {
+        const auto& value = (i % 2) ? bigValue : std::string("value");
+        GetValue gv =
+                kvstore->get(makeStoredDocKey("key" + std::to_string(i)),
+                             Vbid(0));
+        ASSERT_EQ(ENGINE_SUCCESS, gv.getStatus());
+        EXPECT_EQ(value,
+                  std::string(gv.item->getData(), gv.item->getNBytes()));
+    }
+
+    auto& st = kvstore->getKVStoreStat();
+    EXPECT_EQ(1, st.compressHisto.total());
+    EXPECT_EQ(1, st.encodeHisto.total());
+    EXPECT_EQ(1, st.commitBytesHisto.total());
+
+    // Read the bodies back as stored (without decompressing); they must be
+    // flagged as compressed and be the Snappy compression of the values.
+    // setup_kv_store will have progressed the rev to .2
+    Db* db = nullptr;
+    ASSERT_EQ(COUCHSTORE_SUCCESS,
+              couchstore_open_db((data_dir + "/0.couch.2").c_str(),
+                                 COUCHSTORE_OPEN_FLAG_RDONLY,
+                                 &db));
+    // Raw body and DocInfo content_meta of each document, by seqno.
+    std::map<uint64_t, std::pair<std::string, uint8_t>> onDisk;
+    auto readRaw = [](Db* db, DocInfo* info, void* ctx) -> int {
+        Doc* doc = nullptr;
+        EXPECT_EQ(COUCHSTORE_SUCCESS,
+                  couchstore_open_doc_with_docinfo(db, info, &doc, 0));
+        if (doc) {
+            auto& docs = *static_cast<
+                    std::map<uint64_t, std::pair<std::string, uint8_t>>*>(
+                    ctx);
+            docs[info->db_seq] = {std::string(doc->data.buf, doc->data.size),
+                                  info->content_meta};
+            couchstore_free_document(doc);
+        }
+        return 0;
+    };
+    EXPECT_EQ(COUCHSTORE_SUCCESS,
+              couchstore_changes_since(
+                      db, 0, COUCHSTORE_NO_OPTIONS, readRaw, &onDisk));
+    couchstore_close_file(db);
+    couchstore_free_db(db);
+
+    ASSERT_EQ(5, onDisk.size());
+    for (int i = 1; i <= 5; i++) {
+        const auto& value = (i % 2) ? bigValue : std::string("value");
+        const auto& raw = onDisk[i];
+        EXPECT_TRUE(raw.second & COUCH_DOC_IS_COMPRESSED);
+        std::string inflated;
+        ASSERT_TRUE(snappy::Uncompress(
+                raw.first.data(), raw.first.size(), &inflated));
+        EXPECT_EQ(value, inflated);
+        if (i % 2) {
+            EXPECT_LT(raw.first.size(), bigValue.size());
+        }
+    }
+}
+
+// Verify that getMulti returns the correct document for every key when the
+// order of the bodies in the file differs from the key order, and a batch
+// mixes full and metadata-only fetches.
+TEST_F(CouchKVStoreTest, GetMultiOutOfFileOrder) {
+    KVStoreConfig config(
+            1024, 4, data_dir, "couchdb", 0, false /*persistnamespace*/);
+    auto kvstore = setup_kv_store(config);
+
+    // Write the keys in reverse order over separate commits, so the later
+    // keys are stored earlier in the file.
+    WriteCallback wc;
+    const int numKeys = 10;
+    for (int i = numKeys - 1; i >= 0; i--) {
+        kvstore->begin(std::make_unique<TransactionContext>());
+        const std::string value = "value" + std::to_string(i);
+        Item item(makeStoredDocKey("key" + std::to_string(i)),
+                  0,
+                  0,
+                  value.data(),
+                  value.size(),
+                  PROTOCOL_BINARY_RAW_BYTES,
+                  0,
+                  numKeys - i);
+        kvstore->set(item, wc);
+        EXPECT_TRUE(kvstore->commit(flush));
+    }
+
+    vb_bgfetch_queue_t itms;
+    for (int i = 0; i < numKeys; i++) {
+        vb_bgfetch_item_ctx_t ctx;
+        ctx.isMetaOnly = (i % 3) ? GetMetaOnly::No : GetMetaOnly::Yes;
+        itms[makeStoredDocKey("key" + std::to_string(i))] = std::move(ctx);
+    }
+    kvstore->getMulti(Vbid(0), itms);
+
+    for (int i = 0; i < numKeys; i++) {
+        const auto key = makeStoredDocKey("key" + std::to_string(i));
+        auto& ctx = itms[key];
+        ASSERT_EQ(ENGINE_SUCCESS, ctx.value.getStatus()) << key;
+        EXPECT_EQ(key, ctx.value.item->getKey());
+        EXPECT_EQ(numKeys - i, ctx.value.item->getBySeqno());
+        if (ctx.isMetaOnly == GetMetaOnly::No) {
+            EXPECT_EQ("value" + std::to_string(i),
+                      std::string(ctx.value.item->getData(),
+                                  ctx.value.item->getNBytes()));
+        }
+    }
+}
+
+// Runs CouchKVStore tests with couchstore's buffered file ops on (true) and
+// off (false).
+class CouchKVStoreBufferedTest : public CouchKVStoreTest,
+                                 public ::testing::WithParamInterface<bool> {
+};
+
+// Verify that getMulti on a read-only store with asynchronous reads enabled
+// returns the correct documents, serving the body reads from the reads it
+// issued ahead of couchstore.
+TEST_P(CouchKVStoreBufferedTest, GetMultiAsyncReads) {
+    KVStoreConfig config(
+            1024, 4, data_dir, "couchdb", 0, false /*persistnamespace*/);
+    config.setBuffered(GetParam()).setAsyncReads("threadpool");
+    config.setAsyncReadThreads(2);
+    auto kvstore = KVStoreFactory::create(config);
+    initialize_kv_store(kvstore.rw.get(), Vbid(0));
+
+    // Values spanning several blocks, so reads cross block boundaries.
+    const int numKeys = 20;
+    WriteCallback wc;
+    kvstore.rw->begin(std::make_unique<TransactionContext>());
+    for (int i = 0; i < numKeys; i++) {
+        const std::string value(1000 * (i + 1), 'a' + i);
+        Item item(makeStoredDocKey("key" + std::to_string(i)),
+                  0,
+                  0,
+                  value.data(),
+                  value.size(),
+                  PROTOCOL_BINARY_RAW_BYTES,
+                  0,
+                  i + 1);
+        kvstore.rw->set(item, wc);
+    }
+    EXPECT_TRUE(kvstore.rw->commit(flush));
+
+    vb_bgfetch_queue_t itms;
+    for (int i = 0; i < numKeys; i++) {
+        vb_bgfetch_item_ctx_t ctx;
+        ctx.isMetaOnly = GetMetaOnly::No;
+        itms[makeStoredDocKey("key" + std::to_string(i))] = std::move(ctx);
+    }
+    kvstore.ro->getMulti(Vbid(0), itms);
+
+    for (int i = 0; i < numKeys; i++) {
+        auto& ctx = itms[makeStoredDocKey("key" + std::to_string(i))];
+        ASSERT_EQ(ENGINE_SUCCESS, ctx.value.getStatus());
+        EXPECT_EQ(std::string(1000 * (i + 1), 'a' + i),
+                  std::string(ctx.value.item->getData(),
+                              ctx.value.item->getNBytes()));
+    }
+    EXPECT_GT(kvstore.ro->getKVStoreStat().asyncReadWaitHisto.total(), 0);
+}
+
+INSTANTIATE_TEST_CASE_P(BufferedOnOff,
+                        CouchKVStoreBufferedTest,
+                        ::testing::Bool(),
+                        [](const ::testing::TestParamInfo<bool>& info) {
+                            return info.param ? "buffered" : "unbuffered";
+                        });
+
 // Verify the compaction stats returned from operations are accurate.
 TEST_F(CouchKVStoreTest, CompactStatsTest) {
     KVStoreConfig config(
@@ -1287,7 +1482,11 @@ TEST_F(CouchKVStoreErrorInjectionTest, CompactFailedStatsTest) {
 }
 
 
-class MockCouchRequest : public CouchRequest {
+/**
+ * Test access to a CouchRequest queued in a MockCouchKVStore, allowing the
+ * metadata which will be written to be modified.
+ */
+class MockCouchRequest {
 public:
     class MetaData {
     public:
@@ -1312,20 +1511,18 @@ public:
         static const size_t sizeofV2 = 19;
     };
 
-    MockCouchRequest(const Item& it,
-                     uint64_t rev,
-                     MutationRequestCallback& cb,
-                     bool del)
-        : CouchRequest(it, rev, cb, del, false /*persist namespace*/) {
+    MockCouchRequest(CouchRequest& request) : request(request) {
     }
 
-    ~MockCouchRequest() {}
-
     // Update what will be written as 'metadata'
     void writeMetaData(MetaData& meta, size_t size) {
-        std::memcpy(dbDocInfo.rev_meta.buf, &meta, size);
-        dbDocInfo.rev_meta.size = size;
+        auto* dbDocInfo = request.getDbDocInfo();
+        std::memcpy(dbDocInfo->rev_meta.buf, &meta, size);
+        dbDocInfo->rev_meta.size = size;
     }
+
+private:
+    CouchRequest& request;
 };
 
 class MockCouchKVStore : public CouchKVStore {
@@ -1334,7 +1531,7 @@ public:
     }
 
     // Mocks original code but returns the IORequest for fuzzing
-    MockCouchRequest* setAndReturnRequest(
+    std::unique_ptr<MockCouchRequest> setAndReturnRequest(
             const Item& itm,
             Callback<TransactionContext, mutation_result>& cb) {
         if (isReadOnly()) {
@@ -1350,19 +1547,68 @@ public:
         MutationRequestCallback requestcb;
         uint64_t fileRev = (*dbFileRevMap)[itm.getVBucketId().get()];
 
-        // each req will be de-allocated after commit
+        // each req will be destroyed after commit
         requestcb.setCb = &cb;
-        MockCouchRequest *req = new MockCouchRequest(itm, fileRev, requestcb, deleteItem);
-        pendingReqsQ.push_back(req);
-        return req;
+        pendingReqsQ.emplace_back(itm,
+                                  fileRev,
+                                  requestcb,
+                                  deleteItem,
+                                  false /*persist namespace*/);
+        return std::make_unique<MockCouchRequest>(pendingReqsQ.back());
     }
 
     bool compactDBInternal(compaction_ctx* hook_ctx,
                            couchstore_docinfo_hook dhook) {
         return CouchKVStore::compactDBInternal(hook_ctx, dhook);
     }
+
+    size_t getCompressedBodiesCapacity() const {
+        return compressedBodies.capacity();
+    }
 };
 
+// The pre-compression buffer is kept for the next batch, unless a batch
+// grew it past maxRetainedCompressedBodies.
+TEST_F(CouchKVStoreTest, PrecompressBufferCapped) {
+    KVStoreConfig config(
+            1024, 4, data_dir, "couchdb", 0, false /*persistnamespace*/);
+    config.setPrecompressDocs(true);
+    MockCouchKVStore kvstore(config);
+    initialize_kv_store(&kvstore, Vbid(0));
+
+    WriteCallback wc;
+    int64_t seqno = 0;
+    auto commitBatch = [&](size_t count) {
+        const std::string value(128 * 1024, 'x');
+        kvstore.begin(std::make_unique<TransactionContext>());
+        for (size_t i = 0; i < count; ++i) {
+            ++seqno;
+            Item item(makeStoredDocKey("key" + std::to_string(i)),
+                      0,
+                      0,
+                      value.data(),
+                      value.size(),
+                      PROTOCOL_BINARY_RAW_BYTES,
+                      0,
+                      seqno);
+            kvstore.set(item, wc);
+        }
+        EXPECT_TRUE(kvstore.commit(flush));
+    };
+
+    commitBatch(4);
+    EXPECT_LT(0u, kvstore.getCompressedBodiesCapacity());
+    EXPECT_GE(CouchKVStore::maxRetainedCompressedBodies + 0,
+              kvstore.getCompressedBodiesCapacity());
+
+    commitBatch(CouchKVStore::maxRetainedCompressedBodies / (128 * 1024) + 1);
+    EXPECT_EQ(0u, kvstore.getCompressedBodiesCapacity());
+
+    // A normal batch afterwards uses (and keeps) a buffer again.
+    commitBatch(4);
+    EXPECT_LT(0u, kvstore.getCompressedBodiesCapacity());
+}
+
 //
 // Explicitly test couchstore (not valid for other KVStores)
 // Intended to ensure we can read and write couchstore files and
@@ -25,6 +25,8 @@
 
 #include <gtest/gtest.h>
 
+#include <vector>
+
 class ObjectRegistryTest : public ::testing::Test {
 protected:
     void SetUp() override {
@@ -62,3 +64,52 @@ TEST_F(ObjectRegistryTest, MemOverhead) {
     }
     EXPECT_EQ(0, engine.getEpStats().getMemOverhead());
 }
+
+static std::vector<unsigned> switchedArenas;
+
+static size_t testGetAllocSize(const void*) {
+    return 0;
+}
+
+static void recordSwitchArena(unsigned arena) {
+    switchedArenas.push_back(arena);
+}
+
+/// An engine with a dedicated arena (as if dedicated_arena were set).
+class ArenaEPEngine : public SynchronousEPEngine {
+public:
+    explicit ArenaEPEngine(unsigned bucketArena) {
+        arena = bucketArena;
+    }
+};
+
+class ObjectRegistryArenaTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        switchedArenas.clear();
+        ObjectRegistry::initialize(testGetAllocSize, recordSwitchArena);
+        ObjectRegistry::onSwitchThread(&engine);
+    }
+    void TearDown() override {
+        ObjectRegistry::onSwitchThread(nullptr);
+        ObjectRegistry::reset();
+    }
+
+    ArenaEPEngine engine{7};
+};
+
+// Allocations within a NonBucketAllocationGuard are neither accounted to the
+// bucket nor made from its arena, and both are restored afterwards.
+TEST_F(ObjectRegistryArenaTest, NonBucketAllocationGuard) {
+    ASSERT_EQ(std::vector<unsigned>{7}, switchedArenas);
+    {
+        NonBucketAllocationGuard guard;
+        EXPECT_EQ(nullptr, ObjectRegistry::getCurrentEngine());
+        EXPECT_EQ(0u, switchedArenas.back());
+
+        auto item = make_item(Vbid(0), makeStoredDocKey("key"), "value");
+        EXPECT_EQ(0, engine.getEpStats().getNumItem());
+    }
+    EXPECT_EQ(&engine, ObjectRegistry::getCurrentEngine());
+    EXPECT_EQ((std::vector<unsigned>{7, 0, 7}), switchedArenas);
+}
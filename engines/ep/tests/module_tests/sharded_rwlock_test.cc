@@ -0,0 +1,156 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "sharded_rwlock.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Readers on many threads may hold the lock together.
+TEST(ShardedRWLockTest, ConcurrentReaders) {
+    ShardedRWLock lock;
+    const int numThreads = 20;
+    std::atomic<int> holding{0};
+    std::vector<std::thread> threads;
+    for (int ii = 0; ii < numThreads; ++ii) {
+        threads.emplace_back([&lock, &holding]() {
+            std::lock_guard<ShardedRWLock::ReaderLock> guard(lock.reader());
+            holding++;
+            // Every reader must get the lock before any can release it.
+            while (holding < numThreads) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(numThreads, holding.load());
+}
+
+// A writer excludes readers and other writers; readers always see the two
+// values written under the lock as a pair.
+TEST(ShardedRWLockTest, WriterExcludesReaders) {
+    ShardedRWLock lock;
+    uint64_t a = 0;
+    uint64_t b = 0;
+    std::atomic<bool> stop{false};
+    std::atomic<bool> torn{false};
+
+    std::vector<std::thread> readers;
+    for (int ii = 0; ii < 4; ++ii) {
+        readers.emplace_back([&]() {
+            while (!stop) {
+                std::lock_guard<ShardedRWLock::ReaderLock> guard(lock.reader());
+                if (a != b) {
+                    torn = true;
+                }
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int ii = 0; ii < 2; ++ii) {
+        writers.emplace_back([&]() {
+            for (int jj = 0; jj < 10000; ++jj) {
+                std::lock_guard<ShardedRWLock::WriterLock> guard(lock.writer());
+                ++a;
+                ++b;
+            }
+        });
+    }
+
+    for (auto& t : writers) {
+        t.join();
+    }
+    stop = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    EXPECT_FALSE(torn);
+    EXPECT_EQ(20000u, a);
+    EXPECT_EQ(20000u, b);
+}
+
+// A SharedLock moved to another thread releases the shard it was locked on,
+// not the releasing thread's - afterwards a writer can get the lock.
+TEST(ShardedRWLockTest, SharedLockReleasedByOtherThread) {
+    ShardedRWLock lock;
+    ShardedRWLock::SharedLock shared(lock);
+
+    // Lock a shard from a number of other threads, so that at least one of
+    // them uses a different shard to this thread, and move the locks here.
+    std::vector<ShardedRWLock::SharedLock> moved;
+    for (size_t ii = 0; ii < ShardedRWLock::getNumShards(); ++ii) {
+        std::thread t([&lock, &moved]() { moved.emplace_back(lock); });
+        t.join();
+    }
+
+    // ...and release them all from another thread.
+    std::thread releaser([&shared, &moved]() {
+        auto local = std::move(shared);
+        moved.clear();
+    });
+    releaser.join();
+    EXPECT_FALSE(shared.owns_lock());
+
+    // Would wait forever if any shard had been left held.
+    std::lock_guard<ShardedRWLock::WriterLock> guard(lock.writer());
+}
+
+// A thread which already holds the read lock gets it again even when a
+// writer is waiting, instead of deadlocking with the writer.
+TEST(ShardedRWLockTest, NestedReadWithWriterWaiting) {
+    ShardedRWLock lock;
+    std::atomic<bool> writerStarted{false};
+    std::atomic<bool> writerDone{false};
+
+    auto outer = std::make_unique<ShardedRWLock::SharedLock>(lock);
+    std::thread writer([&lock, &writerStarted, &writerDone]() {
+        writerStarted = true;
+        std::lock_guard<ShardedRWLock::WriterLock> guard(lock.writer());
+        writerDone = true;
+    });
+    while (!writerStarted) {
+        std::this_thread::yield();
+    }
+    // Give the writer time to announce itself and start waiting for us.
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    {
+        std::lock_guard<ShardedRWLock::ReaderLock> inner(lock.reader());
+        EXPECT_FALSE(writerDone);
+    }
+    EXPECT_FALSE(writerDone);
+
+    outer.reset();
+    writer.join();
+    EXPECT_TRUE(writerDone);
+}
+
+// The number of shards is a power of two in the documented range.
+TEST(ShardedRWLockTest, NumShards) {
+    const auto shards = ShardedRWLock::getNumShards();
+    EXPECT_LE(size_t(ShardedRWLock::minShards), shards);
+    EXPECT_GE(size_t(ShardedRWLock::maxShards), shards);
+    EXPECT_EQ(0u, shards & (shards - 1));
+}
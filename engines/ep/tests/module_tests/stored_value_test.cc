@@ -87,6 +87,21 @@ TYPED_TEST(ValueTest, getObjectSize) {
               this->sv->getObjectSize());
 }
 
+// Check that when we copy a StoredValue, the key, value and freqCounter are
+// also copied.
+TYPED_TEST(ValueTest, copyStoredValue) {
+    ASSERT_EQ(4, this->sv->getFreqCounterValue());
+    this->sv->setFreqCounterValue(100);
+    ASSERT_EQ(100, this->sv->getFreqCounterValue());
+
+    auto copy = this->factory.copyStoredValue(*this->sv, {});
+
+    EXPECT_EQ(100, copy->getFreqCounterValue());
+    EXPECT_EQ(this->sv->getObjectSize(), copy->getObjectSize());
+    EXPECT_EQ(this->sv->isOrdered(), copy->isOrdered());
+    EXPECT_EQ(*this->sv, *copy);
+}
+
 /* Disabled if jemalloc is not in use as this test relies upon
  * the specific bin sizes used by jemalloc. Additionally, other
  * AllocHooks don't necessarily implement get_allocation_size.
@@ -338,6 +353,138 @@ TYPED_TEST(ValueTest, freqCounterNotReset) {
     EXPECT_EQ(10, this->sv->getFreqCounterValue());
 }
 
+/**
+ * Test fixture for StoredValues created by a factory which stores values of
+ * up to 16 bytes inline.
+ */
+template <typename Factory>
+class InlineValueTest : public ValueTest<Factory> {
+public:
+    InlineValueTest() : inlineFactory(this->stats, 16) {
+    }
+
+    void SetUp() override {
+        // "value" is 5 bytes - stored inline, with 8 bytes reserved.
+        this->sv = inlineFactory(this->item, {});
+    }
+
+    Item makeItemWithValue(const std::string& value) {
+        return make_item(Vbid(0), makeStoredDocKey("key"), value);
+    }
+
+protected:
+    Factory inlineFactory;
+};
+
+TYPED_TEST_CASE(InlineValueTest, ValueFactories);
+
+TYPED_TEST(InlineValueTest, smallValueIsInline) {
+    EXPECT_TRUE(this->sv->isValueInline());
+    EXPECT_TRUE(this->sv->hasValue());
+    EXPECT_FALSE(this->sv->getValueBlob());
+    EXPECT_EQ(5, this->sv->valuelen());
+    EXPECT_EQ("value", cb::to_string(this->sv->getValueView()));
+    EXPECT_EQ("value", this->sv->getValue()->to_s());
+
+    // Value is part of the object; space for it is rounded up to 8 bytes.
+    EXPECT_EQ(this->getFixedSize() + /*key*/ 3 + /*len*/ 1 +
+                      /*default collection-ID*/ 1 + /*inline value*/ 8,
+              this->sv->getObjectSize());
+    EXPECT_EQ(this->sv->getObjectSize(), this->sv->size());
+    EXPECT_EQ(Blob::getAllocationSize(5) - 8,
+              this->sv->getInlineValueSavedBytes());
+}
+
+TYPED_TEST(InlineValueTest, largeValueIsNotInline) {
+    auto sv = this->inlineFactory(this->makeItemWithValue(std::string(17, 'x')),
+                                  {});
+    EXPECT_FALSE(sv->isValueInline());
+    EXPECT_TRUE(sv->getValueBlob());
+    EXPECT_EQ(17, sv->valuelen());
+    EXPECT_EQ(this->getFixedSize() + /*key*/ 3 + /*len*/ 1 +
+                      /*default collection-ID*/ 1,
+              sv->getObjectSize());
+    EXPECT_EQ(0, sv->getInlineValueSavedBytes());
+}
+
+// A value which no longer fits inline moves to a Blob, and back again when
+// it shrinks.
+TYPED_TEST(InlineValueTest, setValueChangingSize) {
+    const auto objectSize = this->sv->getObjectSize();
+
+    this->sv->setValue(this->makeItemWithValue("12345678"));
+    EXPECT_TRUE(this->sv->isValueInline());
+    EXPECT_EQ("12345678", cb::to_string(this->sv->getValueView()));
+
+    this->sv->setValue(this->makeItemWithValue("123456789"));
+    EXPECT_FALSE(this->sv->isValueInline());
+    EXPECT_EQ("123456789", this->sv->getValue()->to_s());
+    EXPECT_EQ(objectSize + 9, this->sv->size());
+
+    this->sv->setValue(this->makeItemWithValue("1"));
+    EXPECT_TRUE(this->sv->isValueInline());
+    EXPECT_FALSE(this->sv->getValueBlob());
+    EXPECT_EQ("1", cb::to_string(this->sv->getValueView()));
+    EXPECT_EQ(objectSize, this->sv->getObjectSize());
+}
+
+TYPED_TEST(InlineValueTest, ejectValue) {
+    this->sv->ejectValue();
+    EXPECT_FALSE(this->sv->isValueInline());
+    EXPECT_FALSE(this->sv->hasValue());
+    EXPECT_EQ(0, this->sv->valuelen());
+
+    this->sv->restoreValue(this->item);
+    EXPECT_TRUE(this->sv->isValueInline());
+    EXPECT_EQ("value", cb::to_string(this->sv->getValueView()));
+}
+
+TYPED_TEST(InlineValueTest, toItem) {
+    auto item = this->sv->toItem(false, Vbid(0));
+    EXPECT_EQ("value", item->getValue()->to_s());
+    EXPECT_EQ(this->sv->getFreqCounterValue(), item->getFreqCounterValue());
+}
+
+// toItem() shares a Blob holding the same data as the inline value instead
+// of allocating a copy; any other Blob is ignored.
+TYPED_TEST(InlineValueTest, toItemSharesValueBlob) {
+    const auto& valueBlob = this->item.getValue();
+    auto item = this->sv->toItem(false, Vbid(0), valueBlob);
+    EXPECT_EQ(valueBlob.get().get(), item->getValue().get().get());
+
+    auto other = this->makeItemWithValue("other");
+    item = this->sv->toItem(false, Vbid(0), other.getValue());
+    EXPECT_NE(other.getValue().get().get(), item->getValue().get().get());
+    EXPECT_EQ("value", item->getValue()->to_s());
+}
+
+TYPED_TEST(InlineValueTest, freqCounterNotReset) {
+    this->sv->setFreqCounterValue(10);
+    this->sv->setValue(this->makeItemWithValue("abc"));
+    EXPECT_EQ(10, this->sv->getFreqCounterValue());
+    this->sv->setValue(this->makeItemWithValue(std::string(20, 'x')));
+    EXPECT_EQ(10, this->sv->getFreqCounterValue());
+    this->sv->setValue(this->makeItemWithValue("abc"));
+    EXPECT_EQ(10, this->sv->getFreqCounterValue());
+}
+
+TYPED_TEST(InlineValueTest, deleteDiscardsValue) {
+    this->sv->del();
+    EXPECT_FALSE(this->sv->isValueInline());
+    EXPECT_FALSE(this->sv->hasValue());
+}
+
+// Check that a copy keeps the inline value (and so the same size).
+TYPED_TEST(InlineValueTest, copyInlineValue) {
+    ASSERT_TRUE(this->sv->isValueInline());
+
+    auto copy = this->inlineFactory.copyStoredValue(*this->sv, {});
+    EXPECT_TRUE(copy->isValueInline());
+    EXPECT_EQ(this->sv->getObjectSize(), copy->getObjectSize());
+    EXPECT_EQ("value", cb::to_string(copy->getValueView()));
+    EXPECT_EQ(*this->sv, *copy);
+}
+
 /// Check that StoredValue / OrderedStoredValue don't unexpectedly change in
 /// size (we've carefully crafted them to be as efficient as possible).
 TEST(StoredValueTest, expectedSize) {
@@ -363,14 +510,3 @@ TEST_F(OrderedStoredValueTest, expectedSize) {
             << key;
 }
 
-// Check that when we copy a OSV, the freqCounter is also copied. (Cannot copy
-// StoredValues, hence no version for them).
-TEST_F(OrderedStoredValueTest, copyStoreValue) {
-    ASSERT_EQ(4, sv->getFreqCounterValue());
-    sv->setFreqCounterValue(100);
-    ASSERT_EQ(100, sv->getFreqCounterValue());
-
-    auto copy = factory.copyStoredValue(*sv, {});
-
-    EXPECT_EQ(100, copy->getFreqCounterValue());
-}
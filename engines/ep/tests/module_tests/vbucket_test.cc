@@ -254,6 +254,66 @@ TEST(BlobTest, basicAllocationSize){
     EXPECT_EQ(BlobTest::getAllocationSize(0), 9);
 }
 
+TEST(BlobTest, appendSmallIsContiguous) {
+    value_t head(Blob::New("abc", 3));
+    value_t result(Blob::Append(*head, "def", 3));
+    EXPECT_FALSE(result->isChunked());
+    EXPECT_EQ("abcdef", result->to_s());
+}
+
+TEST(BlobTest, appendChunked) {
+    std::string expected(ChunkedBlob::minChunkedSize, 'a');
+    value_t value(Blob::New(expected.data(), expected.size()));
+    for (int ii = 0; ii < 1000; ++ii) {
+        const std::string record = std::to_string(ii) + ",";
+        value.reset(Blob::Append(*value, record.data(), record.size()));
+        expected += record;
+
+        ASSERT_TRUE(value->isChunked());
+        ASSERT_EQ(expected.size(), value->valueSize());
+        // Segment count stays logarithmic in the number of appends.
+        ASSERT_LE(static_cast<const ChunkedBlob&>(*value).getSegments().size(),
+                  12);
+    }
+    EXPECT_FALSE(static_cast<const ChunkedBlob&>(*value).isFlattened());
+    EXPECT_EQ(expected, value->to_s());
+    EXPECT_TRUE(static_cast<const ChunkedBlob&>(*value).isFlattened());
+}
+
+TEST(BlobTest, prependChunked) {
+    std::string expected(ChunkedBlob::minChunkedSize, 'a');
+    value_t value(Blob::New(expected.data(), expected.size()));
+    for (int ii = 0; ii < 100; ++ii) {
+        const std::string record = std::to_string(ii) + ",";
+        value.reset(Blob::Prepend(*value, record.data(), record.size()));
+        expected = record + expected;
+    }
+    EXPECT_TRUE(value->isChunked());
+    EXPECT_EQ(expected, value->to_s());
+}
+
+// A previous version of a chunked value is unaffected by later appends.
+TEST(BlobTest, appendChunkedSharesSegments) {
+    const std::string base(ChunkedBlob::minChunkedSize, 'a');
+    value_t v1(Blob::Append(*value_t(Blob::New(base.data(), base.size())),
+                            "b",
+                            1));
+    value_t v2(Blob::Append(*v1, "c", 1));
+    EXPECT_EQ(base + "b", v1->to_s());
+    EXPECT_EQ(base + "bc", v2->to_s());
+}
+
+TEST(BlobTest, copyFlattens) {
+    const std::string base(ChunkedBlob::minChunkedSize, 'a');
+    value_t chunked(Blob::Append(*value_t(Blob::New(base.data(), base.size())),
+                                 "b",
+                                 1));
+    ASSERT_TRUE(chunked->isChunked());
+    value_t copy(Blob::Copy(*chunked));
+    EXPECT_FALSE(copy->isChunked());
+    EXPECT_EQ(base + "b", copy->to_s());
+}
+
 // Measure performance of VBucket::getBGFetchItems - queue and then get
 // 10,000 items from the vbucket.
 TEST_P(EPVBucketTest, GetBGFetchItemsPerformance) {
@@ -419,6 +419,37 @@ struct MEMCACHED_PUBLIC_CLASS EngineIface {
         return {cb::engine_errc::not_supported, 0};
     }
 
+    /**
+     * Append or prepend data to an existing document from within the
+     * engine (e.g. while holding the engine's lock for the document) rather
+     * than via the core's get / allocate / CAS-store sequence.
+     *
+     * Optional interface; not supported by all engines. An engine may also
+     * return ENGINE_ENOTSUP for individual documents it cannot handle this
+     * way (for example non-resident or compressed documents), in which case
+     * the core falls back to the generic implementation.
+     *
+     * @param cookie The cookie provided by the frontend
+     * @param key the key identifying the document to modify
+     * @param value the (uncompressed) data to add to the document
+     * @param mode whether to append or prepend the data
+     * @param cas the CAS value the document must have (0 matches any). On
+     *            success updated to the CAS of the modified document
+     * @param vbucket the virtual bucket id
+     * @param mut_info On success write the mutation details to this address.
+     *
+     * @return ENGINE_SUCCESS if all goes well
+     */
+    virtual ENGINE_ERROR_CODE append_prepend(gsl::not_null<const void*> cookie,
+                                             const DocKey& key,
+                                             cb::const_char_buffer value,
+                                             AppendPrependMode mode,
+                                             uint64_t& cas,
+                                             Vbid vbucket,
+                                             mutation_descr_t& mut_info) {
+        return ENGINE_ENOTSUP;
+    }
+
     /**
      * Flush the cache.
      *
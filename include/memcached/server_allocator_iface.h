@@ -130,6 +130,35 @@ struct ServerAllocatorIface {
      * @return whether the call was successful
      */
     bool (*get_allocator_property)(const char* name, size_t* value);
+
+    /**
+     * Creates an arena dedicated to the caller (e.g. a bucket), which
+     * allocations can be directed to with switch_arena. An arena previously
+     * released with release_arena may be reused.
+     * @param arena destination for the index of the arena
+     * @return whether the call was successful (false if the allocator
+     *         doesn't support arenas)
+     */
+    bool (*create_arena)(unsigned* arena);
+
+    /**
+     * Releases an arena returned by create_arena, once nothing allocated
+     * from it is in use; its free memory is returned to the OS.
+     */
+    void (*release_arena)(unsigned arena);
+
+    /**
+     * Directs the calling thread's allocations to the given arena; 0 is the
+     * default arena. The thread's cache is disabled the first time it
+     * switches to another arena, so allocations aren't served from regions
+     * cached from a different arena.
+     */
+    void (*switch_arena)(unsigned arena);
+
+    /**
+     * Returns the bytes currently allocated from the given arena.
+     */
+    size_t (*get_arena_allocated)(unsigned arena);
 };
 
 #ifdef __cplusplus
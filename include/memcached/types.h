@@ -30,6 +30,11 @@ typedef enum {
     OPERATION_CAS = 6 /**< Store with set semantics. */
 } ENGINE_STORE_OPERATION;
 
+/**
+ * Where EngineIface::append_prepend should add the new data.
+ */
+enum class AppendPrependMode : uint8_t { Append, Prepend };
+
 typedef enum {
     CONN_PRIORITY_HIGH,
     CONN_PRIORITY_MED,
@@ -33,6 +33,9 @@
 #include <gsl/gsl>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 static uint32_t getValue(cJSON *root, const char *key) {
     cJSON *obj = cJSON_GetObjectItem(root, key);
@@ -114,6 +117,13 @@ public:
             dump("s ", 80, 0, wayout[4]);
         }
         std::cout << "Total: " << total << " operations" << std::endl;
+        if (!percentiles.empty()) {
+            std::cout << "Percentiles:";
+            for (const auto& p : percentiles) {
+                std::cout << " p" << p.first << " " << p.second << "us";
+            }
+            std::cout << std::endl;
+        }
     }
 
 private:
@@ -186,6 +196,16 @@ private:
             oldwayout = true;
         }
 
+        // Newer servers also report the latency at a few percentiles
+        auto* pct = cJSON_GetObjectItem(root, "percentiles");
+        if (pct != nullptr) {
+            for (auto* p = pct->child; p != nullptr; p = p->next) {
+                if (p->type == cJSON_Number) {
+                    percentiles.emplace_back(p->string, uint64_t(p->valuedouble));
+                }
+            }
+        }
+
         // Calculate total and cumulative counts, and find the highest value.
         total = max = 0;
 
@@ -256,6 +276,9 @@ private:
     bool oldwayout;
 
     uint64_t total;
+
+    // (percentile, microseconds) pairs, if provided by the server
+    std::vector<std::pair<std::string, uint64_t>> percentiles;
 };
 
 std::string opcode2string(cb::mcbp::ClientOpcode opcode) {
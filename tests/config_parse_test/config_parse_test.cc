@@ -569,6 +569,30 @@ TEST_F(SettingsTest, StdinListener) {
     }
 }
 
+TEST_F(SettingsTest, ReuseportListeners) {
+    nonBooleanValuesShouldFail("reuseport_listeners");
+
+    unique_cJSON_ptr obj(cJSON_CreateObject());
+    cJSON_AddTrueToObject(obj.get(), "reuseport_listeners");
+    try {
+        Settings settings(obj);
+        EXPECT_TRUE(settings.isReuseportListenersEnabled());
+        EXPECT_TRUE(settings.has.reuseport_listeners);
+    } catch (std::exception& exception) {
+        FAIL() << exception.what();
+    }
+
+    obj.reset(cJSON_CreateObject());
+    cJSON_AddFalseToObject(obj.get(), "reuseport_listeners");
+    try {
+        Settings settings(obj);
+        EXPECT_FALSE(settings.isReuseportListenersEnabled());
+        EXPECT_TRUE(settings.has.reuseport_listeners);
+    } catch (std::exception& exception) {
+        FAIL() << exception.what();
+    }
+}
+
 TEST_F(SettingsTest, TopkeysEnabled) {
     nonBooleanValuesShouldFail("topkeys_enabled");
 
@@ -994,6 +1018,42 @@ TEST_F(SettingsTest, ExternalAuthService) {
     }
 }
 
+TEST_F(SettingsTest, OffloadThreshold) {
+    nonNumericValuesShouldFail("offload_threshold");
+
+    unique_cJSON_ptr obj(cJSON_CreateObject());
+    cJSON_AddNumberToObject(obj.get(), "offload_threshold", 4096);
+    try {
+        Settings settings(obj);
+        EXPECT_EQ(4096, settings.getOffloadThreshold());
+        EXPECT_TRUE(settings.has.offload_threshold);
+    } catch (const std::exception& exception) {
+        FAIL() << exception.what();
+    }
+
+    obj.reset(cJSON_CreateObject());
+    cJSON_AddNumberToObject(obj.get(), "offload_threshold", -1);
+    expectFail(obj);
+}
+
+TEST_F(SettingsTest, ResponseCompressionThreshold) {
+    nonNumericValuesShouldFail("response_compression_threshold");
+
+    unique_cJSON_ptr obj(cJSON_CreateObject());
+    cJSON_AddNumberToObject(obj.get(), "response_compression_threshold", 4096);
+    try {
+        Settings settings(obj);
+        EXPECT_EQ(4096, settings.getResponseCompressionThreshold());
+        EXPECT_TRUE(settings.has.response_compression_threshold);
+    } catch (const std::exception& exception) {
+        FAIL() << exception.what();
+    }
+
+    obj.reset(cJSON_CreateObject());
+    cJSON_AddNumberToObject(obj.get(), "response_compression_threshold", -1);
+    expectFail(obj);
+}
+
 TEST_F(SettingsTest, ScramshaFallbackSalt) {
     nonStringValuesShouldFail("scramsha_fallback_salt");
     unique_cJSON_ptr obj(cJSON_CreateObject());
@@ -1484,6 +1544,28 @@ TEST(SettingsUpdateTest, DedupeNmvbMapsIsDynamic) {
     EXPECT_FALSE(settings.isDedupeNmvbMaps());
 }
 
+TEST(SettingsUpdateTest, OffloadThresholdIsDynamic) {
+    Settings settings;
+    Settings updated;
+    auto old = settings.getOffloadThreshold();
+    updated.setOffloadThreshold(old + 1);
+    EXPECT_NO_THROW(settings.updateSettings(updated, false));
+    EXPECT_EQ(old, settings.getOffloadThreshold());
+    EXPECT_NO_THROW(settings.updateSettings(updated));
+    EXPECT_EQ(old + 1, settings.getOffloadThreshold());
+}
+
+TEST(SettingsUpdateTest, ResponseCompressionThresholdIsDynamic) {
+    Settings settings;
+    Settings updated;
+    auto old = settings.getResponseCompressionThreshold();
+    updated.setResponseCompressionThreshold(old + 1);
+    EXPECT_NO_THROW(settings.updateSettings(updated, false));
+    EXPECT_EQ(old, settings.getResponseCompressionThreshold());
+    EXPECT_NO_THROW(settings.updateSettings(updated));
+    EXPECT_EQ(old + 1, settings.getResponseCompressionThreshold());
+}
+
 TEST(SettingsUpdateTest, OpcodeAttributesOverrideIsDynamic) {
     Settings settings;
     Settings updated;
@@ -0,0 +1,133 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <daemon/front_end_thread.h>
+#include <event2/thread.h>
+#include <gtest/gtest.h>
+#include <platform/socket.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+/**
+ * Runs an event loop standing in for a front-end thread: each time it is
+ * woken through the notification channel it acknowledges the notification
+ * and then takes everything "queued" for it, as thread_libevent_process
+ * does with its queues.
+ */
+class FrontEndThreadNotifyTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase() {
+#ifdef WIN32
+        evthread_use_windows_threads();
+#else
+        evthread_use_pthreads();
+#endif
+    }
+
+    void SetUp() override {
+        ASSERT_TRUE(create_notification_channel(thread));
+        thread.base = event_base_new();
+        ASSERT_NE(nullptr, thread.base);
+        ASSERT_EQ(0,
+                  event_assign(&thread.notify_event,
+                               thread.base,
+                               thread.notify[0],
+                               EV_READ | EV_PERSIST,
+                               onNotify,
+                               this));
+        ASSERT_EQ(0, event_add(&thread.notify_event, nullptr));
+        loop = std::thread([this]() { event_base_loop(thread.base, 0); });
+    }
+
+    void TearDown() override {
+        stop = true;
+        wakeup();
+        loop.join();
+        event_del(&thread.notify_event);
+        event_base_free(thread.base);
+    }
+
+    static void onNotify(evutil_socket_t, short, void* arg) {
+        auto& self = *reinterpret_cast<FrontEndThreadNotifyTest*>(arg);
+        acknowledge_notification(self.thread);
+        self.processed += self.queued.exchange(0);
+        if (self.stop) {
+            event_base_loopbreak(self.thread.base);
+        }
+    }
+
+    /// Wake the thread without going through notify_thread().
+    void wakeup() {
+#ifdef __linux__
+        if (thread.notify_eventfd) {
+            const uint64_t one = 1;
+            ASSERT_EQ(ssize_t(sizeof(one)),
+                      write(thread.notify[0], &one, sizeof(one)));
+            return;
+        }
+#endif
+        ASSERT_EQ(1, cb::net::send(thread.notify[1], "", 1, 0));
+    }
+
+    FrontEndThread thread;
+    std::thread loop;
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> queued{0};
+    std::atomic<uint64_t> processed{0};
+};
+
+// Many threads queue work and notify the thread while it is processing
+// earlier notifications; all of the work must get processed without any
+// further notification. A notification swallowed while notify_pending stays
+// set would leave the thread asleep with work queued.
+TEST_F(FrontEndThreadNotifyTest, NoLostWakeups) {
+    const int numNotifiers = 4;
+    const uint64_t perNotifier = 100000;
+
+    std::vector<std::thread> notifiers;
+    for (int ii = 0; ii < numNotifiers; ++ii) {
+        notifiers.emplace_back([this, perNotifier]() {
+            for (uint64_t jj = 0; jj < perNotifier; ++jj) {
+                queued++;
+                notify_thread(thread);
+            }
+        });
+    }
+    for (auto& t : notifiers) {
+        t.join();
+    }
+
+    // Wait for the thread to catch up with (and acknowledge) everything.
+    const uint64_t total = numNotifiers * perNotifier;
+    const auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((processed < total || thread.notify_pending) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(total, processed.load());
+    EXPECT_FALSE(thread.notify_pending.load());
+    EXPECT_EQ(total,
+              thread.wakeups.load() + thread.notifications_coalesced.load());
+}
@@ -15,6 +15,7 @@
  *   limitations under the License.
  */
 
+#include <platform/compress.h>
 #include <cctype>
 #include <limits>
 #include <thread>
@@ -39,6 +40,55 @@ protected:
     }
 
     void test_MB_17506(bool dedupe);
+
+    /// A config which Snappy compresses well (so is sent compressed to
+    /// clients which enabled it)
+    static std::string makeCompressibleConfig(int revision) {
+        return R"({"rev":)" + std::to_string(revision) + R"(,"nodes":")" +
+               std::string(1024, 'x') + R"("})";
+    }
+
+    /**
+     * Check that a map we received is compressed if (and only if) the
+     * client enabled Snappy, with the given datatype, and that it inflates
+     * back to the expected map.
+     */
+    ::testing::AssertionResult isExpectedMap(const std::string& expected,
+                                             cb::mcbp::Datatype expectedType,
+                                             cb::mcbp::Datatype datatype,
+                                             cb::const_char_buffer value) {
+        const bool snappy = hasSnappySupport() == ClientSnappySupport::Yes;
+        if (snappy) {
+            expectedType = cb::mcbp::Datatype(int(expectedType) |
+                                              int(cb::mcbp::Datatype::Snappy));
+        }
+        if (datatype != expectedType) {
+            return ::testing::AssertionFailure()
+                   << "Datatype mismatch - expected:" << int(expectedType)
+                   << " actual:" << int(datatype);
+        }
+
+        std::string map{value.data(), value.size()};
+        if (snappy) {
+            if (map.size() >= expected.size()) {
+                return ::testing::AssertionFailure()
+                       << "Map was not compressed";
+            }
+            cb::compression::Buffer inflated;
+            if (!cb::compression::inflate(
+                        cb::compression::Algorithm::Snappy, value, inflated)) {
+                return ::testing::AssertionFailure()
+                       << "Failed to inflate the map";
+            }
+            map.assign(inflated.data(), inflated.size());
+        }
+        if (map != expected) {
+            return ::testing::AssertionFailure()
+                   << "Map mismatch - expected:" << expected
+                   << " actual:" << map;
+        }
+        return ::testing::AssertionSuccess();
+    }
 };
 
 void ClusterConfigTest::test_MB_17506(bool dedupe) {
@@ -88,7 +138,8 @@ INSTANTIATE_TEST_CASE_P(
                                              XattrSupport::No),
                            ::testing::Values(ClientJSONSupport::Yes,
                                              ClientJSONSupport::No),
-                           ::testing::Values(ClientSnappySupport::No)),
+                           ::testing::Values(ClientSnappySupport::Yes,
+                                             ClientSnappySupport::No)),
         PrintToStringCombinedName());
 
 TEST_P(ClusterConfigTest, SetClusterConfigWithIncorrectSessionToken) {
@@ -129,6 +180,46 @@ TEST_P(ClusterConfigTest, GetClusterConfig) {
                                    {value.data(), value.size()}));
 }
 
+// A large map is sent compressed to clients which enabled Snappy.
+TEST_P(ClusterConfigTest, GetClusterConfigCompressed) {
+    const auto config = makeCompressibleConfig(200);
+    auto response = setClusterConfig(token, config);
+    ASSERT_TRUE(response.isSuccess());
+
+    BinprotGenericCommand cmd{cb::mcbp::ClientOpcode::GetClusterConfig, "", ""};
+    auto& conn = getConnection();
+    conn.executeCommand(cmd, response);
+    ASSERT_TRUE(response.isSuccess());
+    const auto value = response.getDataString();
+    EXPECT_TRUE(isExpectedMap(config,
+                              expectedJSONDatatype(),
+                              cb::mcbp::Datatype(response.getDatatype()),
+                              {value.data(), value.size()}));
+}
+
+// NOT_MY_VBUCKET responses carry the map with the JSON datatype (if the
+// client enabled it), compressed if the client enabled Snappy.
+TEST_P(ClusterConfigTest, NotMyVbucketCompressed) {
+    memcached_cfg["dedupe_nmvb_maps"] = false;
+    reconfigure();
+
+    const auto config = makeCompressibleConfig(300);
+    auto response = setClusterConfig(token, config);
+    ASSERT_TRUE(response.isSuccess());
+
+    auto& conn = getConnection();
+    BinprotGetCommand command;
+    command.setKey("foo");
+    command.setVBucket(Vbid(1));
+    conn.executeCommand(command, response);
+    ASSERT_EQ(cb::mcbp::Status::NotMyVbucket, response.getStatus());
+    const auto value = response.getDataString();
+    EXPECT_TRUE(isExpectedMap(config,
+                              expectedJSONDatatype(),
+                              cb::mcbp::Datatype(response.getDatatype()),
+                              {value.data(), value.size()}));
+}
+
 TEST_P(ClusterConfigTest, test_MB_17506_no_dedupe) {
     test_MB_17506(false);
 }
@@ -203,3 +294,37 @@ TEST_P(ClusterConfigTest, CccpPushNotification) {
                              value.size()};
     EXPECT_EQ(R"({"rev":666})", config);
 }
+
+// A pushed map is compressed for clients which enabled Snappy.
+TEST_P(ClusterConfigTest, CccpPushNotificationCompressed) {
+    auto& conn = getAdminConnection();
+    conn.selectBucket("default");
+
+    auto second = conn.clone();
+    second->setDuplexSupport(true);
+    second->setClustermapChangeNotification(true);
+    if (hasSnappySupport() == ClientSnappySupport::Yes) {
+        second->setFeature(cb::mcbp::Feature::SNAPPY, true);
+    }
+
+    const auto config = makeCompressibleConfig(777);
+    BinprotResponse response;
+    conn.executeCommand(BinprotSetClusterConfigCommand{token, config},
+                        response);
+    ASSERT_TRUE(response.isSuccess());
+
+    Frame frame;
+    second->recvFrame(frame);
+    ASSERT_EQ(cb::mcbp::Magic::ServerRequest, frame.getMagic());
+    auto* request = frame.getRequest();
+    ASSERT_EQ(cb::mcbp::ServerOpcode::ClustermapChangeNotification,
+              request->getServerOpcode());
+
+    // The notification is always marked as JSON
+    auto value = request->getValue();
+    EXPECT_TRUE(isExpectedMap(
+            config,
+            cb::mcbp::Datatype::JSON,
+            cb::mcbp::Datatype(request->getDatatype()),
+            {reinterpret_cast<const char*>(value.data()), value.size()}));
+}
@@ -429,6 +429,47 @@ INSTANTIATE_TEST_CASE_P(
                            ::testing::Values(ClientSnappySupport::Yes)),
         PrintToStringCombinedName());
 
+/**
+ * Test fixture which offloads all of the work which may be offloaded to the
+ * executor pool (see the offload_threshold setting).
+ */
+class GetSetOffloadTest : public GetSetTest {
+protected:
+    void SetUp() override {
+        GetSetTest::SetUp();
+        memcached_cfg["offload_threshold"] = 1;
+        reconfigure();
+    }
+
+    void TearDown() override {
+        memcached_cfg["offload_threshold"] = 1024 * 1024;
+        reconfigure();
+        GetSetTest::TearDown();
+    }
+
+    /// @return the number of commands which offloaded work so far
+    int getOffloadedCommands() {
+        auto stats = getAdminConnection().stats("");
+        auto* offloaded =
+                cJSON_GetObjectItem(stats.get(), "offloaded_commands");
+        if (offloaded == nullptr) {
+            throw std::runtime_error("offloaded_commands stat not found");
+        }
+        return offloaded->valueint;
+    }
+};
+
+INSTANTIATE_TEST_CASE_P(
+        TransportProtocols,
+        GetSetOffloadTest,
+        ::testing::Combine(::testing::Values(TransportProtocols::McbpPlain,
+                                             TransportProtocols::McbpSsl),
+                           ::testing::Values(XattrSupport::Yes),
+                           ::testing::Values(ClientJSONSupport::Yes,
+                                             ClientJSONSupport::No),
+                           ::testing::Values(ClientSnappySupport::Yes)),
+        PrintToStringCombinedName());
+
 INSTANTIATE_TEST_CASE_P(
         TransportProtocols,
         GetSetSnappyOnOffTest,
@@ -927,6 +968,65 @@ TEST_P(GetSetTest, TestIllegalVbucket) {
     conn.reconnect();
 }
 
+/**
+ * On a connection in unordered execution mode a GET which blocks in the
+ * engine must not hold up the GETs behind it, and a command which may not
+ * be reordered (the NOOP) must not be executed before all of the GETs
+ * ahead of it have completed.
+ */
+TEST_P(GetSetTest, TestUnorderedExecutionOfBlockedGet) {
+    auto& conn = getConnection();
+    conn.mutate(document, Vbid(0), MutationType::Set);
+    conn.setUnorderedExecutionMode(ExecutionMode::Unordered);
+
+    // Suspend the next command on the connection (the first GET); it stays
+    // blocked in the engine until we resume it below
+    const uint32_t suspendId = 0xdeadbeef;
+    conn.configureEwouldBlockEngine(
+            EWBEngineMode::Suspend, ENGINE_EWOULDBLOCK, suspendId);
+
+    // Send GET(1), GET(2), NOOP(3), using the opaque to tell the responses
+    // apart
+    auto send = [&conn](const BinprotCommand& command, uint32_t opaque) {
+        Frame frame;
+        command.encode(frame.payload);
+        reinterpret_cast<cb::mcbp::Request*>(frame.payload.data())
+                ->setOpaque(opaque);
+        conn.sendFrame(frame);
+    };
+    BinprotGetCommand get;
+    get.setKey(name);
+    send(get, 1);
+    send(get, 2);
+    BinprotGenericCommand noop{cb::mcbp::ClientOpcode::Noop};
+    send(noop, 3);
+
+    // The second GET overtakes the blocked one
+    BinprotResponse rsp;
+    conn.recvResponse(rsp);
+    EXPECT_EQ(cb::mcbp::ClientOpcode::Get, rsp.getOp());
+    EXPECT_EQ(2, rsp.getResponse().getOpaque());
+    EXPECT_TRUE(rsp.isSuccess()) << to_string(rsp.getStatus());
+
+    // The NOOP must wait for the blocked GET
+    auto& admin = getAdminConnection();
+    admin.selectBucket("default");
+    admin.configureEwouldBlockEngine(
+            EWBEngineMode::Resume, ENGINE_SUCCESS, suspendId);
+
+    conn.recvResponse(rsp);
+    EXPECT_EQ(cb::mcbp::ClientOpcode::Get, rsp.getOp());
+    EXPECT_EQ(1, rsp.getResponse().getOpaque());
+    EXPECT_TRUE(rsp.isSuccess()) << to_string(rsp.getStatus());
+
+    conn.recvResponse(rsp);
+    EXPECT_EQ(cb::mcbp::ClientOpcode::Noop, rsp.getOp());
+    EXPECT_EQ(3, rsp.getResponse().getOpaque());
+    EXPECT_TRUE(rsp.isSuccess());
+
+    conn.setUnorderedExecutionMode(ExecutionMode::Ordered);
+}
+
 // Test sending compressed raw data; check server handles correctly.
 TEST_P(GetSetSnappyOnOffTest, TestCompressedData) {
     doTestCompressedRawData("off");
@@ -952,6 +1052,37 @@ TEST_P(GetSetSnappyOnOffTest, TestCompressedJSONInActiveMode) {
     doTestCompressedJSON("active");
 }
 
+// Test that uncompressed documents of at least response_compression_threshold
+// bytes are sent compressed to clients which negotiated Snappy (and only to
+// those)
+TEST_P(GetSetSnappyOnOffTest, TestResponseCompression) {
+    MemcachedConnection& conn = getConnection();
+    setCompressionMode("off");
+
+    const std::string valueData(1024, 'a');
+    document.info.datatype = cb::mcbp::Datatype::Raw;
+    document.value = valueData;
+    conn.mutate(document, Vbid(0), MutationType::Set);
+
+    memcached_cfg["response_compression_threshold"] = 512;
+    reconfigure();
+
+    int successCount = getResponseCount(cb::mcbp::Status::Success);
+    if (hasSnappySupport() == ClientSnappySupport::Yes) {
+        document.compress();
+        verifyData(conn,
+                   successCount,
+                   0,
+                   cb::mcbp::Datatype::Snappy,
+                   document.value);
+    } else {
+        verifyData(conn, successCount, 0, cb::mcbp::Datatype::Raw, valueData);
+    }
+
+    memcached_cfg["response_compression_threshold"] = 0;
+    reconfigure();
+}
+
 TEST_P(GetSetSnappyOnOffTest, TestInvalidCompressedData) {
     MemcachedConnection& conn = getConnection();
     document.value = "uncompressed JSON string";
@@ -988,6 +1119,34 @@ TEST_P(GetSetTest, TestAppendCompressedSourceAndData) {
     doTestAppend(/*compressedSource*/ true, /*compressedData*/ true);
 }
 
+// Test that append still works when the inflation of the values is
+// offloaded to the executor pool
+TEST_P(GetSetOffloadTest, TestAppendCompressed) {
+    const auto offloaded = getOffloadedCommands();
+    doTestAppend(/*compressedSource*/ true, /*compressedData*/ true);
+    EXPECT_LT(offloaded, getOffloadedCommands());
+}
+
+// Test that a GET by a client which doesn't support Snappy still works when
+// the inflation of the value is offloaded to the executor pool
+TEST_P(GetSetOffloadTest, TestGetInflated) {
+    auto& conn = getConnection();
+    document.info.cas = mcbp::cas::Wildcard;
+    document.info.datatype = cb::mcbp::Datatype::Raw;
+    document.value.assign(4096, 'a');
+    document.compress();
+    conn.mutate(document, Vbid(0), MutationType::Set);
+
+    auto plain = conn.clone();
+    plain->setDatatypeCompressed(false);
+
+    const auto offloaded = getOffloadedCommands();
+    const auto stored = plain->get(name, Vbid(0));
+    EXPECT_EQ(offloaded + 1, getOffloadedCommands());
+    EXPECT_EQ(std::string(4096, 'a'), stored.value);
+    EXPECT_EQ(cb::mcbp::Datatype::Raw, stored.info.datatype);
+}
+
 TEST_P(GetSetTest, TestAppendInvalidCompressedData) {
     MemcachedConnection& conn = getConnection();
     document.info.datatype = cb::mcbp::Datatype::Raw;
@@ -20,6 +20,9 @@
 
 #include <nlohmann/json.hpp>
 
+#include <memory>
+#include <vector>
+
 // Test fixture for new MCBP miscellaneous commands
 class MiscTest : public TestappClientTest {};
 
@@ -126,3 +129,60 @@ TEST_P(MiscTest, GetRbacDatabase) {
     ASSERT_FALSE(response.isSuccess());
     ASSERT_EQ(cb::mcbp::Status::Eaccess, response.getStatus());
 }
+
+static const size_t reuseportThreads = 8;
+static const size_t reuseportClients = 16;
+
+// Each front-end thread accepts its own clients when reuseport_listeners is
+// enabled.
+class ReuseportListenersTest : public TestappTest {
+public:
+    static void SetUpTestCase() {
+        memcached_cfg = generate_config(0);
+        memcached_cfg["threads"] = reuseportThreads;
+        memcached_cfg["reuseport_listeners"] = true;
+        // Leave little headroom on the port so that counting the extra
+        // listeners as connections of the port would reject our clients.
+        memcached_cfg["interfaces"][0]["maxconn"] =
+                reuseportClients + reuseportThreads + 4;
+        start_memcached_server();
+
+        if (HasFailure()) {
+            std::cerr << "Error in ReuseportListenersTest::SetUpTestCase, "
+                         "terminating process"
+                      << std::endl;
+            exit(EXIT_FAILURE);
+        } else {
+            CreateTestBucket();
+        }
+    }
+};
+
+TEST_F(ReuseportListenersTest, ConnectSeveralClients) {
+    auto& conn = getConnection();
+    std::vector<std::unique_ptr<MemcachedConnection>> connections;
+    for (size_t ii = 0; ii < reuseportClients; ++ii) {
+        connections.emplace_back(conn.clone());
+        auto& c = *connections.back();
+        c.authenticate("@admin", "password", "PLAIN");
+        c.selectBucket(bucketName);
+
+        Document doc;
+        doc.info.cas = mcbp::cas::Wildcard;
+        doc.info.id = name + std::to_string(ii);
+        doc.value = std::to_string(ii);
+        ASSERT_NO_THROW(c.mutate(doc, Vbid(0), MutationType::Set));
+    }
+
+    // All of the clients are still served, whichever thread accepted them
+    for (size_t ii = 0; ii < reuseportClients; ++ii) {
+        const auto doc = connections[ii]->get(name + std::to_string(ii),
+                                              Vbid(0));
+        EXPECT_EQ(std::to_string(ii), doc.value);
+    }
+
+    auto stats = getAdminConnection().stats("");
+    auto* rejected = cJSON_GetObjectItem(stats.get(), "rejected_conns");
+    ASSERT_NE(nullptr, rejected);
+    EXPECT_EQ(0, rejected->valueint);
+}
@@ -17,6 +17,8 @@
 #include "testapp_stats.h"
 
 #include <gsl/gsl>
+#include <chrono>
+#include <thread>
 
 INSTANTIATE_TEST_CASE_P(TransportProtocols,
                         StatsTest,
@@ -386,6 +388,139 @@ TEST_P(StatsTest, TestSchedulerInfo_Aggregate) {
     EXPECT_NE(nullptr, cJSON_GetObjectItem(stats.get(), "aggregate"));
 }
 
+/**
+ * Sum the per-thread counter <code>N:name</code> returned by one of the
+ * "worker_thread_info" stat groups over all of the worker threads.
+ */
+static size_t sumWorkerThreadStat(const unique_cJSON_ptr& stats,
+                                  const std::string& name) {
+    size_t total = 0;
+    for (size_t ii = 0;; ++ii) {
+        auto* value = cJSON_GetObjectItem(
+                stats.get(), (std::to_string(ii) + ":" + name).c_str());
+        if (value == nullptr) {
+            return total;
+        }
+        total += value->valueint;
+    }
+}
+
+TEST_P(StatsTest, TestSchedulerInfo_Notify) {
+    auto& conn = getConnection();
+    auto stats = conn.stats("worker_thread_info notify");
+    // We should at least have the counters for the first thread
+    ASSERT_NE(nullptr, cJSON_GetObjectItem(stats.get(), "0:wakeups"));
+    ASSERT_NE(nullptr,
+              cJSON_GetObjectItem(stats.get(), "0:notifications_coalesced"));
+    const auto before = sumWorkerThreadStat(stats, "wakeups") +
+                        sumWorkerThreadStat(stats, "notifications_coalesced");
+
+    // Let the engine block the GET. The ewouldblock engine completes it
+    // from its own thread, which has to notify the front-end thread serving
+    // the connection. Use a separate connection so that the ewouldblock
+    // sequence doesn't stick to the one we use for the stats.
+    auto blocked = conn.clone();
+    blocked->configureEwouldBlockEngine(
+            EWBEngineMode::Sequence, ENGINE_EWOULDBLOCK, 0xfffffffd);
+    try {
+        blocked->get(name, Vbid(0));
+        FAIL() << "The document should not exist";
+    } catch (const ConnectionError& error) {
+        EXPECT_TRUE(error.isNotFound()) << error.getReason();
+    }
+
+    stats = conn.stats("worker_thread_info notify");
+    const auto after = sumWorkerThreadStat(stats, "wakeups") +
+                       sumWorkerThreadStat(stats, "notifications_coalesced");
+    EXPECT_LT(before, after);
+}
+
+TEST_P(StatsTest, TestSchedulerInfo_Buffers) {
+    auto stats = getConnection().stats("worker_thread_info buffers");
+    // We should at least have the pool counters for the first thread
+    for (const auto* key : {"0:rbufs_pooled",
+                            "0:rbufs_pooled_bytes",
+                            "0:rbufs_in_use",
+                            "0:wbufs_pooled",
+                            "0:wbufs_pooled_bytes",
+                            "0:wbufs_in_use"}) {
+        EXPECT_NE(nullptr, cJSON_GetObjectItem(stats.get(), key)) << key;
+    }
+}
+
+/**
+ * Leave a partial packet on more connections than the front-end threads
+ * may pool read buffers for. Each of them has to hold on to its read
+ * buffer until the rest of the packet arrives. Once they're all served
+ * the buffers go back to the pools, which only keep up to
+ * NetworkBufferPool::MaxPooledBuffers of them per thread.
+ */
+TEST_P(StatsTest, TestSchedulerInfo_BuffersPartialReads) {
+    const int maxPooledBuffers = 16;
+    auto& conn = getConnection();
+    auto stats = conn.stats("worker_thread_info buffers");
+    size_t numThreads = 0;
+    while (cJSON_GetObjectItem(
+                   stats.get(),
+                   (std::to_string(numThreads) + ":rbufs_pooled").c_str())) {
+        ++numThreads;
+    }
+    ASSERT_LT(0, numThreads);
+
+    // The connections are handed out to the threads round robin, so this
+    // gives each thread more buffers back than it may keep
+    std::vector<std::unique_ptr<MemcachedConnection>> clients;
+    std::vector<Frame> frames;
+    for (size_t ii = 0; ii < numThreads * (maxPooledBuffers + 1); ++ii) {
+        clients.emplace_back(conn.clone());
+        frames.emplace_back(clients.back()->encodeCmdGet(name, Vbid(0)));
+        clients.back()->sendPartialFrame(frames.back(),
+                                         frames.back().payload.size() - 1);
+    }
+
+    // Wait for the server to read the partial packets. The connection
+    // running the stats command holds a read buffer of its own.
+    const auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    size_t inUse = 0;
+    do {
+        stats = conn.stats("worker_thread_info buffers");
+        inUse = sumWorkerThreadStat(stats, "rbufs_in_use");
+        if (inUse > clients.size()) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    } while (std::chrono::steady_clock::now() < deadline);
+    ASSERT_LT(clients.size(), inUse);
+
+    for (size_t ii = 0; ii < clients.size(); ++ii) {
+        clients[ii]->sendFrame(frames[ii]);
+        Frame response;
+        clients[ii]->recvFrame(response);
+    }
+
+    // The buffers are given back after the responses are sent, so we may
+    // beat the server to it. In the end only the connection running the
+    // stats command should hold a read buffer.
+    do {
+        stats = conn.stats("worker_thread_info buffers");
+        inUse = sumWorkerThreadStat(stats, "rbufs_in_use");
+        if (inUse == 1) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    } while (std::chrono::steady_clock::now() < deadline);
+    EXPECT_EQ(1, inUse);
+
+    for (size_t ii = 0; ii < numThreads; ++ii) {
+        auto* pooled = cJSON_GetObjectItem(
+                stats.get(), (std::to_string(ii) + ":rbufs_pooled").c_str());
+        ASSERT_NE(nullptr, pooled);
+        EXPECT_LT(0, pooled->valueint) << "thread " << ii;
+        EXPECT_GE(maxPooledBuffers, pooled->valueint) << "thread " << ii;
+    }
+}
+
 TEST_P(StatsTest, TestSchedulerInfo_InvalidSubcommand) {
     try {
         getConnection().stats("worker_thread_info foo");
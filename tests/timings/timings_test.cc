@@ -0,0 +1,199 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2019 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "daemon/timings.h"
+
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+// Small values are recorded exactly, and larger ones to within 1/16.
+TEST(CommandTimingHistogramTest, Precision) {
+    for (uint64_t value : {0, 1, 20, 31, 32, 100, 1000, 65536, 1000000}) {
+        CommandTimingHistogram histogram;
+        histogram.add(microseconds(value));
+        const auto recorded = histogram.getValueAtPercentile(100.0);
+        if (value < 31) {
+            EXPECT_EQ(value, recorded);
+        } else {
+            EXPECT_LE(value, recorded) << "value:" << value;
+            EXPECT_GE(value + value / 16, recorded) << "value:" << value;
+        }
+    }
+
+    // Values past max_value are counted as it.
+    CommandTimingHistogram histogram;
+    histogram.add(seconds(1000));
+    EXPECT_EQ(1u, histogram.get_total());
+    EXPECT_LE(CommandTimingHistogram::max_value -
+                      CommandTimingHistogram::max_value / 16,
+              histogram.getValueAtPercentile(100.0));
+}
+
+TEST(CommandTimingHistogramTest, Percentiles) {
+    CommandTimingHistogram histogram;
+    EXPECT_EQ(0u, histogram.getValueAtPercentile(50.0));
+
+    // 1..10000 us
+    for (int ii = 1; ii <= 10000; ++ii) {
+        histogram.add(microseconds(ii));
+    }
+    EXPECT_EQ(10000u, histogram.get_total());
+
+    auto check = [&histogram](double percentile, uint64_t expected) {
+        const auto value = histogram.getValueAtPercentile(percentile);
+        EXPECT_LE(expected, value) << "p" << percentile;
+        EXPECT_GE(expected + expected / 16, value) << "p" << percentile;
+    };
+    check(50.0, 5000);
+    check(99.0, 9900);
+    check(99.9, 9990);
+    check(99.99, 9999);
+    check(100.0, 10000);
+}
+
+// The JSON keeps the TimingHistogram layout that mctimings expects.
+TEST(CommandTimingHistogramTest, LegacyJson) {
+    CommandTimingHistogram histogram;
+    histogram.add(nanoseconds(500));
+    histogram.add(microseconds(15));
+    // Not on a bucket boundary; 3ms would be recorded as just below it.
+    histogram.add(microseconds(3500));
+    histogram.add(milliseconds(700));
+    histogram.add(seconds(12));
+    histogram.add(seconds(1000));
+
+    const auto json = nlohmann::json::parse(histogram.to_string());
+    EXPECT_EQ(1, json["ns"].get<int>());
+    EXPECT_EQ(100u, json["us"].size());
+    EXPECT_EQ(1, json["us"][1].get<int>());
+    EXPECT_EQ(49u, json["ms"].size());
+    EXPECT_EQ(1, json["ms"][2].get<int>()); // element 0 is 1ms
+    EXPECT_EQ(10u, json["500ms"].size());
+    EXPECT_EQ(1, json["500ms"][1].get<int>());
+    EXPECT_EQ(0, json["5s-9s"].get<int>());
+    EXPECT_EQ(1, json["10s-19s"].get<int>());
+    EXPECT_EQ(1, json["80s-inf"].get<int>());
+    EXPECT_EQ(2, json["wayout"].get<int>());
+    EXPECT_EQ(4u, json["percentiles"].size());
+    EXPECT_LE(3000u, json["percentiles"]["50"].get<uint64_t>());
+}
+
+// Timings recorded by different threads are merged when read, and threads
+// outside of the configured range still get counted.
+TEST(TimingsTest, PerThreadAggregation) {
+    Timings timings;
+    timings.set_num_threads(4);
+
+    for (size_t thread = 0; thread < 6; ++thread) {
+        for (size_t ii = 0; ii <= thread; ++ii) {
+            timings.collect(cb::mcbp::ClientOpcode::Get,
+                            microseconds(10 * (thread + 1)),
+                            thread);
+        }
+    }
+    timings.collect(cb::mcbp::ClientOpcode::Set, microseconds(10), 0);
+
+    const auto get = timings.get_timing_histogram(
+            uint8_t(cb::mcbp::ClientOpcode::Get));
+    EXPECT_EQ(21u, get.get_total());
+    EXPECT_EQ(60u, get.getValueAtPercentile(100.0));
+    EXPECT_EQ(21u, timings.get_aggregated_retrival_stats());
+    EXPECT_EQ(1u, timings.get_aggregated_mutation_stats());
+
+    timings.reset();
+    EXPECT_EQ(0u,
+              timings.get_timing_histogram(uint8_t(cb::mcbp::ClientOpcode::Get))
+                      .get_total());
+}
+
+// Interval counters recorded by each thread are summed (and reset) by
+// sample().
+TEST(TimingsTest, PerThreadIntervals) {
+    Timings timings;
+    timings.set_num_threads(2);
+
+    timings.collect(cb::mcbp::ClientOpcode::Get, microseconds(10), 0);
+    timings.collect(cb::mcbp::ClientOpcode::Get, microseconds(20), 1);
+    timings.collect(cb::mcbp::ClientOpcode::Set, microseconds(30), 1);
+    timings.sample(seconds(1));
+
+    auto lookups = timings.get_interval_lookup_latency();
+    EXPECT_EQ(2u, lookups.count);
+    EXPECT_EQ(30000u, lookups.duration_ns);
+    auto mutations = timings.get_interval_mutation_latency();
+    EXPECT_EQ(1u, mutations.count);
+    EXPECT_EQ(30000u, mutations.duration_ns);
+
+    // The counters were consumed by the first sample.
+    timings.sample(seconds(1));
+    lookups = timings.get_interval_lookup_latency();
+    EXPECT_EQ(2u, lookups.count);
+}
+
+// Assigning Timings copies the histograms and the unsampled intervals.
+TEST(TimingsTest, Assignment) {
+    Timings timings;
+    timings.set_num_threads(2);
+    timings.collect(cb::mcbp::ClientOpcode::Get, microseconds(10), 0);
+    timings.collect(cb::mcbp::ClientOpcode::Get, microseconds(20), 1);
+    timings.sample(seconds(1));
+    timings.collect(cb::mcbp::ClientOpcode::Set, microseconds(30), 1);
+
+    Timings copy;
+    copy = timings;
+    EXPECT_EQ(2u,
+              copy.get_timing_histogram(uint8_t(cb::mcbp::ClientOpcode::Get))
+                      .get_total());
+    EXPECT_EQ(2u, copy.get_interval_lookup_latency().count);
+
+    // The Set recorded after the last sample is picked up by the copy's.
+    copy.sample(seconds(1));
+    const auto mutations = copy.get_interval_mutation_latency();
+    EXPECT_EQ(1u, mutations.count);
+    EXPECT_EQ(30000u, mutations.duration_ns);
+}
+
+// Threads record concurrently with a reader sampling and merging them.
+TEST(TimingsTest, ConcurrentCollect) {
+    Timings timings;
+    timings.set_num_threads(4);
+    const size_t iterations = 10000;
+
+    std::vector<std::thread> threads;
+    for (size_t thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([&timings, thread]() {
+            for (size_t ii = 0; ii < iterations; ++ii) {
+                timings.collect(
+                        cb::mcbp::ClientOpcode::Get, microseconds(ii), thread);
+            }
+        });
+    }
+    for (int ii = 0; ii < 100; ++ii) {
+        timings.sample(seconds(1));
+        timings.get_timing_histogram(uint8_t(cb::mcbp::ClientOpcode::Get));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(4 * iterations, timings.get_aggregated_retrival_stats());
+}
@@ -18,13 +18,14 @@
 #include "daemon/settings.h"
 #include "daemon/topkeys.h"
 #include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
 #include <memory>
 
 class TopKeysTest : public ::testing::Test {
 protected:
     void SetUp() {
         settings.setTopkeysEnabled(true);
-        topkeys.reset(new TopKeys(10));
+        topkeys.reset(new TopKeys(10, 2));
     }
 
     std::unique_ptr<TopKeys> topkeys;
@@ -49,12 +50,84 @@ TEST_F(TopKeysTest, Basic) {
     // loop inserting keys
     for (int jj = 0; jj < 20000; jj++) {
         for (auto& key : keys) {
-            topkeys->updateKey(key.c_str(), key.size(), jj);
+            topkeys->updateKey(key.c_str(), key.size(), jj, 0);
         }
     }
 
-    // Verify we hit all shards inside TopKeys
+    // Verify we report mkeys * KEYS_MULTIPLIER keys
     size_t count = 0;
     topkeys->stats(&count, 0, dump_key);
     EXPECT_EQ(80, count);
 }
+
+// A frequently accessed key is reported (with at least its true count, summed
+// over threads) even when interleaved with many more distinct keys than
+// are tracked.
+TEST_F(TopKeysTest, HeavyHitterAcrossThreads) {
+    const std::string hot = "hot_key";
+    for (size_t thread = 0; thread < 2; thread++) {
+        for (int ii = 0; ii < 2000; ii++) {
+            const auto cold = "cold_key_" + std::to_string(thread) + "_" +
+                              std::to_string(ii);
+            // All within one DECAY_INTERVAL, so no counts are halved.
+            topkeys->updateKey(cold.c_str(), cold.size(), 10, thread);
+            if (ii % 20 == 0) {
+                topkeys->updateKey(hot.c_str(), hot.size(), 10, thread);
+            }
+        }
+    }
+
+    nlohmann::json json;
+    topkeys->json_stats(json, 20);
+    const auto& keys = json["topkeys"];
+    ASSERT_EQ(80u, keys.size());
+    EXPECT_EQ(hot, keys[0]["key"].get<std::string>());
+    EXPECT_LE(200, keys[0]["access_count"].get<int>());
+}
+
+// The counts decay over time, so a key which was hot but is no longer
+// accessed drops out of the top keys - including when the thread which
+// accessed it has gone idle.
+TEST_F(TopKeysTest, FormerlyHotKeyDecays) {
+    const std::string hot = "hot_key";
+    for (int ii = 0; ii < 1000; ii++) {
+        topkeys->updateKey(hot.c_str(), hot.size(), 0, 1);
+    }
+
+    nlohmann::json json;
+    topkeys->json_stats(json, 0);
+    ASSERT_EQ(1u, json["topkeys"].size());
+    EXPECT_EQ(1000, json["topkeys"][0]["access_count"].get<int>());
+
+    // One interval later thread 1's counts have halved, although it hasn't
+    // updated since.
+    topkeys->json_stats(json, TopKeys::DECAY_INTERVAL);
+    EXPECT_EQ(500, json["topkeys"][0]["access_count"].get<int>());
+
+    // Long afterwards, other keys are accessed a few times each.
+    const rel_time_t later = 10 * TopKeys::DECAY_INTERVAL;
+    for (int ii = 0; ii < 100; ii++) {
+        const auto key = "new_key_" + std::to_string(ii);
+        for (int jj = 0; jj < 5; jj++) {
+            topkeys->updateKey(key.c_str(), key.size(), later, 0);
+        }
+    }
+
+    json = nlohmann::json();
+    topkeys->json_stats(json, later);
+    const auto& keys = json["topkeys"];
+    ASSERT_EQ(80u, keys.size());
+    for (const auto& key : keys) {
+        EXPECT_NE(hot, key["key"].get<std::string>());
+        EXPECT_EQ(5, key["access_count"].get<int>());
+    }
+
+    // Thread 1 halves its own counts when it next updates.
+    topkeys->updateKey(hot.c_str(), hot.size(), later, 1);
+    json = nlohmann::json();
+    topkeys->json_stats(json, later);
+    EXPECT_EQ(5, json["topkeys"][0]["access_count"].get<int>());
+    for (const auto& key : json["topkeys"]) {
+        EXPECT_NE(hot, key["key"].get<std::string>());
+    }
+}
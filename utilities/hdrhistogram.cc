@@ -38,6 +38,31 @@ HdrHistogram::HdrHistogram(uint64_t lowestTrackableValue,
     histogram.reset(hist);
 }
 
+HdrHistogram::HdrHistogram(const HdrHistogram& other) {
+    struct hdr_histogram* hist;
+    // other's trackable values already include the bias.
+    hdr_init(other.histogram->lowest_trackable_value,
+             other.histogram->highest_trackable_value,
+             other.histogram->significant_figures,
+             &hist);
+    histogram.reset(hist);
+    hdr_add(histogram.get(), other.histogram.get());
+}
+
+HdrHistogram& HdrHistogram::operator=(const HdrHistogram& other) {
+    if (this != &other) {
+        HdrHistogram copy(other);
+        histogram = std::move(copy.histogram);
+    }
+    return *this;
+}
+
+HdrHistogram& HdrHistogram::operator+=(const HdrHistogram& other) {
+    // Both histograms hold biased values, so they can be added directly.
+    hdr_add(histogram.get(), other.histogram.get());
+    return *this;
+}
+
 void HdrHistogram::addValue(uint64_t v) {
     // A hdr_histogram cannot store 0, therefore we add a bias of +1.
     int64_t vBiased = v + 1;
@@ -75,6 +100,12 @@ HdrHistogram::Iterator HdrHistogram::makeLinearIterator(
     return iter;
 }
 
+HdrHistogram::Iterator HdrHistogram::makeRecordedIterator() const {
+    HdrHistogram::Iterator iter;
+    hdr_iter_recorded_init(&iter, histogram.get());
+    return iter;
+}
+
 boost::optional<std::pair<uint64_t, uint64_t>>
 HdrHistogram::getNextValueAndCount(Iterator& iter) const {
     boost::optional<std::pair<uint64_t, uint64_t>> valueAndCount;
@@ -73,6 +73,19 @@ public:
                  uint64_t highestTrackableValue,
                  int significantFigures);
 
+    /// Copy other's range, precision and values.
+    HdrHistogram(const HdrHistogram& other);
+    HdrHistogram& operator=(const HdrHistogram& other);
+
+    HdrHistogram(HdrHistogram&& other) = default;
+    HdrHistogram& operator=(HdrHistogram&& other) = default;
+
+    /**
+     * Adds the values of other to this histogram. Values outside of this
+     * histogram's range are dropped.
+     */
+    HdrHistogram& operator+=(const HdrHistogram& other);
+
     /**
      * Adds a value to the histogram.
      */
@@ -106,6 +119,12 @@ public:
      */
     Iterator makeLinearIterator(int64_t valueUnitsPerBucket) const;
 
+    /**
+     * Returns an iterator over the buckets of the histogram which hold any
+     * values; getNextValueAndCount() returns the lowest value of each.
+     */
+    Iterator makeRecordedIterator() const;
+
     /**
      * Gets the next value and corresponding count from the histogram
      * Returns an optional pair, comprising of: